@@ -0,0 +1,89 @@
+dnl Check for PCRE2 Libraries
+dnl CHECK_PCRE2(ACTION-IF-FOUND [, ACTION-IF-NOT-FOUND])
+dnl Sets:
+dnl  HAVE_PCRE2
+dnl  PCRE2_CFLAGS
+dnl  PCRE2_LDADD
+
+PCRE2_CONFIG=""
+PCRE2_VERSION=""
+PCRE2_CFLAGS=""
+PCRE2_LDADD=""
+
+AC_DEFUN([CHECK_PCRE2],
+[dnl
+
+test_paths="/usr/local/pcre2 /usr/local /opt/pcre2 /opt/local /opt/qualys/usr /opt /usr"
+
+AC_ARG_WITH(
+    pcre2,
+    [AC_HELP_STRING([--with-pcre2=PATH],[Path to pcre2 prefix or config script])],
+    [test_paths="${with_pcre2}"],
+    [])
+
+if test "${with_pcre2}" != "no"; then
+    AC_MSG_CHECKING([for libpcre2 config script])
+
+    for x in ${test_paths}; do
+        dnl # Determine if the script was specified and use it directly
+        if test ! -d "$x" -a -e "$x"; then
+            PCRE2_CONFIG=$x
+            pcre2_path="no"
+            break
+        fi
+
+        if test -e "${x}/bin/pcre2-config"; then
+            pcre2_path="${x}/bin"
+            break
+        elif test -e "${x}/pcre2-config"; then
+            pcre2_path="${x}"
+            break
+        else
+            pcre2_path=""
+        fi
+    done
+
+    if test -n "${pcre2_path}"; then
+        if test "${pcre2_path}" != "no"; then
+            PCRE2_CONFIG="${pcre2_path}/pcre2-config"
+        fi
+        AC_MSG_RESULT([${PCRE2_CONFIG}])
+        PCRE2_VERSION="`${PCRE2_CONFIG} --version`"
+        PCRE2_CFLAGS="`${PCRE2_CONFIG} --cflags`"
+        PCRE2_LDADD="`${PCRE2_CONFIG} --libs8`"
+        if test "$verbose_output" -eq 1; then AC_MSG_NOTICE(pcre2 VERSION: $PCRE2_VERSION); fi
+    else
+        AC_MSG_RESULT([no])
+    fi
+fi
+
+dnl # pcre2_set_depth_limit() appeared in 10.30; require it.
+if test -n "${PCRE2_VERSION}"; then
+    save_CFLAGS=$CFLAGS
+    save_LIBS=$LIBS
+    CFLAGS="${PCRE2_CFLAGS} ${CFLAGS}"
+    LIBS="${PCRE2_LDADD} ${LIBS}"
+    AC_CHECK_FUNC([pcre2_set_depth_limit_8], [], [PCRE2_VERSION=""])
+    CFLAGS=$save_CFLAGS
+    LIBS=$save_LIBS
+fi
+
+if test -n "${PCRE2_VERSION}"; then
+    AC_DEFINE([HAVE_PCRE2], [1], [pcre2 is available])
+    AC_MSG_NOTICE([using pcre2 v${PCRE2_VERSION}])
+    ifelse([$1], , , $1)
+else
+    PCRE2_CFLAGS=""
+    PCRE2_LDADD=""
+    if test -n "${with_pcre2}" -a "${with_pcre2}" != "no"; then
+        AC_MSG_ERROR([pcre2 (10.30 or later) not found])
+    fi
+    AC_MSG_NOTICE([Not building with pcre2 support.])
+    ifelse([$2], , , $2)
+fi
+
+AC_SUBST(PCRE2_CONFIG)
+AC_SUBST(PCRE2_VERSION)
+AC_SUBST(PCRE2_CFLAGS)
+AC_SUBST(PCRE2_LDADD)
+])
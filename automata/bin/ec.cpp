@@ -58,6 +58,7 @@ int main(int argc, char **argv)
     size_t id_width = 0;
     size_t align_to = 1;
     double high_node_weight = 1.0;
+    size_t dense_depth = 0;
 
     po::options_description desc("Options:");
     desc.add_options()
@@ -80,6 +81,10 @@ int main(int argc, char **argv)
             "> 1 favors low nodes; < 1 favors high nodes; 1.0 = smallest; "
             "default 1.0"
         )
+        ("dense-depth,d", po::value<size_t>(&dense_depth),
+            "use direct lookup tables for nodes with defaults closer than "
+            "this to the start; default 0 = off"
+        )
         ;
 
     po::positional_options_description pd;
@@ -152,6 +157,7 @@ int main(int argc, char **argv)
         configuration.id_width = id_width;
         configuration.align_to = align_to;
         configuration.high_node_weight = high_node_weight;
+        configuration.dense_depth = dense_depth;
         try {
             result = EudoxusCompiler::compile(automata, configuration);
         }
@@ -165,12 +171,15 @@ int main(int argc, char **argv)
         cout << "id_width         = " << result.configuration.id_width << endl;
         cout << "align_to         = " << result.configuration.align_to << endl;
         cout << "high_node_weight = " << result.configuration.high_node_weight << endl;
+        cout << "dense_depth      = " << result.configuration.dense_depth << endl;
         cout << "ids_used         = " << result.ids_used << endl;
         cout << "padding          = " << result.padding << endl;
         cout << "low_nodes        = " << result.low_nodes << endl;
         cout << "low_nodes_bytes  = " << result.low_nodes_bytes << endl;
         cout << "high_nodes       = " << result.high_nodes << endl;
         cout << "high_nodes_bytes = " << result.high_nodes_bytes << endl;
+        cout << "dense_nodes      = " << result.dense_nodes << endl;
+        cout << "dense_nodes_bytes = " << result.dense_nodes_bytes << endl;
         cout << "pc_nodes         = " << result.pc_nodes << endl;
         cout << "pc_nodes_bytes   = " << result.pc_nodes_bytes << endl;
 
@@ -48,12 +48,64 @@
 #include <ironautomata/vls.h>
 
 #include <assert.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+/**
+ * A read-only mapping of an automata file.
+ *
+ * Images live in a process-wide list, @c s_images, and are shared by all
+ * engines created from the same file.
+ */
+typedef struct ia_eudoxus_image_t ia_eudoxus_image_t;
+struct ia_eudoxus_image_t
+{
+    /** @name Identity of the mapped file.
+     * @{
+     */
+    dev_t  dev;
+    ino_t  ino;
+    off_t  size;
+    time_t mtime;
+    /** @} */
+
+    /**
+     * Start of mapping.
+     */
+    void *addr;
+
+    /**
+     * Number of engines using this image.  Protected by @c s_images_lock.
+     */
+    size_t refcount;
+
+    /**
+     * Next image in @c s_images.
+     */
+    ia_eudoxus_image_t *next;
+};
+
+/**
+ * All mapped images.
+ */
+static ia_eudoxus_image_t *s_images = NULL;
+
+/**
+ * Protects @c s_images and the reference counts of its images.
+ */
+static pthread_mutex_t s_images_lock = PTHREAD_MUTEX_INITIALIZER;
+
 struct ia_eudoxus_t
 {
     /**
@@ -61,6 +113,11 @@ struct ia_eudoxus_t
      */
     const ia_eudoxus_automata_t *automata;
 
+    /**
+     * Image @c automata is mapped from or NULL if @c automata was malloced.
+     */
+    ia_eudoxus_image_t *image;
+
     /**
      * Most recent error message.
      *
@@ -195,6 +252,7 @@ ia_eudoxus_result_t ia_eudoxus_create(
     }
 
     eudoxus->automata           = (ia_eudoxus_automata_t *)data;
+    eudoxus->image              = NULL;
     eudoxus->error_message      = NULL;
     eudoxus->free_error_message = false;
 
@@ -267,6 +325,178 @@ ia_eudoxus_result_t ia_eudoxus_create_from_path(
     return result;
 }
 
+/**
+ * Release a reference to @a image, unmapping it if it was the last.
+ *
+ * @param[in] image Image to release.
+ */
+static
+void ia_eudoxus_image_release(
+    ia_eudoxus_image_t *image
+)
+{
+    ia_eudoxus_image_t **link;
+
+    pthread_mutex_lock(&s_images_lock);
+    assert(image->refcount > 0);
+    --image->refcount;
+    if (image->refcount > 0) {
+        pthread_mutex_unlock(&s_images_lock);
+        return;
+    }
+    for (link = &s_images; *link != NULL; link = &(*link)->next) {
+        if (*link == image) {
+            *link = image->next;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_images_lock);
+
+    munmap(image->addr, image->size);
+    free(image);
+}
+
+/**
+ * Acquire a reference to the image of the file at @a path.
+ *
+ * Maps the file if it is not already mapped.  The file is mapped private so
+ * that the image never writes back to it, and is checked against the data
+ * length its header declares before it is shared.
+ *
+ * @param[out] out_image Acquired image.
+ * @param[in]  path      Path of automata file.
+ * @param[in]  flags     Flags; see ia_eudoxus_map_flags_t.
+ * @return
+ * - IA_EUDOXUS_OK on success.
+ * - IA_EUDOXUS_EINVAL if @a path can not be opened or mapped, or is shorter
+ *   than the automata header or the data length it declares.
+ * - IA_EUDOXUS_EALLOC on allocation failure.
+ */
+static
+ia_eudoxus_result_t ia_eudoxus_image_acquire(
+    ia_eudoxus_image_t **out_image,
+    const char          *path,
+    int                  flags
+)
+{
+    ia_eudoxus_image_t *image;
+    struct stat         sb;
+    int                 fd;
+    int                 mmap_flags = MAP_PRIVATE;
+    void               *addr;
+    uint64_t            data_length;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return IA_EUDOXUS_EINVAL;
+    }
+    if (fstat(fd, &sb) != 0) {
+        close(fd);
+        return IA_EUDOXUS_EINVAL;
+    }
+    if (sb.st_size < (off_t)sizeof(ia_eudoxus_automata_t)) {
+        close(fd);
+        return IA_EUDOXUS_EINVAL;
+    }
+
+    pthread_mutex_lock(&s_images_lock);
+    for (image = s_images; image != NULL; image = image->next) {
+        if (
+            image->dev        == sb.st_dev &&
+            image->ino        == sb.st_ino &&
+            image->size       == sb.st_size &&
+            image->mtime      == sb.st_mtime
+        ) {
+            ++image->refcount;
+            pthread_mutex_unlock(&s_images_lock);
+            close(fd);
+            *out_image = image;
+            return IA_EUDOXUS_OK;
+        }
+    }
+
+    /* Map while holding the lock so that concurrent loads of the same file
+     * share a single mapping. */
+#ifdef MAP_POPULATE
+    if (flags & IA_EUDOXUS_MAP_POPULATE) {
+        mmap_flags |= MAP_POPULATE;
+    }
+#endif
+    addr = mmap(NULL, sb.st_size, PROT_READ, mmap_flags, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        pthread_mutex_unlock(&s_images_lock);
+        return IA_EUDOXUS_EINVAL;
+    }
+
+    /* Executing past the end of the file would raise SIGBUS rather than
+     * fail, so the automata must fit in what was mapped. */
+    data_length = ((const ia_eudoxus_automata_t *)addr)->data_length;
+    if (
+        data_length < sizeof(ia_eudoxus_automata_t) ||
+        data_length > (uint64_t)sb.st_size
+    ) {
+        pthread_mutex_unlock(&s_images_lock);
+        munmap(addr, sb.st_size);
+        return IA_EUDOXUS_EINVAL;
+    }
+#ifdef MADV_HUGEPAGE
+    if (flags & IA_EUDOXUS_MAP_HUGEPAGES) {
+        /* Advisory only; ignore failure. */
+        madvise(addr, sb.st_size, MADV_HUGEPAGE);
+    }
+#endif
+
+    image = (ia_eudoxus_image_t *)malloc(sizeof(*image));
+    if (image == NULL) {
+        pthread_mutex_unlock(&s_images_lock);
+        munmap(addr, sb.st_size);
+        return IA_EUDOXUS_EALLOC;
+    }
+    image->dev        = sb.st_dev;
+    image->ino        = sb.st_ino;
+    image->size       = sb.st_size;
+    image->mtime      = sb.st_mtime;
+    image->addr       = addr;
+    image->refcount   = 1;
+    image->next       = s_images;
+    s_images          = image;
+    pthread_mutex_unlock(&s_images_lock);
+
+    *out_image = image;
+
+    return IA_EUDOXUS_OK;
+}
+
+ia_eudoxus_result_t ia_eudoxus_create_from_path_mapped(
+    ia_eudoxus_t **out_eudoxus,
+    const char    *path,
+    int            flags
+)
+{
+    ia_eudoxus_image_t  *image;
+    ia_eudoxus_result_t  rc;
+
+    if (out_eudoxus == NULL || path == NULL) {
+        return IA_EUDOXUS_EINVAL;
+    }
+
+    rc = ia_eudoxus_image_acquire(&image, path, flags);
+    if (rc != IA_EUDOXUS_OK) {
+        return rc;
+    }
+
+    /* The mapping is read only; ia_eudoxus_create() only reads. */
+    rc = ia_eudoxus_create(out_eudoxus, (char *)image->addr);
+    if (rc != IA_EUDOXUS_OK) {
+        ia_eudoxus_image_release(image);
+        return rc;
+    }
+    (*out_eudoxus)->image = image;
+
+    return IA_EUDOXUS_OK;
+}
+
 void ia_eudoxus_destroy(
     ia_eudoxus_t *eudoxus
 )
@@ -277,7 +507,10 @@ void ia_eudoxus_destroy(
 
     /* Better to cast away const here than to not have const checks for
      * all uses. */
-    if (eudoxus->automata) {
+    if (eudoxus->image != NULL) {
+        ia_eudoxus_image_release(eudoxus->image);
+    }
+    else if (eudoxus->automata) {
         free((void *)eudoxus->automata);
     }
     if (eudoxus->error_message != NULL && eudoxus->free_error_message) {
@@ -414,6 +647,153 @@ void ia_eudoxus_set_error_printf(
     va_end(ap);
 }
 
+/**
+ * Find the index of @a c in the first @a n bytes of @a keys.
+ *
+ * Used by low degree nodes.  Full blocks of keys are compared with SIMD
+ * instructions where available; the remainder is scanned.  Never reads past
+ * @a keys + @a n.
+ *
+ * @param[in] keys Keys to search.
+ * @param[in] n    Number of keys.
+ * @param[in] c    Key to search for.
+ * @return Index of first occurrence of @a c or @a n if not found.
+ */
+static inline
+int ia_eudoxus_find_key(
+    const uint8_t *keys,
+    int            n,
+    uint8_t        c
+)
+{
+    int i = 0;
+
+#if defined(__AVX2__)
+    const __m256i needle32 = _mm256_set1_epi8((char)c);
+    for (; i + 32 <= n; i += 32) {
+        __m256i block = _mm256_loadu_si256((const __m256i *)(keys + i));
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(block, needle32)
+        );
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i needle16 = _mm_set1_epi8((char)c);
+    for (; i + 16 <= n; i += 16) {
+        __m128i block = _mm_loadu_si128((const __m128i *)(keys + i));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(
+            _mm_cmpeq_epi8(block, needle16)
+        );
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+
+    while (i < n && keys[i] != c) {
+        ++i;
+    }
+
+    return i;
+}
+
+/**
+ * Number of inputs ia_eudoxus_execute_batch() executes at once.
+ */
+#define IA_EUDOXUS_BATCH_WIDTH 4
+
+/**
+ * An input being executed by ia_eudoxus_execute_batch().
+ */
+typedef struct ia_eudoxus_batch_slot_t ia_eudoxus_batch_slot_t;
+struct ia_eudoxus_batch_slot_t
+{
+    /** State of execution; callback data is this slot. */
+    ia_eudoxus_state_t          state;
+    /** User callback. */
+    ia_eudoxus_batch_callback_t callback;
+    /** User callback data. */
+    void                       *callback_data;
+    /** Tag of input. */
+    void                       *tag;
+    /** Current segment of input. */
+    const ia_eudoxus_input_t   *segment;
+    /** Last element of the batch; ends any input. */
+    const ia_eudoxus_input_t   *last;
+};
+
+/**
+ * Load the first non-empty segment of the input of @a slot.
+ *
+ * Starts at ia_eudoxus_batch_slot_t::segment, which is updated.
+ *
+ * @param[in] slot Slot to load.
+ * @return true if a segment was loaded; false if the input is consumed.
+ */
+static
+bool ia_eudoxus_batch_slot_load(
+    ia_eudoxus_batch_slot_t *slot
+)
+{
+    while (slot->segment->length == 0) {
+        if (! slot->segment->continued || slot->segment == slot->last) {
+            return false;
+        }
+        ++slot->segment;
+    }
+
+    slot->state.input_location  = slot->segment->data;
+    slot->state.remaining_bytes = slot->segment->length;
+
+    return true;
+}
+
+/**
+ * Load the next segment of the input of @a slot, if any.
+ *
+ * @param[in] slot Slot whose current segment is consumed.
+ * @return true if a segment was loaded; false if the input is consumed.
+ */
+static
+bool ia_eudoxus_batch_slot_next(
+    ia_eudoxus_batch_slot_t *slot
+)
+{
+    if (! slot->segment->continued || slot->segment == slot->last) {
+        return false;
+    }
+    ++slot->segment;
+
+    return ia_eudoxus_batch_slot_load(slot);
+}
+
+/**
+ * Forward output of a batch slot to the user callback with its tag.
+ */
+static
+ia_eudoxus_command_t ia_eudoxus_batch_callback(
+    ia_eudoxus_t  *eudoxus,
+    const char    *output,
+    size_t         output_length,
+    const uint8_t *input_location,
+    void          *callback_data
+)
+{
+    const ia_eudoxus_batch_slot_t *slot =
+        (const ia_eudoxus_batch_slot_t *)callback_data;
+
+    return slot->callback(
+        eudoxus,
+        output, output_length,
+        input_location,
+        slot->tag,
+        slot->callback_data
+    );
+}
+
 /* Specific Subengine Code */
 
 #define IA_EUDOXUS(a) ia_eudoxus8_ ## a
@@ -482,6 +862,47 @@ ia_eudoxus_result_t ia_eudoxus_execute_without_output(
     return ia_eudoxus_execute_impl(state, input, input_length, false);
 }
 
+ia_eudoxus_result_t ia_eudoxus_execute_batch(
+    ia_eudoxus_t                *eudoxus,
+    const ia_eudoxus_input_t    *inputs,
+    size_t                       num_inputs,
+    ia_eudoxus_batch_callback_t  callback,
+    void                        *callback_data
+)
+{
+    if (eudoxus == NULL || eudoxus->automata == NULL || inputs == NULL) {
+        return IA_EUDOXUS_EINVAL;
+    }
+    for (size_t i = 0; i < num_inputs; ++i) {
+        if (inputs[i].data == NULL && inputs[i].length > 0) {
+            return IA_EUDOXUS_EINVAL;
+        }
+    }
+
+    ia_eudoxus_set_error(eudoxus, NULL);
+
+    switch (eudoxus->automata->id_width) {
+    case 8:
+        return ia_eudoxus8_execute_batch(
+            eudoxus, inputs, num_inputs, callback, callback_data
+        );
+    case 4:
+        return ia_eudoxus4_execute_batch(
+            eudoxus, inputs, num_inputs, callback, callback_data
+        );
+    case 2:
+        return ia_eudoxus2_execute_batch(
+            eudoxus, inputs, num_inputs, callback, callback_data
+        );
+    case 1:
+        return ia_eudoxus1_execute_batch(
+            eudoxus, inputs, num_inputs, callback, callback_data
+        );
+    default:
+        return IA_EUDOXUS_EINCOMPAT;
+    }
+}
+
 ia_eudoxus_result_t ia_eudoxus_metadata(
     ia_eudoxus_t                   *eudoxus,
     ia_eudoxus_metadata_callback_t  callback,
@@ -47,7 +47,7 @@ using namespace std;
 namespace IronAutomata {
 namespace EudoxusCompiler {
 
-#define CPP_EUDOXUS_VERSION 10
+#define CPP_EUDOXUS_VERSION 11
 #if CPP_EUDOXUS_VERSION != IA_EUDOXUS_VERSION
 #error "Mismatch between compiler version and automata version."
 #endif
@@ -92,8 +92,6 @@ private:
     typedef Eudoxus::subengine_traits<id_width> traits_t;
     //! Eudoxus Identifier.
     typedef typename traits_t::id_t          e_id_t;
-    //! Eudoxus Low Edge.
-    typedef typename traits_t::low_edge_t    e_low_edge_t;
     //! Eudoxus Low Node.
     typedef typename traits_t::low_node_t    e_low_node_t;
     //! Eudoxus High Node
@@ -163,7 +161,7 @@ private:
             }
             if (! node->edges().empty()) {
                 low_node_cost += sizeof(uint8_t);
-                low_node_cost += sizeof(typename traits_t::low_edge_t) * out_degree;
+                low_node_cost += (sizeof(uint8_t) + sizeof(e_id_t)) * out_degree;
             }
             if (node->default_target()) {
                 low_node_cost += sizeof(e_id_t);
@@ -196,6 +194,19 @@ private:
             else {
                 high_node_cost += sizeof(e_id_t) * out_degree;
             }
+
+            dense_nonadvancing = has_nonadvancing || (
+                node->default_target() && ! node->advance_on_default()
+            );
+            dense_node_cost = 0;
+            dense_node_cost += sizeof(e_high_node_t);
+            if (node->first_output()) {
+                dense_node_cost += sizeof(e_id_t);
+            }
+            if (dense_nonadvancing) {
+                dense_node_cost += sizeof(ia_bitmap256_t);
+            }
+            dense_node_cost += sizeof(e_id_t) * 256;
         }
 
         //! True if there are non-advancing edges (not including default).
@@ -218,6 +229,10 @@ private:
         size_t low_node_cost;
         //! Cost in bytes of representing with a high node.
         size_t high_node_cost;
+        //! Cost in bytes of representing with a dense node.
+        size_t dense_node_cost;
+        //! True if any input of a dense node would not advance.
+        bool dense_nonadvancing;
 
         //! Targets by input map.
         Intermediate::Node::targets_by_input_t targets_by_input;
@@ -299,8 +314,13 @@ private:
         m_result.pc_nodes_bytes += m_assembler.size() - old_size;
     }
 
-    //! Compile node into a demux (high or low) node.
-    void demux_node(const Intermediate::node_p& node)
+    /**
+     * Compile node into a demux (dense, high or low) node.
+     *
+     * @param[in] node  Intermediate node to compile.
+     * @param[in] depth Distance of @a node from the start node.
+     */
+    void demux_node(const Intermediate::node_p& node, size_t depth)
     {
         NodeOracle oracle(node);
 
@@ -316,6 +336,15 @@ private:
         size_t cost_prediction = 0;
 
         if (
+            depth < m_configuration.dense_depth &&
+            (node->default_target() || oracle.out_degree == 256)
+        ) {
+            cost_prediction = oracle.dense_node_cost;
+            bytes_counter = &m_result.dense_nodes_bytes;
+            nodes_counter = &m_result.dense_nodes;
+            dense_node(*node, oracle);
+        }
+        else if (
             oracle.high_node_cost * m_configuration.high_node_weight
              > oracle.low_node_cost
         ) {
@@ -400,6 +429,7 @@ private:
             advance_index = m_assembler.index(advance);
         }
 
+        // Keys first, then targets in the same order.
         size_t edge_i = 0;
         BOOST_FOREACH(const Intermediate::Edge& edge, node.edges()) {
             if (edge.epsilon()) {
@@ -418,13 +448,71 @@ private:
                 }
                 ++edge_i;
 
-                e_low_edge_t* e_edge =
-                    m_assembler.append_object(e_low_edge_t());
-                e_edge->c = value;
-                register_node_ref(
-                    m_assembler.index(&(e_edge->next_node)),
-                    edge.target()
-                );
+                m_assembler.append_object(value);
+            }
+        }
+
+        BOOST_FOREACH(const Intermediate::Edge& edge, node.edges()) {
+            for (size_t i = 0; i < edge.size(); ++i) {
+                append_node_ref(edge.target());
+            }
+        }
+    }
+
+    /**
+     * Compile @a node as a dense node.
+     *
+     * A dense node is a high node with a target for every input: inputs
+     * without an edge get the default target.  Lookup is then a direct
+     * index into the targets table.  Only valid for nodes with a default
+     * target or with edges for all inputs.
+     *
+     * @param[in] node Intermediate node to compile.
+     */
+    void dense_node(
+        const Intermediate::Node& node,
+        const NodeOracle& oracle
+    )
+    {
+        {
+            e_high_node_t* header =
+                m_assembler.append_object(e_high_node_t());
+
+            header->header = IA_EUDOXUS_HIGH;
+            if (node.first_output()) {
+                header->header = ia_setbit8(header->header, 0 + IA_EUDOXUS_TYPE_WIDTH);
+            }
+            if (oracle.dense_nonadvancing) {
+                header->header = ia_setbit8(header->header, 1 + IA_EUDOXUS_TYPE_WIDTH);
+            }
+        }
+
+        if (node.first_output()) {
+            append_output_ref(node.first_output());
+            m_outputs.insert(node.first_output());
+        }
+
+        if (oracle.dense_nonadvancing) {
+            ia_bitmap256_t& advance_bm =
+                *m_assembler.append_object(ia_bitmap256_t());
+            for (int c = 0; c < 256; ++c) {
+                bool advance = node.advance_on_default();
+                if (! oracle.targets_by_input[c].empty()) {
+                    advance = oracle.targets_by_input[c].front().second;
+                }
+                if (advance) {
+                    ia_setbitv64(advance_bm.bits, c);
+                }
+            }
+        }
+
+        for (int c = 0; c < 256; ++c) {
+            if (! oracle.targets_by_input[c].empty()) {
+                append_node_ref(oracle.targets_by_input[c].front().first);
+            }
+            else {
+                assert(node.default_target());
+                append_node_ref(node.default_target());
             }
         }
     }
@@ -831,6 +919,8 @@ void Compiler<id_width>::compile(
     m_result.high_nodes_bytes = 0;
     m_result.pc_nodes = 0;
     m_result.pc_nodes_bytes = 0;
+    m_result.dense_nodes = 0;
+    m_result.dense_nodes_bytes = 0;
 
     // Header
     ia_eudoxus_automata_t* e_automata =
@@ -858,15 +948,17 @@ void Compiler<id_width>::compile(
     );
 
     // Adapted BFS... Complicated by path compression nodes.
-    queue<Intermediate::node_p> todo;
-    set<Intermediate::node_p>   queued;
+    // Depth is the BFS depth at which a node was first queued.
+    queue<Intermediate::node_p>       todo;
+    map<Intermediate::node_p, size_t> queued;
 
     todo.push(automata.start_node());
-    queued.insert(automata.start_node());
+    queued[automata.start_node()] = 0;
 
     while (! todo.empty()) {
         Intermediate::node_p node = todo.front();
         todo.pop();
+        size_t depth = queued[node];
 
         // Padding
         size_t index = m_assembler.size();
@@ -908,19 +1000,22 @@ void Compiler<id_width>::compile(
             // Path Compression
             pc_node(node, end_of_path, path_length);
             // Add end of path.
-            bool need_to_queue = queued.insert(end_of_path).second;
+            bool need_to_queue = queued.insert(
+                make_pair(end_of_path, depth + path_length)
+            ).second;
             if (need_to_queue) {
                 todo.push(end_of_path);
             }
         }
         else {
             // Demux: High or Low
-            demux_node(node);
+            demux_node(node, depth);
 
             // And add all children.
             BOOST_FOREACH(const Intermediate::Edge& edge, node->edges()) {
                 const Intermediate::node_p& target = edge.target();
-                bool need_to_queue = queued.insert(target).second;
+                bool need_to_queue =
+                    queued.insert(make_pair(target, depth + 1)).second;
                 if (need_to_queue) {
                     todo.push(target);
                 }
@@ -929,7 +1024,8 @@ void Compiler<id_width>::compile(
         if (node->default_target()) {
             const Intermediate::node_p& target =
                 node->default_target();
-            bool need_to_queue = queued.insert(target).second;
+            bool need_to_queue =
+                queued.insert(make_pair(target, depth + 1)).second;
             if (need_to_queue) {
                 todo.push(target);
             }
@@ -1027,7 +1123,8 @@ result_t compile_minimal(
 configuration_t::configuration_t() :
     id_width(0),
     align_to(1),
-    high_node_weight(1.0)
+    high_node_weight(1.0),
+    dense_depth(0)
 {
     // nop
 }
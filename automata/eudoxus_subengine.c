@@ -94,25 +94,28 @@ ia_eudoxus_result_t IA_EUDOXUS(next_low)(
     const uint8_t *advance = IA_VLS_VARRAY_IF(
         vls,
         const uint8_t,
-        out_degree / 8,
+        (out_degree + 7) / 8,
         has_nonadvancing & has_edges
     );
-    const IA_EUDOXUS(low_edge_t) *edges = IA_VLS_FINAL(
+    const uint8_t *keys = IA_VLS_VARRAY_IF(
         vls,
-        const IA_EUDOXUS(low_edge_t)
+        const uint8_t,
+        out_degree,
+        has_edges
+    );
+    const IA_EUDOXUS_ID_T *targets = IA_VLS_FINAL(
+        vls,
+        const IA_EUDOXUS_ID_T
     );
 
     IA_EUDOXUS_ID_T next_node            = 0;
     bool            advance_on_next_node = true;
 
     if (has_edges) {
-        int i = 0;
-        while (i < out_degree && edges[i].c != c) {
-            ++i;
-        }
+        int i = ia_eudoxus_find_key(keys, out_degree, c);
 
         if (i != out_degree) {
-            next_node = edges[i].next_node;
+            next_node = targets[i];
             if (has_nonadvancing) {
                 advance_on_next_node = ia_bitv(advance, i);
             }
@@ -599,4 +602,129 @@ ia_eudoxus_result_t IA_EUDOXUS(execute)(
     return IA_EUDOXUS_OK;
 }
 
+/**
+ * Batch execute function.
+ *
+ * This is the subengine specific version of ia_eudoxus_execute_batch() and
+ * has the same semantics.  Up to IA_EUDOXUS_BATCH_WIDTH inputs are active at
+ * a time; each round advances every active input by one transition and
+ * prefetches its next node, so that node fetches of different inputs
+ * overlap.  An input keeps its slot across its segments.  Finished inputs
+ * are replaced by the next pending input.
+ *
+ * @param[in] eudoxus       Engine.
+ * @param[in] inputs        Inputs to execute on.
+ * @param[in] num_inputs    Number of inputs.
+ * @param[in] callback      User callback; may be NULL.
+ * @param[in] callback_data User callback data.
+ * @return See ia_eudoxus_execute_batch() for return codes meanings.
+ */
+static
+ia_eudoxus_result_t IA_EUDOXUS(execute_batch)(
+    ia_eudoxus_t                *eudoxus,
+    const ia_eudoxus_input_t    *inputs,
+    size_t                       num_inputs,
+    ia_eudoxus_batch_callback_t  callback,
+    void                        *callback_data
+)
+{
+    assert(eudoxus           != NULL);
+    assert(eudoxus->automata != NULL);
+    assert(inputs            != NULL);
+
+    ia_eudoxus_batch_slot_t  slots[IA_EUDOXUS_BATCH_WIDTH];
+    size_t                   num_active = 0;
+    size_t                   next_input = 0;
+    const ia_eudoxus_node_t *start      = (const ia_eudoxus_node_t *)(
+        (const char *)eudoxus->automata + eudoxus->automata->start_index
+    );
+    bool                     no_advance_no_output =
+        eudoxus->automata->no_advance_no_output;
+    ia_eudoxus_result_t      result;
+
+    for (;;) {
+        /* Fill free slots with pending inputs. */
+        while (num_active < IA_EUDOXUS_BATCH_WIDTH && next_input < num_inputs) {
+            const ia_eudoxus_input_t *input = &inputs[next_input];
+            ia_eudoxus_batch_slot_t  *slot  = &slots[num_active];
+
+            /* Skip the remaining segments of the input. */
+            ++next_input;
+            while (
+                next_input < num_inputs &&
+                inputs[next_input - 1].continued
+            ) {
+                ++next_input;
+            }
+
+            slot->callback              = callback;
+            slot->callback_data         = callback_data;
+            slot->tag                   = input->tag;
+            slot->segment               = input;
+            slot->last                  = &inputs[num_inputs - 1];
+            slot->state.eudoxus         = eudoxus;
+            /* Always set; next functions require a callback.  Outputs
+             * are only run if the user provided one. */
+            slot->state.callback        = ia_eudoxus_batch_callback;
+            slot->state.callback_data   = slot;
+            slot->state.node            = start;
+            slot->state.byte_index      = 0;
+
+            /* Outputs of the start node, as for ia_eudoxus_create_state(). */
+            if (callback != NULL) {
+                result = IA_EUDOXUS(output)(&slot->state);
+                if (result != IA_EUDOXUS_OK) {
+                    return result;
+                }
+            }
+
+            if (ia_eudoxus_batch_slot_load(slot)) {
+                ++num_active;
+            }
+        }
+
+        if (num_active == 0) {
+            break;
+        }
+
+        for (size_t i = 0; i < num_active;) {
+            ia_eudoxus_state_t *state              = &slots[i].state;
+            const uint8_t      *old_input_location = state->input_location;
+
+            result = IA_EUDOXUS(next)(state);
+            if (
+                result == IA_EUDOXUS_OK &&
+                callback != NULL &&
+                ( ! no_advance_no_output ||
+                  state->input_location != old_input_location )
+            ) {
+                result = IA_EUDOXUS(output)(state);
+            }
+
+            if (
+                result == IA_EUDOXUS_END ||
+                ( result == IA_EUDOXUS_OK &&
+                  state->remaining_bytes == 0 &&
+                  ! ia_eudoxus_batch_slot_next(&slots[i]) )
+            ) {
+                /* Input finished; move last active slot here. */
+                --num_active;
+                if (i != num_active) {
+                    slots[i] = slots[num_active];
+                    slots[i].state.callback_data = &slots[i];
+                }
+                continue;
+            }
+            if (result != IA_EUDOXUS_OK) {
+                return result;
+            }
+
+            __builtin_prefetch(state->node);
+            ++i;
+        }
+    }
+
+    return IA_EUDOXUS_OK;
+}
+
 /** @} IronAutomataEudoxusAutomata */
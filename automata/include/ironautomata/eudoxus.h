@@ -154,6 +154,64 @@ ia_eudoxus_result_t ia_eudoxus_create_from_path(
     const char    *path
 );
 
+/**
+ * Flags for ia_eudoxus_create_from_path_mapped().
+ */
+enum ia_eudoxus_map_flags_t
+{
+    /**
+     * Fault in the whole image at load time (@c MAP_POPULATE) instead of
+     * on first execution.
+     */
+    IA_EUDOXUS_MAP_POPULATE  = 0x01,
+
+    /**
+     * Ask the kernel to back the image with huge pages where it can
+     * (@c MADV_HUGEPAGE).  Ignored where unsupported.
+     */
+    IA_EUDOXUS_MAP_HUGEPAGES = 0x02
+};
+
+/**
+ * As ia_eudoxus_create_from_path(), but map the file read-only and private.
+ *
+ * The image is shared: all engines created from the same file (same device,
+ * inode, size and modification time) in this process use a single
+ * reference counted mapping, which is unmapped when the last of them is
+ * destroyed.  Loading a file that is already mapped costs a @c stat() and
+ * no I/O.  As the mapping is backed by the page cache, other processes
+ * mapping the same file, including children forked after the load, share
+ * its pages.
+ *
+ * @attention Automata files must be replaced by rename, never rewritten or
+ *            truncated in place, while any process has them mapped.  A
+ *            private mapping does not snapshot the file: pages not yet read
+ *            show in place writes, and pages past a truncation raise
+ *            @c SIGBUS in every engine using the image.  Write the new
+ *            automata to a temporary file in the same directory and
+ *            rename() it over the old one; engines already created keep
+ *            the old image and later loads map the new file.
+ *
+ * This function is thread safe.
+ *
+ * @param[out] out_eudoxus Variable to hold pointer to created engine.
+ * @param[in]  path        Path to file on disk holding automata.
+ * @param[in]  flags       Bitwise or of @ref ia_eudoxus_map_flags_t values.
+ * @return
+ * - IA_EUDOXUS_EINVAL if @a out_eudoxus or @a path is NULL, if @a path can
+ *   not be opened or mapped, or if it is shorter than the automata
+ *   header or the data length the header declares.
+ * - IA_EUDOXUS_EALLOC on allocation failure.
+ * - IA_EUDOXUS_EINCOMPAT if automata is not compatible with engine.
+ *
+ * @sa ia_eudoxus_t
+ */
+ia_eudoxus_result_t ia_eudoxus_create_from_path_mapped(
+    ia_eudoxus_t **out_eudoxus,
+    const char    *path,
+    int            flags
+);
+
 /**
  * Destroy engine @a eudoxus, releasing associated memory.
  *
@@ -379,6 +437,96 @@ ia_eudoxus_result_t ia_eudoxus_execute_without_output(
     size_t              input_length
 );
 
+/**
+ * An input of ia_eudoxus_execute_batch().
+ *
+ * An input may be split into several segments, e.g., to execute on data
+ * that is not contiguous without copying it.  Each segment but the last
+ * sets @c continued; the segments are executed in order from one state, as
+ * by successive ia_eudoxus_execute() calls.
+ */
+typedef struct ia_eudoxus_input_t ia_eudoxus_input_t;
+struct ia_eudoxus_input_t
+{
+    /** Input to execute on. */
+    const uint8_t *data;
+    /** Length of @c data. */
+    size_t         length;
+    /**
+     * Passed to the callback with every output of this input.
+     *
+     * Only the tag of the first segment of an input is used.
+     */
+    void          *tag;
+    /** True if the next element is the next segment of this input. */
+    bool           continued;
+};
+
+/**
+ * Callback function for processing batched input.
+ *
+ * As ia_eudoxus_callback_t but also passed the tag of the input the output
+ * occurred in.
+ *
+ * @param[in] engine         Engine involved.
+ * @param[in] output         Output defined by automata.
+ * @param[in] output_length  Length of @a output.
+ * @param[in] input_location Location in input.
+ * @param[in] tag            Tag of input.
+ * @param[in] callback_data  Callback data as passed to
+ *                           ia_eudoxus_execute_batch().
+ * @return ia_eudoxus_command_t
+ */
+typedef ia_eudoxus_command_t (*ia_eudoxus_batch_callback_t)(
+    ia_eudoxus_t  *engine,
+    const char    *output,
+    size_t         output_length,
+    const uint8_t *input_location,
+    void          *tag,
+    void          *callback_data
+);
+
+/**
+ * Execute automata on each of several independent inputs.
+ *
+ * Equivalent to creating a fresh state for each input, executing it on the
+ * input, and destroying it, except that @a callback is also told the tag of
+ * the input.  Inputs are processed several at a time, a byte from each in
+ * turn, so that the memory accesses of one input overlap those of others.
+ * As such, outputs of different inputs are interleaved.
+ *
+ * An input for which no next state can be reached simply ends; it does not
+ * end the batch.
+ *
+ * If an error is reported, a message may be available via ia_eudoxus_error().
+ *
+ * @param[in] eudoxus       Engine to execute.
+ * @param[in] inputs        Inputs to execute on.
+ * @param[in] num_inputs    Number of elements of @a inputs, counting each
+ *                          segment.  @c continued of the last is ignored.
+ * @param[in] callback      Callback to be called for each output of each
+ *                          entered state.  May be NULL.
+ * @param[in] callback_data Data to pass to @a callback.
+ * @return
+ * - IA_EUDOXUS_OK if all inputs were consumed or ended.
+ * - IA_EUDOXUS_EINVAL if @a eudoxus or @a inputs is NULL, an input has
+ *   NULL data but positive length, or a corrupt engine or automata is
+ *   detected.
+ * - IA_EUDOXUS_STOP if callback returned IA_EUDOXUS_CMD_STOP.  Remaining
+ *   input is not processed.
+ * - IA_EUDOXUS_ERROR if callback returned IA_EUDOXUS_CMD_ERROR.  Remaining
+ *   input is not processed.
+ * - IA_EUDOXUS_EINSANE on insanity error; please report as bug along with
+ *   message.
+ */
+ia_eudoxus_result_t ia_eudoxus_execute_batch(
+    ia_eudoxus_t                *eudoxus,
+    const ia_eudoxus_input_t    *inputs,
+    size_t                       num_inputs,
+    ia_eudoxus_batch_callback_t  callback,
+    void                        *callback_data
+);
+
 /**
  * Set error for @a eudoxus to @a message (claim ownership version).
  *
@@ -54,7 +54,7 @@ extern "C" {
  * This is checked by @c ia_eudoxus_create_ methods to insure that an automata
  * was generated for the current engine.
  */
-#define IA_EUDOXUS_VERSION 10
+#define IA_EUDOXUS_VERSION 11
 
 /**
  * A Eudoxus Automata.
@@ -283,7 +283,6 @@ namespace Eudoxus {
  * - @c id_t
  * - @c output_t
  * - @c low_node_t
- * - @c low_edge_t
  */
 template <size_t id_width>
 struct subengine_traits
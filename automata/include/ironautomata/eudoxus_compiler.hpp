@@ -52,6 +52,7 @@ struct configuration_t
      * - id_width = 0, i.e., minimal.
      * - align_to = 1, i.e., no alignment
      * - high_node_weight = 1.0, i.e., optimize space
+     * - dense_depth = 0, i.e., no dense nodes
      */
     configuration_t();
 
@@ -107,6 +108,18 @@ struct configuration_t
      * for very low degree.
      */
     double high_node_weight;
+
+    /**
+     * Dense Depth
+     *
+     * Nodes closer than this to the start node are compiled as dense nodes
+     * if they have a default target: high nodes with a target for every
+     * input, so that each transition is a single table lookup.  Each dense
+     * node costs 256 identifiers.  Shallow nodes are visited for almost
+     * every input byte, so a small value, e.g., 1 or 2, trades a little
+     * space for speed.  A value of 0 disables dense nodes.
+     */
+    size_t dense_depth;
 };
 
 /**
@@ -132,6 +145,12 @@ struct result_t
     //! Bytes of high nodes.
     size_t high_nodes_bytes;
 
+    //! Number of dense nodes.
+    size_t dense_nodes;
+
+    //! Bytes of dense nodes.
+    size_t dense_nodes_bytes;
+
     //! Number of low nodes.
     size_t low_nodes;
 
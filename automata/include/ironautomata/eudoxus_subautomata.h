@@ -50,13 +50,6 @@ struct IA_EUDOXUS(output_list_t)
 
 /* Low Degree Nodes */
 
-typedef struct IA_EUDOXUS(low_edge_t) IA_EUDOXUS(low_edge_t);
-struct IA_EUDOXUS(low_edge_t)
-{
-    uint8_t         c;
-    IA_EUDOXUS_ID_T next_node;
-} __attribute((packed));
-
 typedef struct IA_EUDOXUS(low_node_t) IA_EUDOXUS(low_node_t);
 struct IA_EUDOXUS(low_node_t)
 {
@@ -83,16 +76,22 @@ struct IA_EUDOXUS(low_node_t)
     /*
      * Number of edges, not including default.
      *
-     * I.e., the size of advance and edges.
+     * I.e., the size of advance, keys, and targets.
      */
     /*
     uint8_t out_degree if has_edges
     */
 
     /*
-    IA_EUDOXUS_ID_T default_node          if has_defaults
-    uint8_t         advance[out_degree/8] if has_nonadvancing & has_edges
-    low_edge_t      edges[]
+     * Edges are stored as parallel arrays: the input byte of edge i is
+     * keys[i] and its target is targets[i].  Keeping the keys contiguous
+     * allows them to be searched several at a time.
+     */
+    /*
+    IA_EUDOXUS_ID_T default_node                  if has_defaults
+    uint8_t         advance[(out_degree + 7) / 8] if has_nonadvancing & has_edges
+    uint8_t         keys[out_degree]              if has_edges
+    IA_EUDOXUS_ID_T targets[out_degree]           if has_edges
     */
 } __attribute((packed));
 
@@ -240,7 +239,6 @@ struct subengine_traits<sizeof(IA_EUDOXUS_ID_T)>
 {
     typedef IA_EUDOXUS_ID_T           id_t;
     typedef IA_EUDOXUS(output_list_t) output_list_t;
-    typedef IA_EUDOXUS(low_edge_t)    low_edge_t;
     typedef IA_EUDOXUS(low_node_t)    low_node_t;
     typedef IA_EUDOXUS(high_node_t)   high_node_t;
     typedef IA_EUDOXUS(pc_node_t)     pc_node_t;
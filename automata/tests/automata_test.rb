@@ -89,14 +89,14 @@ module AutomataTest
     parse_ee_output(IO.read(output_path))
   end
 
-  def ac_test(words, text, prefix = "ac_test", optimize = false)
-    automata_test(words, ACGEN, prefix, optimize) do |dir, eudoxus_path|
+  def ac_test(words, text, prefix = "ac_test", optimize = false, ec_args = [])
+    automata_test(words, ACGEN, prefix, optimize, ec_args) do |dir, eudoxus_path|
       output_substrings = ee(eudoxus_path, dir, text)
       assert_substrings_equal(substrings(words, text), output_substrings)
     end
   end
 
-  def automata_test(words, generator, prefix = "automata_test", optimize = false)
+  def automata_test(words, generator, prefix = "automata_test", optimize = false, ec_args = [])
     dir = File.join(BUILDDIR, "automata_test_#{prefix}#{$$}.#{rand(100000)}")
     Dir.mkdir(dir)
     puts "Test files are in #{dir}"
@@ -120,7 +120,7 @@ module AutomataTest
     end
 
     eudoxus_path = File.join(dir, "eudoxus")
-    result = mysystem(EC, "-i", automata_path, "-o", eudoxus_path)
+    result = mysystem(EC, "-i", automata_path, "-o", eudoxus_path, *ec_args)
     assert(result, "EC failed.")
 
     if block_given?
@@ -114,6 +114,45 @@ class TestBasic < CLIPPTest::TestCase
     end
   end
 
+  def test_dense
+    n = 200
+
+    words = Set.new
+    while words.size < n
+      words << random_word(10)
+    end
+    words = words.to_a
+
+    text = words.join(" ")
+
+    ac_test(words, text, "dense", false, ["-d", "3"])
+    ac_test(words, text, "dense_fast", :fast, ["-d", "3"])
+  end
+
+  def test_low_wide
+    # Force low nodes so that nodes with many edges are searched in blocks.
+    words = []
+    ('a'..'z').each do |x|
+      ('a'..'z').each do |y|
+        words << "#{x}#{y}q"
+      end
+    end
+    text = words.join(" ")
+
+    ac_test(words, text, "low_wide", false, ["-h", "4000"])
+    ac_test(words, text, "low_wide_fast", :fast, ["-h", "4000"])
+  end
+
+  def test_mmap
+    words = ["he", "she", "his", "hers"]
+    text = "she saw his world as he saw hers..."
+
+    automata_test(words, ACGEN, "mmap") do |dir, eudoxus_path|
+      output_substrings = ee(eudoxus_path, dir, text, "input", "output", "auto", ["-m"])
+      assert_substrings_equal(substrings(words, text), output_substrings)
+    end
+  end
+
   def test_foo
     words = ["forb"]
     text = "aaa ford bbb"
@@ -0,0 +1,440 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronAutomata --- Eudoxus execution test.
+ *
+ * @author Christopher Alfeld <calfeld@qualys.com>
+ **/
+
+#include <ironautomata/eudoxus.h>
+#include <ironautomata/eudoxus_compiler.hpp>
+#include <ironautomata/generator/aho_corasick.hpp>
+#include <ironautomata/optimize_edges.hpp>
+
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace IronAutomata;
+
+namespace {
+
+//! A match: input index, end offset, and matched length.
+struct match_t
+{
+    size_t   input;
+    size_t   offset;
+    uint32_t length;
+
+    bool operator<(const match_t& other) const
+    {
+        if (input != other.input) {
+            return input < other.input;
+        }
+        if (offset != other.offset) {
+            return offset < other.offset;
+        }
+        return length < other.length;
+    }
+
+    bool operator==(const match_t& other) const
+    {
+        return
+            input  == other.input  &&
+            offset == other.offset &&
+            length == other.length;
+    }
+};
+
+typedef set<match_t> matches_t;
+
+//! Callback data of single_callback().
+struct single_data_t
+{
+    matches_t*     matches;
+    size_t         input;
+    const uint8_t* data;
+};
+
+ia_eudoxus_command_t single_callback(
+    ia_eudoxus_t*  engine,
+    const char*    output,
+    size_t         output_length,
+    const uint8_t* input_location,
+    void*          callback_data
+)
+{
+    single_data_t* d = reinterpret_cast<single_data_t*>(callback_data);
+    match_t m;
+    EXPECT_EQ(sizeof(uint32_t), output_length);
+    memcpy(&m.length, output, sizeof(m.length));
+    m.input = d->input;
+    m.offset = input_location - d->data;
+    d->matches->insert(m);
+    return IA_EUDOXUS_CMD_CONTINUE;
+}
+
+//! Callback data of batch_callback().
+struct batch_data_t
+{
+    matches_t*                        matches;
+    const vector<ia_eudoxus_input_t>* inputs;
+};
+
+ia_eudoxus_command_t batch_callback(
+    ia_eudoxus_t*  engine,
+    const char*    output,
+    size_t         output_length,
+    const uint8_t* input_location,
+    void*          tag,
+    void*          callback_data
+)
+{
+    batch_data_t* d = reinterpret_cast<batch_data_t*>(callback_data);
+    match_t m;
+    EXPECT_EQ(sizeof(uint32_t), output_length);
+    memcpy(&m.length, output, sizeof(m.length));
+    m.input = reinterpret_cast<size_t>(tag);
+    m.offset = input_location - (*d->inputs)[m.input].data;
+    d->matches->insert(m);
+    return IA_EUDOXUS_CMD_CONTINUE;
+}
+
+ia_eudoxus_command_t stop_callback(
+    ia_eudoxus_t*  engine,
+    const char*    output,
+    size_t         output_length,
+    const uint8_t* input_location,
+    void*          tag,
+    void*          callback_data
+)
+{
+    ++*reinterpret_cast<size_t*>(callback_data);
+    return IA_EUDOXUS_CMD_STOP;
+}
+
+//! Compile Aho-Corasick automata of @a words.
+EudoxusCompiler::result_t compile_words(
+    const vector<string>&                  words,
+    const EudoxusCompiler::configuration_t configuration =
+        EudoxusCompiler::configuration_t()
+)
+{
+    Intermediate::Automata a;
+    Generator::aho_corasick_begin(a);
+    for (size_t i = 0; i < words.size(); ++i) {
+        Generator::aho_corasick_add_length(a, words[i]);
+    }
+    Generator::aho_corasick_finish(a);
+    Intermediate::breadth_first(a, Intermediate::optimize_edges);
+
+    return EudoxusCompiler::compile(a, configuration);
+}
+
+//! Build Eudoxus engine for Aho-Corasick automata of @a words.
+ia_eudoxus_t* build(
+    const vector<string>&                  words,
+    const EudoxusCompiler::configuration_t configuration =
+        EudoxusCompiler::configuration_t()
+)
+{
+    EudoxusCompiler::result_t result = compile_words(words, configuration);
+
+    // Engine takes ownership of data.
+    char* data = reinterpret_cast<char*>(malloc(result.buffer.size()));
+    memcpy(data, &result.buffer[0], result.buffer.size());
+
+    ia_eudoxus_t* eudoxus = NULL;
+    EXPECT_EQ(IA_EUDOXUS_OK, ia_eudoxus_create(&eudoxus, data));
+    return eudoxus;
+}
+
+//! Compare batch execution of @a texts to individual execution.
+void compare(ia_eudoxus_t* eudoxus, const vector<string>& texts)
+{
+    vector<ia_eudoxus_input_t> inputs;
+    matches_t expected;
+    matches_t actual;
+
+    for (size_t i = 0; i < texts.size(); ++i) {
+        ia_eudoxus_input_t input;
+        input.data = reinterpret_cast<const uint8_t*>(texts[i].data());
+        input.length = texts[i].length();
+        input.tag = reinterpret_cast<void*>(i);
+        input.continued = false;
+        inputs.push_back(input);
+
+        single_data_t d = {&expected, i, input.data};
+        ia_eudoxus_state_t* state = NULL;
+        ASSERT_EQ(
+            IA_EUDOXUS_OK,
+            ia_eudoxus_create_state(&state, eudoxus, single_callback, &d)
+        );
+        ASSERT_EQ(
+            IA_EUDOXUS_OK,
+            ia_eudoxus_execute(state, input.data, input.length)
+        );
+        ia_eudoxus_destroy_state(state);
+    }
+
+    batch_data_t d = {&actual, &inputs};
+    ASSERT_EQ(
+        IA_EUDOXUS_OK,
+        ia_eudoxus_execute_batch(
+            eudoxus,
+            &inputs[0], inputs.size(),
+            batch_callback, &d
+        )
+    );
+
+    EXPECT_FALSE(expected.empty());
+    EXPECT_EQ(expected.size(), actual.size());
+    EXPECT_TRUE(expected == actual);
+
+    // Again, with each text split into segments, including empty ones.
+    // The segments are slices of the text, so offsets are unchanged.
+    vector<ia_eudoxus_input_t> segments;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        const ia_eudoxus_input_t& input = inputs[i];
+        const size_t split = input.length / 3;
+        ia_eudoxus_input_t segment = input;
+
+        segment.continued = true;
+        segment.length = split;
+        segments.push_back(segment);
+        segment.data += split;
+        segment.length = 0;
+        segments.push_back(segment);
+        segment.length = input.length - split;
+        segment.continued = false;
+        segments.push_back(segment);
+    }
+
+    actual.clear();
+    ASSERT_EQ(
+        IA_EUDOXUS_OK,
+        ia_eudoxus_execute_batch(
+            eudoxus,
+            &segments[0], segments.size(),
+            batch_callback, &d
+        )
+    );
+
+    EXPECT_EQ(expected.size(), actual.size());
+    EXPECT_TRUE(expected == actual);
+}
+
+vector<string> words()
+{
+    vector<string> w;
+    w.push_back("he");
+    w.push_back("she");
+    w.push_back("his");
+    w.push_back("hers");
+    w.push_back("a rather long pattern to compress");
+    return w;
+}
+
+vector<string> texts()
+{
+    vector<string> t;
+    t.push_back("she saw his world as he saw hers...");
+    t.push_back("");
+    t.push_back("hers");
+    t.push_back("nothing");
+    t.push_back("a rather long pattern to compress, twice: "
+                "a rather long pattern to compress");
+    t.push_back("h");
+    t.push_back("ushers");
+    t.push_back("he");
+    t.push_back("");
+    t.push_back("this is his");
+    return t;
+}
+
+}
+
+TEST(TestEudoxus, ExecuteBatch)
+{
+    ia_eudoxus_t* eudoxus = build(words());
+    ASSERT_TRUE(eudoxus);
+    compare(eudoxus, texts());
+    ia_eudoxus_destroy(eudoxus);
+}
+
+TEST(TestEudoxus, ExecuteBatchNodeTypes)
+{
+    EudoxusCompiler::configuration_t configuration;
+
+    // All low nodes, with wide ids.
+    configuration.id_width = 8;
+    configuration.high_node_weight = 4000;
+    ia_eudoxus_t* eudoxus = build(words(), configuration);
+    ASSERT_TRUE(eudoxus);
+    compare(eudoxus, texts());
+    ia_eudoxus_destroy(eudoxus);
+
+    // Dense nodes near the start, high nodes elsewhere.
+    configuration.id_width = 0;
+    configuration.high_node_weight = 0;
+    configuration.dense_depth = 2;
+    eudoxus = build(words(), configuration);
+    ASSERT_TRUE(eudoxus);
+    compare(eudoxus, texts());
+    ia_eudoxus_destroy(eudoxus);
+}
+
+TEST(TestEudoxus, ExecuteBatchStop)
+{
+    ia_eudoxus_t* eudoxus = build(words());
+    ASSERT_TRUE(eudoxus);
+
+    vector<string> t = texts();
+    vector<ia_eudoxus_input_t> inputs;
+    for (size_t i = 0; i < t.size(); ++i) {
+        ia_eudoxus_input_t input;
+        input.data = reinterpret_cast<const uint8_t*>(t[i].data());
+        input.length = t[i].length();
+        input.tag = NULL;
+        input.continued = false;
+        inputs.push_back(input);
+    }
+
+    size_t calls = 0;
+    EXPECT_EQ(
+        IA_EUDOXUS_STOP,
+        ia_eudoxus_execute_batch(
+            eudoxus,
+            &inputs[0], inputs.size(),
+            stop_callback, &calls
+        )
+    );
+    EXPECT_EQ(1UL, calls);
+
+    EXPECT_EQ(
+        IA_EUDOXUS_OK,
+        ia_eudoxus_execute_batch(
+            eudoxus,
+            &inputs[0], inputs.size(),
+            NULL, NULL
+        )
+    );
+
+    EXPECT_EQ(
+        IA_EUDOXUS_EINVAL,
+        ia_eudoxus_execute_batch(eudoxus, NULL, 0, NULL, NULL)
+    );
+
+    ia_eudoxus_destroy(eudoxus);
+}
+
+TEST(TestEudoxus, MappedTruncated)
+{
+    EudoxusCompiler::result_t result = compile_words(words());
+    char path[] = "/tmp/test_eudoxus.XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_LE(0, fd);
+    ia_eudoxus_t* eudoxus = NULL;
+
+    /* A file shorter than the automata header is rejected. */
+    ASSERT_EQ(4, write(fd, &result.buffer[0], 4));
+    EXPECT_EQ(
+        IA_EUDOXUS_EINVAL,
+        ia_eudoxus_create_from_path_mapped(&eudoxus, path, 0)
+    );
+    EXPECT_FALSE(eudoxus);
+    ASSERT_EQ(0, ftruncate(fd, 0));
+    ASSERT_EQ(0, lseek(fd, 0, SEEK_SET));
+
+    /* A file shorter than the automata it declares is rejected rather than
+     * read past its end. */
+    ASSERT_EQ(
+        ssize_t(result.buffer.size() - 1),
+        write(fd, &result.buffer[0], result.buffer.size() - 1)
+    );
+    EXPECT_EQ(
+        IA_EUDOXUS_EINVAL,
+        ia_eudoxus_create_from_path_mapped(&eudoxus, path, 0)
+    );
+    EXPECT_FALSE(eudoxus);
+
+    /* The whole automata maps fine. */
+    ASSERT_EQ(1, write(fd, &result.buffer[result.buffer.size() - 1], 1));
+    EXPECT_EQ(
+        IA_EUDOXUS_OK,
+        ia_eudoxus_create_from_path_mapped(&eudoxus, path, 0)
+    );
+    ASSERT_TRUE(eudoxus);
+    compare(eudoxus, texts());
+    ia_eudoxus_destroy(eudoxus);
+
+    close(fd);
+    unlink(path);
+}
+
+TEST(TestEudoxus, MappedReplacedByRename)
+{
+    EudoxusCompiler::result_t result = compile_words(words());
+    char path[] = "/tmp/test_eudoxus.XXXXXX";
+    char new_path[] = "/tmp/test_eudoxus.XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_LE(0, fd);
+    ASSERT_EQ(
+        ssize_t(result.buffer.size()),
+        write(fd, &result.buffer[0], result.buffer.size())
+    );
+    close(fd);
+
+    ia_eudoxus_t* old_eudoxus = NULL;
+    ASSERT_EQ(
+        IA_EUDOXUS_OK,
+        ia_eudoxus_create_from_path_mapped(&old_eudoxus, path, 0)
+    );
+
+    /* Replacing the file by rename leaves the old image intact and later
+     * loads map the new file. */
+    fd = mkstemp(new_path);
+    ASSERT_LE(0, fd);
+    ASSERT_EQ(
+        ssize_t(result.buffer.size()),
+        write(fd, &result.buffer[0], result.buffer.size())
+    );
+    close(fd);
+    ASSERT_EQ(0, rename(new_path, path));
+
+    ia_eudoxus_t* new_eudoxus = NULL;
+    ASSERT_EQ(
+        IA_EUDOXUS_OK,
+        ia_eudoxus_create_from_path_mapped(&new_eudoxus, path, 0)
+    );
+    unlink(path);
+
+    compare(old_eudoxus, texts());
+    compare(new_eudoxus, texts());
+
+    ia_eudoxus_destroy(old_eudoxus);
+    compare(new_eudoxus, texts());
+    ia_eudoxus_destroy(new_eudoxus);
+}
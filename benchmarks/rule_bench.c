@@ -0,0 +1,855 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Rule Engine Benchmark
+ *
+ * This program measures the rule engine in process.  It creates an engine
+ * with ib_engine_create(), configures it with a generated ruleset of
+ * configurable size and shape, and then drives synthetic transactions
+ * through the ib_state_notify_*() API, in the same order clipp does.
+ *
+ * The ruleset cycles through the requested operators (streq, rx, pm and
+ * dfa), spreads the rules over the four rule phases, optionally adds
+ * transformations to each rule and chains every Nth rule to the next.  About
+ * one rule in ten matches the synthetic traffic.
+ *
+ * It reports:
+ * - Transactions per second.
+ * - The 50th and 99th percentile latency of each phase of a transaction.
+ * - Bytes allocated from the transaction memory pool per transaction.
+ *
+ * Run with -h for options.  Use -p to print the generated configuration.
+ **/
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/config.h>
+#include <ironbee/engine.h>
+#include <ironbee/mpool.h>
+#include <ironbee/state_notify.h>
+#include <ironbee/string.h>
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef BENCH_MODULE_PATH
+/** Where to load modules from, if not given on the command line. */
+#define BENCH_MODULE_PATH MODULE_BASE_PATH
+#endif
+
+/** Percent of rules which match the synthetic traffic. */
+#define BENCH_MATCH_PERCENT 10
+
+/**
+ * Phases of a transaction that are timed separately.
+ **/
+typedef enum {
+    BENCH_PHASE_REQUEST_HEADER,  /**< Request line and headers. */
+    BENCH_PHASE_REQUEST,         /**< Request body and finished. */
+    BENCH_PHASE_RESPONSE_HEADER, /**< Response line and headers. */
+    BENCH_PHASE_RESPONSE,        /**< Response body, finished and cleanup. */
+    BENCH_PHASE_TOTAL,           /**< The whole transaction. */
+    BENCH_NUM_PHASES
+} bench_phase_t;
+
+/** Names of @ref bench_phase_t values. */
+static const char *c_phase_names[BENCH_NUM_PHASES] = {
+    "request_header",
+    "request",
+    "response_header",
+    "response",
+    "total"
+};
+
+/** Rule phase, target and a matching value for each @ref bench_phase_t. */
+static const struct {
+    const char *phase;
+    const char *target;
+    const char *value;
+} c_rule_targets[] = {
+    { "REQUEST_HEADER",  "REQUEST_HEADERS:User-Agent",    "benchagent"  },
+    { "REQUEST",         "ARGS:q",                        "benchquery"  },
+    { "RESPONSE_HEADER", "RESPONSE_HEADERS:Server",       "benchserver" },
+    { "RESPONSE",        "RESPONSE_HEADERS:Content-Type", "text/html"   }
+};
+
+/**
+ * Operators the ruleset is built from.
+ **/
+typedef enum {
+    BENCH_OP_STREQ,
+    BENCH_OP_RX,
+    BENCH_OP_PM,
+    BENCH_OP_DFA
+} bench_op_t;
+
+/** Names of @ref bench_op_t values, as given with -o. */
+static const char *c_op_names[] = { "streq", "rx", "pm", "dfa" };
+
+/** Transformations which may be applied, in order. */
+static const char *c_tfn_names[] = {
+    "lowercase", "trim", "compressWhitespace", "urlDecode"
+};
+
+/**
+ * Benchmark options.
+ **/
+typedef struct {
+    size_t      num_tx;          /**< Transactions to measure. */
+    size_t      num_warmup;      /**< Transactions to run first, unmeasured. */
+    size_t      tx_per_conn;     /**< Transactions per connection. */
+    size_t      num_rules;       /**< Rules to generate. */
+    size_t      num_tfns;        /**< Transformations per rule. */
+    size_t      chain_every;     /**< Chain every Nth rule; 0 for none. */
+    bench_op_t  ops[4];          /**< Operators to cycle through. */
+    size_t      num_ops;         /**< Number of ops. */
+    const char *module_path;     /**< Module base path. */
+    const char *extra_config;    /**< Extra configuration file or NULL. */
+    bool        print_config;    /**< Print the generated configuration. */
+} bench_options_t;
+
+/**
+ * Growable string buffer.
+ **/
+typedef struct {
+    char   *data;  /**< NUL terminated contents. */
+    size_t  len;   /**< Length of data. */
+    size_t  size;  /**< Allocated size of data. */
+} bench_buf_t;
+
+/**
+ * Timing samples.
+ **/
+typedef struct {
+    uint64_t *samples[BENCH_NUM_PHASES]; /**< Nanoseconds, per phase. */
+    size_t    count;                     /**< Samples per phase. */
+    uint64_t  bytes;                     /**< Transaction bytes allocated. */
+} bench_stats_t;
+
+/**
+ * Print usage and exit.
+ *
+ * @param[in] prog Program name.
+ **/
+static void usage(const char *prog)
+{
+    fprintf(
+        stderr,
+        "Usage: %s [options]\n"
+        "  -n <num>   Transactions to measure [10000].\n"
+        "  -w <num>   Warm up transactions [1000].\n"
+        "  -k <num>   Transactions per connection [10].\n"
+        "  -r <num>   Rules to generate [100].\n"
+        "  -t <num>   Transformations per rule, 0-4 [1].\n"
+        "  -c <num>   Chain every Nth rule to the next, 0 for none [0].\n"
+        "  -o <ops>   Comma separated operators from streq, rx, pm, dfa\n"
+        "             [streq,rx,pm,dfa].\n"
+        "  -M <path>  Module base path [%s].\n"
+        "  -C <file>  Additional configuration file to load.\n"
+        "  -p         Print the generated configuration.\n",
+        prog, IB_XSTRINGIFY(BENCH_MODULE_PATH)
+    );
+    exit(1);
+}
+
+/**
+ * Append formatted text to @a buf, exiting on allocation failure.
+ *
+ * @param[in,out] buf Buffer.
+ * @param[in] fmt Format.
+ **/
+static void buf_printf(bench_buf_t *buf, const char *fmt, ...)
+{
+    va_list ap;
+    int     n;
+
+    for (;;) {
+        size_t avail = buf->size - buf->len;
+
+        va_start(ap, fmt);
+        n = vsnprintf(buf->data + buf->len, avail, fmt, ap);
+        va_end(ap);
+        if (n < 0) {
+            fprintf(stderr, "Error formatting configuration.\n");
+            exit(1);
+        }
+        if ((size_t)n < avail) {
+            buf->len += n;
+            return;
+        }
+
+        buf->size = (buf->size + n + 1) * 2;
+        buf->data = realloc(buf->data, buf->size);
+        if (buf->data == NULL) {
+            fprintf(stderr, "Out of memory.\n");
+            exit(1);
+        }
+    }
+}
+
+/**
+ * Parse the -o option.
+ *
+ * @param[out] options Options to set ops in.
+ * @param[in] arg Comma separated operator names.
+ *
+ * @returns true on success.
+ **/
+static bool parse_ops(bench_options_t *options, const char *arg)
+{
+    const char *p = arg;
+
+    options->num_ops = 0;
+    while (*p != '\0') {
+        size_t len = strcspn(p, ",");
+        size_t i;
+
+        for (i = 0; i < sizeof(c_op_names) / sizeof(*c_op_names); ++i) {
+            if (strlen(c_op_names[i]) == len &&
+                strncmp(c_op_names[i], p, len) == 0)
+            {
+                break;
+            }
+        }
+        if (i == sizeof(c_op_names) / sizeof(*c_op_names) ||
+            options->num_ops == sizeof(options->ops) / sizeof(*options->ops))
+        {
+            return false;
+        }
+        options->ops[options->num_ops++] = (bench_op_t)i;
+
+        p += len;
+        if (*p == ',') {
+            ++p;
+        }
+    }
+
+    return options->num_ops > 0;
+}
+
+/**
+ * Append the operator and argument of rule @a n to @a buf.
+ *
+ * @param[in,out] buf Buffer.
+ * @param[in] op Operator.
+ * @param[in] value Value to match, or NULL to generate one which does not.
+ * @param[in] n Rule number.
+ **/
+static void generate_operator(
+    bench_buf_t *buf,
+    bench_op_t   op,
+    const char  *value,
+    size_t       n
+)
+{
+    switch (op) {
+    case BENCH_OP_STREQ:
+        if (value != NULL) {
+            buf_printf(buf, "@streq \"%s\"", value);
+        }
+        else {
+            buf_printf(buf, "@streq \"nomatch%zu\"", n);
+        }
+        break;
+    case BENCH_OP_RX:
+        if (value != NULL) {
+            buf_printf(buf, "@rx \"^%.4s.*\"", value);
+        }
+        else {
+            buf_printf(buf, "@rx \"nomatch%zu[0-9]+x\"", n);
+        }
+        break;
+    case BENCH_OP_PM:
+        /* The core "match" operator is the multi-pattern string match. */
+        buf_printf(buf, "@match \"alpha%zu beta%zu gamma%zu %s\"",
+                   n, n, n, value != NULL ? value : "delta");
+        break;
+    case BENCH_OP_DFA:
+        if (value != NULL) {
+            buf_printf(buf, "@dfa \"%.4s\"", value + 1);
+        }
+        else {
+            buf_printf(buf, "@dfa \"nomatch%zu\"", n);
+        }
+        break;
+    }
+}
+
+/**
+ * Generate the configuration.
+ *
+ * @param[in] options Options.
+ *
+ * @returns NUL terminated configuration; free with free().
+ **/
+static char *generate_config(const bench_options_t *options)
+{
+    bench_buf_t buf = { NULL, 0, 0 };
+    size_t      num_targets = sizeof(c_rule_targets) / sizeof(*c_rule_targets);
+    bool        chained = false;
+    size_t      target = 0;
+
+    buf_printf(&buf, "ModuleBasePath \"%s\"\n", options->module_path);
+    buf_printf(&buf,
+        "LoadModule \"ibmod_htp.so\"\n"
+        "LoadModule \"ibmod_pcre.so\"\n"
+        "LoadModule \"ibmod_rules.so\"\n"
+        "SensorId AAAABBBB-1111-2222-3333-000000000000\n"
+        "SensorName RuleBench\n"
+        "SensorHostname rule-bench.sensor.tld\n"
+        "LogLevel error\n"
+        "RuleEngineLogLevel error\n"
+        "InitVar BENCH_HITS 0\n"
+    );
+
+    for (size_t n = 0; n < options->num_rules; ++n) {
+        bench_op_t  op = options->ops[n % options->num_ops];
+        bool        matches = (n * BENCH_MATCH_PERCENT) % 100 == 0;
+        bool        chains = (options->chain_every > 0 &&
+                              (n + 1) % options->chain_every == 0 &&
+                              n + 1 < options->num_rules);
+
+        /* Chained rules share the phase of the rule they follow. */
+        if (! chained) {
+            target = n % num_targets;
+        }
+
+        buf_printf(&buf, "Rule %s ", c_rule_targets[target].target);
+        generate_operator(
+            &buf, op,
+            matches || chained ? c_rule_targets[target].value : NULL,
+            n);
+        if (! chained) {
+            buf_printf(&buf, " id:bench/%zu rev:1 phase:%s",
+                       n, c_rule_targets[target].phase);
+        }
+        for (size_t i = 0; i < options->num_tfns; ++i) {
+            buf_printf(&buf, " t:%s", c_tfn_names[i]);
+        }
+        if (chains) {
+            buf_printf(&buf, " chain");
+        }
+        else {
+            buf_printf(&buf, " setvar:BENCH_HITS+=1");
+        }
+        buf_printf(&buf, "\n");
+
+        chained = chains;
+    }
+
+    if (options->extra_config != NULL) {
+        buf_printf(&buf, "Include \"%s\"\n", options->extra_config);
+    }
+
+    buf_printf(&buf,
+        "<Site default>\n"
+        "    SiteId AAAABBBB-1111-2222-3333-000000000001\n"
+        "    Hostname *\n"
+        "    RuleEnable all\n"
+        "</Site>\n"
+    );
+
+    return buf.data;
+}
+
+/**
+ * Create and configure the engine.
+ *
+ * @param[out] engine Engine created.
+ * @param[in] server Server.
+ * @param[in] config Configuration text.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - Error code on any failure.
+ **/
+static ib_status_t create_engine(
+    ib_engine_t       **engine,
+    const ib_server_t  *server,
+    const char         *config
+)
+{
+    ib_cfgparser_t *parser;
+    ib_status_t     rc;
+
+    rc = ib_engine_create(engine, server);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_cfgparser_create(&parser, *engine);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_engine_config_started(*engine, parser);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_cfgparser_parse_buffer(parser, config, strlen(config), false);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_engine_config_finished(*engine);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    ib_cfgparser_destroy(parser);
+
+    return IB_OK;
+}
+
+/**
+ * Build headers from a NULL terminated list of name/value pairs.
+ *
+ * @param[out] headers Headers created.
+ * @param[in] mm Memory manager.
+ * @param[in] pairs Name, value, name, value, ..., NULL.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - Error code on any failure.
+ **/
+static ib_status_t make_headers(
+    ib_parsed_headers_t **headers,
+    ib_mm_t               mm,
+    const char * const   *pairs
+)
+{
+    ib_status_t rc;
+
+    rc = ib_parsed_headers_create(headers, mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    for (; *pairs != NULL; pairs += 2) {
+        rc = ib_parsed_headers_add(*headers,
+                                   IB_S2SL(pairs[0]), IB_S2SL(pairs[1]));
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    return IB_OK;
+}
+
+/** Request headers of every transaction. */
+static const char * const c_request_headers[] = {
+    "Host",           "bench.example.com",
+    "User-Agent",     "benchagent",
+    "Accept",         "*/*",
+    "Cookie",         "session=0123456789abcdef; theme=dark",
+    "Content-Type",   "application/x-www-form-urlencoded",
+    "Content-Length", "30",
+    NULL
+};
+
+/** Request body of every transaction. */
+static const char c_request_body[] = "user=bench&comment=Hello+World";
+
+/** Response headers of every transaction. */
+static const char * const c_response_headers[] = {
+    "Server",         "benchserver",
+    "Content-Type",   "text/html",
+    "Content-Length", "27",
+    NULL
+};
+
+/** Response body of every transaction. */
+static const char c_response_body[] = "<html>Bench response</html>";
+
+/**
+ * Current time in nanoseconds.
+ *
+ * @returns Monotonic time.
+ **/
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * Send one transaction.
+ *
+ * @param[in] engine Engine.
+ * @param[in] conn Connection.
+ * @param[in] stats Where to record samples or NULL not to.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - Error code on any failure.
+ **/
+static ib_status_t send_tx(
+    ib_engine_t   *engine,
+    ib_conn_t     *conn,
+    bench_stats_t *stats
+)
+{
+    ib_tx_t               *tx;
+    ib_parsed_req_line_t  *req_line;
+    ib_parsed_resp_line_t *resp_line;
+    ib_parsed_headers_t   *headers;
+    uint64_t               t[BENCH_NUM_PHASES + 1];
+    ib_status_t            rc;
+
+    t[0] = now_ns();
+
+    rc = ib_tx_create(&tx, conn, NULL);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    /* Request header. */
+    rc = ib_parsed_req_line_create(
+        &req_line, tx->mm,
+        IB_S2SL("POST /bench/path?q=benchquery&id=42 HTTP/1.1"),
+        IB_S2SL("POST"),
+        IB_S2SL("/bench/path?q=benchquery&id=42"),
+        IB_S2SL("HTTP/1.1"));
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_state_notify_request_started(engine, tx, req_line);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = make_headers(&headers, tx->mm, c_request_headers);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_state_notify_request_header_data(engine, tx, headers);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_state_notify_request_header_finished(engine, tx);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    t[1] = now_ns();
+
+    /* Request body. */
+    rc = ib_state_notify_request_body_data(
+        engine, tx, c_request_body, sizeof(c_request_body) - 1);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_state_notify_request_finished(engine, tx);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    t[2] = now_ns();
+
+    /* Response header. */
+    rc = ib_parsed_resp_line_create(
+        &resp_line, tx->mm,
+        IB_S2SL("HTTP/1.1 200 OK"),
+        IB_S2SL("HTTP/1.1"),
+        IB_S2SL("200"),
+        IB_S2SL("OK"));
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_state_notify_response_started(engine, tx, resp_line);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = make_headers(&headers, tx->mm, c_response_headers);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_state_notify_response_header_data(engine, tx, headers);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_state_notify_response_header_finished(engine, tx);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    t[3] = now_ns();
+
+    /* Response body. */
+    rc = ib_state_notify_response_body_data(
+        engine, tx, c_response_body, sizeof(c_response_body) - 1);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_state_notify_response_finished(engine, tx);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    if (stats != NULL) {
+        stats->bytes += ib_mpool_inuse(tx->mp);
+    }
+
+    ib_tx_destroy(tx);
+    t[4] = now_ns();
+
+    if (stats != NULL) {
+        for (int i = 0; i < BENCH_PHASE_TOTAL; ++i) {
+            stats->samples[i][stats->count] = t[i + 1] - t[i];
+        }
+        stats->samples[BENCH_PHASE_TOTAL][stats->count] = t[4] - t[0];
+        ++(stats->count);
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Run @a num_tx transactions.
+ *
+ * @param[in] engine Engine.
+ * @param[in] num_tx Number of transactions.
+ * @param[in] tx_per_conn Transactions per connection.
+ * @param[in] stats Where to record samples or NULL not to.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - Error code on any failure.
+ **/
+static ib_status_t run(
+    ib_engine_t   *engine,
+    size_t         num_tx,
+    size_t         tx_per_conn,
+    bench_stats_t *stats
+)
+{
+    size_t      sent = 0;
+    ib_status_t rc;
+
+    while (sent < num_tx) {
+        ib_conn_t *conn;
+
+        rc = ib_conn_create(engine, &conn, NULL);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        conn->local_ipstr  = "10.0.0.1";
+        conn->local_port   = 80;
+        conn->remote_ipstr = "10.0.0.2";
+        conn->remote_port  = 40000;
+
+        rc = ib_state_notify_conn_opened(engine, conn);
+        if (rc != IB_OK) {
+            return rc;
+        }
+
+        for (size_t i = 0; i < tx_per_conn && sent < num_tx; ++i, ++sent) {
+            rc = send_tx(engine, conn, stats);
+            if (rc != IB_OK) {
+                return rc;
+            }
+        }
+
+        rc = ib_state_notify_conn_closed(engine, conn);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        ib_conn_destroy(conn);
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Compare two uint64_t for qsort().
+ **/
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a;
+    uint64_t y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * Get percentile @a p of sorted @a samples.
+ *
+ * @param[in] samples Sorted samples.
+ * @param[in] count Number of samples.
+ * @param[in] p Percentile, 0-100.
+ *
+ * @returns Sample at percentile @a p.
+ **/
+static uint64_t percentile(const uint64_t *samples, size_t count, size_t p)
+{
+    size_t i = (count * p + 99) / 100;
+
+    return samples[i == 0 ? 0 : i - 1];
+}
+
+/**
+ * Print results.
+ *
+ * @param[in] options Options.
+ * @param[in] stats Samples; sorted in place.
+ * @param[in] elapsed Wall time of the measured run, in nanoseconds.
+ **/
+static void report(
+    const bench_options_t *options,
+    bench_stats_t         *stats,
+    uint64_t               elapsed
+)
+{
+    printf("rules:        %zu (ops=", options->num_rules);
+    for (size_t i = 0; i < options->num_ops; ++i) {
+        printf("%s%s", i > 0 ? "," : "", c_op_names[options->ops[i]]);
+    }
+    printf(" tfns=%zu chain_every=%zu)\n",
+           options->num_tfns, options->chain_every);
+    printf("transactions: %zu\n", stats->count);
+    printf("tx/s:         %.1f\n",
+           (double)stats->count * 1e9 / (double)(elapsed ? elapsed : 1));
+    printf("bytes/tx:     %.1f\n",
+           (double)stats->bytes / (double)stats->count);
+    printf("%-16s %12s %12s\n", "phase", "p50 (us)", "p99 (us)");
+    for (int i = 0; i < BENCH_NUM_PHASES; ++i) {
+        qsort(stats->samples[i], stats->count, sizeof(uint64_t), cmp_u64);
+        printf("%-16s %12.2f %12.2f\n",
+               c_phase_names[i],
+               percentile(stats->samples[i], stats->count, 50) / 1000.0,
+               percentile(stats->samples[i], stats->count, 99) / 1000.0);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    ib_server_t server = {
+        IB_SERVER_HEADER_DEFAULTS,
+        "benchmarks/rule_bench",
+        NULL, NULL,
+        NULL, NULL,
+        NULL, NULL,
+        NULL, NULL,
+        NULL, NULL,
+        NULL, NULL,
+        NULL, NULL
+    };
+    bench_options_t options = {
+        .num_tx       = 10000,
+        .num_warmup   = 1000,
+        .tx_per_conn  = 10,
+        .num_rules    = 100,
+        .num_tfns     = 1,
+        .chain_every  = 0,
+        .ops          = {
+            BENCH_OP_STREQ, BENCH_OP_RX, BENCH_OP_PM, BENCH_OP_DFA
+        },
+        .num_ops      = 4,
+        .module_path  = IB_XSTRINGIFY(BENCH_MODULE_PATH),
+        .extra_config = NULL,
+        .print_config = false
+    };
+    bench_stats_t  stats;
+    ib_engine_t   *engine;
+    char          *config;
+    uint64_t       start;
+    ib_status_t    rc;
+    int            opt;
+
+    while ((opt = getopt(argc, argv, "n:w:k:r:t:c:o:M:C:ph")) != -1) {
+        switch (opt) {
+        case 'n': options.num_tx      = strtoul(optarg, NULL, 10); break;
+        case 'w': options.num_warmup  = strtoul(optarg, NULL, 10); break;
+        case 'k': options.tx_per_conn = strtoul(optarg, NULL, 10); break;
+        case 'r': options.num_rules   = strtoul(optarg, NULL, 10); break;
+        case 't': options.num_tfns    = strtoul(optarg, NULL, 10); break;
+        case 'c': options.chain_every = strtoul(optarg, NULL, 10); break;
+        case 'o':
+            if (! parse_ops(&options, optarg)) {
+                usage(argv[0]);
+            }
+            break;
+        case 'M': options.module_path  = optarg; break;
+        case 'C': options.extra_config = optarg; break;
+        case 'p': options.print_config = true; break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (options.num_tx == 0 || options.tx_per_conn == 0 ||
+        options.num_tfns > sizeof(c_tfn_names) / sizeof(*c_tfn_names))
+    {
+        usage(argv[0]);
+    }
+
+    config = generate_config(&options);
+    if (options.print_config) {
+        fputs(config, stdout);
+    }
+
+    for (int i = 0; i < BENCH_NUM_PHASES; ++i) {
+        stats.samples[i] = malloc(options.num_tx * sizeof(uint64_t));
+        if (stats.samples[i] == NULL) {
+            fprintf(stderr, "Out of memory.\n");
+            return 1;
+        }
+    }
+    stats.count = 0;
+    stats.bytes = 0;
+
+    ib_initialize();
+
+    rc = create_engine(&engine, &server, config);
+    if (rc != IB_OK) {
+        fprintf(stderr, "Error creating engine: %s\n",
+                ib_status_to_string(rc));
+        return 1;
+    }
+
+    rc = run(engine, options.num_warmup, options.tx_per_conn, NULL);
+    if (rc != IB_OK) {
+        fprintf(stderr, "Error during warm up: %s\n",
+                ib_status_to_string(rc));
+        return 1;
+    }
+
+    start = now_ns();
+    rc = run(engine, options.num_tx, options.tx_per_conn, &stats);
+    if (rc != IB_OK) {
+        fprintf(stderr, "Error during run: %s\n", ib_status_to_string(rc));
+        return 1;
+    }
+    report(&options, &stats, now_ns() - start);
+
+    ib_engine_destroy(engine);
+    ib_shutdown();
+
+    for (int i = 0; i < BENCH_NUM_PHASES; ++i) {
+        free(stats.samples[i]);
+    }
+    free(config);
+
+    return 0;
+}
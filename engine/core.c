@@ -3152,6 +3152,17 @@ static ib_status_t core_dir_param1(ib_cfgparser_t *cp,
             ib_mm_strdup(ib_engine_mm_config_get(ib), p1_unescaped);
         return IB_OK;
     }
+    else if (strcasecmp("ConfigWorkers", name) == 0) {
+        ib_num_t workers;
+        rc = ib_type_atoi(p1_unescaped, 10, &workers);
+        if ( (rc != IB_OK) || (workers < 0) ) {
+            ib_log_error(ib, "Invalid value: %s \"%s\"", name, p1_unescaped);
+            return IB_EINVAL;
+        }
+
+        ib_engine_config_workers_set(ib, (size_t)workers);
+        return IB_OK;
+    }
     else if (strcasecmp("ModuleBasePath", name) == 0) {
         rc = ib_core_context_config(ctx, &corecfg);
 
@@ -3610,6 +3621,96 @@ static ib_status_t core_dir_logwrite(
     return IB_OK;
 }
 
+/**
+ * Implementation of the LogQueue directive.
+ *
+ * LogQueue <capacity> [<overflow policy> [<max wait usec>]]
+ *
+ * The capacity applies to log writers added after this directive; the
+ * overflow policy and the maximum wait apply to all writers.
+ *
+ * @param[in] cp Configuration parser.
+ * @param[in] name The string "LogQueue".
+ * @param[in] vars The directive parameters.
+ * @param[in] cbdata An @ref ib_strval_t map of overflow policy names.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EINVAL On invalid parameters.
+ */
+static ib_status_t core_dir_logqueue(
+    ib_cfgparser_t  *cp,
+    const char      *name,
+    const ib_list_t *vars,
+    void            *cbdata
+)
+{
+    assert(cp != NULL);
+    assert(cp->ib != NULL);
+    assert(name != NULL);
+    assert(vars != NULL);
+    assert(cbdata != NULL);
+
+    const ib_strval_t    *map = (const ib_strval_t *)cbdata;
+    const ib_list_node_t *node;
+    const char           *param;
+    ib_num_t              capacity;
+    ib_num_t              overflow = IB_LOGGER_OVERFLOW_BLOCK;
+    ib_num_t              max_wait = IB_LOGGER_QUEUE_WAIT_DEFAULT;
+    ib_status_t           rc;
+
+    if (ib_list_elements(vars) > 3) {
+        ib_cfg_log_error(cp, "%s takes at most 3 parameters.", name);
+        return IB_EINVAL;
+    }
+
+    node = ib_list_first_const(vars);
+    if (node == NULL) {
+        ib_cfg_log_error(cp, "%s requires a capacity.", name);
+        return IB_EINVAL;
+    }
+    param = (const char *)ib_list_node_data_const(node);
+    rc = ib_type_atoi(param, 10, &capacity);
+    if (rc != IB_OK || capacity <= 0) {
+        ib_cfg_log_error(cp, "Invalid %s capacity: %s", name, param);
+        return IB_EINVAL;
+    }
+
+    node = ib_list_node_next_const(node);
+    if (node != NULL) {
+        param = (const char *)ib_list_node_data_const(node);
+        rc = ib_config_strval_pair_lookup(param, map, &overflow);
+        if (rc != IB_OK) {
+            ib_cfg_log_error(cp, "Invalid %s overflow policy: %s",
+                             name, param);
+            return IB_EINVAL;
+        }
+        node = ib_list_node_next_const(node);
+    }
+
+    if (node != NULL) {
+        param = (const char *)ib_list_node_data_const(node);
+        rc = ib_type_atoi(param, 10, &max_wait);
+        if (rc != IB_OK || max_wait < 0) {
+            ib_cfg_log_error(cp, "Invalid %s maximum wait: %s", name, param);
+            return IB_EINVAL;
+        }
+    }
+
+    rc = ib_logger_queue_set(
+        ib_engine_logger_get(cp->ib),
+        (size_t)capacity,
+        (ib_logger_overflow_t)overflow,
+        (ib_time_t)max_wait);
+    if (rc != IB_OK) {
+        ib_cfg_log_error(cp, "Invalid %s capacity: %" PRId64,
+                         name, capacity);
+        return rc;
+    }
+
+    return IB_OK;
+}
+
 /**
  * Parse a InitVar directive.
  *
@@ -3819,6 +3920,16 @@ static IB_STRVAL_MAP(core_loglevels_map) = {
     IB_STRVAL_PAIR_LAST
 };
 
+/**
+ * Mapping of valid log queue overflow policies to numerical value
+ */
+static IB_STRVAL_MAP(core_logqueue_overflow_map) = {
+    IB_STRVAL_PAIR("drop-newest", IB_LOGGER_OVERFLOW_DROP_NEWEST),
+    IB_STRVAL_PAIR("drop-oldest", IB_LOGGER_OVERFLOW_DROP_OLDEST),
+    IB_STRVAL_PAIR("block", IB_LOGGER_OVERFLOW_BLOCK),
+    IB_STRVAL_PAIR_LAST
+};
+
 /**
  * Mapping of valid audit log part names to flag values.
  */
@@ -4025,8 +4136,18 @@ static IB_DIRMAP_INIT_STRUCTURE(core_directive_map) = {
         core_dir_param1,
         NULL
     ),
+    IB_DIRMAP_INIT_LIST(
+        "LogQueue",
+        core_dir_logqueue,
+        core_logqueue_overflow_map
+    ),
 
     /* Config */
+    IB_DIRMAP_INIT_PARAM1(
+        "ConfigWorkers",
+        core_dir_param1,
+        NULL
+    ),
     IB_DIRMAP_INIT_SBLK1(
         "Site",
         core_dir_site_start,
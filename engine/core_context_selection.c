@@ -41,7 +41,10 @@
 #include <ironbee/util.h>
 
 #include <assert.h>
+#include <ctype.h>
 #include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <strings.h>
 #include <unistd.h>
 
@@ -67,6 +70,18 @@
  *    allows the selection to avoid looking at the other fields in the
  *    structure.
  *
+ * 4. At finalize time, a selection index is compiled (see
+ *    core_ctxsel_finalize()).  The host names of all sites are compiled into
+ *    a single trie of reversed host names whose nodes list the selectors
+ *    that match there.  Selectors of sites which match any host are instead
+ *    bucketed in a hash by service (IP and port, either of which may be a
+ *    wildcard).  Each site's location paths are compiled into a trie.
+ *    Selection makes one pass over the host name and looks up the (at most
+ *    four) service buckets which can match the connection, then walks the
+ *    candidates in selector order, so that the first matching selector
+ *    wins, exactly as a linear walk would.  The cost is independent of the
+ *    number of sites.
+ *
  * Note that the code does not enforce that the last item in the lists be
  * a default; it is possible to create a configuration without a default site,
  * or with a default site in the middle of the list, or a default service /
@@ -74,12 +89,41 @@
  * do that.  If you do, the site selection will not do what you expect.
  */
 
+/** Trie value indicating that no key ends at a node */
+#define CORE_TRIE_NONE SIZE_MAX
+
+/**
+ * Trie used by the selection index for host names and location paths.
+ *
+ * Host names are inserted reversed and lower cased so that wildcard host
+ * names become prefixes.  Location nodes record the lowest index of any
+ * exact key and of any prefix key ending at them.  Host name nodes instead
+ * list the selectors, in selector order, of the keys ending at them; the
+ * prefix list of a node also includes those of its ancestors.
+ */
+typedef struct core_trie_t core_trie_t;
+struct core_trie_t {
+    core_trie_t           *child;        /**< First child node */
+    core_trie_t           *sibling;      /**< Next sibling node */
+    size_t                 exact;        /**< Lowest exact key index */
+    size_t                 prefix;       /**< Lowest prefix key index */
+    ib_list_t             *exact_list;   /**< Exact key selectors or NULL */
+    ib_list_t             *prefix_list;  /**< Prefix key selectors or NULL */
+    unsigned char          c;            /**< Character leading here */
+};
+
 /** Core context selection site structure */
 typedef struct core_site_t {
     ib_site_t              site;         /**< Site data */
     ib_list_t             *hosts;        /**< List of core_host_t* */
     ib_list_t             *services;     /**< List of core_service_t* */
     ib_list_t             *locations;    /**< List of core_location_t* */
+
+    /* Compiled by core_ctxsel_finalize() */
+    bool                   any_host;     /**< Does every host match? */
+    core_trie_t           *location_trie;/**< Trie of location paths */
+    size_t                 any_location; /**< First match-any location */
+    const struct core_location_t **location_array; /**< Locations by index */
 } core_site_t;
 
 /** Core context selection host name entity */
@@ -106,6 +150,7 @@ typedef struct core_location_t {
 
 /** Core site selection data */
 typedef struct core_site_selector_t {
+    size_t                 index;        /**< Position in selector list */
     const core_site_t     *site;         /**< Pointer to the site */
     const core_service_t  *service;      /**< Service (IP/Port) */
     const ib_list_t       *hosts;        /**< List of core_host_t* */
@@ -142,141 +187,639 @@ static const core_location_t *core_ctxsel_matchany_location(
 }
 
 /**
- * Check for a matching host within a host list
+ * Create a trie node.
  *
- * This function takes a list of hosts, and attempts to find the first
- * host that matches the transaction.  This function is intended to aid in
- * the development of context selection functions, but it's use is optional.
- * It is used by the core site selector.
+ * @param[in] mm Memory manager
+ * @param[in] c Character leading to the node
  *
- * @param[in] ib IronBee engine
- * @param[in] tx Transaction to match
- * @param[in] hosts List of ib_core_host_t
- * @param[out] match true if a match was found, else false
+ * @returns New node or NULL on allocation failure
+ */
+static core_trie_t *core_trie_create(ib_mm_t mm, unsigned char c)
+{
+    core_trie_t *node = ib_mm_alloc(mm, sizeof(*node));
+
+    if (node == NULL) {
+        return NULL;
+    }
+    node->child = NULL;
+    node->sibling = NULL;
+    node->exact = CORE_TRIE_NONE;
+    node->prefix = CORE_TRIE_NONE;
+    node->exact_list = NULL;
+    node->prefix_list = NULL;
+    node->c = c;
+
+    return node;
+}
+
+/**
+ * Get the @a i'th character of a trie key.
+ *
+ * @param[in] key Key
+ * @param[in] len Length of @a key
+ * @param[in] i Character position
+ * @param[in] hostname Is @a key a host name (reversed, case-insensitive)?
  *
- * @returns IB_OK
+ * @returns The character
  */
-static ib_status_t core_ctxsel_match_host(
-    const ib_engine_t *ib,
-    const ib_tx_t *tx,
-    const ib_list_t *hosts,
-    bool *match)
+static inline unsigned char core_trie_char(
+    const char *key,
+    size_t len,
+    size_t i,
+    bool hostname)
 {
-    assert(ib != NULL);
-    assert(tx != NULL);
-    assert(match != NULL);
+    if (hostname) {
+        return (unsigned char)tolower((unsigned char)key[len - 1 - i]);
+    }
+    return (unsigned char)key[i];
+}
 
-    const ib_list_node_t *node;
-    size_t len;
+/**
+ * Find the node of a key in a trie, creating it if need be.
+ *
+ * @param[in] mm Memory manager
+ * @param[in] root Root of the trie
+ * @param[in] key Key to insert
+ * @param[in] len Length of @a key
+ * @param[in] hostname Is @a key a host name (reversed, case-insensitive)?
+ *
+ * @returns The node or NULL on allocation failure
+ */
+static core_trie_t *core_trie_node(
+    ib_mm_t mm,
+    core_trie_t *root,
+    const char *key,
+    size_t len,
+    bool hostname)
+{
+    assert(root != NULL);
+    assert(key != NULL);
+
+    core_trie_t *node = root;
+
+    for (size_t i = 0; i < len; ++i) {
+        unsigned char c = core_trie_char(key, len, i, hostname);
+        core_trie_t *child;
+
+        for (child = node->child; child != NULL; child = child->sibling) {
+            if (child->c == c) {
+                break;
+            }
+        }
+        if (child == NULL) {
+            child = core_trie_create(mm, c);
+            if (child == NULL) {
+                return NULL;
+            }
+            child->sibling = node->child;
+            node->child = child;
+        }
+        node = child;
+    }
+
+    return node;
+}
+
+/**
+ * Insert a key into a trie.
+ *
+ * @param[in] mm Memory manager
+ * @param[in] root Root of the trie
+ * @param[in] key Key to insert
+ * @param[in] len Length of @a key
+ * @param[in] hostname Is @a key a host name (reversed, case-insensitive)?
+ * @param[in] prefix Does @a key match as a prefix (vs. an exact match)?
+ * @param[in] index Index to store (the lowest index of a node is kept)
+ *
+ * @returns IB_OK or IB_EALLOC
+ */
+static ib_status_t core_trie_insert(
+    ib_mm_t mm,
+    core_trie_t *root,
+    const char *key,
+    size_t len,
+    bool hostname,
+    bool prefix,
+    size_t index)
+{
+    core_trie_t *node = core_trie_node(mm, root, key, len, hostname);
+
+    if (node == NULL) {
+        return IB_EALLOC;
+    }
 
-    /* If no hosts in the list, we have an automatic match */
-    if (hosts == NULL) {
-        *match = true;
+    if (prefix) {
+        if (index < node->prefix) {
+            node->prefix = index;
+        }
+    }
+    else if (index < node->exact) {
+        node->exact = index;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Find the lowest index of any key in a trie that matches @a key.
+ *
+ * Prefix keys match if they are a prefix of @a key; exact keys match if
+ * they are equal to @a key.
+ *
+ * @param[in] root Root of the trie
+ * @param[in] key Key to look up
+ * @param[in] len Length of @a key
+ * @param[in] hostname Is @a key a host name (reversed, case-insensitive)?
+ *
+ * @returns Lowest matching index or CORE_TRIE_NONE
+ */
+static size_t core_trie_lookup(
+    const core_trie_t *root,
+    const char *key,
+    size_t len,
+    bool hostname)
+{
+    assert(root != NULL);
+    assert(key != NULL);
+
+    const core_trie_t *node = root;
+    size_t best = root->prefix;
+
+    for (size_t i = 0; i < len; ++i) {
+        unsigned char c = core_trie_char(key, len, i, hostname);
+        const core_trie_t *child;
+
+        for (child = node->child; child != NULL; child = child->sibling) {
+            if (child->c == c) {
+                break;
+            }
+        }
+        if (child == NULL) {
+            return best;
+        }
+        node = child;
+        if (node->prefix < best) {
+            best = node->prefix;
+        }
+    }
+
+    return (node->exact < best) ? node->exact : best;
+}
+
+/**
+ * Merge two lists of selectors, each in selector order.
+ *
+ * @param[in] mm Memory manager
+ * @param[in] a First list
+ * @param[in] b Second list
+ * @param[out] merged New list of the selectors of @a a and @a b, in order
+ *
+ * @returns IB_OK or IB_EALLOC
+ */
+static ib_status_t core_ctxsel_list_merge(
+    ib_mm_t mm,
+    const ib_list_t *a,
+    const ib_list_t *b,
+    ib_list_t **merged)
+{
+    assert(a != NULL);
+    assert(b != NULL);
+    assert(merged != NULL);
+
+    const ib_list_node_t *na = ib_list_first_const(a);
+    const ib_list_node_t *nb = ib_list_first_const(b);
+    ib_list_t *list;
+    ib_status_t rc;
+
+    rc = ib_list_create(&list, mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    while ( (na != NULL) || (nb != NULL) ) {
+        const core_site_selector_t *sa = (na == NULL) ? NULL :
+            (const core_site_selector_t *)ib_list_node_data_const(na);
+        const core_site_selector_t *sb = (nb == NULL) ? NULL :
+            (const core_site_selector_t *)ib_list_node_data_const(nb);
+        const core_site_selector_t *next;
+
+        if ( (sb == NULL) || ( (sa != NULL) && (sa->index <= sb->index) ) ) {
+            next = sa;
+            na = ib_list_node_next_const(na);
+            if ( (sb != NULL) && (sb == sa) ) {
+                nb = ib_list_node_next_const(nb);
+            }
+        }
+        else {
+            next = sb;
+            nb = ib_list_node_next_const(nb);
+        }
+
+        rc = ib_list_push(list, (void *)next);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    *merged = list;
+    return IB_OK;
+}
+
+/**
+ * Add a selector to a list of a host trie node.
+ *
+ * Selectors are added in selector order; a selector whose site lists the
+ * same host name twice is only added once.
+ *
+ * @param[in] mm Memory manager
+ * @param[in,out] plist List to add to, created if NULL
+ * @param[in] selector Selector to add
+ *
+ * @returns IB_OK or IB_EALLOC
+ */
+static ib_status_t core_ctxsel_host_list_add(
+    ib_mm_t mm,
+    ib_list_t **plist,
+    const core_site_selector_t *selector)
+{
+    assert(plist != NULL);
+    assert(selector != NULL);
+
+    ib_status_t rc;
+
+    if (*plist == NULL) {
+        rc = ib_list_create(plist, mm);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+    else if (ib_list_node_data_const(ib_list_last_const(*plist)) == selector) {
         return IB_OK;
     }
 
-    /* Now, loop through the list of hostnames */
-    if (tx->hostname != NULL) {
-        len = strlen(tx->hostname);
-        IB_LIST_LOOP_CONST(hosts, node) {
+    return ib_list_push(*plist, (void *)selector);
+}
+
+/**
+ * Add the host names of a selector's site to the host trie
+ *
+ * @param[in] mm Memory manager
+ * @param[in] root Root of the host trie
+ * @param[in] selector Selector to add; its site must not match any host
+ *
+ * @returns IB_OK or IB_EALLOC
+ */
+static ib_status_t core_ctxsel_host_trie_add(
+    ib_mm_t mm,
+    core_trie_t *root,
+    const core_site_selector_t *selector)
+{
+    assert(root != NULL);
+    assert(selector != NULL);
+    assert(! selector->site->any_host);
+
+    const ib_list_node_t *node;
+    ib_status_t rc;
+
+    IB_LIST_LOOP_CONST(selector->site->hosts, node) {
+        const core_host_t *core_host =
+            (const core_host_t *)ib_list_node_data_const(node);
+        const ib_site_host_t *host = &(core_host->host);
+        core_trie_t *trie_node;
+
+        if (host->suffix != NULL) {
+            trie_node = core_trie_node(mm, root,
+                                       host->suffix, core_host->suffix_len,
+                                       true);
+            if (trie_node == NULL) {
+                return IB_EALLOC;
+            }
+            rc = core_ctxsel_host_list_add(mm, &(trie_node->prefix_list),
+                                           selector);
+        }
+        else {
+            trie_node = core_trie_node(mm, root,
+                                       host->hostname, core_host->hostname_len,
+                                       true);
+            if (trie_node == NULL) {
+                return IB_EALLOC;
+            }
+            rc = core_ctxsel_host_list_add(mm, &(trie_node->exact_list),
+                                           selector);
+        }
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Fold the prefix lists of the host trie into their descendants
+ *
+ * Afterwards, the prefix list of each node holds every selector matching
+ * as a prefix at that node or any of its ancestors, so that a lookup only
+ * needs the deepest prefix list on its path.
+ *
+ * @param[in] mm Memory manager
+ * @param[in,out] node Node to fold
+ * @param[in] inherited Prefix list of the nearest ancestor that has one
+ *
+ * @returns IB_OK or IB_EALLOC
+ */
+static ib_status_t core_ctxsel_host_trie_fold(
+    ib_mm_t mm,
+    core_trie_t *node,
+    const ib_list_t *inherited)
+{
+    assert(node != NULL);
+
+    core_trie_t *child;
+    ib_status_t rc;
+
+    if (node->prefix_list == NULL) {
+        node->prefix_list = (ib_list_t *)inherited;
+    }
+    else if (inherited != NULL) {
+        rc = core_ctxsel_list_merge(mm, inherited, node->prefix_list,
+                                    &(node->prefix_list));
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    for (child = node->child; child != NULL; child = child->sibling) {
+        rc = core_ctxsel_host_trie_fold(mm, child, node->prefix_list);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Find the selectors whose host names match a host name
+ *
+ * This is a single pass over @a hostname, independent of the number of
+ * sites.
+ *
+ * @param[in] root Root of the host trie
+ * @param[in] hostname Host name to look up
+ * @param[out] exact Selectors matching @a hostname exactly or NULL
+ * @param[out] prefix Selectors matching a suffix of @a hostname or NULL
+ */
+static void core_ctxsel_host_lookup(
+    const core_trie_t *root,
+    const char *hostname,
+    const ib_list_t **exact,
+    const ib_list_t **prefix)
+{
+    assert(root != NULL);
+    assert(hostname != NULL);
+    assert(exact != NULL);
+    assert(prefix != NULL);
+
+    const core_trie_t *node = root;
+    size_t len = strlen(hostname);
+
+    *exact = NULL;
+    *prefix = NULL;
+    for (size_t i = 0; i < len; ++i) {
+        unsigned char c = core_trie_char(hostname, len, i, true);
+        const core_trie_t *child;
+
+        for (child = node->child; child != NULL; child = child->sibling) {
+            if (child->c == c) {
+                break;
+            }
+        }
+        if (child == NULL) {
+            *prefix = node->prefix_list;
+            return;
+        }
+        node = child;
+    }
+
+    *exact = node->exact_list;
+    *prefix = node->prefix_list;
+}
+
+/**
+ * Compile a site's hosts and locations for the selection index
+ *
+ * @param[in] mm Memory manager
+ * @param[in,out] site Site to compile
+ *
+ * @returns IB_OK or IB_EALLOC
+ */
+static ib_status_t core_ctxsel_site_compile(
+    ib_mm_t mm,
+    core_site_t *site)
+{
+    assert(site != NULL);
+
+    const ib_list_node_t *node;
+    ib_status_t rc;
+    size_t index;
+
+    /* Hosts: no host list, or a "match any" host, match every host.
+     * Other host names are compiled into the global host trie. */
+    site->any_host = (site->hosts == NULL);
+    if (site->hosts != NULL) {
+        IB_LIST_LOOP_CONST(site->hosts, node) {
             const core_host_t *core_host =
                 (const core_host_t *)ib_list_node_data_const(node);
-            const ib_site_host_t *host = &(core_host->host);
 
-            /* If this is a "match any" host entry? */
             if (core_host->match_any) {
-                ib_log_debug2_tx(tx, "Host %s matched wildcard.",
-                                 tx->hostname);
-                *match = true;
-                return IB_OK;
+                site->any_host = true;
+                break;
             }
+        }
+    }
 
-            /* Check the suffix */
-            if ( (host->suffix != NULL) && (len >= core_host->suffix_len) ) {
-                ib_log_debug2_tx(tx, "Host %s matched suffix: %s",
-                                 tx->hostname, host->suffix);
-                const char *suffix = tx->hostname + len - core_host->suffix_len;
-                if (strcasecmp(host->suffix, suffix) == 0) {
-                    *match = true;
-                    return IB_OK;
-                }
-            }
+    /* Locations: indexed by position, so the first match wins. */
+    site->any_location = CORE_TRIE_NONE;
+    site->location_trie = core_trie_create(mm, 0);
+    if (site->location_trie == NULL) {
+        return IB_EALLOC;
+    }
+    site->location_array = ib_mm_alloc(
+        mm,
+        (ib_list_elements(site->locations) + 1) *
+            sizeof(*(site->location_array)));
+    if (site->location_array == NULL) {
+        return IB_EALLOC;
+    }
+    index = 0;
+    IB_LIST_LOOP_CONST(site->locations, node) {
+        const core_location_t *core_location =
+            (const core_location_t *)ib_list_node_data_const(node);
 
-            /* Finally, do a full hostname match */
-            if ( (core_host->hostname_len == len) &&
-                 (strcasecmp(host->hostname, tx->hostname) == 0) )
-            {
-                ib_log_debug2_tx(tx, "Host %s matched full hostname: %s",
-                                 tx->hostname, host->hostname);
-                *match = true;
-                return IB_OK;
+        site->location_array[index] = core_location;
+        if (core_location->match_any || core_location->path_len == 0) {
+            if (site->any_location == CORE_TRIE_NONE) {
+                site->any_location = index;
+            }
+        }
+        else {
+            rc = core_trie_insert(mm, site->location_trie,
+                                  core_location->location.path,
+                                  core_location->path_len,
+                                  false, true, index);
+            if (rc != IB_OK) {
+                return rc;
             }
         }
+        ++index;
     }
 
-    /* No matches */
-    *match = false;
     return IB_OK;
 }
 
 /**
- * Check for a matching location within a location list
+ * Check whether a selector's service matches a connection
  *
- * This function takes a list of locations, and attempts to find the first
- * location that matches the transaction.  This function is intended to aid in
- * the development of context selection functions, but it's use is optional.
- * It is used by the core site selector.
+ * @param[in] conn Connection to match
+ * @param[in] selector Selector
+ *
+ * @returns true if the service of @a selector matches @a conn
+ */
+static bool core_ctxsel_match_service(
+    const ib_conn_t *conn,
+    const core_site_selector_t *selector)
+{
+    assert(conn != NULL);
+    assert(selector != NULL);
+
+    const core_service_t *service = selector->service;
+
+    /* No service or a "match any" service is an automatic match */
+    if ( (service == NULL) || service->match_any ) {
+        return true;
+    }
+    if ( (service->service.port >= 0) &&
+         (service->service.port != conn->local_port) )
+    {
+        return false;
+    }
+    if ( (service->ip_len != 0) &&
+         (strcmp(service->service.ipstr, conn->local_ipstr) != 0) )
+    {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Find the first matching location within a site
  *
- * @param[in] ib IronBee engine
  * @param[in] tx Transaction to match
- * @param[in] locations List of ib_ctxsel_location_t
- * @param[out] match Pointer to matched location (or NULL)
+ * @param[in] site Compiled site
  *
- * @returns IB_OK
+ * @returns First matching location (in configuration order) or NULL
  */
-static ib_status_t core_ctxsel_match_location(
-    const ib_engine_t *ib,
+static const core_location_t *core_ctxsel_match_location(
     const ib_tx_t *tx,
-    const ib_list_t *locations,
-    const core_location_t **match)
+    const core_site_t *site)
 {
-    assert(ib != NULL);
     assert(tx != NULL);
-    assert(locations != NULL);
-    assert(match != NULL);
+    assert(site != NULL);
 
-    const ib_list_node_t *node;
+    size_t index;
+
+    index = core_trie_lookup(site->location_trie,
+                             tx->path, strlen(tx->path),
+                             false);
+    if (site->any_location < index) {
+        index = site->any_location;
+    }
+    if (index == CORE_TRIE_NONE) {
+        return NULL;
+    }
+
+    return site->location_array[index];
+}
+
+/**
+ * Format the selection index key of a service.
+ *
+ * @param[out] buf Buffer to write to
+ * @param[in] bufsize Size of @a buf
+ * @param[in] ipstr IP address or NULL for any
+ * @param[in] port Port number or -1 for any
+ *
+ * @returns Length of the key
+ */
+static size_t core_ctxsel_service_key(
+    char *buf,
+    size_t bufsize,
+    const char *ipstr,
+    int port)
+{
+    int len;
+
+    if (port < 0) {
+        len = snprintf(buf, bufsize, "%s *", ipstr == NULL ? "*" : ipstr);
+    }
+    else {
+        len = snprintf(buf, bufsize, "%s %d", ipstr == NULL ? "*" : ipstr, port);
+    }
+    if (len < 0) {
+        return 0;
+    }
+
+    return ((size_t)len < bufsize) ? (size_t)len : bufsize - 1;
+}
+
+/**
+ * Add a selector to the selection index
+ *
+ * @param[in] mm Memory manager
+ * @param[in] index Selection index hash
+ * @param[in] selector Selector to add
+ *
+ * @returns IB_OK or error status
+ */
+static ib_status_t core_ctxsel_index_add(
+    ib_mm_t mm,
+    ib_hash_t *index,
+    const core_site_selector_t *selector)
+{
+    const core_service_t *service = selector->service;
+    const char *ipstr = NULL;
+    int port = -1;
+    char buf[128];
     size_t len;
+    ib_list_t *bucket;
+    ib_status_t rc;
 
-    /* Now, loop through the list of locations */
-    len = strlen(tx->path);
-    IB_LIST_LOOP_CONST(locations, node) {
-        const core_location_t *core_location =
-            (const core_location_t *)ib_list_node_data_const(node);
-        const ib_site_location_t *location = &(core_location->location);
-
-        /* Is this a "match any" location? */
-        if (core_location->match_any) {
-            ib_log_debug2_tx(tx, "Location %s matched root.",
-                             tx->path);
-            *match = core_location;
-            return IB_OK;
-        }
+    if ( (service != NULL) && (! service->match_any) ) {
+        ipstr = service->service.ipstr;
+        port = service->service.port;
+    }
 
-        /* Check the path */
-        if ( (core_location->path_len <= len) &&
-             (strncmp(location->path, tx->path, core_location->path_len) == 0) )
-        {
-            ib_log_debug2_tx(tx, "Location %s matched: %s",
-                             tx->path, location->path);
-            *match = core_location;
-            return IB_OK;
+    len = core_ctxsel_service_key(buf, sizeof(buf), ipstr, port);
+    rc = ib_hash_get_ex(index, &bucket, buf, len);
+    if (rc == IB_ENOENT) {
+        char *key = ib_mm_memdup(mm, buf, len);
+
+        if (key == NULL) {
+            return IB_EALLOC;
         }
+        rc = ib_list_create(&bucket, mm);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        rc = ib_hash_set_ex(index, key, len, bucket);
+    }
+    if (rc != IB_OK) {
+        return rc;
     }
 
-    /* No matches */
-    *match = NULL;
-    return IB_OK;
+    return ib_list_push(bucket, (void *)selector);
 }
 
 /**
@@ -306,6 +849,7 @@ static ib_status_t core_create_site_selector(
     if (object == NULL) {
         return IB_EALLOC;
     }
+    object->index = ib_list_elements(core_data->selector_list);
     object->service = service;
     object->hosts = site->hosts;
     object->locations = site->locations;
@@ -328,7 +872,8 @@ static ib_status_t core_create_site_selector(
  *
  * This functions creates the site selector list which is used during the site
  * selection process.  It walks through the list of sites / locations, and
- * creates corresponding site selector objects.
+ * creates corresponding site selector objects.  It then compiles the
+ * selection index from the selectors.
  *
  * @param[in] ib IronBee engine
  * @param[in] common_cb_data Common callback data
@@ -346,7 +891,9 @@ static ib_status_t core_ctxsel_finalize(
     assert(ib != NULL);
 
     const ib_list_node_t *site_node;
+    const ib_list_node_t *node;
     ib_core_module_data_t *core_data = (ib_core_module_data_t *)common_cb_data;
+    ib_mm_t mm = ib_engine_mm_main_get(ib);
     ib_status_t rc;
 
     /* Do nothing if we're not the current site selector */
@@ -408,6 +955,56 @@ static ib_status_t core_ctxsel_finalize(
         }
     }
 
+    /* Compile the hosts and locations of each site */
+    IB_LIST_LOOP_CONST(core_data->site_list, site_node) {
+        core_site_t *site = (core_site_t *)ib_list_node_data_const(site_node);
+
+        rc = core_ctxsel_site_compile(mm, site);
+        if (rc != IB_OK) {
+            ib_log_error(ib, "Error compiling site \"%s\": %s",
+                         site->site.name, ib_status_to_string(rc));
+            return rc;
+        }
+    }
+
+    /* Build the host trie and the service index of the selectors */
+    rc = ib_hash_create(&(core_data->selector_index), mm);
+    if (rc != IB_OK) {
+        ib_log_error(ib, "Error creating core site selector index: %s",
+                     ib_status_to_string(rc));
+        return rc;
+    }
+    core_data->host_trie = core_trie_create(mm, 0);
+    if (core_data->host_trie == NULL) {
+        ib_log_error(ib, "Error creating core site host trie: %s",
+                     ib_status_to_string(IB_EALLOC));
+        return IB_EALLOC;
+    }
+    IB_LIST_LOOP_CONST(core_data->selector_list, node) {
+        const core_site_selector_t *selector =
+            (const core_site_selector_t *)ib_list_node_data_const(node);
+
+        if (selector->site->any_host) {
+            rc = core_ctxsel_index_add(mm, core_data->selector_index,
+                                       selector);
+        }
+        else {
+            rc = core_ctxsel_host_trie_add(mm, core_data->host_trie,
+                                           selector);
+        }
+        if (rc != IB_OK) {
+            ib_log_error(ib, "Error indexing core site selector: %s",
+                         ib_status_to_string(rc));
+            return rc;
+        }
+    }
+    rc = core_ctxsel_host_trie_fold(mm, core_data->host_trie, NULL);
+    if (rc != IB_OK) {
+        ib_log_error(ib, "Error compiling core site host trie: %s",
+                     ib_status_to_string(rc));
+        return rc;
+    }
+
     return IB_OK;
 }
 
@@ -436,17 +1033,21 @@ static ib_status_t core_ctxsel_select(
     assert(common_cb_data != NULL);
     assert(pctx != NULL);
 
-    const ib_list_node_t *node;
-    size_t ip_len;
-    ib_status_t rc;
     ib_core_module_data_t *core_data = (ib_core_module_data_t *)common_cb_data;
+    const ib_list_node_t *cursors[6];
+    size_t num_cursors = 0;
+    size_t num_host_cursors = 0;
+    int port = conn->local_port;
 
     /* Verify that we're the current selector */
     if (ib_ctxsel_module_is_active(ib, ib_core_module(ib)) == false) {
         return IB_EINVAL;
     }
 
-    if (core_data->selector_list == NULL) {
+    if ( (core_data->selector_list == NULL) ||
+         (core_data->selector_index == NULL) ||
+         (core_data->host_trie == NULL) )
+    {
         ib_log_notice(ib, "No site selection list: Using main context");
         goto select_main_context;
     }
@@ -456,65 +1057,89 @@ static ib_status_t core_ctxsel_select(
         goto select_main_context;
     }
 
-    /* Get the length of the IP address string before the main loop */
-    ip_len = strlen(conn->local_ipstr);
+    /* Find the selectors whose host names match the transaction; their
+     * services are checked as they are walked. */
+    if (tx->hostname != NULL) {
+        const ib_list_t *lists[2];
+
+        core_ctxsel_host_lookup(core_data->host_trie, tx->hostname,
+                                &lists[0], &lists[1]);
+        for (int n = 0; n < 2; ++n) {
+            if (lists[n] != NULL) {
+                cursors[num_cursors++] = ib_list_first_const(lists[n]);
+            }
+        }
+    }
+    num_host_cursors = num_cursors;
+
+    /* Find the service buckets of "match any" host selectors which can
+     * match the connection. */
+    for (int n = 0; n < 4; ++n) {
+        const ib_list_t *bucket;
+        char buf[128];
+        size_t len;
+
+        len = core_ctxsel_service_key(buf, sizeof(buf),
+                                      (n & 1) ? NULL : conn->local_ipstr,
+                                      (n & 2) ? -1 : port);
+        if (ib_hash_get_ex(core_data->selector_index,
+                           &bucket, buf, len) == IB_OK)
+        {
+            cursors[num_cursors++] = ib_list_first_const(bucket);
+        }
+    }
 
     /*
-     * Walk through the list of site selectors, return when the first matching
-     * selector is found.  At any point in the loop if a non-match is found,
-     * we continue to the top of the loop, and try the next selector.
+     * Walk through the candidate selectors in selector list order, return
+     * when the first matching selector is found.
      */
-    IB_LIST_LOOP_CONST(core_data->selector_list, node) {
-        const core_site_selector_t *selector =
-            (const core_site_selector_t *)ib_list_node_data_const(node);
-        const core_service_t *service = selector->service;
+    for (;;) {
+        const core_site_selector_t *selector = NULL;
         const core_location_t *location;
         ib_context_t *ctx;
-        bool match;
+        size_t which = 0;
 
-        ib_log_debug2(ib, "Looking for matching context against site=%s(%s)",
-                      (selector->site ? selector->site->site.id : "none"),
-                      (selector->site ? selector->site->site.name : "none"));
+        /* Take the candidate earliest in the selector list. */
+        for (size_t n = 0; n < num_cursors; ++n) {
+            const core_site_selector_t *candidate;
 
-        /*
-         * Check if the service matches the connection data.
-         */
-        if ( (service != NULL) && (! service->match_any) ) {
-            /* Check that the port matches the service (if specified) */
-            if ( (service->service.port >= 0) &&
-                 (service->service.port != conn->local_port) ) {
+            if (cursors[n] == NULL) {
                 continue;
             }
-            /* Check that the address matches the service (if specified) */
-            if ( (service->service.ipstr != NULL) &&
-                 (service->ip_len == ip_len) &&
-                 (strcmp(service->service.ipstr, conn->local_ipstr) != 0) )
-            {
-                continue;
+            candidate = (const core_site_selector_t *)
+                ib_list_node_data_const(cursors[n]);
+            if ( (selector == NULL) || (candidate->index < selector->index) ) {
+                selector = candidate;
+                which = n;
             }
         }
-        ib_log_debug2(ib, "Connection %s:%d matched context service.",
-                      conn->local_ipstr, conn->local_port);
-
-        /* Check if the hostname matches the transaction data. */
-        rc = core_ctxsel_match_host(ib, tx, selector->hosts, &match);
-        if (rc != IB_OK) {
-            /* todo: What is the right thing to do here? */
-            continue;
+        if (selector == NULL) {
+            break;
         }
-        if (! match) {
+        cursors[which] = ib_list_node_next_const(cursors[which]);
+
+        ib_log_debug2(ib, "Looking for matching context against site=%s(%s)",
+                      (selector->site ? selector->site->site.id : "none"),
+                      (selector->site ? selector->site->site.name : "none"));
+
+        /* Host trie candidates still need their service checked. */
+        if ( (which < num_host_cursors) &&
+             (! core_ctxsel_match_service(conn, selector)) )
+        {
             continue;
         }
+        ib_log_debug2(ib, "Connection %s:%d matched context service.",
+                      conn->local_ipstr, conn->local_port);
+        ib_log_debug2_tx(tx, "Host %s matched site %s.",
+                         tx->hostname, selector->site->site.name);
 
         /* Check if the location matches the transaction data. */
-        rc = core_ctxsel_match_location(ib, tx, selector->locations, &location);
-        if (rc != IB_OK) {
-            /* todo: What is the right thing to do here? */
-            continue;
-        }
+        location = core_ctxsel_match_location(tx, selector->site);
         if (location == NULL) {
             continue;
         }
+        ib_log_debug2_tx(tx, "Location %s matched: %s",
+                         tx->path, location->location.path);
 
         /* Everything matches.  Use this selector's context. */
         ctx = location->location.context;
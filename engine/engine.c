@@ -35,6 +35,7 @@
 #include "state_notify_private.h"
 
 #include <ironbee/array.h>
+#include <ironbee/atomic.h>
 #include <ironbee/cfgmap.h>
 #include <ironbee/context.h>
 #include <ironbee/context_selection.h>
@@ -54,6 +55,7 @@
 
 #include <assert.h>
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -692,6 +694,177 @@ ib_status_t ib_engine_config_finished(ib_engine_t *ib)
     return rc;
 }
 
+/**
+ * A queued configuration job.
+ */
+typedef struct config_job_t config_job_t;
+struct config_job_t {
+    ib_engine_config_job_fn_t  fn;     /**< Job function */
+    void                      *cbdata; /**< Callback data for fn */
+};
+
+/**
+ * State shared by the configuration workers of one run.
+ */
+typedef struct config_run_t config_run_t;
+struct config_run_t {
+    ib_engine_t         *ib;       /**< Engine */
+    const config_job_t **jobs;     /**< Jobs to run */
+    size_t               num_jobs; /**< Number of jobs */
+    size_t               next;     /**< Next unclaimed job (atomic) */
+    ib_status_t          rc;       /**< First failure; set with cas */
+};
+
+/**
+ * Configuration worker: run jobs until none remain.
+ *
+ * @param[in] arg The @ref config_run_t.
+ *
+ * @returns NULL
+ */
+static void *config_worker(void *arg)
+{
+    config_run_t *run = (config_run_t *)arg;
+
+    for (;;) {
+        size_t i = ib_atomic_add(&run->next, 1) - 1;
+        ib_status_t expected = IB_OK;
+        ib_status_t rc;
+
+        if (i >= run->num_jobs) {
+            break;
+        }
+
+        rc = run->jobs[i]->fn(run->ib, run->jobs[i]->cbdata);
+        if (rc != IB_OK) {
+            ib_atomic_cas(&run->rc, &expected, rc);
+        }
+    }
+
+    return NULL;
+}
+
+ib_status_t ib_engine_config_job_add(
+    ib_engine_t               *ib,
+    ib_engine_config_job_fn_t  fn,
+    void                      *cbdata
+)
+{
+    assert(ib != NULL);
+    assert(fn != NULL);
+
+    config_job_t *job;
+    ib_status_t   rc;
+
+    if (ib->cfg_state != CFG_STARTED || ib_engine_config_workers(ib) < 2) {
+        return fn(ib, cbdata);
+    }
+
+    if (ib->config_jobs == NULL) {
+        rc = ib_list_create(&ib->config_jobs, ib_engine_mm_temp_get(ib));
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    job = ib_mm_alloc(ib_engine_mm_temp_get(ib), sizeof(*job));
+    if (job == NULL) {
+        return IB_EALLOC;
+    }
+    job->fn = fn;
+    job->cbdata = cbdata;
+
+    return ib_list_push(ib->config_jobs, job);
+}
+
+ib_status_t ib_engine_config_jobs_run(ib_engine_t *ib)
+{
+    assert(ib != NULL);
+
+    config_run_t          run;
+    pthread_t            *threads;
+    size_t                num_threads;
+    size_t                started;
+    size_t                i;
+    const ib_list_node_t *node;
+
+    if (ib->config_jobs == NULL || ib_list_elements(ib->config_jobs) == 0) {
+        return IB_OK;
+    }
+
+    run.ib = ib;
+    run.num_jobs = ib_list_elements(ib->config_jobs);
+    run.next = 0;
+    run.rc = IB_OK;
+    run.jobs = ib_mm_alloc(ib_engine_mm_temp_get(ib),
+                           run.num_jobs * sizeof(*run.jobs));
+    if (run.jobs == NULL) {
+        return IB_EALLOC;
+    }
+    i = 0;
+    IB_LIST_LOOP_CONST(ib->config_jobs, node) {
+        run.jobs[i++] = (const config_job_t *)ib_list_node_data_const(node);
+    }
+    ib_list_clear(ib->config_jobs);
+
+    /* The calling thread is one of the workers. */
+    num_threads = ib_engine_config_workers(ib);
+    if (num_threads > run.num_jobs) {
+        num_threads = run.num_jobs;
+    }
+    --num_threads;
+
+    threads = ib_mm_alloc(ib_engine_mm_temp_get(ib),
+                          (num_threads + 1) * sizeof(*threads));
+    if (threads == NULL) {
+        return IB_EALLOC;
+    }
+    for (started = 0; started < num_threads; ++started) {
+        int err = pthread_create(&threads[started], NULL,
+                                 config_worker, &run);
+        if (err != 0) {
+            break;
+        }
+    }
+    if (started < num_threads) {
+        ib_log_warning(ib,
+                       "Started only %zu of %zu configuration workers.",
+                       started + 1, num_threads + 1);
+    }
+
+    config_worker(&run);
+
+    for (i = 0; i < started; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+
+    ib_log_debug(ib, "Ran %zu configuration jobs on %zu workers.",
+                 run.num_jobs, started + 1);
+
+    return run.rc;
+}
+
+void ib_engine_config_workers_set(ib_engine_t *ib, size_t workers)
+{
+    assert(ib != NULL);
+
+    ib->config_workers = workers;
+}
+
+size_t ib_engine_config_workers(const ib_engine_t *ib)
+{
+    assert(ib != NULL);
+
+    long cpus;
+
+    if (ib->config_workers > 0) {
+        return ib->config_workers;
+    }
+
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (size_t)cpus : 1;
+}
+
 ib_status_t ib_engine_module_get(const ib_engine_t *ib,
                                  const char * name,
                                  ib_module_t **pm)
@@ -801,6 +974,7 @@ void ib_engine_pool_temp_destroy(ib_engine_t *ib)
 
     ib_engine_pool_destroy(ib, ib->temp_mp);
     ib->temp_mp = NULL;
+    ib->config_jobs = NULL;
     return;
 }
 
@@ -1013,9 +1187,9 @@ ib_status_t ib_conn_create(ib_engine_t *ib,
     ib_conn_t *conn = NULL;
     ib_mm_t mm;
 
-    /* Create a sub-pool for each connection and allocate from it */
+    /* Create an arena pool for each connection and allocate from it */
     /// @todo Need to tune the pool size
-    rc = ib_mpool_create(&pool, "conn", NULL);
+    rc = ib_mpool_create_arena(&pool, "conn");
     if (rc != IB_OK) {
         rc = IB_EALLOC;
         goto failed;
@@ -1104,6 +1278,16 @@ void ib_conn_destroy(ib_conn_t *conn)
 {
     /// @todo Probably need to update state???
     if ( conn != NULL && conn->mp != NULL ) {
+        ib_tx_t *tx = conn->tx_first;
+
+        /* Transaction pools are not children of the connection pool, so
+         * destroy any transactions that were never destroyed themselves. */
+        while (tx != NULL) {
+            ib_tx_t *next = tx->next;
+            ib_engine_pool_destroy(conn->ib, tx->mp);
+            tx = next;
+        }
+
         ib_engine_pool_destroy(conn->ib, conn->mp);
         /* Don't do this: conn->mp = NULL; conn is now freed memory! */
     }
@@ -1134,12 +1318,11 @@ ib_status_t ib_tx_create(ib_tx_t **ptx,
 
     assert(corecfg != NULL);
 
-    /* Create a sub-pool from the connection memory pool for each
-     * transaction and allocate from it.
-     *
-     * Preallocate some pages.
+    /* Create an arena pool for each transaction and allocate from it.
+     * Arena pools are recycled per-thread and do not lock the connection
+     * pool.
      */
-    rc = ib_mpool_create(&pool, "tx", conn->mp);
+    rc = ib_mpool_create_arena(&pool, "tx");
     if (rc != IB_OK) {
         rc = IB_EALLOC;
         goto failed;
@@ -2318,6 +2501,12 @@ ib_status_t ib_context_close(ib_context_t *ctx)
         return IB_EINVAL;
     }
 
+    /* Finish queued jobs so their results are visible to close hooks. */
+    rc = ib_engine_config_jobs_run(ib);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
     rc = ib_state_notify_context_close(ib, ctx);
     if (rc != IB_OK) {
         return rc;
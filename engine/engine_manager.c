@@ -27,6 +27,7 @@
 
 #include <ironbee/engine_manager.h>
 
+#include <ironbee/atomic.h>
 #include <ironbee/config.h>
 #include <ironbee/context.h>
 #include <ironbee/engine.h>
@@ -46,9 +47,25 @@
 #include <inttypes.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
 
+/**
+ * Number of reader shards.
+ *
+ * Threads are spread over the shards so that readers rarely share a
+ * counter.
+ */
+#define MANAGER_READ_SHARDS 16
+
+/**
+ * Microseconds to nap while waiting for readers in manager_synchronize().
+ */
+#define MANAGER_SYNC_NAP 10
+
 /* The manager's engine wrapper type */
 typedef struct ib_manager_engine_t ib_manager_engine_t;
 
@@ -70,6 +87,53 @@ struct manager_engine_preconfig_t {
 };
 typedef struct manager_engine_preconfig_t manager_engine_preconfig_t;
 
+/**
+ * Reader counts of one shard, one per grace period parity.
+ *
+ * Padded to a cache line so that shards do not share one.
+ */
+struct manager_shard_t {
+    size_t readers[2];                     /**< Readers per parity. */
+    char   pad[64 - 2 * sizeof(size_t)];   /**< Padding. */
+};
+typedef struct manager_shard_t manager_shard_t;
+
+/**
+ * A named engine in a @ref manager_snapshot_t.
+ */
+struct manager_named_t {
+    const char          *name;    /**< Name of the engine. */
+    ib_manager_engine_t *wrapper; /**< The engine wrapper. */
+};
+typedef struct manager_named_t manager_named_t;
+
+/**
+ * A managed engine in a @ref manager_snapshot_t.
+ */
+struct manager_managed_t {
+    const ib_engine_t   *engine;  /**< The engine. */
+    ib_manager_engine_t *wrapper; /**< The engine wrapper. */
+};
+typedef struct manager_managed_t manager_managed_t;
+
+/**
+ * Immutable snapshot of the manager's engines.
+ *
+ * ib_manager_engine_acquire() and ib_manager_engine_release() only read
+ * the current snapshot, and do so without taking the manager lock.  The
+ * snapshot is rebuilt and republished, under the manager lock, whenever
+ * the named or managed engines change (see manager_snapshot_publish()).
+ * A replaced snapshot is freed once all readers which may have seen it
+ * have finished (see manager_synchronize()).
+ */
+struct manager_snapshot_t {
+    size_t             named_count;  /**< Number of named engines. */
+    manager_named_t   *named;        /**< Named engines. */
+    size_t             engine_count; /**< Number of managed engines. */
+    manager_managed_t *engines;      /**< Managed (not retired) engines. */
+};
+typedef struct manager_snapshot_t manager_snapshot_t;
+
 /**
  * The Engine Manager.
  */
@@ -123,6 +187,24 @@ struct ib_manager_t {
 
     //! A list of @ref manager_engine_postconfig_t.
     ib_list_t *postconfig_functions;
+
+    /**
+     * The current engine snapshot; published atomically.
+     *
+     * This is NULL until the first engine is registered.
+     */
+    manager_snapshot_t *snapshot;
+
+    /**
+     * Grace period counter.
+     *
+     * Readers register in the reader count of the current parity of this
+     * counter. It is only advanced with the manager lock held.
+     */
+    size_t epoch;
+
+    //! Reader counts, sharded by thread.
+    manager_shard_t shards[MANAGER_READ_SHARDS];
 };
 
 /**
@@ -140,15 +222,223 @@ struct ib_manager_engine_t {
      * represents the manager's use of that engine as the current engine.
      * Other engines may have a reference count as low as zero. If an
      * engine's reference count is zero, it may be cleaned up.
+     *
+     * This is only modified atomically.
      */
     size_t        ref_count;
 
+    /**
+     * Is this engine being destroyed?
+     *
+     * Retired engines are excluded from snapshots.  Only accessed with
+     * the manager lock held.
+     */
+    bool          retired;
+
     /**
      * When this engine was created. From this you can compute uptime.
      */
     ib_time_t     created;
 };
 
+/** Source of thread shard identifiers. */
+static size_t manager_shard_next = 0;
+
+/** This thread's shard identifier plus one, or zero if not yet assigned. */
+static __thread size_t manager_shard_id = 0;
+
+/**
+ * Enter a read-side critical section.
+ *
+ * While in the critical section, the snapshot loaded from
+ * ib_manager_t::snapshot, and every engine wrapper in it, remain valid.
+ * The critical section must be short and must not block.
+ *
+ * @param[in] manager The manager.
+ *
+ * @returns Token to pass to manager_read_unlock().
+ */
+static size_t manager_read_lock(ib_manager_t *manager)
+{
+    size_t shard;
+    size_t epoch;
+    size_t parity;
+
+    if (manager_shard_id == 0) {
+        manager_shard_id = ib_atomic_add(&manager_shard_next, 1);
+    }
+    shard = manager_shard_id % MANAGER_READ_SHARDS;
+
+    for (;;) {
+        epoch = ib_atomic_load(&(manager->epoch));
+        parity = epoch & 1;
+        ib_atomic_add(&(manager->shards[shard].readers[parity]), 1);
+
+        /* Order the registration before the re-check and any load of the
+         * snapshot. */
+        ib_atomic_fence();
+
+        /* If a grace period started between loading the epoch and
+         * registering, manager_synchronize() may not have seen the
+         * registration.  Register again under the new parity. */
+        if (ib_atomic_load(&(manager->epoch)) == epoch) {
+            break;
+        }
+        ib_atomic_sub(&(manager->shards[shard].readers[parity]), 1);
+    }
+
+    return (shard * 2) + parity;
+}
+
+/**
+ * Leave a read-side critical section.
+ *
+ * @param[in] manager The manager.
+ * @param[in] token Token from manager_read_lock().
+ */
+static void manager_read_unlock(ib_manager_t *manager, size_t token)
+{
+    ib_atomic_sub(&(manager->shards[token / 2].readers[token % 2]), 1);
+}
+
+/**
+ * Wait for all read-side critical sections in progress to finish.
+ *
+ * On return, no reader can still be using a snapshot that was replaced
+ * before this call.  New readers do not delay this function; they
+ * register under the new grace period parity.  A reader that loaded the
+ * old epoch but registers after the flip notices the epoch changed and
+ * registers again (see manager_read_lock()), so it can not be missed.
+ *
+ * This requires the caller to hold the manager lock.
+ *
+ * @param[in] manager The manager.
+ */
+static void manager_synchronize(ib_manager_t *manager)
+{
+    const size_t parity = manager->epoch & 1;
+
+    ib_atomic_store(&(manager->epoch), manager->epoch + 1);
+
+    /* Order the flip (and any snapshot publish) before the reads below. */
+    ib_atomic_fence();
+
+    for (size_t i = 0; i < MANAGER_READ_SHARDS; ++i) {
+        while (ib_atomic_load(&(manager->shards[i].readers[parity])) != 0) {
+            struct timespec ts = { 0, MANAGER_SYNC_NAP * 1000 };
+
+            nanosleep(&ts, NULL);
+        }
+    }
+}
+
+/**
+ * Build and publish a new snapshot of @a manager's engines.
+ *
+ * The previous snapshot is freed once no reader can be using it.
+ *
+ * This requires the caller to hold the manager lock.
+ *
+ * @param[in] manager The manager.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation errors; the previous snapshot remains current.
+ */
+static ib_status_t manager_snapshot_publish(ib_manager_t *manager)
+{
+    assert(manager != NULL);
+
+    ib_hash_iterator_t *itr;
+    manager_snapshot_t *snapshot;
+    manager_snapshot_t *previous;
+    const size_t        named_count = ib_hash_size(manager->name_to_engine);
+    size_t              names_size = 0;
+    size_t              engine_count = 0;
+    char               *names;
+    size_t              n;
+
+    itr = ib_hash_iterator_create_malloc();
+    if (itr == NULL) {
+        return IB_EALLOC;
+    }
+
+    /* Size the snapshot. */
+    for (
+        ib_hash_iterator_first(itr, manager->name_to_engine);
+        ! ib_hash_iterator_at_end(itr);
+        ib_hash_iterator_next(itr)
+    ) {
+        const char *name;
+        size_t      name_len;
+
+        ib_hash_iterator_fetch(&name, &name_len, NULL, itr);
+        names_size += name_len + 1;
+    }
+    for (size_t num = 0; num < manager->engine_count; ++num) {
+        if (! manager->engine_list[num]->retired) {
+            ++engine_count;
+        }
+    }
+
+    /* Allocate it as a single block: header, arrays, then names. */
+    snapshot = malloc(
+        sizeof(*snapshot) +
+        (named_count * sizeof(*(snapshot->named))) +
+        (engine_count * sizeof(*(snapshot->engines))) +
+        names_size);
+    if (snapshot == NULL) {
+        free(itr);
+        return IB_EALLOC;
+    }
+    snapshot->named_count = named_count;
+    snapshot->named = (manager_named_t *)(snapshot + 1);
+    snapshot->engine_count = engine_count;
+    snapshot->engines = (manager_managed_t *)(snapshot->named + named_count);
+    names = (char *)(snapshot->engines + engine_count);
+
+    /* Fill it in. */
+    n = 0;
+    for (
+        ib_hash_iterator_first(itr, manager->name_to_engine);
+        ! ib_hash_iterator_at_end(itr);
+        ib_hash_iterator_next(itr)
+    ) {
+        const char          *name;
+        size_t               name_len;
+        ib_manager_engine_t *wrapper;
+
+        ib_hash_iterator_fetch(&name, &name_len, &wrapper, itr);
+        memcpy(names, name, name_len);
+        names[name_len] = '\0';
+        snapshot->named[n].name = names;
+        snapshot->named[n].wrapper = wrapper;
+        names += name_len + 1;
+        ++n;
+    }
+    free(itr);
+
+    n = 0;
+    for (size_t num = 0; num < manager->engine_count; ++num) {
+        ib_manager_engine_t *wrapper = manager->engine_list[num];
+
+        if (! wrapper->retired) {
+            snapshot->engines[n].engine = wrapper->engine;
+            snapshot->engines[n].wrapper = wrapper;
+            ++n;
+        }
+    }
+
+    /* Publish it and reclaim the previous snapshot. */
+    previous = ib_atomic_exchange(&(manager->snapshot), snapshot);
+    if (previous != NULL) {
+        manager_synchronize(manager);
+        free(previous);
+    }
+
+    return IB_OK;
+}
+
 /**
  * Destroy IronBee engines with a reference count of zero.
  *
@@ -164,8 +454,47 @@ static void destroy_inactive_engines(
 {
     assert(manager != NULL);
     const size_t list_sz = manager->engine_count;
+    size_t       retired = 0;
+    size_t       num;
+
+    /* Quick check for anything to do. */
+    for (num = 0; num < list_sz; ++num) {
+        if (ib_atomic_load(&(manager->engine_list[num]->ref_count)) == 0) {
+            break;
+        }
+    }
+    if (num == list_sz) {
+        return;
+    }
+
+    /* Wait out acquires which may have seen an engine while it was still
+     * named.  After this, the reference count of an engine which is no
+     * longer named can only decrease, so zero is final. */
+    manager_synchronize(manager);
 
-    /* Destroy all non-current engines with zero reference count */
+    /* Retire all non-current engines with zero reference count */
+    for (size_t num = 0; num < list_sz; ++num) {
+        ib_manager_engine_t *wrapper = manager->engine_list[num];
+        assert(wrapper != NULL);
+
+        if (ib_atomic_load(&(wrapper->ref_count)) == 0) {
+            wrapper->retired = true;
+            ++retired;
+        }
+    }
+    if (retired == 0) {
+        return;
+    }
+
+    /* Unpublish the retired engines before destroying them. */
+    if (manager_snapshot_publish(manager) != IB_OK) {
+        for (size_t num = 0; num < list_sz; ++num) {
+            manager->engine_list[num]->retired = false;
+        }
+        return;
+    }
+
+    /* Destroy all retired engines */
     for (size_t num = 0; num < list_sz; ++num) {
 
         /* Get and check the wrapper for the IronBee engine. */
@@ -176,7 +505,7 @@ static void destroy_inactive_engines(
         ib_engine_t *engine = wrapper->engine;
         assert(engine != NULL);
 
-        if ( wrapper->ref_count == 0) {
+        if (wrapper->retired) {
             --(manager->engine_count);
 
             /* Note: This will destroy the engine wrapper object, too */
@@ -418,6 +747,9 @@ void ib_manager_destroy(
         ib_engine_destroy(manager_engine->engine);
     }
 
+    /* Free the engine snapshot. */
+    free(manager->snapshot);
+
     /* Destroy the manager by destroying it's memory pool. */
     ib_mpool_destroy(manager->mpool);
 
@@ -436,12 +768,18 @@ void ib_manager_destroy(
  * - Demote the current engine, removing the manager's reference count.
  * - Promote @a engine to current, adding a manager reference count.
  *
+ * If the engine can not be published, the manager is left unchanged and
+ * the caller remains responsible for @a engine.
+ *
  * @param[in] manager Engine manager.
  * @param[in] name The unique name of the engine being registered.
  * @param[in] engine Engine wrapper object.
  *
+ * @returns
+ * - IB_OK On success.
+ * - Other if the engine could not be published.
  */
-static void register_engine(
+static ib_status_t register_engine(
     ib_manager_t        *manager,
     const char          *name,
     ib_manager_engine_t *engine
@@ -454,6 +792,7 @@ static void register_engine(
 
     ib_status_t          rc;
     ib_manager_engine_t *previous_engine;
+    bool                 is_current = false;
 
     /* Store the engine in the list of all engines. */
     manager->engine_list[manager->engine_count] = engine;
@@ -482,14 +821,38 @@ static void register_engine(
     }
     else {
         /* Add a reference count to the current engine for the manager. */
-        ++(engine->ref_count);
+        ib_atomic_add(&(engine->ref_count), 1);
+        is_current = true;
+    }
+
+    /* Make the engine available to ib_manager_engine_acquire(). */
+    rc = manager_snapshot_publish(manager);
+    if (rc != IB_OK) {
+        ib_log_error(
+            engine->engine,
+            "Failed to publish engine %s: %s",
+            name, ib_status_to_string(rc));
+
+        /* Undo the registration; the previous snapshot is still live. */
+        if (is_current) {
+            ib_atomic_sub(&(engine->ref_count), 1);
+            if (previous_engine != NULL) {
+                ib_hash_set(manager->name_to_engine, name, previous_engine);
+            }
+            else {
+                ib_hash_remove(manager->name_to_engine, NULL, name);
+            }
+        }
+        --(manager->engine_count);
+        manager->engine_list[manager->engine_count] = NULL;
+        return rc;
     }
 
     /* If there was a previous engine, clean it up. */
     if (previous_engine != NULL) {
 
         /* Remove the engine manager's reference to the engine. */
-        --(previous_engine->ref_count);
+        ib_atomic_sub(&(previous_engine->ref_count), 1);
 
         /* Tell the engine that we would like to shut down. */
         rc = ib_state_notify_engine_shutdown_initiated(
@@ -500,6 +863,8 @@ static void register_engine(
                 "Failed to signal previous engine to shutdown.");
         }
     }
+
+    return IB_OK;
 }
 
 /**
@@ -706,7 +1071,12 @@ ib_status_t ib_manager_engine_create(
     }
 
     /* ... and register that engine with the manager. */
-    register_engine(manager, name, wrapper);
+    rc = register_engine(manager, name, wrapper);
+    if (rc != IB_OK) {
+        /* Note: This will destroy the engine wrapper object, too */
+        ib_engine_destroy(wrapper->engine);
+        goto cleanup;
+    }
 
     /* Destroy any inactive engines. */
     destroy_inactive_engines(manager);
@@ -747,10 +1117,13 @@ ib_status_t ib_manager_disable(
 {
     assert(manager != NULL);
 
-    ib_status_t      rc;
-    ib_list_t       *engines;
-    ib_mpool_lite_t *mp;
-    ib_mm_t          mm;
+    ib_status_t         rc;
+    ib_status_t         tmp_rc;
+    ib_list_t          *engines;
+    ib_hash_t          *named;
+    ib_hash_iterator_t *itr;
+    ib_mpool_lite_t    *mp;
+    ib_mm_t             mm;
 
     rc = ib_mpool_lite_create(&mp);
     if (rc != IB_OK) {
@@ -760,25 +1133,70 @@ ib_status_t ib_manager_disable(
     mm = ib_mm_mpool_lite(mp);
 
     rc = ib_list_create(&engines, mm);
-    if (rc != IB_OK) {
-        goto cleanup;
+    if (rc == IB_OK) {
+        rc = ib_hash_create(&named, mm);
+    }
+    if (rc == IB_OK) {
+        itr = ib_hash_iterator_create(mm);
+        rc = (itr == NULL) ? IB_EALLOC : IB_OK;
+    }
+    if (rc == IB_OK) {
+        rc = ib_lock_lock(manager->manager_lck);
     }
-
-    rc = ib_lock_lock(manager->manager_lck);
     if (rc != IB_OK) {
-        goto cleanup;
+        ib_mpool_lite_destroy(mp);
+        return rc;
     }
 
     rc = ib_hash_get_all(manager->name_to_engine, engines);
     if (rc != IB_OK) {
+        ib_list_clear(engines);
         goto cleanup;
     }
 
+    /* Keep the names, to restore them if publishing fails. */
+    for (
+        ib_hash_iterator_first(itr, manager->name_to_engine);
+        ! ib_hash_iterator_at_end(itr);
+        ib_hash_iterator_next(itr)
+    ) {
+        const char *name;
+        size_t      name_len;
+        void       *wrapper;
+
+        ib_hash_iterator_fetch(&name, &name_len, &wrapper, itr);
+        rc = ib_hash_set_ex(named, name, name_len, wrapper);
+        if (rc != IB_OK) {
+            ib_list_clear(engines);
+            goto cleanup;
+        }
+    }
+
     /* We've captured all the engines in the name-value map.
      * Remove them from the map. They still have a +1 reference count
      * which we must take care of, but we'll do that outside this loop. */
     ib_hash_clear(manager->name_to_engine);
 
+    /* Stop handing them out. */
+    rc = manager_snapshot_publish(manager);
+    if (rc != IB_OK) {
+        /* The previous snapshot is still live; keep the engines. */
+        for (
+            ib_hash_iterator_first(itr, named);
+            ! ib_hash_iterator_at_end(itr);
+            ib_hash_iterator_next(itr)
+        ) {
+            const char *name;
+            size_t      name_len;
+            void       *wrapper;
+
+            ib_hash_iterator_fetch(&name, &name_len, &wrapper, itr);
+            ib_hash_set_ex(manager->name_to_engine, name, name_len, wrapper);
+        }
+        ib_list_clear(engines);
+        goto cleanup;
+    }
+
     /* The last thing we do before releasing the lock is flagging the
      * manager as disabled. */
     manager->enabled = false;
@@ -801,16 +1219,16 @@ cleanup:
         assert(previous_engine != NULL);
 
         /* Let the previous engine know it is to shut down. */
-        rc = ib_state_notify_engine_shutdown_initiated(previous_engine);
-        if (rc != IB_OK) {
+        tmp_rc = ib_state_notify_engine_shutdown_initiated(previous_engine);
+        if (tmp_rc != IB_OK) {
             ib_log_error(
                 previous_engine,
                 "Failed to signal previous engine to shutdown.");
         }
 
         /* Release the reference count of the engine manager to this engine. */
-        rc = ib_manager_engine_release(manager, previous_engine);
-        if (rc != IB_OK) {
+        tmp_rc = ib_manager_engine_release(manager, previous_engine);
+        if (tmp_rc != IB_OK) {
             ib_log_error(
                 previous_engine,
                 "Failed to release manager reference to the current engine.");
@@ -829,47 +1247,33 @@ cleanup:
 }
 
 /**
- * Return any live engine reference.
+ * Find a named engine in a snapshot.
  *
- * This function does not lock and must be protected.
+ * @param[in] snapshot The snapshot (may be NULL).
+ * @param[in] name The name, or @ref IB_MANAGER_ENGINE_NAME_ANY.
  *
- * @param[in] manager The manager to interrogate.
- * @param[out] pengine The engine. Unchanged if none found.
- *
- * @returns
- * - IB_OK On success.
- * - IB_DECLINED If nothing found.
- * - IB_EALLOC If cannot malloc the hash iterator.
+ * @returns The engine wrapper or NULL if not found.
  */
-static ib_status_t manager_engine_acquire_any(
-    ib_manager_t         *manager,
-    ib_manager_engine_t **pengine
+static ib_manager_engine_t *manager_snapshot_find(
+    const manager_snapshot_t *snapshot,
+    const char               *name
 )
 {
-    ib_hash_iterator_t  *itr = ib_hash_iterator_create_malloc();
-    const char          *name;
-    size_t               name_len;
-    ib_status_t          rc;
-
-    if (itr == NULL) {
-        return IB_EALLOC;
+    if ( (snapshot == NULL) || (snapshot->named_count == 0) ) {
+        return NULL;
     }
 
-    ib_hash_iterator_first(itr, manager->name_to_engine);
-
-    if (ib_hash_iterator_at_end(itr)) {
-        rc = IB_DECLINED;
-        goto cleanup;
-    }
-    else {
-        rc = IB_OK;
+    if (strcmp(name, IB_MANAGER_ENGINE_NAME_ANY) == 0) {
+        return snapshot->named[0].wrapper;
     }
 
-    ib_hash_iterator_fetch(&name, &name_len, pengine, itr);
+    for (size_t num = 0; num < snapshot->named_count; ++num) {
+        if (strcmp(name, snapshot->named[num].name) == 0) {
+            return snapshot->named[num].wrapper;
+        }
+    }
 
-cleanup:
-    free(itr);
-    return rc;
+    return NULL;
 }
 
 ib_status_t ib_manager_engine_acquire(
@@ -883,25 +1287,19 @@ ib_status_t ib_manager_engine_acquire(
     assert(pengine != NULL);
 
     ib_status_t          rc;
-    ib_manager_engine_t *engine = NULL;
-
-    /* Grab the engine list lock */
-    rc = ib_lock_lock(manager->manager_lck);
-    if (rc != IB_OK) {
-        return rc;
-    }
+    ib_manager_engine_t *engine;
+    size_t               token;
 
-    if (strcmp(name, IB_MANAGER_ENGINE_NAME_ANY) == 0) {
-        rc = manager_engine_acquire_any(manager, &engine);
-    }
-    else {
-        rc = ib_hash_get(manager->name_to_engine, &engine, name);
-    }
+    /* No lock is taken: the snapshot is stable while we are reading. */
+    token = manager_read_lock(manager);
 
-    if (rc == IB_OK) {
+    engine = manager_snapshot_find(
+        ib_atomic_load(&(manager->snapshot)),
+        name);
+    if (engine != NULL) {
 
         /* Increment and return the engine. */
-        ++(engine->ref_count);
+        ib_atomic_add(&(engine->ref_count), 1);
         *pengine = engine->engine;
 
         rc = IB_OK;
@@ -910,7 +1308,7 @@ ib_status_t ib_manager_engine_acquire(
         rc = IB_DECLINED;
     }
 
-    ib_lock_unlock(manager->manager_lck);
+    manager_read_unlock(manager, token);
     return rc;
 }
 
@@ -922,22 +1320,23 @@ ib_status_t ib_manager_engine_release(
     assert(manager != NULL);
     assert(engine != NULL);
 
-    ib_status_t          rc;
-    ib_manager_engine_t *managed_engine = NULL;
+    ib_status_t               rc;
+    ib_manager_engine_t      *managed_engine = NULL;
+    const manager_snapshot_t *snapshot;
+    size_t                    token;
 
-    /* Grab the engine list lock */
-    rc = ib_lock_lock(manager->manager_lck);
-    if (rc != IB_OK) {
-        return rc;
-    }
+    /* No lock is taken: the snapshot is stable while we are reading. */
+    token = manager_read_lock(manager);
 
     /* Find an old engine that's being released. */
-    for (size_t num = 0; num < manager->engine_count; ++num) {
-        ib_manager_engine_t *cur = manager->engine_list[num];
-
-        /* Decrement the reference count if the engine matches. */
-        if (engine == cur->engine) {
-            managed_engine = cur;
+    snapshot = ib_atomic_load(&(manager->snapshot));
+    for (
+        size_t num = 0;
+        (snapshot != NULL) && (num < snapshot->engine_count);
+        ++num
+    ) {
+        if (engine == snapshot->engines[num].engine) {
+            managed_engine = snapshot->engines[num].wrapper;
 
             /* Leave the loop as we won't find engine a second time. */
             break;
@@ -946,12 +1345,14 @@ ib_status_t ib_manager_engine_release(
 
     /* Found the engine in this manager. Release it. */
     if (managed_engine != NULL) {
-
-        /* Quick sanity check. Never release an unowned engine. */
-        assert(managed_engine->ref_count > 0);
+        size_t ref_count;
 
         /* Release the engine. */
-        --(managed_engine->ref_count);
+        ref_count = ib_atomic_sub(&(managed_engine->ref_count), 1);
+
+        /* Quick sanity check. Never release an unowned engine. */
+        assert(ref_count != SIZE_MAX);
+        (void)ref_count;
 
         rc = IB_OK;
     }
@@ -961,8 +1362,7 @@ ib_status_t ib_manager_engine_release(
         rc = IB_EINVAL;
     }
 
-    /* Release the lock. */
-    ib_lock_unlock(manager->manager_lck);
+    manager_read_unlock(manager, token);
 
     return rc;
 }
@@ -1103,7 +1503,7 @@ ib_status_t DLL_PUBLIC ib_manager_engine_status(
 
         es->id        = ib_engine_instance_id(e->engine);
         es->uptime    = IB_CLOCK_SECS(time_now - e->created);
-        es->ref_count = e->ref_count;
+        es->ref_count = ib_atomic_load_relaxed(&(e->ref_count));
 
         // FIXME - this is useless information.
         es->current   = false;
@@ -27,10 +27,13 @@
 #include <ironbee/engine_manager_control_channel.h>
 
 #include <ironbee/engine_manager.h>
+#include <ironbee/escape.h>
 #include <ironbee/hash.h>
+#include <ironbee/logger.h>
 #include <ironbee/mm.h>
 #include <ironbee/mm_mpool_lite.h>
 #include <ironbee/mpool_lite.h>
+#include <ironbee/rule_engine.h>
 
 #ifdef HAVE_VALGRIND
 #include <valgrind/memcheck.h>
@@ -39,6 +42,8 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <inttypes.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <sys/socket.h>
@@ -491,6 +496,360 @@ static ib_status_t manager_cmd_cleanup(
     return ib_manager_engine_cleanup(manager);
 }
 
+/**
+ * Space for one rule_stats line, excluding the rule id.
+ */
+#define RULE_STATS_LINE_MAX 320
+
+/**
+ * A rule and its statistics as collected by manager_cmd_rule_stats().
+ */
+struct rule_stats_entry_t {
+    const ib_rule_t *rule;  /**< The rule. */
+    ib_rule_stats_t  stats; /**< Statistics of @ref rule. */
+    uint64_t         total; /**< Sum of all times in @ref stats. */
+};
+typedef struct rule_stats_entry_t rule_stats_entry_t;
+
+/**
+ * Callback data of rule_stats_collect().
+ */
+struct rule_stats_collect_t {
+    ib_mm_t    mm;   /**< Memory manager for entries. */
+    ib_list_t *list; /**< List of @ref rule_stats_entry_t. */
+};
+typedef struct rule_stats_collect_t rule_stats_collect_t;
+
+/**
+ * Collect rule statistics into a list of @ref rule_stats_entry_t.
+ *
+ * @param[in] rule The rule.
+ * @param[in] stats Statistics of @a rule.
+ * @param[in] cbdata The @ref rule_stats_collect_t to append to.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation errors.
+ */
+static ib_status_t rule_stats_collect(
+    const ib_rule_t       *rule,
+    const ib_rule_stats_t *stats,
+    void                  *cbdata
+)
+{
+    assert(rule != NULL);
+    assert(stats != NULL);
+    assert(cbdata != NULL);
+
+    rule_stats_collect_t *collect = (rule_stats_collect_t *)cbdata;
+    rule_stats_entry_t   *entry;
+
+    entry = ib_mm_alloc(collect->mm, sizeof(*entry));
+    if (entry == NULL) {
+        return IB_EALLOC;
+    }
+    entry->rule  = rule;
+    entry->stats = *stats;
+    entry->total =
+        stats->operator_time + stats->tfn_time + stats->action_time;
+
+    return ib_list_push(collect->list, entry);
+}
+
+/**
+ * Order @ref rule_stats_entry_t pointers by descending total time.
+ */
+static int rule_stats_cmp(const void *a, const void *b)
+{
+    const rule_stats_entry_t *ea = *(const rule_stats_entry_t * const *)a;
+    const rule_stats_entry_t *eb = *(const rule_stats_entry_t * const *)b;
+
+    if (ea->total != eb->total) {
+        return (ea->total < eb->total) ? 1 : -1;
+    }
+    return (ea->rule->meta.index < eb->rule->meta.index) ? -1 : 1;
+}
+
+/**
+ * Report per-rule statistics of the current engine as JSON.
+ *
+ * Rules are ordered by descending total time (operator, transformations
+ * and actions), so the most expensive rules come first.  Rules that have
+ * never executed are omitted.  Times are in nanoseconds.
+ *
+ * @param[in] mm Memory manager for allocations of @a result and other
+ *            allocations that should live until the response is sent.
+ * @param[in] name The name this command is called by.
+ * @param[in] args Optional maximum number of rules to report.
+ * @param[out] result The JSON report.
+ * @param[in] cbdata The @ref ib_manager_t * to act on.
+ *
+ * @sa ib_rule_stats_foreach()
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EINVAL If @a args is not a number.
+ * - IB_EALLOC On allocation errors.
+ * - IB_DECLINED If there is no current engine.
+ */
+static ib_status_t manager_cmd_rule_stats(
+    ib_mm_t      mm,
+    const char  *name,
+    const char  *args,
+    const char **result,
+    void        *cbdata
+)
+{
+    assert(args != NULL);
+    assert(cbdata != NULL);
+
+    const char *PRELUDE = "{ \"rules\": [\n";
+    const char *EPILOGUE = "] }\n";
+
+    ib_manager_t              *manager = (ib_manager_t *)cbdata;
+    ib_engine_t               *ib;
+    ib_status_t                rc;
+    rule_stats_collect_t       collect;
+    const ib_list_node_t      *node;
+    const rule_stats_entry_t **entries;
+    size_t                     count;
+    size_t                     limit = SIZE_MAX;
+    size_t                     i = 0;
+    char                      *answer;
+    size_t                     answer_len;
+    size_t                     answer_sz;
+
+    /* Parse the optional limit. */
+    while (*args == ' ') {
+        ++args;
+    }
+    if (*args != '\0') {
+        char *end;
+
+        errno = 0;
+        limit = strtoul(args, &end, 10);
+        if (errno != 0 || end == args || (*end != '\0' && *end != ' ')) {
+            return IB_EINVAL;
+        }
+    }
+
+    collect.mm = mm;
+    rc = ib_list_create(&collect.list, mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    rc = ib_manager_engine_acquire(
+        manager,
+        IB_MANAGER_ENGINE_NAME_DEFAULT,
+        &ib);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    /* Rules belong to the engine, so render before releasing it. */
+    rc = ib_rule_stats_foreach(ib, rule_stats_collect, &collect);
+    if (rc != IB_OK) {
+        goto release;
+    }
+
+    count = ib_list_elements(collect.list);
+    entries = ib_mm_alloc(mm, sizeof(*entries) * (count + 1));
+    if (entries == NULL) {
+        rc = IB_EALLOC;
+        goto release;
+    }
+    IB_LIST_LOOP_CONST(collect.list, node) {
+        entries[i++] = ib_list_node_data_const(node);
+    }
+    qsort(entries, count, sizeof(*entries), rule_stats_cmp);
+    if (count > limit) {
+        count = limit;
+    }
+
+    /* Render each rule as one line of JSON. */
+    answer_sz = RULE_STATS_LINE_MAX * (count + 1);
+    answer = ib_mm_alloc(mm, answer_sz);
+    if (answer == NULL) {
+        rc = IB_EALLOC;
+        goto release;
+    }
+    strcpy(answer, PRELUDE);
+    answer_len = strlen(PRELUDE);
+    for (i = 0; i < count; ++i) {
+        const rule_stats_entry_t *entry = entries[i];
+        const char               *id = ib_rule_id(entry->rule);
+        size_t                    id_sz = strlen(id) * 6 + 3;
+        char                     *id_json;
+        size_t                    id_json_len;
+        int                       n;
+
+        /* Rule ids come from configuration; escape them. */
+        id_json = ib_mm_alloc(mm, id_sz);
+        if (id_json == NULL) {
+            rc = IB_EALLOC;
+            goto release;
+        }
+        rc = ib_string_escape_json_buf(
+            (const uint8_t *)id, strlen(id),
+            id_json, id_sz, &id_json_len);
+        if (rc != IB_OK) {
+            goto release;
+        }
+
+        /* Grow the buffer for unexpectedly long rule ids. */
+        if (answer_len + id_json_len + RULE_STATS_LINE_MAX > answer_sz) {
+            char *grown;
+
+            answer_sz = (answer_sz + id_json_len) * 2;
+            grown = ib_mm_alloc(mm, answer_sz);
+            if (grown == NULL) {
+                rc = IB_EALLOC;
+                goto release;
+            }
+            memcpy(grown, answer, answer_len + 1);
+            answer = grown;
+        }
+
+        n = snprintf(
+            answer + answer_len,
+            answer_sz - answer_len,
+            "    { \"id\": %s, \"executions\": %" PRIu64
+            ", \"matches\": %" PRIu64
+            ", \"operator_ns\": %" PRIu64
+            ", \"tfn_ns\": %" PRIu64
+            ", \"action_ns\": %" PRIu64
+            ", \"total_ns\": %" PRIu64 " }%s\n",
+            id_json,
+            entry->stats.executions,
+            entry->stats.matches,
+            entry->stats.operator_time,
+            entry->stats.tfn_time,
+            entry->stats.action_time,
+            entry->total,
+            (i + 1 < count) ? "," : ""
+        );
+        if (n < 0) {
+            rc = IB_EOTHER;
+            goto release;
+        }
+        answer_len += n;
+    }
+    strcpy(answer + answer_len, EPILOGUE);
+
+    *result = answer;
+
+release:
+    ib_manager_engine_release(manager, ib);
+    return rc;
+}
+
+/**
+ * Zero the per-rule statistics of the current engine.
+ *
+ * @param[in] mm Memory manager for allocations of @a result and other
+ *            allocations that should live until the response is sent.
+ * @param[in] name The name this command is called by.
+ * @param[in] args Unused.
+ * @param[out] result This is unchanged.
+ * @param[in] cbdata The @ref ib_manager_t * to act on.
+ *
+ * @sa ib_rule_stats_reset()
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_DECLINED If there is no current engine.
+ */
+static ib_status_t manager_cmd_rule_stats_reset(
+    ib_mm_t      mm,
+    const char  *name,
+    const char  *args,
+    const char **result,
+    void        *cbdata
+)
+{
+    assert(cbdata != NULL);
+
+    ib_manager_t *manager = (ib_manager_t *)cbdata;
+    ib_engine_t  *ib;
+    ib_status_t   rc;
+
+    rc = ib_manager_engine_acquire(
+        manager,
+        IB_MANAGER_ENGINE_NAME_DEFAULT,
+        &ib);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    ib_rule_stats_reset(ib);
+
+    return ib_manager_engine_release(manager, ib);
+}
+
+/**
+ * Space for the log_queue_stats report.
+ */
+#define LOG_QUEUE_STATS_MAX 128
+
+/**
+ * Report the log record queue statistics of the current engine as JSON.
+ *
+ * @param[in] mm Memory manager for allocations of @a result and other
+ *            allocations that should live until the response is sent.
+ * @param[in] name The name this command is called by.
+ * @param[in] args Unused.
+ * @param[out] result The JSON report.
+ * @param[in] cbdata The @ref ib_manager_t * to act on.
+ *
+ * @sa ib_logger_queue_stats()
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation errors.
+ * - IB_DECLINED If there is no current engine.
+ */
+static ib_status_t manager_cmd_log_queue_stats(
+    ib_mm_t      mm,
+    const char  *name,
+    const char  *args,
+    const char **result,
+    void        *cbdata
+)
+{
+    assert(cbdata != NULL);
+
+    ib_manager_t            *manager = (ib_manager_t *)cbdata;
+    ib_engine_t             *ib;
+    ib_logger_queue_stats_t  stats;
+    char                    *answer;
+    ib_status_t              rc;
+
+    answer = ib_mm_alloc(mm, LOG_QUEUE_STATS_MAX);
+    if (answer == NULL) {
+        return IB_EALLOC;
+    }
+
+    rc = ib_manager_engine_acquire(
+        manager,
+        IB_MANAGER_ENGINE_NAME_DEFAULT,
+        &ib);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    ib_logger_queue_stats(ib_engine_logger_get(ib), &stats);
+
+    snprintf(
+        answer,
+        LOG_QUEUE_STATS_MAX,
+        "{ \"depth\": %zu, \"high_water\": %zu, \"dropped\": %zu }\n",
+        stats.depth,
+        stats.high_water,
+        stats.dropped);
+    *result = answer;
+
+    return ib_manager_engine_release(manager, ib);
+}
+
 /**
  * Log an error message through the current IronBee engine.
  *
@@ -1172,10 +1531,13 @@ ib_status_t DLL_PUBLIC ib_engine_manager_control_manager_diag_register(
         const char                                 *name;
         ib_engine_manager_control_channel_cmd_fn_t  fn;
     } cmds[] = {
-        { "valgrind",       manager_diag_valgrind },
-        { "valgrind_added", manager_diag_valgrind_added },
-        { "version",        manager_diag_version },
-        { NULL,             NULL }
+        { "valgrind",         manager_diag_valgrind },
+        { "valgrind_added",   manager_diag_valgrind_added },
+        { "version",          manager_diag_version },
+        { "rule_stats",       manager_cmd_rule_stats },
+        { "rule_stats_reset", manager_cmd_rule_stats_reset },
+        { "log_queue_stats",  manager_cmd_log_queue_stats },
+        { NULL,               NULL }
     };
 
     for (int i = 0; cmds[i].name != NULL; ++i) {
@@ -158,6 +158,8 @@ struct ib_engine_t {
     const char            *sensor_hostname; /**< Sensor hostname */
     char                   instance_id[IB_UUID_LENGTH]; /**< Engine instance UUID */
     ib_cfgparser_t        *cfgparser;       /**< Our configuration parser */
+    size_t                 config_workers;  /**< Config worker threads */
+    ib_list_t             *config_jobs;     /**< Pending config jobs */
 
     /// @todo Only these should be private
     const ib_server_t     *server;          /**< Info about the server */
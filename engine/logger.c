@@ -25,12 +25,27 @@
 #include "ironbee_config_auto.h"
 
 #include <ironbee/logger.h>
+#include <ironbee/atomic.h>
 #include <ironbee/mm_mpool_lite.h>
 #include <ironbee/string.h>
 #include <ironbee/type_convert.h>
 
 #include <assert.h>
+#include <sched.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <time.h>
+
+/**
+ * A slot in a writer's record ring.
+ *
+ * The sequence number tells producers and consumers whose turn it is to
+ * use the slot, so neither needs a lock.
+ */
+typedef struct logger_slot_t {
+    size_t  seq; /**< Slot sequence number. */
+    void   *rec; /**< Formatted record. */
+} logger_slot_t;
 
 /**
  * A collection of callbacks and function pointer that implement a logger.
@@ -45,8 +60,36 @@ struct ib_logger_writer_t {
     ib_logger_format_t    *format;      /**< Format a message.  */
     ib_logger_record_fn_t  record_fn;   /**< Signal a record is ready. */
     void                  *record_data; /**< Callback data. */
-    ib_queue_t            *records;     /**< Records for the log writer. */
-    ib_lock_t             *records_lck; /**< Guard the queue. */
+
+    /**
+     * Bounded multi-producer ring of records for the log writer.
+     *
+     * Formatting threads enqueue without locking. The ring is also safe
+     * for multiple consumers, which allows producers to discard the
+     * oldest record under @ref IB_LOGGER_OVERFLOW_DROP_OLDEST.
+     */
+    logger_slot_t         *slots;
+    size_t                 mask;        /**< Ring capacity - 1. */
+    size_t                 head;        /**< Next enqueue position. */
+    size_t                 tail;        /**< Next dequeue position. */
+
+    /**
+     * Records enqueued but not yet dequeued.
+     *
+     * This is signed as a dequeue may be counted before the matching
+     * enqueue. The producer that moves this from 0 to 1 calls
+     * ib_logger_writer_t::record_fn.
+     */
+    ssize_t                depth;
+    size_t                 high_water;  /**< Largest depth seen. */
+    size_t                 dropped;     /**< Records dropped on overflow. */
+
+    /**
+     * Serializes ib_logger_dequeue() so records are handled in order.
+     *
+     * Producers never take this lock.
+     */
+    ib_lock_t             *dequeue_lck;
 };
 
 //! Identify the type of a logger callback function.
@@ -111,6 +154,21 @@ struct ib_logger_t {
      * retrieved to assist clients to this API to better share functions.
      */
      ib_hash_t *functions;
+
+    /**
+     * Capacity of record queues of writers added to this logger.
+     */
+    size_t               queue_capacity;
+
+    /**
+     * What writers do when their record queue is full.
+     */
+    ib_logger_overflow_t queue_overflow;
+
+    /**
+     * Maximum microseconds to wait with @ref IB_LOGGER_OVERFLOW_BLOCK.
+     */
+    ib_time_t            queue_max_wait;
 };
 
 /**
@@ -203,17 +261,172 @@ typedef struct logger_write_cbdata_t {
 } logger_write_cbdata_t;
 
 /**
- * The maximum depth of a message queue in a @ref ib_logger_writer_t.
+ * Microseconds a blocked formatting thread sleeps between enqueue attempts.
+ */
+static const long QUEUE_BLOCK_NAP = 50;
+
+/**
+ * Try to add @a rec to @a writer's ring.
+ *
+ * @param[in] writer The writer.
+ * @param[in] rec The record.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EAGAIN If the ring is full.
+ */
+static ib_status_t writer_ring_push(
+    ib_logger_writer_t *writer,
+    void               *rec
+)
+{
+    logger_slot_t *slot;
+    size_t         pos = ib_atomic_load_relaxed(&writer->head);
+
+    for (;;) {
+        intptr_t diff;
+
+        slot = &writer->slots[pos & writer->mask];
+        diff = (intptr_t)ib_atomic_load(&slot->seq) - (intptr_t)pos;
+        if (diff == 0) {
+            if (ib_atomic_cas(&writer->head, &pos, pos + 1)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            return IB_EAGAIN;
+        }
+        else {
+            pos = ib_atomic_load_relaxed(&writer->head);
+        }
+    }
+
+    slot->rec = rec;
+    ib_atomic_store(&slot->seq, pos + 1);
+
+    return IB_OK;
+}
+
+/**
+ * Try to remove the oldest record from @a writer's ring.
+ *
+ * @param[in] writer The writer.
+ * @param[out] rec The record.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_ENOENT If no record is available.
+ */
+static ib_status_t writer_ring_pop(
+    ib_logger_writer_t  *writer,
+    void               **rec
+)
+{
+    logger_slot_t *slot;
+    size_t         pos = ib_atomic_load_relaxed(&writer->tail);
+
+    for (;;) {
+        intptr_t diff;
+
+        slot = &writer->slots[pos & writer->mask];
+        diff = (intptr_t)ib_atomic_load(&slot->seq) - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (ib_atomic_cas(&writer->tail, &pos, pos + 1)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            return IB_ENOENT;
+        }
+        else {
+            pos = ib_atomic_load_relaxed(&writer->tail);
+        }
+    }
+
+    *rec = slot->rec;
+    ib_atomic_store(&slot->seq, pos + writer->mask + 1);
+
+    return IB_OK;
+}
+
+/**
+ * Free a formatted record that will not be written.
+ *
+ * @param[in] logger The logger.
+ * @param[in] writer The writer that formatted @a rec.
+ * @param[in] rec The record.
+ */
+static void writer_drop(
+    ib_logger_t        *logger,
+    ib_logger_writer_t *writer,
+    void               *rec
+)
+{
+    if (writer->format->format_free_fn != NULL) {
+        writer->format->format_free_fn(
+            logger,
+            rec,
+            writer->format->format_free_cbdata);
+    }
+    ib_atomic_add_relaxed(&writer->dropped, 1);
+}
+
+/**
+ * Add @a rec to @a writer's ring, applying the overflow policy.
+ *
+ * @param[in] logger The logger.
+ * @param[in] writer The writer.
+ * @param[in] rec The record.
+ *
+ * @returns
+ * - IB_OK If @a rec was queued.
+ * - IB_DECLINED If @a rec was dropped. It has been freed.
  */
-static const size_t MAX_QUEUE_DEPTH = 1000;
+static ib_status_t writer_enqueue(
+    ib_logger_t        *logger,
+    ib_logger_writer_t *writer,
+    void               *rec
+)
+{
+    ib_time_t waited = 0;
+
+    while (writer_ring_push(writer, rec) != IB_OK) {
+        switch (ib_atomic_load_relaxed(&logger->queue_overflow)) {
+            case IB_LOGGER_OVERFLOW_DROP_OLDEST: {
+                void *old;
+
+                if (writer_ring_pop(writer, &old) == IB_OK) {
+                    ib_atomic_sub(&writer->depth, 1);
+                    writer_drop(logger, writer, old);
+                }
+                break;
+            }
+            case IB_LOGGER_OVERFLOW_BLOCK: {
+                struct timespec ts = { 0, QUEUE_BLOCK_NAP * 1000 };
+
+                if (waited < ib_atomic_load_relaxed(&logger->queue_max_wait)) {
+                    nanosleep(&ts, NULL);
+                    waited += QUEUE_BLOCK_NAP;
+                    break;
+                }
+            }
+            /* Fall through: waited long enough. */
+            case IB_LOGGER_OVERFLOW_DROP_NEWEST:
+            default:
+                writer_drop(logger, writer, rec);
+                return IB_DECLINED;
+        }
+    }
+
+    return IB_OK;
+}
 
 /**
  * The implementation for logger_log().
  *
  * This function will
  * - Format the message stored in @a cbdata as a @ref logger_write_cbdata_t.
- * - Lock the message queue.
- * - Enqueue the formatted message.
+ * - Enqueue the formatted message without locking.
  * - If the message is the only message in the queue,
  *   ib_logger_writer_t::record_fn is called to signal the
  *   writer that at least one record is available.
@@ -235,6 +448,7 @@ static ib_status_t logger_write(
     ib_status_t rc;
     void *rec = NULL;
     logger_write_cbdata_t *logger_write_data = (logger_write_cbdata_t *)cbdata;
+    ssize_t depth;
 
     if (writer->format == NULL) {
         return IB_DECLINED;
@@ -258,43 +472,22 @@ static ib_status_t logger_write(
         return rc;
     }
 
-    rc = ib_lock_lock(writer->records_lck);
-    if (rc != IB_OK) {
-        return rc;
-    }
-
-    /* Busy-wait until the queue has space available.
-     * This is emergency code to avoid a crash at the cost of a slowdown. */
-    while (ib_queue_size(writer->records) >= MAX_QUEUE_DEPTH) {
-        rc = ib_lock_unlock(writer->records_lck);
-        if (rc != IB_OK) {
-            return rc;
-        }
-
-        /* TODO - The number of times we need to sleep should be
-         *        audited. It is a good indicator of excessive logging or
-         *        proxy load. */
-        sleep(1);
-        rc = ib_lock_lock(writer->records_lck);
-        if (rc != IB_OK) {
-            return rc;
-        }
+    rc = writer_enqueue(logger, writer, rec);
+    if (rc == IB_DECLINED) {
+        return IB_OK;
     }
 
-    rc = ib_queue_push_front(writer->records, rec);
-    if (rc != IB_OK) {
-        return rc;
+    depth = ib_atomic_add(&writer->depth, 1);
+    if (depth > 0) {
+        ib_atomic_max(&writer->high_water, (size_t)depth);
     }
 
-    /* If the queue is size=1, unlock and notify writers. */
-    if (ib_queue_size(writer->records) == 1) {
-        ib_lock_unlock(writer->records_lck);
-        rc = writer->record_fn(logger, writer, writer->record_data);
-        return rc;
+    /* If the queue went from empty to non-empty, notify the writer. */
+    if (depth == 1) {
+        return writer->record_fn(logger, writer, writer->record_data);
     }
 
-    ib_lock_unlock(writer->records_lck);
-    return rc;
+    return IB_OK;
 }
 
 /**
@@ -633,6 +826,9 @@ ib_status_t ib_logger_create(
 
     l->level = level;
     l->mm = mm;
+    l->queue_capacity = IB_LOGGER_QUEUE_CAPACITY_DEFAULT;
+    l->queue_overflow = IB_LOGGER_OVERFLOW_BLOCK;
+    l->queue_max_wait = IB_LOGGER_QUEUE_WAIT_DEFAULT;
     rc = ib_list_create(&(l->writers), mm);
     if (rc != IB_OK) {
         return rc;
@@ -674,6 +870,11 @@ ib_status_t ib_logger_writer_add(
     ib_status_t         rc;
     ib_logger_writer_t *writer;
 
+    /* Guaranteed by ib_logger_queue_set(). */
+    if (logger->queue_capacity > SIZE_MAX / sizeof(*(writer->slots))) {
+        return IB_EINVAL;
+    }
+
     writer = (ib_logger_writer_t *)ib_mm_alloc(logger->mm, sizeof(*writer));
     if (writer == NULL) {
         return IB_EALLOC;
@@ -688,18 +889,23 @@ ib_status_t ib_logger_writer_add(
     writer->format      = format;
     writer->record_fn   = record_fn;
     writer->record_data = record_data;
-    rc = ib_queue_create(&(writer->records), logger->mm, IB_QUEUE_NEVER_SHRINK);
-    if (rc != IB_OK) {
-        return rc;
-    }
-    writer->records_lck = ib_mm_alloc(
+    writer->mask        = logger->queue_capacity - 1;
+    writer->head        = 0;
+    writer->tail        = 0;
+    writer->depth       = 0;
+    writer->high_water  = 0;
+    writer->dropped     = 0;
+    writer->slots       = ib_mm_alloc(
         logger->mm,
-        sizeof(*(writer->records_lck)));
-    if (writer->records_lck == NULL) {
+        logger->queue_capacity * sizeof(*(writer->slots)));
+    if (writer->slots == NULL) {
         return IB_EALLOC;
     }
-    rc = ib_lock_create(&(writer->records_lck), logger->mm)
-    ;
+    for (size_t i = 0; i < logger->queue_capacity; ++i) {
+        writer->slots[i].seq = i;
+        writer->slots[i].rec = NULL;
+    }
+    rc = ib_lock_create(&(writer->dequeue_lck), logger->mm);
     if (rc != IB_OK) {
         return rc;
     }
@@ -835,34 +1041,6 @@ ib_status_t ib_logger_reopen(
     return for_each_writer(logger, logger_reopen, NULL);
 }
 
-/**
- * Custom callback data for logger_handler().
- */
-struct logger_handler_cbdata_t {
-    ib_logger_t                *logger;    /**< The logger. */
-    ib_queue_element_fn_t       user_fn;   /**< User's callback function. */
-    void                       *user_data; /**< User's callback data. */
-    ib_logger_format_free_fn_t  free_fn;   /**< Free the queue element. */
-    void                       *free_data; /**< Free callback data. */
-};
-typedef struct logger_handler_cbdata_t logger_handler_cbdata_t;
-
-/**
- * Dispatches log message to handler, then frees them.
- */
-static void logger_handler(void *element, void *cbdata)
-{
-    assert(cbdata != NULL);
-
-    logger_handler_cbdata_t *data = (logger_handler_cbdata_t *)cbdata;
-
-    /* Let the user write the record. */
-    data->user_fn(element, data->user_data);
-
-    /* Free the data. */
-    data->free_fn(data->logger, element, data->free_data);
-}
-
 ib_status_t ib_logger_dequeue(
     ib_logger_t           *logger,
     ib_logger_writer_t    *writer,
@@ -872,30 +1050,115 @@ ib_status_t ib_logger_dequeue(
 {
     assert(logger != NULL);
     assert(writer != NULL);
-    assert(writer->records != NULL);
+    assert(writer->slots != NULL);
 
     ib_status_t rc;
-    logger_handler_cbdata_t logger_handler_cbdata = {
-        .logger    = logger,
-        .user_fn   = handler,
-        .user_data = cbdata,
-        .free_fn   = writer->format->format_free_fn,
-        .free_data = writer->format->format_free_cbdata
-    };
-
-    rc = ib_lock_lock(writer->records_lck);
+    void *rec;
+
+    rc = ib_lock_lock(writer->dequeue_lck);
     if (rc != IB_OK) {
         return rc;
     }
 
-    rc = ib_queue_dequeue_all_to_function(
-        writer->records,
-        logger_handler,
-        &logger_handler_cbdata);
+    for (;;) {
+        if (writer_ring_pop(writer, &rec) == IB_OK) {
+            ib_atomic_sub(&writer->depth, 1);
 
-    ib_lock_unlock(writer->records_lck);
+            /* Let the user write the record, then free it. */
+            handler(rec, cbdata);
+            if (writer->format->format_free_fn != NULL) {
+                writer->format->format_free_fn(
+                    logger,
+                    rec,
+                    writer->format->format_free_cbdata);
+            }
+            continue;
+        }
 
-    return rc;
+        /* A counted record that is not yet visible is still being
+         * published by a producer which will not notify us. Wait for it. */
+        if (ib_atomic_load(&writer->depth) <= 0) {
+            break;
+        }
+        sched_yield();
+    }
+
+    ib_lock_unlock(writer->dequeue_lck);
+
+    return IB_OK;
+}
+
+ib_status_t ib_logger_queue_set(
+    ib_logger_t          *logger,
+    size_t                capacity,
+    ib_logger_overflow_t  overflow,
+    ib_time_t             max_wait
+)
+{
+    assert(logger != NULL);
+
+    size_t pow2 = 1;
+    size_t max = SIZE_MAX / sizeof(logger_slot_t);
+
+    /* The largest power of two whose ring size fits a size_t. */
+    while (max & (max - 1)) {
+        max &= max - 1;
+    }
+    if (capacity == 0 || capacity > max) {
+        return IB_EINVAL;
+    }
+    while (pow2 < capacity) {
+        pow2 <<= 1;
+    }
+
+    logger->queue_capacity = pow2;
+    ib_atomic_store(&logger->queue_overflow, overflow);
+    ib_atomic_store(&logger->queue_max_wait, max_wait);
+
+    return IB_OK;
+}
+
+void ib_logger_writer_queue_stats(
+    const ib_logger_writer_t *writer,
+    ib_logger_queue_stats_t  *stats
+)
+{
+    assert(writer != NULL);
+    assert(stats != NULL);
+
+    ssize_t depth = ib_atomic_load_relaxed(&writer->depth);
+
+    stats->depth      = (depth > 0) ? (size_t)depth : 0;
+    stats->high_water = ib_atomic_load_relaxed(&writer->high_water);
+    stats->dropped    = ib_atomic_load_relaxed(&writer->dropped);
+}
+
+void ib_logger_queue_stats(
+    const ib_logger_t       *logger,
+    ib_logger_queue_stats_t *stats
+)
+{
+    assert(logger != NULL);
+    assert(stats != NULL);
+
+    const ib_list_node_t *node;
+
+    stats->depth      = 0;
+    stats->high_water = 0;
+    stats->dropped    = 0;
+
+    IB_LIST_LOOP_CONST(logger->writers, node) {
+        const ib_logger_writer_t *writer =
+            (const ib_logger_writer_t *)ib_list_node_data_const(node);
+        ib_logger_queue_stats_t writer_stats;
+
+        ib_logger_writer_queue_stats(writer, &writer_stats);
+        stats->depth   += writer_stats.depth;
+        stats->dropped += writer_stats.dropped;
+        if (writer_stats.high_water > stats->high_water) {
+            stats->high_water = writer_stats.high_water;
+        }
+    }
 }
 
 size_t ib_logger_writer_count(ib_logger_t *logger) {
@@ -28,6 +28,13 @@
 
 #include "engine_private.h"
 
+#include <ironbee/config.h>
+#include <ironbee/context.h>
+#include <ironbee/engine.h>
+#include <ironbee/flags.h>
+#include <ironbee/log.h>
+#include <ironbee/mm_mpool_lite.h>
+
 #include <assert.h>
 
 struct ib_operator_t {
@@ -373,6 +380,166 @@ ib_status_t ib_operator_inst_create(
 }
 
 
+/**
+ * An operator instance whose create function runs as a configuration job.
+ */
+typedef struct deferred_create_t deferred_create_t;
+struct deferred_create_t {
+    ib_operator_inst_t *op_inst; /**< Instance to complete */
+    ib_context_t       *ctx;     /**< Context the instance was created in */
+    ib_mpool_lite_t    *mpl;     /**< Memory owned by the create function */
+    const char         *file;    /**< Configuration file or NULL */
+    size_t              line;    /**< Configuration line */
+};
+
+/**
+ * Memory manager cleanup: destroy a deferred instance's memory.
+ *
+ * @param[in] cbdata The ib_mpool_lite_t.
+ */
+static void deferred_create_cleanup(void *cbdata)
+{
+    ib_mpool_lite_destroy((ib_mpool_lite_t *)cbdata);
+}
+
+/**
+ * Configuration job: run a deferred operator create function.
+ *
+ * @param[in] ib Engine.
+ * @param[in] cbdata The @ref deferred_create_t.
+ *
+ * @returns Status of the create function or cleanup registration.
+ */
+static ib_status_t deferred_create_job(ib_engine_t *ib, void *cbdata)
+{
+    deferred_create_t   *deferred = (deferred_create_t *)cbdata;
+    ib_operator_inst_t  *op_inst  = deferred->op_inst;
+    const ib_operator_t *op       = op_inst->op;
+    ib_mm_t              mm       = ib_mm_mpool_lite(deferred->mpl);
+    ib_status_t          rc;
+
+    rc = op->create_fn(
+        deferred->ctx,
+        mm,
+        op_inst->parameters,
+        &(op_inst->instance_data),
+        op->create_cbdata
+    );
+    if (rc != IB_OK) {
+        ib_cfg_log_error_ex(
+            ib, deferred->file, deferred->line,
+            "Error creating operator instance "
+            "operator=\"%s\" operand=\"%s\": %s",
+            op->name,
+            op_inst->parameters == NULL ? "" : op_inst->parameters,
+            ib_status_to_string(rc));
+        return rc;
+    }
+
+    if (op->destroy_fn != NULL) {
+        rc = ib_mm_register_cleanup(mm, cleanup_op, op_inst);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    return IB_OK;
+}
+
+ib_status_t ib_operator_inst_create_deferred(
+    ib_operator_inst_t  **op_inst,
+    ib_mm_t               mm,
+    ib_context_t         *ctx,
+    const ib_operator_t  *op,
+    ib_flags_t            required_capabilities,
+    const char           *parameters
+)
+{
+    assert(op_inst != NULL);
+    assert(ctx != NULL);
+    assert(op != NULL);
+
+    ib_engine_t        *ib = ib_context_get_engine(ctx);
+    ib_operator_inst_t *local_op_inst;
+    deferred_create_t  *deferred;
+    ib_status_t         rc;
+
+    if (
+        ! ib_flags_any(op->capabilities,
+                       IB_OP_CAPABILITY_THREAD_SAFE_CREATE) ||
+        op->create_fn == NULL ||
+        ib_engine_config_workers(ib) < 2
+    ) {
+        return ib_operator_inst_create(
+            op_inst, mm, ctx, op, required_capabilities, parameters
+        );
+    }
+
+    /* Verify that this operator is valid for this rule type */
+    if (
+        (op->capabilities & required_capabilities) !=
+        required_capabilities
+    ) {
+        return IB_EINVAL;
+    }
+
+    local_op_inst =
+        (ib_operator_inst_t *)ib_mm_alloc(mm, sizeof(*local_op_inst));
+    if (local_op_inst == NULL) {
+        return IB_EALLOC;
+    }
+    if (parameters != NULL) {
+        local_op_inst->parameters = ib_mm_strdup(mm, parameters);
+        if (local_op_inst->parameters == NULL) {
+            return IB_EALLOC;
+        }
+    }
+    else {
+        local_op_inst->parameters = NULL;
+    }
+    local_op_inst->op = op;
+    local_op_inst->instance_data = NULL;
+
+    deferred = (deferred_create_t *)ib_mm_alloc(mm, sizeof(*deferred));
+    if (deferred == NULL) {
+        return IB_EALLOC;
+    }
+    deferred->op_inst = local_op_inst;
+    deferred->ctx = ctx;
+    deferred->file = NULL;
+    deferred->line = 0;
+
+    /* Remember the directive, as the job may fail after it is parsed. */
+    if (ib->cfgparser != NULL && ib->cfgparser->curr != NULL) {
+        deferred->file =
+            ib_mm_strdup(mm, ib_cfgparser_curr_file(ib->cfgparser));
+        if (deferred->file == NULL) {
+            return IB_EALLOC;
+        }
+        deferred->line = ib_cfgparser_curr_line(ib->cfgparser);
+    }
+
+    /* Jobs run concurrently, so each gets memory of its own. */
+    rc = ib_mpool_lite_create(&(deferred->mpl));
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_mm_register_cleanup(mm, deferred_create_cleanup, deferred->mpl);
+    if (rc != IB_OK) {
+        ib_mpool_lite_destroy(deferred->mpl);
+        return rc;
+    }
+
+    rc = ib_engine_config_job_add(ib, deferred_create_job, deferred);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    *op_inst = local_op_inst;
+
+    return IB_OK;
+}
+
 const ib_operator_t *ib_operator_inst_operator(
     const ib_operator_inst_t *op_inst
 )
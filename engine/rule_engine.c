@@ -31,6 +31,7 @@
 #include "rule_logger_private.h"
 
 #include <ironbee/action.h>
+#include <ironbee/atomic.h>
 #include <ironbee/bytestr.h>
 #include <ironbee/capture.h>
 #include <ironbee/config.h>
@@ -49,6 +50,9 @@
 
 #include <assert.h>
 #include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 /**
  * Phase Flags
@@ -582,6 +586,17 @@ ib_status_t ib_rule_exec_create(ib_tx_t *tx, ib_rule_exec_t **rule_exec)
         return rc;
     }
 
+    /* Create the transformation cache */
+    rc = ib_hash_create(&(exec->tfn_cache), tx->mm);
+    if (rc != IB_OK) {
+        ib_rule_log_tx_error(tx, "Failed to create transformation cache: %s",
+                             ib_status_to_string(rc));
+        return rc;
+    }
+
+    /* The equality fold cache is created on first use. */
+    exec->fold_cache = NULL;
+
     /* Create the TX log object */
     rc = ib_rule_log_tx_create(exec, &(exec->tx_log));
     if (rc != IB_OK) {
@@ -808,16 +823,240 @@ static ib_status_t execute_tfn_single(const ib_rule_exec_t  *rule_exec,
     return IB_OK;
 }
 
+/**
+ * Transformation cache key.
+ */
+typedef struct {
+    const void *source;      /**< Identity of the untransformed value. */
+    const char *fingerprint; /**< Interned transformation fingerprint. */
+} tfn_cache_key_t;
+
+/**
+ * Snapshot of an untransformed value.
+ *
+ * Fields may be modified between rules (e.g., values appended to a
+ * collection), so a cached result is only used if the snapshot taken
+ * when it was stored still matches the value.
+ */
+typedef struct {
+    const void *value;       /**< Value pointer (string or list). */
+    const void *data;        /**< Byte string data pointer. */
+    size_t      length;      /**< Byte string length or list elements. */
+    size_t      generation;  /**< List generation; see ib_list_generation(). */
+} tfn_cache_snapshot_t;
+
+/**
+ * Transformation cache entry.
+ */
+typedef struct {
+    tfn_cache_key_t       key;      /**< Key; owned by the entry. */
+    tfn_cache_snapshot_t  snapshot; /**< Value snapshot. */
+    const ib_field_t     *result;   /**< Transformed value. */
+} tfn_cache_entry_t;
+
+/**
+ * Transaction cache of an equality fold group.
+ *
+ * An entry is valid if @ref value is not NULL.
+ */
+struct ib_rule_fold_cache_t {
+    const ib_field_t     *value;    /**< Untransformed value looked up. */
+    tfn_cache_snapshot_t  snapshot; /**< Snapshot of @ref value. */
+    const char           *operand;  /**< Interned operand found; or NULL. */
+};
+
+/**
+ * Take a snapshot of @a value for the transformation cache.
+ *
+ * Only non-dynamic string and list fields are cached.
+ *
+ * @param[in] value Untransformed value.
+ * @param[out] snapshot Snapshot of @a value.
+ *
+ * @returns true if @a value is cacheable.
+ */
+static bool tfn_cache_snapshot(const ib_field_t     *value,
+                               tfn_cache_snapshot_t *snapshot)
+{
+    assert(value != NULL);
+    assert(snapshot != NULL);
+
+    ib_status_t rc;
+
+    if (ib_field_is_dynamic(value)) {
+        return false;
+    }
+
+    memset(snapshot, 0, sizeof(*snapshot));
+    switch (value->type) {
+        case IB_FTYPE_BYTESTR: {
+            const ib_bytestr_t *bs;
+
+            rc = ib_field_value(value, ib_ftype_bytestr_out(&bs));
+            if (rc != IB_OK) {
+                return false;
+            }
+            snapshot->value = bs;
+            if (bs != NULL) {
+                snapshot->data = ib_bytestr_const_ptr(bs);
+                snapshot->length = ib_bytestr_length(bs);
+            }
+            return true;
+        }
+        case IB_FTYPE_NULSTR: {
+            const char *s;
+
+            rc = ib_field_value(value, ib_ftype_nulstr_out(&s));
+            if (rc != IB_OK) {
+                return false;
+            }
+            snapshot->value = s;
+            return true;
+        }
+        case IB_FTYPE_LIST: {
+            const ib_list_t *list;
+
+            rc = ib_field_value(value, ib_ftype_list_out(&list));
+            if (rc != IB_OK) {
+                return false;
+            }
+            snapshot->value = list;
+            if (list != NULL) {
+                snapshot->length = ib_list_elements(list);
+                snapshot->generation = ib_list_generation(list);
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+/**
+ * Rule statistics of one thread.
+ *
+ * Each thread executing rules owns one block and is its only writer, so
+ * counters are updated without read-modify-write atomics.  Blocks live
+ * until the engine is destroyed so that the counts of a thread survive it.
+ */
+struct ib_rule_stats_block_t {
+    struct ib_rule_stats_block_t *next;    /**< Next block. */
+    size_t                        count;   /**< Elements in stats. */
+    ib_rule_stats_t               stats[]; /**< Statistics by rule index. */
+};
+typedef struct ib_rule_stats_block_t ib_rule_stats_block_t;
+
+/**
+ * Get the monotonic clock time in nanoseconds.
+ *
+ * @returns Time in nanoseconds.
+ */
+static inline uint64_t rule_stats_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * Add @a val to a counter of the calling thread's block.
+ *
+ * @param[in] counter Counter to add to.
+ * @param[in] val Value to add.
+ */
+static inline void rule_stats_add(uint64_t *counter, uint64_t val)
+{
+    ib_atomic_store_relaxed(counter, ib_atomic_load_relaxed(counter) + val);
+}
+
+/**
+ * Create the calling thread's statistics block.
+ *
+ * @param[in] rule_engine Rule engine.
+ *
+ * @returns New block or NULL on allocation or thread key failure.
+ */
+static ib_rule_stats_block_t *rule_stats_block_create(
+    ib_rule_engine_t *rule_engine
+)
+{
+    assert(rule_engine != NULL);
+
+    ib_rule_stats_block_t *block;
+    size_t                 count = rule_engine->index_limit;
+
+    block = calloc(1, sizeof(*block) + count * sizeof(ib_rule_stats_t));
+    if (block == NULL) {
+        return NULL;
+    }
+    block->count = count;
+
+    if (pthread_setspecific(rule_engine->stats.key, block) != 0) {
+        free(block);
+        return NULL;
+    }
+
+    ib_lock_lock(rule_engine->stats.lock);
+    block->next = rule_engine->stats.blocks;
+    rule_engine->stats.blocks = block;
+    ib_lock_unlock(rule_engine->stats.lock);
+
+    return block;
+}
+
+/**
+ * Get the calling thread's statistics of the current rule.
+ *
+ * @param[in] rule_exec Rule execution object.
+ *
+ * @returns Statistics or NULL if they are unavailable.
+ */
+static ib_rule_stats_t *rule_exec_stats(const ib_rule_exec_t *rule_exec)
+{
+    assert(rule_exec != NULL);
+
+    ib_rule_engine_t      *rule_engine = rule_exec->ib->rule_engine;
+    ib_rule_stats_block_t *block;
+
+    if (rule_exec->rule == NULL) {
+        return NULL;
+    }
+
+    block = pthread_getspecific(rule_engine->stats.key);
+    if (block == NULL) {
+        block = rule_stats_block_create(rule_engine);
+        if (block == NULL) {
+            return NULL;
+        }
+    }
+
+    /* Rules created after the block was allocated are not counted. */
+    if (rule_exec->rule->meta.index >= block->count) {
+        return NULL;
+    }
+
+    return &(block->stats[rule_exec->rule->meta.index]);
+}
+
 /**
  * Execute list of transformations on a target.
  *
+ * Results are cached in the rule execution object, so that other rules
+ * (or targets) applying the same transformation chain to the same value
+ * later in the transaction reuse the result.  The cache is bypassed if
+ * transformation rule logging is enabled.
+ *
  * @param[in] rule_exec The rule execution object
+ * @param[in] source Identity of the untransformed value (or NULL to
+ *                   disable caching)
  * @param[in] value Initial value of the target field
  * @param[out] result Pointer to field in which to store the result
  *
  * @returns Status code
  */
 static ib_status_t execute_tfns(const ib_rule_exec_t *rule_exec,
+                                const void *source,
                                 const ib_field_t *value,
                                 const ib_field_t **result)
 {
@@ -828,26 +1067,55 @@ static ib_status_t execute_tfns(const ib_rule_exec_t *rule_exec,
     const ib_list_node_t *node = NULL;
     const ib_field_t     *in_field;
     const ib_field_t     *out = NULL;
+    const ib_rule_target_t *target = rule_exec->target;
+    tfn_cache_key_t       key;
+    tfn_cache_snapshot_t  snapshot;
+    tfn_cache_entry_t    *entry;
+    bool                  cacheable;
 
     /* No transformations?  Do nothing. */
     if (value == NULL) {
         *result = NULL;
         return IB_OK;
     }
-    else if (ib_list_elements(rule_exec->target->tfn_list) == 0) {
+    else if (ib_list_elements(target->tfn_list) == 0) {
         *result = value;
         ib_rule_log_trace(rule_exec, "No transformations");
         return IB_OK;
     }
 
+    /* Have we already transformed this value with the same chain? */
+    cacheable =
+        (source != NULL) &&
+        (rule_exec->tfn_cache != NULL) &&
+        (target->tfn_fingerprint != NULL) &&
+        (! ib_flags_all(ib_rule_log_flags(rule_exec->tx->ctx),
+                        IB_RULE_LOG_FLAG_TFN)) &&
+        tfn_cache_snapshot(value, &snapshot);
+    if (cacheable) {
+        key.source = source;
+        key.fingerprint = target->tfn_fingerprint;
+        rc = ib_hash_get_ex(rule_exec->tfn_cache, &entry,
+                            (const char *)&key, sizeof(key));
+        if ( (rc == IB_OK) &&
+             (memcmp(&entry->snapshot, &snapshot, sizeof(snapshot)) == 0) )
+        {
+            ib_rule_log_trace(rule_exec,
+                              "Using cached result of %zd transformations",
+                              ib_list_elements(target->tfn_list));
+            *result = entry->result;
+            return IB_OK;
+        }
+    }
+
     ib_rule_log_trace(rule_exec, "Executing %zd transformations",
-                      ib_list_elements(rule_exec->target->tfn_list));
+                      ib_list_elements(target->tfn_list));
 
     /*
      * Loop through all of the target's transformations.
      */
     in_field = value;
-    IB_LIST_LOOP_CONST(rule_exec->target->tfn_list, node) {
+    IB_LIST_LOOP_CONST(target->tfn_list, node) {
         const ib_transformation_inst_t  *tfn_inst =
             (const ib_transformation_inst_t *)ib_list_node_data_const(node);
 
@@ -896,6 +1164,25 @@ static ib_status_t execute_tfns(const ib_rule_exec_t *rule_exec,
     /* The output of the final operator is the result */
     *result = out;
 
+    /* Cache the result for later rules. */
+    if (cacheable) {
+        entry = ib_mm_alloc(rule_exec->tx->mm, sizeof(*entry));
+        if (entry == NULL) {
+            return IB_EALLOC;
+        }
+        entry->key = key;
+        entry->snapshot = snapshot;
+        entry->result = out;
+        rc = ib_hash_set_ex(rule_exec->tfn_cache,
+                            (const char *)&entry->key, sizeof(entry->key),
+                            entry);
+        if (rc != IB_OK) {
+            ib_rule_log_warn(rule_exec,
+                             "Failed to cache transformation result: %s",
+                             ib_status_to_string(rc));
+        }
+    }
+
     /* Done. */
     return IB_OK;
 }
@@ -1562,8 +1849,10 @@ static ib_status_t execute_phase_operator(ib_rule_exec_t *rule_exec,
 
     /* No recursion required, handle it here */
     else {
-        ib_num_t    result = 0;
-        ib_status_t op_rc = IB_OK;
+        ib_num_t         result = 0;
+        ib_status_t      op_rc = IB_OK;
+        ib_rule_stats_t *stats = rule_exec_stats(rule_exec);
+        uint64_t         start;
 
         /* Fill in the FIELD* fields */
         rc = set_target_fields(rule_exec, value);
@@ -1590,6 +1879,7 @@ static ib_status_t execute_phase_operator(ib_rule_exec_t *rule_exec,
         }
 
         /* @todo remove the cast-away of the constness of value */
+        start = rule_stats_now();
         op_rc = ib_operator_inst_execute(
             opinst->opinst,
             rule_exec->tx,
@@ -1597,6 +1887,9 @@ static ib_status_t execute_phase_operator(ib_rule_exec_t *rule_exec,
             get_capture(rule_exec),
             &result
         );
+        if (stats != NULL) {
+            rule_stats_add(&stats->operator_time, rule_stats_now() - start);
+        }
         if (op_rc != IB_OK) {
             ib_rule_log_warn(rule_exec, "Operator returned an error: %s",
                              ib_status_to_string(op_rc));
@@ -1631,7 +1924,11 @@ static ib_status_t execute_phase_operator(ib_rule_exec_t *rule_exec,
         store_results(rule_exec, value, op_rc, result);
 
         /* Execute any and all actions. */
+        start = rule_stats_now();
         execute_rule_actions(rule_exec);
+        if (stats != NULL) {
+            rule_stats_add(&stats->action_time, rule_stats_now() - start);
+        }
 
         /* Done. */
         clear_target_fields(rule_exec);
@@ -1714,6 +2011,7 @@ static ib_status_t execute_phase_rule_targets(ib_rule_exec_t *rule_exec)
     ib_rule_operator_inst_t *opinst = rule_exec->rule->opinst;
     ib_status_t              rc     = IB_OK;
     ib_list_node_t          *node   = NULL;
+    ib_rule_stats_t         *stats  = rule_exec_stats(rule_exec);
 
     /* Special case: External rules */
     if (ib_flags_all(rule->flags, IB_RULE_FLAG_EXTERNAL)) {
@@ -1867,9 +2165,24 @@ static ib_status_t execute_phase_rule_targets(ib_rule_exec_t *rule_exec)
             }
         }
 
-        /* Execute the target transformations */
+        /* Execute the target transformations.  A single value is
+         * identified by its field; multiple values are wrapped in a new
+         * field above, so are identified by the result list. */
         if (value != NULL) {
-            rc = execute_tfns(rule_exec, value, &tfnvalue);
+            /* Only time targets that have transformations. */
+            bool     timed = (stats != NULL) &&
+                             (ib_list_elements(target->tfn_list) > 0);
+            uint64_t start = timed ? rule_stats_now() : 0;
+
+            rc = execute_tfns(
+                rule_exec,
+                (ib_list_elements(result) == 1) ?
+                    (const void *)value : (const void *)result,
+                value,
+                &tfnvalue);
+            if (timed) {
+                rule_stats_add(&stats->tfn_time, rule_stats_now() - start);
+            }
             if (rc != IB_OK) {
                 return rc;
             }
@@ -1971,6 +2284,7 @@ static ib_status_t execute_phase_rule(ib_rule_exec_t *rule_exec,
 {
     ib_status_t         rc = IB_OK;
     ib_status_t         trc;          /* Temporary status code */
+    ib_rule_stats_t    *stats;
 #ifdef IB_RULE_TRACE
     ib_time_t pre_time;
     ib_time_t post_time;
@@ -2020,6 +2334,13 @@ static ib_status_t execute_phase_rule(ib_rule_exec_t *rule_exec,
     }
 #endif
     trc = execute_phase_rule_targets(rule_exec);
+    stats = rule_exec_stats(rule_exec);
+    if (stats != NULL) {
+        rule_stats_add(&stats->executions, 1);
+        if (rule_exec->rule_result != 0) {
+            rule_stats_add(&stats->matches, 1);
+        }
+    }
     if (trc != IB_OK) {
         rc = trc;
         goto cleanup;
@@ -2274,6 +2595,153 @@ static ib_status_t append_context_rules(const ib_engine_t *ib,
     return IB_OK;
 }
 
+/**
+ * Check whether the equality fold of @a rule proves it can not match.
+ *
+ * The target of the rule's fold group is fetched and transformed, and the
+ * result looked up in the group's operands.  The lookup is cached per
+ * transaction, so that the remaining members of the group only compare
+ * their interned operand to the cached result.  A skipped rule is counted
+ * as executed in the rule statistics.
+ *
+ * The fold is not used if anything could observe the execution of a
+ * non-matching rule: rule hooks, rule execution logging or debug logging.
+ * It is also not used for values that the group can not decide (e.g.,
+ * lists or non byte string results); such rules execute normally.
+ *
+ * @param[in] rule_exec Rule execution object.
+ * @param[in] rule Rule to check.
+ *
+ * @returns true if @a rule can be skipped.
+ */
+static bool fold_skip(ib_rule_exec_t *rule_exec, const ib_rule_t *rule)
+{
+    assert(rule_exec != NULL);
+    assert(rule != NULL);
+
+    const ib_rule_engine_t      *rule_engine = rule_exec->ib->rule_engine;
+    const ib_rule_fold_group_t  *group;
+    struct ib_rule_fold_cache_t *cache;
+    const ib_list_t             *result;
+    const ib_field_t            *value;
+    const ib_field_t            *tfnvalue;
+    const ib_bytestr_t          *bs;
+    tfn_cache_snapshot_t         snapshot;
+    ib_rule_stats_t             *stats;
+    ib_rule_t                   *saved_rule;
+    ib_rule_target_t            *saved_target;
+    ib_status_t                  rc;
+
+    if (rule->fold == NULL) {
+        return false;
+    }
+    if ( (ib_list_elements(rule_engine->hooks.pre_rule) > 0) ||
+         (ib_list_elements(rule_engine->hooks.post_rule) > 0) ||
+         (ib_list_elements(rule_engine->hooks.pre_operator) > 0) ||
+         (ib_list_elements(rule_engine->hooks.post_operator) > 0) )
+    {
+        return false;
+    }
+    if (ib_flags_any(ib_rule_log_flags(rule_exec->tx->ctx),
+                     IB_RULE_LOG_FLAG_RULE | IB_RULE_LOG_FLAG_TARGET |
+                     IB_RULE_LOG_FLAG_TFN | IB_RULE_LOG_FLAG_OPERATOR))
+    {
+        return false;
+    }
+    if (ib_rule_dlog_level(rule_exec->tx->ctx) >= IB_RULE_DLOG_DEBUG) {
+        return false;
+    }
+
+    if (rule_exec->fold_cache == NULL) {
+        rule_exec->fold_cache = ib_mm_calloc(
+            rule_exec->tx->mm,
+            rule_engine->fold_group_count,
+            sizeof(*(rule_exec->fold_cache))
+        );
+        if (rule_exec->fold_cache == NULL) {
+            return false;
+        }
+    }
+
+    group = rule->fold->group;
+    cache = &(rule_exec->fold_cache[group->index]);
+
+    /* Without a target, the operator is never executed. */
+    rc = ib_var_target_get(
+        group->target->target,
+        &result,
+        rule_exec->tx->mm,
+        rule_exec->tx->var_store
+    );
+    if (rc == IB_ENOENT) {
+        goto skip;
+    }
+    else if ( (rc != IB_OK) || (ib_list_elements(result) != 1) ) {
+        return false;
+    }
+    value = (const ib_field_t *)
+        ib_list_node_data_const(ib_list_first_const(result));
+    if ( (value == NULL) || ! tfn_cache_snapshot(value, &snapshot) ) {
+        return false;
+    }
+
+    /* Look up the transformed value unless it is cached. */
+    if ( (cache->value != value) ||
+         (memcmp(&(cache->snapshot), &snapshot, sizeof(snapshot)) != 0) )
+    {
+        cache->value = NULL;
+
+        saved_rule = rule_exec->rule;
+        saved_target = rule_exec->target;
+        rule_exec->rule = (ib_rule_t *)rule;
+        rule_exec->target = group->target;
+        rc = execute_tfns(rule_exec, value, value, &tfnvalue);
+        rule_exec->rule = saved_rule;
+        rule_exec->target = saved_target;
+
+        if ( (rc != IB_OK) ||
+             (tfnvalue == NULL) ||
+             (tfnvalue->type != IB_FTYPE_BYTESTR) )
+        {
+            return false;
+        }
+        rc = ib_field_value(tfnvalue, ib_ftype_bytestr_out(&bs));
+        if (rc != IB_OK) {
+            return false;
+        }
+
+        cache->operand = NULL;
+        if ( (bs != NULL) && (ib_bytestr_const_ptr(bs) != NULL) ) {
+            rc = ib_hash_get_ex(
+                group->operands,
+                &(cache->operand),
+                (const char *)ib_bytestr_const_ptr(bs),
+                ib_bytestr_length(bs)
+            );
+            if (rc != IB_OK) {
+                cache->operand = NULL;
+            }
+        }
+        cache->value = value;
+        cache->snapshot = snapshot;
+    }
+
+    if (cache->operand == rule->fold->operand) {
+        return false;
+    }
+
+skip:
+    saved_rule = rule_exec->rule;
+    rule_exec->rule = (ib_rule_t *)rule;
+    stats = rule_exec_stats(rule_exec);
+    rule_exec->rule = saved_rule;
+    if (stats != NULL) {
+        rule_stats_add(&stats->executions, 1);
+    }
+
+    return true;
+}
+
 /**
  * Run a set of phase rules.
  *
@@ -2430,6 +2898,11 @@ static ib_status_t run_phase_rules(ib_engine_t *ib,
             break;
         }
 
+        /* Skip equality rules that can not match. */
+        if (fold_skip(rule_exec, rule)) {
+            continue;
+        }
+
         /* Execute the rule, it's actions and chains */
         rule_rc = execute_phase_rule(rule_exec, rule, MAX_CHAIN_RECURSION);
 
@@ -2538,6 +3011,8 @@ static ib_status_t execute_stream_operator(ib_rule_exec_t *rule_exec,
     bool             pushed = rule_exec_push_value(rule_exec, value);
     ib_num_t         result = 0;
     ib_status_t      op_rc;
+    ib_rule_stats_t *stats = rule_exec_stats(rule_exec);
+    uint64_t         start;
 
     /* Add a target execution result to the log object */
     ib_rule_log_exec_add_stream_tgt(rule_exec->ib, rule_exec->exec_log, value);
@@ -2551,6 +3026,7 @@ static ib_status_t execute_stream_operator(ib_rule_exec_t *rule_exec,
     }
 
     /* Execute the rule operator */
+    start = rule_stats_now();
     op_rc = ib_operator_inst_execute(
         rule->opinst->opinst,
         rule_exec->tx,
@@ -2558,6 +3034,10 @@ static ib_status_t execute_stream_operator(ib_rule_exec_t *rule_exec,
         get_capture(rule_exec),
         &result
     );
+    if (stats != NULL) {
+        rule_stats_add(&stats->executions, 1);
+        rule_stats_add(&stats->operator_time, rule_stats_now() - start);
+    }
     if (op_rc != IB_OK) {
         ib_rule_log_error(rule_exec, "Operator returned an error: %s",
                           ib_status_to_string(op_rc));
@@ -2574,9 +3054,16 @@ static ib_status_t execute_stream_operator(ib_rule_exec_t *rule_exec,
 
     /* Store the results */
     store_results(rule_exec, value, op_rc, result);
+    if (stats != NULL && rule_exec->rule_result != 0) {
+        rule_stats_add(&stats->matches, 1);
+    }
 
     /* Execute any and all actions. */
+    start = rule_stats_now();
     execute_rule_actions(rule_exec);
+    if (stats != NULL) {
+        rule_stats_add(&stats->action_time, rule_stats_now() - start);
+    }
 
     /* Allow/Block if required */
     if (ib_flags_all(rule_exec->tx->flags, IB_TX_FALLOW_ALL) ) {
@@ -3206,6 +3693,28 @@ static ib_status_t register_callbacks(ib_engine_t *ib,
     return IB_OK;
 }
 
+/**
+ * Release the rule statistics of all threads.
+ *
+ * @param[in] cbdata Rule engine.
+ */
+static void rule_stats_cleanup(void *cbdata)
+{
+    assert(cbdata != NULL);
+
+    ib_rule_engine_t      *rule_engine = (ib_rule_engine_t *)cbdata;
+    ib_rule_stats_block_t *block = rule_engine->stats.blocks;
+
+    while (block != NULL) {
+        ib_rule_stats_block_t *next = block->next;
+        free(block);
+        block = next;
+    }
+    rule_engine->stats.blocks = NULL;
+
+    pthread_key_delete(rule_engine->stats.key);
+}
+
 /**
  * Initialize a rule engine object.
  *
@@ -3251,6 +3760,24 @@ static ib_status_t create_rule_engine(const ib_engine_t *ib,
         return rc;
     }
 
+    /* Create the transformation fingerprint hash */
+    rc = ib_hash_create(&(rule_engine->tfn_fingerprints), mm);
+    if (rc != IB_OK) {
+        ib_log_error(ib,
+                     "Error creating rule engine fingerprint hash: %s",
+                     ib_status_to_string(rc));
+        return rc;
+    }
+
+    /* Create the equality fold group hash */
+    rc = ib_hash_create(&(rule_engine->fold_groups), mm);
+    if (rc != IB_OK) {
+        ib_log_error(ib,
+                     "Error creating rule engine fold group hash: %s",
+                     ib_status_to_string(rc));
+        return rc;
+    }
+
     /* Create the external drivers hash */
     rc = ib_hash_create(&(rule_engine->external_drivers), mm);
     if (rc != IB_OK) {
@@ -3260,6 +3787,24 @@ static ib_status_t create_rule_engine(const ib_engine_t *ib,
         return rc;
     }
 
+    /* Create the rule statistics lock and thread key */
+    rc = ib_lock_create(&(rule_engine->stats.lock), mm);
+    if (rc != IB_OK) {
+        ib_log_error(ib,
+                     "Error creating rule engine statistics lock: %s",
+                     ib_status_to_string(rc));
+        return rc;
+    }
+    if (pthread_key_create(&(rule_engine->stats.key), NULL) != 0) {
+        ib_log_error(ib, "Error creating rule engine statistics key.");
+        return IB_EOTHER;
+    }
+    rc = ib_mm_register_cleanup(mm, rule_stats_cleanup, rule_engine);
+    if (rc != IB_OK) {
+        pthread_key_delete(rule_engine->stats.key);
+        return rc;
+    }
+
     /* Create the ownership cb list */
     rc = ib_list_create(&(rule_engine->ownership_cbs), mm);
     if (rc != IB_OK) {
@@ -3712,6 +4257,202 @@ bool ib_rule_is_marked(const ib_rule_t *rule) {
     return ib_flags_any(rule->flags, IB_RULE_FLAG_MARK);
 }
 
+/**
+ * Determine if @a rule can be a member of an equality fold group.
+ *
+ * Eligible rules have a single target and a non-inverted `streq` or
+ * `istreq` operator with a constant, non-empty operand, and only have
+ * actions if they match.  Stream, external, action, traced and chained
+ * rules are not eligible.
+ *
+ * @param[in] rule Rule.
+ * @param[out] nocase Set if the comparison is case-insensitive.
+ * @param[out] operand Operand of @a rule.
+ * @param[out] operand_length Length of @a operand.
+ *
+ * @returns true if @a rule is eligible.
+ */
+static bool fold_eligible(const ib_rule_t *rule,
+                          bool *nocase,
+                          const char **operand,
+                          size_t *operand_length)
+{
+    assert(rule != NULL);
+    assert(nocase != NULL);
+    assert(operand != NULL);
+    assert(operand_length != NULL);
+
+    const ib_rule_target_t *target;
+    const ib_var_expand_t  *expand;
+    const char             *name;
+    ib_status_t             rc;
+
+    if (ib_flags_any(rule->flags,
+                     IB_RULE_FLAG_EXTERNAL | IB_RULE_FLAG_STREAM |
+                     IB_RULE_FLAG_NO_TGT | IB_RULE_FLAG_TRACE |
+                     IB_RULE_FLAG_CHCHILD | IB_RULE_FLAG_CAPTURE))
+    {
+        return false;
+    }
+    if ( (rule->opinst == NULL) ||
+         (rule->opinst->opinst == NULL) ||
+         rule->opinst->invert )
+    {
+        return false;
+    }
+    if ( (ib_list_elements(rule->false_actions) > 0) ||
+         (ib_list_elements(rule->aux_actions) > 0) )
+    {
+        return false;
+    }
+    if (ib_list_elements(rule->target_fields) != 1) {
+        return false;
+    }
+    target = (const ib_rule_target_t *)
+        ib_list_node_data_const(ib_list_first_const(rule->target_fields));
+    if ( (target == NULL) || (target->target == NULL) ) {
+        return false;
+    }
+
+    name = ib_operator_name(ib_operator_inst_operator(rule->opinst->opinst));
+    if (strcmp(name, "streq") == 0) {
+        *nocase = false;
+    }
+    else if (strcmp(name, "istreq") == 0) {
+        *nocase = true;
+    }
+    else {
+        return false;
+    }
+
+    /* The instance data of the string operators is the operand expansion;
+     * see core_operators.c. */
+    expand = ib_operator_inst_data(rule->opinst->opinst);
+    if (expand == NULL) {
+        return false;
+    }
+    rc = ib_var_expand_constant(expand, operand, operand_length);
+
+    return (rc == IB_OK) && (*operand_length > 0);
+}
+
+/**
+ * Fold equality rules into groups.
+ *
+ * Eligible rules (see fold_eligible()) with the same target, transformation
+ * chain and case sensitivity are grouped.  Rules are still executed in
+ * order; the group only allows non-matching members to be skipped (see
+ * fold_skip()).
+ *
+ * @param[in] ib IronBee engine.
+ *
+ * @returns
+ *   - IB_OK on success.
+ *   - IB_EALLOC on allocation errors.
+ */
+static ib_status_t fold_rules(ib_engine_t *ib)
+{
+    assert(ib != NULL);
+    assert(ib->rule_engine != NULL);
+
+    ib_rule_engine_t *rule_engine = ib->rule_engine;
+    ib_mm_t           mm = ib_engine_mm_main_get(ib);
+    ib_list_node_t   *node;
+    size_t            folded = 0;
+    ib_status_t       rc;
+
+    IB_LIST_LOOP(rule_engine->rule_list, node) {
+        ib_rule_t            *rule = (ib_rule_t *)ib_list_node_data(node);
+        ib_rule_target_t     *target;
+        ib_rule_fold_group_t *group;
+        ib_rule_fold_t       *fold;
+        const char           *fingerprint;
+        const char           *operand;
+        const char           *interned;
+        size_t                operand_length;
+        bool                  nocase;
+        char                 *key;
+        size_t                key_length;
+
+        if ( (rule == NULL) ||
+             (rule->fold != NULL) ||
+             ! fold_eligible(rule, &nocase, &operand, &operand_length) )
+        {
+            continue;
+        }
+        target = (ib_rule_target_t *)
+            ib_list_node_data(ib_list_first(rule->target_fields));
+        fingerprint =
+            (target->tfn_fingerprint == NULL) ? "" : target->tfn_fingerprint;
+
+        /* Key: case sensitivity, transformations and target. */
+        key_length =
+            strlen(fingerprint) + strlen(target->target_str) + 3;
+        key = ib_mm_alloc(mm, key_length + 1);
+        if (key == NULL) {
+            return IB_EALLOC;
+        }
+        snprintf(key, key_length + 1, "%c\n%s\n%s",
+                 nocase ? 'i' : 's', fingerprint, target->target_str);
+
+        rc = ib_hash_get(rule_engine->fold_groups, &group, key);
+        if (rc == IB_ENOENT) {
+            group = ib_mm_calloc(mm, 1, sizeof(*group));
+            if (group == NULL) {
+                return IB_EALLOC;
+            }
+            group->index = rule_engine->fold_group_count;
+            group->target = target;
+            if (nocase) {
+                rc = ib_hash_create_nocase(&(group->operands), mm);
+            }
+            else {
+                rc = ib_hash_create(&(group->operands), mm);
+            }
+            if (rc != IB_OK) {
+                return rc;
+            }
+            rc = ib_hash_set(rule_engine->fold_groups, key, group);
+            if (rc != IB_OK) {
+                return rc;
+            }
+            ++rule_engine->fold_group_count;
+        }
+        else if (rc != IB_OK) {
+            return rc;
+        }
+
+        /* Intern the operand. */
+        rc = ib_hash_get_ex(group->operands, &interned,
+                            operand, operand_length);
+        if (rc == IB_ENOENT) {
+            interned = operand;
+            rc = ib_hash_set_ex(group->operands, operand, operand_length,
+                                (void *)interned);
+        }
+        if (rc != IB_OK) {
+            return rc;
+        }
+
+        fold = ib_mm_alloc(mm, sizeof(*fold));
+        if (fold == NULL) {
+            return IB_EALLOC;
+        }
+        fold->group = group;
+        fold->operand = interned;
+        rule->fold = fold;
+        ++group->members;
+        ++folded;
+    }
+
+    if (folded > 0) {
+        ib_log_debug(ib, "Folded %zd equality rules into %zd groups.",
+                     folded, rule_engine->fold_group_count);
+    }
+
+    return IB_OK;
+}
+
 /**
  * Close a context for the rule engine.
  *
@@ -3738,6 +4479,16 @@ static ib_status_t rule_engine_ctx_close(ib_engine_t *ib,
     ib_context_t   *main_ctx = ib_context_main(ib);
     ib_status_t     rc;
 
+    /* The main context is closed last; all rules are known. */
+    if (ctx == main_ctx) {
+        rc = fold_rules(ib);
+        if (rc != IB_OK) {
+            ib_log_error(ib, "Error folding equality rules: %s",
+                         ib_status_to_string(rc));
+            return rc;
+        }
+    }
+
     /* Don't enable rules for non-location contexts */
     if (ctx->ctype != IB_CTYPE_LOCATION) {
         return IB_OK;
@@ -4300,6 +5051,12 @@ ib_status_t ib_rule_create(
     rule->opinst           = NULL;
     ++ib->rule_engine->index_limit;
 
+    /* Record the rule by index for statistics */
+    rc = ib_list_push(ib->rule_engine->rule_list, rule);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
     /* Note if this is the main context */
     if (ctx == ib_context_main(ib)) {
         rule->flags |= IB_RULE_FLAG_MAIN_CTX;
@@ -5324,6 +6081,77 @@ bool ib_rule_tag_match(const ib_rule_t *rule, const char *tag)
     return false;
 }
 
+/**
+ * Append a transformation instance to a target.
+ *
+ * This also extends the target's transformation fingerprint and interns
+ * it in the rule engine.
+ *
+ * @param[in] ib IronBee engine
+ * @param[in,out] target Target to operate on
+ * @param[in] tfn_inst Transformation instance to append
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EALLOC On allocation errors.
+ * - Other if an error occurs.
+ */
+static ib_status_t target_push_tfn_inst(
+    ib_engine_t                    *ib,
+    ib_rule_target_t               *target,
+    const ib_transformation_inst_t *tfn_inst
+)
+{
+    assert(ib != NULL);
+    assert(ib->rule_engine != NULL);
+    assert(target != NULL);
+    assert(tfn_inst != NULL);
+
+    ib_status_t  rc;
+    const char  *name;
+    const char  *params;
+    const char  *prev;
+    char        *fingerprint;
+    const char  *interned;
+    size_t       len;
+
+    rc = ib_list_push(target->tfn_list, (void *)tfn_inst);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    name = ib_transformation_name(
+        ib_transformation_inst_transformation(tfn_inst));
+    params = ib_transformation_inst_parameters(tfn_inst);
+    if (params == NULL) {
+        params = "";
+    }
+    prev = (target->tfn_fingerprint == NULL) ? "" : target->tfn_fingerprint;
+
+    /* The parameter length is included so that parameters containing
+     * delimiters can not produce ambiguous fingerprints. */
+    len = strlen(prev) + strlen(name) + strlen(params) + 32;
+    fingerprint = ib_mm_alloc(ib_rule_mm(ib), len);
+    if (fingerprint == NULL) {
+        return IB_EALLOC;
+    }
+    snprintf(fingerprint, len, "%s%s(%zu:%s)",
+             prev, name, strlen(params), params);
+
+    rc = ib_hash_get(ib->rule_engine->tfn_fingerprints, &interned, fingerprint);
+    if (rc == IB_ENOENT) {
+        rc = ib_hash_set(ib->rule_engine->tfn_fingerprints,
+                         fingerprint, fingerprint);
+        interned = fingerprint;
+    }
+    if (rc != IB_OK) {
+        return rc;
+    }
+    target->tfn_fingerprint = interned;
+
+    return IB_OK;
+}
+
 ib_status_t ib_rule_create_target(ib_engine_t *ib,
                                   const char *str,
                                   ib_list_t *tfns,
@@ -5382,9 +6210,11 @@ ib_status_t ib_rule_create_target(ib_engine_t *ib,
 
         /* Copy the list elements. */
         IB_LIST_LOOP_CONST(tfns, node) {
-            rc = ib_list_push(
-                (*target)->tfn_list,
-                (void *)ib_list_node_data_const(node));
+            rc = target_push_tfn_inst(
+                ib,
+                *target,
+                (const ib_transformation_inst_t *)
+                    ib_list_node_data_const(node));
             if (rc != IB_OK) {
                 return rc;
             }
@@ -5466,7 +6296,7 @@ ib_status_t ib_rule_target_add_tfn(ib_engine_t *ib,
     }
 
     /* Add the transformation to the list */
-    rc = ib_list_push(target->tfn_list, (void *)tfn_inst);
+    rc = target_push_tfn_inst(ib, target, tfn_inst);
     if (rc != IB_OK) {
         ib_log_error(ib,
                      "Error adding transformation \"%s\" to list: %s",
@@ -6089,3 +6919,109 @@ ib_status_t ib_rule_tfn_fields_to_inst(
 
     return IB_OK;
 }
+
+/**
+ * Get the first statistics block of @a rule_engine.
+ *
+ * Blocks are only ever prepended and are not freed until the engine is
+ * destroyed, so the returned list may be walked without the lock.
+ *
+ * @param[in] rule_engine Rule engine.
+ *
+ * @returns First block or NULL if no thread has executed rules.
+ */
+static const ib_rule_stats_block_t *rule_stats_blocks(
+    ib_rule_engine_t *rule_engine
+)
+{
+    const ib_rule_stats_block_t *blocks;
+
+    ib_lock_lock(rule_engine->stats.lock);
+    blocks = rule_engine->stats.blocks;
+    ib_lock_unlock(rule_engine->stats.lock);
+
+    return blocks;
+}
+
+ib_status_t ib_rule_stats_foreach(
+    const ib_engine_t  *ib,
+    ib_rule_stats_fn_t  fn,
+    void               *cbdata
+)
+{
+    assert(ib != NULL);
+    assert(ib->rule_engine != NULL);
+    assert(fn != NULL);
+
+    const ib_rule_stats_block_t *blocks;
+    const ib_list_node_t        *node;
+
+    blocks = rule_stats_blocks(ib->rule_engine);
+    if (blocks == NULL) {
+        return IB_OK;
+    }
+
+    IB_LIST_LOOP_CONST(ib->rule_engine->rule_list, node) {
+        const ib_rule_t             *rule = ib_list_node_data_const(node);
+        size_t                       index = rule->meta.index;
+        const ib_rule_stats_block_t *block;
+        ib_rule_stats_t              stats = { 0, 0, 0, 0, 0 };
+        ib_status_t                  rc;
+
+        for (block = blocks; block != NULL; block = block->next) {
+            const ib_rule_stats_t *bstats;
+
+            if (index >= block->count) {
+                continue;
+            }
+            bstats = &(block->stats[index]);
+            stats.executions    += ib_atomic_load_relaxed(&bstats->executions);
+            stats.matches       += ib_atomic_load_relaxed(&bstats->matches);
+            stats.operator_time +=
+                ib_atomic_load_relaxed(&bstats->operator_time);
+            stats.tfn_time      += ib_atomic_load_relaxed(&bstats->tfn_time);
+            stats.action_time   +=
+                ib_atomic_load_relaxed(&bstats->action_time);
+        }
+
+        if (stats.executions == 0) {
+            continue;
+        }
+
+        rc = fn(rule, &stats, cbdata);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    return IB_OK;
+}
+
+void ib_rule_stats_reset(
+    const ib_engine_t *ib
+)
+{
+    assert(ib != NULL);
+    assert(ib->rule_engine != NULL);
+
+    ib_rule_stats_block_t *block;
+
+    ib_lock_lock(ib->rule_engine->stats.lock);
+    for (block = ib->rule_engine->stats.blocks;
+         block != NULL;
+         block = block->next)
+    {
+        size_t i;
+
+        for (i = 0; i < block->count; ++i) {
+            ib_rule_stats_t *bstats = &(block->stats[i]);
+
+            ib_atomic_store_relaxed(&bstats->executions, 0);
+            ib_atomic_store_relaxed(&bstats->matches, 0);
+            ib_atomic_store_relaxed(&bstats->operator_time, 0);
+            ib_atomic_store_relaxed(&bstats->tfn_time, 0);
+            ib_atomic_store_relaxed(&bstats->action_time, 0);
+        }
+    }
+    ib_lock_unlock(ib->rule_engine->stats.lock);
+}
@@ -28,9 +28,12 @@
  */
 
 #include <ironbee/clock.h>
+#include <ironbee/lock.h>
 #include <ironbee/rule_engine.h>
 #include <ironbee/types.h>
 
+#include <pthread.h>
+
 /**
  * Context-specific rule object.  This is the type of the objects
  * stored in the 'rule_list' field of ib_ruleset_phase_t.
@@ -76,18 +79,55 @@ struct ib_rule_target_t {
     ib_var_target_t *target;
     const char      *target_str; /**< The target string */
     ib_list_t       *tfn_list;   /**< List of transformations */
+
+    /**
+     * Fingerprint of @ref tfn_list (or NULL if there are no
+     * transformations).
+     *
+     * Fingerprints are interned in the rule engine, so targets with
+     * identical transformation chains share the same pointer.  This is
+     * used to key the per-transaction transformation cache.
+     */
+    const char      *tfn_fingerprint;
 };
 
 
+/**
+ * Group of equality rules with the same target and transformation chain.
+ *
+ * Members use the `streq` or (for a case-insensitive group) the `istreq`
+ * operator with a constant operand.  During a transaction, the target is
+ * transformed and looked up in @ref operands once; each member then only
+ * compares its interned operand to the result.
+ */
+typedef struct ib_rule_fold_group_t ib_rule_fold_group_t;
+struct ib_rule_fold_group_t {
+    size_t            index;    /**< Index of transaction cache */
+    ib_rule_target_t *target;   /**< Target of the first member */
+    ib_hash_t        *operands; /**< Interned operands by operand */
+    size_t            members;  /**< Number of member rules */
+};
+
+/**
+ * Membership of a rule in a @ref ib_rule_fold_group_t.
+ */
+struct ib_rule_fold_t {
+    const ib_rule_fold_group_t *group;   /**< Group */
+    const char                 *operand; /**< Interned operand */
+};
+
 /**
  * Rule engine.
  */
 struct ib_rule_engine_t {
-    ib_list_t *rule_list;        /**< All registered rules. */
+    ib_list_t *rule_list;        /**< All created rules, by index. */
     ib_hash_t *rule_hash;        /**< All rules by rule-id. */
     ib_hash_t *external_drivers; /**< Drivers for external rules. */
     ib_list_t *ownership_cbs;    /**< List of ownership callbacks. */
     size_t     index_limit;      /**< One more than highest rule index. */
+    ib_hash_t *tfn_fingerprints; /**< Interned target tfn fingerprints. */
+    ib_hash_t *fold_groups;      /**< Equality fold groups by key. */
+    size_t     fold_group_count; /**< Number of fold groups. */
 
     /**
      * Rule injection callbacks.
@@ -112,6 +152,13 @@ struct ib_rule_engine_t {
         ib_list_t *pre_operator;
         ib_list_t *post_operator;
     } hooks;
+
+    /* Rule statistics */
+    struct {
+        pthread_key_t                 key;    /**< Calling thread's block. */
+        ib_lock_t                    *lock;   /**< Protects blocks. */
+        struct ib_rule_stats_block_t *blocks; /**< Blocks of all threads. */
+    } stats;
 };
 
 /**
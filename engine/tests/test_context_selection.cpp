@@ -0,0 +1,160 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Core Context Selection Tests
+ */
+
+#include "gtest/gtest.h"
+#include "base_fixture.h"
+
+#include <ironbee/context.h>
+#include <ironbee/site.h>
+
+#include <string>
+
+class ContextSelectionTest : public BaseTransactionFixture
+{
+public:
+    virtual void SetUp()
+    {
+        BaseTransactionFixture::SetUp();
+        configureIronBeeByString(
+            "LoadModule \"ibmod_htp.so\"\n"
+            "SensorId AAAABBBB-1111-2222-3333-000000000000\n"
+            "SensorName UnitTesting\n"
+            "SensorHostname unit-testing.sensor.tld\n"
+            "<Site other-port>\n"
+            "    SiteId 00000000-0000-0000-0000-000000000001\n"
+            "    Service *:8080\n"
+            "    Hostname *\n"
+            "</Site>\n"
+            "<Site other-ip>\n"
+            "    SiteId 00000000-0000-0000-0000-000000000002\n"
+            "    Service 1.0.0.10:80\n"
+            "    Hostname *\n"
+            "</Site>\n"
+            "<Site alpha>\n"
+            "    SiteId 00000000-0000-0000-0000-000000000003\n"
+            "    Service 1.0.0.1:80\n"
+            "    Hostname www.alpha.com\n"
+            "    Hostname *.alpha.net\n"
+            "    <Location /admin>\n"
+            "    </Location>\n"
+            "    <Location /admin/deep>\n"
+            "    </Location>\n"
+            "    <Location /static>\n"
+            "    </Location>\n"
+            "</Site>\n"
+            "<Site gamma>\n"
+            "    SiteId 00000000-0000-0000-0000-000000000005\n"
+            "    Service 1.0.0.99:80\n"
+            "    Hostname www.gamma.com\n"
+            "</Site>\n"
+            "<Site beta>\n"
+            "    SiteId 00000000-0000-0000-0000-000000000006\n"
+            "    Service *:80\n"
+            "    Hostname *.beta.org\n"
+            "    Hostname www.alpha.com\n"
+            "</Site>\n"
+            "<Site beta-deep>\n"
+            "    SiteId 00000000-0000-0000-0000-000000000007\n"
+            "    Service *:*\n"
+            "    Hostname *.deep.beta.org\n"
+            "    Hostname www.gamma.com\n"
+            "</Site>\n"
+            "<Site fallback>\n"
+            "    SiteId 00000000-0000-0000-0000-000000000004\n"
+            "    Service *:*\n"
+            "    Hostname *\n"
+            "</Site>\n"
+        );
+    }
+
+    /* Run a transaction and return "site location" of its context. */
+    std::string select(const char *hostname, const char *path)
+    {
+        m_hostname = hostname;
+        m_path = path;
+        m_selected.clear();
+        performTx();
+        return m_selected;
+    }
+
+    virtual void sendRequestLine()
+    {
+        BaseTransactionFixture::sendRequestLine("GET", m_path, "HTTP/1.1");
+    }
+
+    virtual void generateRequestHeader()
+    {
+        addRequestHeader("Host", m_hostname);
+    }
+
+    virtual void generateResponseHeader()
+    {
+        const ib_site_t *site = NULL;
+        const ib_site_location_t *location = NULL;
+
+        BaseTransactionFixture::generateResponseHeader();
+        ASSERT_EQ(IB_OK, ib_context_site_get(ib_tx->ctx, &site));
+        ASSERT_EQ(IB_OK, ib_context_location_get(ib_tx->ctx, &location));
+        m_selected = std::string(site ? site->name : "none") + " " +
+                     (location ? location->path : "none");
+    }
+
+private:
+    const char  *m_hostname;
+    const char  *m_path;
+    std::string  m_selected;
+};
+
+TEST_F(ContextSelectionTest, HostnameExact)
+{
+    EXPECT_EQ("alpha /", select("www.alpha.com", "/"));
+    EXPECT_EQ("alpha /", select("WWW.Alpha.COM", "/index.html"));
+    EXPECT_EQ("fallback /", select("alpha.com", "/"));
+    EXPECT_EQ("fallback /", select("xwww.alpha.com", "/"));
+}
+
+TEST_F(ContextSelectionTest, HostnameWildcard)
+{
+    EXPECT_EQ("alpha /", select("a.alpha.net", "/"));
+    EXPECT_EQ("alpha /", select("a.b.ALPHA.net", "/"));
+    EXPECT_EQ("fallback /", select("alpha.net", "/"));
+    EXPECT_EQ("fallback /", select("a.alpha.network", "/"));
+}
+
+TEST_F(ContextSelectionTest, LocationFirstMatch)
+{
+    EXPECT_EQ("alpha /admin", select("www.alpha.com", "/admin"));
+    /* /admin precedes /admin/deep, so it wins. */
+    EXPECT_EQ("alpha /admin", select("www.alpha.com", "/admin/deep/x"));
+    EXPECT_EQ("alpha /static", select("www.alpha.com", "/static/a.css"));
+    EXPECT_EQ("alpha /", select("www.alpha.com", "/adm"));
+}
+
+TEST_F(ContextSelectionTest, HostnameAcrossSites)
+{
+    /* Earlier sites win when host names overlap. */
+    EXPECT_EQ("alpha /", select("www.alpha.com", "/"));
+    EXPECT_EQ("beta /", select("x.beta.org", "/"));
+    EXPECT_EQ("beta /", select("x.deep.beta.org", "/"));
+    /* gamma's service does not match the connection. */
+    EXPECT_EQ("beta-deep /", select("www.gamma.com", "/"));
+}
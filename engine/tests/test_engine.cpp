@@ -25,7 +25,10 @@
 #include "gtest/gtest.h"
 #include "base_fixture.h"
 
+#include <ironbee/atomic.h>
 #include <ironbee/field.h>
+#include <ironbee/operator.h>
+#include <ironbee/rule_engine.h>
 #include <ironbee/state_notify.h>
 #include <ironbee/bytestr.h>
 #include <ironbee/transformation.h>
@@ -33,6 +36,7 @@
 #include "config-parser.h"
 #include "ibtest_util.hpp"
 #include "engine_private.h"
+#include "rule_engine_private.h"
 
 
 /// @test Test ironbee library - ib_engine_create()
@@ -312,3 +316,92 @@ TEST_F(TestIronBee, test_module_data)
     ASSERT_EQ(IB_OK, ib_tx_set_module_data(tx, module, NULL));
     ASSERT_EQ(IB_ENOENT, ib_tx_get_module_data(tx, module, &data));
 }
+
+namespace {
+
+//! Configuration job: count calls; fail on the 7th.
+ib_status_t count_job(ib_engine_t *ib, void *cbdata)
+{
+    size_t n = ib_atomic_add(reinterpret_cast<size_t *>(cbdata), 1);
+
+    return n == 7 ? IB_EUNKNOWN : IB_OK;
+}
+
+}
+
+TEST_F(TestIronBee, test_engine_config_jobs)
+{
+    size_t calls = 0;
+
+    ib_engine_config_workers_set(ib_engine, 4);
+    ASSERT_EQ(4UL, ib_engine_config_workers(ib_engine));
+
+    // Outside of configuration, jobs run immediately.
+    ASSERT_EQ(IB_OK, ib_engine_config_job_add(ib_engine, count_job, &calls));
+    ASSERT_EQ(1UL, calls);
+
+    // During configuration, jobs are queued until run.
+    ib_engine->cfg_state = CFG_STARTED;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQ(IB_OK,
+                  ib_engine_config_job_add(ib_engine, count_job, &calls));
+    }
+    ASSERT_EQ(1UL, calls);
+    ASSERT_EQ(IB_OK, ib_engine_config_jobs_run(ib_engine));
+    ASSERT_EQ(5UL, calls);
+    ASSERT_EQ(IB_OK, ib_engine_config_jobs_run(ib_engine));
+    ASSERT_EQ(5UL, calls);
+
+    // All jobs run even if one fails.
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(IB_OK,
+                  ib_engine_config_job_add(ib_engine, count_job, &calls));
+    }
+    ASSERT_EQ(IB_EUNKNOWN, ib_engine_config_jobs_run(ib_engine));
+    ASSERT_EQ(15UL, calls);
+    ib_engine->cfg_state = CFG_NOT_STARTED;
+
+    // Zero means one worker per CPU.
+    ib_engine_config_workers_set(ib_engine, 0);
+    ASSERT_LE(1UL, ib_engine_config_workers(ib_engine));
+}
+
+TEST_F(TestIronBee, test_engine_config_workers)
+{
+    std::string cfgbuf =
+        "LogLevel 4\n"
+        "ModuleBasePath " IB_XSTRINGIFY(MODULE_BASE_PATH) "\n"
+        "ConfigWorkers 3\n"
+        "LoadModule ibmod_rules.so\n"
+        "LoadModule ibmod_pcre.so\n";
+    for (int i = 0; i < 16; ++i) {
+        std::string n = boost::lexical_cast<std::string>(i);
+        cfgbuf +=
+            "Rule ARGS @rx \"^a{" + n + "}b+\" "
+            "id:rx" + n + " rev:1 phase:REQUEST_HEADER\n";
+    }
+    cfgbuf +=
+        "<Site *>\n"
+        "  Hostname *\n"
+        "</Site>\n";
+
+    configureIronBeeByString(cfgbuf);
+    ASSERT_EQ(3UL, ib_engine_config_workers(ib_engine));
+
+    // Every deferred operator instance was created before the main
+    // context closed.
+    for (int i = 0; i < 16; ++i) {
+        ib_rule_t *rule = NULL;
+        ASSERT_EQ(
+            IB_OK,
+            ib_rule_lookup(
+                ib_engine,
+                ib_context_main(ib_engine),
+                ("rx" + boost::lexical_cast<std::string>(i)).c_str(),
+                &rule
+            )
+        );
+        ASSERT_TRUE(rule->opinst->opinst);
+        ASSERT_TRUE(ib_operator_inst_data(rule->opinst->opinst));
+    }
+}
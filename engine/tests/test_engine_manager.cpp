@@ -27,6 +27,9 @@
 
 #include <fstream>
 
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
 #include <ironbee/engine_manager.h>
 
 /**
@@ -200,3 +203,72 @@ TEST_F(EngineManager, MaxEngines)
 
     ib_manager_destroy(m_manager);
 }
+
+namespace {
+
+/* Acquire and release engines until told to stop. */
+void acquire_release_loop(ib_manager_t *manager, const bool *stop, size_t *failures)
+{
+    while (! __atomic_load_n(stop, __ATOMIC_ACQUIRE)) {
+        ib_engine_t *engine;
+
+        if (ib_manager_engine_acquire(
+                manager, IB_MANAGER_ENGINE_NAME_ANY, &engine) != IB_OK)
+        {
+            ++*failures;
+            continue;
+        }
+        if (ib_manager_engine_release(manager, engine) != IB_OK) {
+            ++*failures;
+        }
+    }
+}
+
+}
+
+TEST_F(EngineManager, ConcurrentAcquireRelease)
+{
+    const size_t num_threads = 4;
+    bool stop = false;
+    std::vector<size_t> failures(num_threads, 0);
+    boost::thread_group threads;
+
+    ASSERT_EQ(
+        IB_OK,
+        ib_manager_engine_create(
+            m_manager,
+            IB_MANAGER_ENGINE_NAME_DEFAULT,
+            createIronBeeConfig().c_str()
+        )
+    );
+
+    for (size_t i = 0; i < num_threads; ++i) {
+        threads.create_thread(
+            boost::bind(acquire_release_loop, m_manager, &stop, &failures[i]));
+    }
+
+    /* Replace the engine while the threads are using it. */
+    for (size_t i = 0; i < 2 * IB_MANAGER_DEFAULT_MAX_ENGINES; ++i) {
+        EXPECT_EQ(
+            IB_OK,
+            ib_manager_engine_create(
+                m_manager,
+                IB_MANAGER_ENGINE_NAME_DEFAULT,
+                createIronBeeConfig().c_str()
+            )
+        );
+    }
+
+    __atomic_store_n(&stop, true, __ATOMIC_RELEASE);
+    threads.join_all();
+
+    for (size_t i = 0; i < num_threads; ++i) {
+        EXPECT_EQ(0U, failures[i]);
+    }
+
+    /* Only the current engine survives. */
+    ASSERT_EQ(IB_OK, ib_manager_engine_cleanup(m_manager));
+    EXPECT_EQ(1U, ib_manager_engine_count(m_manager));
+
+    ib_manager_destroy(m_manager);
+}
@@ -25,18 +25,27 @@ extern "C" {
 
 #include "util/kvstore_private.h"
 #include <ironbee/kvstore.h>
+#include <ironbee/kvstore_cache.h>
 #include <ironbee/kvstore_filesystem.h>
+#include <ironbee/kvstore_log.h>
 #include <ironbee/mm.h>
 #include <ironbee/util.h>
 #include <ironbee/uuid.h>
 #include <ironbee/mm_mpool.h>
 
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 }
 
 #include "gtest/gtest.h"
 
+#include <string>
+
+#include <stdio.h>
+#include <string.h>
+
 
 class TestKVStore : public testing::Test
 {
@@ -170,3 +179,302 @@ TEST_F(TestKVStore, test_removes) {
 
     ASSERT_FALSE(result);
 }
+
+class TestKVStoreLog : public testing::Test
+{
+    public:
+
+    ib_kvstore_t kvstore;
+    ib_mpool_t *mp;
+    ib_mm_t mm;
+
+    virtual void SetUp() {
+        int mkdir_rc;
+
+        mkdir_rc = mkdir("TestKVStoreLog.d", 0777);
+        ASSERT_TRUE(mkdir_rc == 0 || ( mkdir_rc == -1 && errno == EEXIST));
+        ib_uuid_initialize();
+        ASSERT_EQ(IB_OK, ib_kvstore_log_init(&kvstore, "TestKVStoreLog.d"));
+        ASSERT_EQ(IB_OK, ib_kvstore_connect(&kvstore));
+        ib_mpool_create(&mp, "TestKVStoreLog", NULL);
+        mm = ib_mm_mpool(mp);
+    }
+
+    virtual void TearDown() {
+        ib_kvstore_destroy(&kvstore);
+        ib_mpool_destroy(mp);
+        ib_uuid_shutdown();
+    }
+
+    ib_kvstore_key_t *key(const char *name) {
+        ib_kvstore_key_t *k;
+
+        EXPECT_EQ(
+            IB_OK,
+            ib_kvstore_key_create(
+                &k,
+                mm,
+                reinterpret_cast<const uint8_t *>(name), strlen(name)));
+        return k;
+    }
+
+    void set(ib_kvstore_t *store, const char *name, const char *value) {
+        ib_kvstore_value_t *val;
+
+        ASSERT_EQ(IB_OK, ib_kvstore_value_create(&val, mm));
+        ib_kvstore_value_value_set(
+            val,
+            reinterpret_cast<const uint8_t *>(value),
+            strlen(value));
+        ib_kvstore_value_type_set(val, "txt", 3);
+        ib_kvstore_value_expiration_set(val, 10 * 1000000LU);
+
+        ASSERT_EQ(IB_OK, ib_kvstore_set(store, NULL, key(name), val));
+    }
+
+    std::string get(ib_kvstore_t *store, const char *name) {
+        ib_kvstore_value_t *result = NULL;
+        const uint8_t      *data;
+        size_t              data_length;
+
+        if (ib_kvstore_get(store, NULL, mm, key(name), &result) != IB_OK) {
+            return "<none>";
+        }
+        ib_kvstore_value_value_get(result, &data, &data_length);
+        return std::string(reinterpret_cast<const char *>(data), data_length);
+    }
+};
+
+TEST_F(TestKVStoreLog, test_reads) {
+    set(&kvstore, "k1", "A key");
+    ASSERT_EQ("A key", get(&kvstore, "k1"));
+
+    set(&kvstore, "k1", "Another key");
+    ASSERT_EQ("Another key", get(&kvstore, "k1"));
+}
+
+TEST_F(TestKVStoreLog, test_removes) {
+    set(&kvstore, "k2", "A key");
+    ASSERT_EQ(IB_OK, ib_kvstore_remove(&kvstore, key("k2")));
+    ASSERT_EQ("<none>", get(&kvstore, "k2"));
+}
+
+TEST_F(TestKVStoreLog, test_expires) {
+    ib_kvstore_value_t *val;
+    ib_kvstore_value_t *result;
+
+    ASSERT_EQ(IB_OK, ib_kvstore_value_create(&val, mm));
+    ib_kvstore_value_value_set(
+        val,
+        reinterpret_cast<const uint8_t *>("A key"),
+        5);
+    ib_kvstore_value_type_set(val, "txt", 3);
+    ib_kvstore_value_expiration_set(val, 0);
+
+    ASSERT_EQ(IB_OK, ib_kvstore_set(&kvstore, NULL, key("k3"), val));
+    ASSERT_EQ(
+        IB_ENOENT,
+        ib_kvstore_get(&kvstore, NULL, mm, key("k3"), &result));
+}
+
+TEST_F(TestKVStoreLog, test_compact) {
+    char name[16];
+
+    for (int i = 0; i < 100; ++i) {
+        snprintf(name, sizeof(name), "c%d", i % 10);
+        set(&kvstore, name, i < 90 ? "old" : "new");
+    }
+    ASSERT_EQ(IB_OK, ib_kvstore_remove(&kvstore, key("c0")));
+    ASSERT_EQ(IB_OK, ib_kvstore_log_compact(&kvstore));
+
+    ASSERT_EQ("<none>", get(&kvstore, "c0"));
+    for (int i = 1; i < 10; ++i) {
+        snprintf(name, sizeof(name), "c%d", i);
+        ASSERT_EQ("new", get(&kvstore, name));
+    }
+}
+
+TEST_F(TestKVStoreLog, test_shared) {
+    ib_kvstore_t other;
+
+    ASSERT_EQ(IB_OK, ib_kvstore_log_init(&other, "TestKVStoreLog.d"));
+    ASSERT_EQ(IB_OK, ib_kvstore_connect(&other));
+
+    set(&kvstore, "k4", "A key");
+    ASSERT_EQ("A key", get(&other, "k4"));
+
+    set(&other, "k4", "Another key");
+    ASSERT_EQ("Another key", get(&kvstore, "k4"));
+
+    /* Compaction in one store is picked up by the other. */
+    ASSERT_EQ(IB_OK, ib_kvstore_log_compact(&other));
+    set(&other, "k5", "A key");
+    ASSERT_EQ("Another key", get(&kvstore, "k4"));
+    ASSERT_EQ("A key", get(&kvstore, "k5"));
+
+    ib_kvstore_destroy(&other);
+}
+
+TEST_F(TestKVStoreLog, test_invalid_index) {
+    ib_kvstore_t other;
+    uint64_t     bucket_count = 3;
+    int          fd;
+
+    ASSERT_EQ(IB_OK, ib_kvstore_log_init(&other, "TestKVStoreLog.d"));
+    ASSERT_EQ(IB_OK, ib_kvstore_connect(&other));
+
+    set(&kvstore, "k6", "A key");
+
+    /* Not a power of 2; follows magic, version and generation. */
+    fd = open("TestKVStoreLog.d/kvstore.idx", O_RDWR);
+    ASSERT_LE(0, fd);
+    ASSERT_EQ(
+        static_cast<ssize_t>(sizeof(bucket_count)),
+        pwrite(fd, &bucket_count, sizeof(bucket_count), 16));
+    close(fd);
+
+    /* One store replaces the index, the other moves to the new one. */
+    set(&other, "k7", "Another key");
+    ASSERT_EQ("A key", get(&kvstore, "k6"));
+    ASSERT_EQ("Another key", get(&kvstore, "k7"));
+    set(&kvstore, "k8", "A third key");
+    ASSERT_EQ("A third key", get(&other, "k8"));
+
+    ib_kvstore_destroy(&other);
+}
+
+class TestKVStoreCache : public TestKVStoreLog
+{
+    public:
+
+    ib_kvstore_t  cache;
+    ib_kvstore_t *backend;
+
+    void cache_init(size_t max_bytes, ib_time_t max_age,
+                    ib_kvstore_cache_mode_t mode)
+    {
+        backend = static_cast<ib_kvstore_t *>(
+            ib_mm_alloc(mm, ib_kvstore_size()));
+        ASSERT_TRUE(backend);
+        ASSERT_EQ(IB_OK, ib_kvstore_log_init(backend, "TestKVStoreLog.d"));
+        ASSERT_EQ(
+            IB_OK,
+            ib_kvstore_cache_init(&cache, backend, max_bytes, max_age, mode));
+        ASSERT_EQ(IB_OK, ib_kvstore_connect(&cache));
+    }
+
+    virtual void TearDown() {
+        ib_kvstore_destroy(&cache);
+        TestKVStoreLog::TearDown();
+    }
+};
+
+TEST_F(TestKVStoreCache, test_write_through) {
+    uint64_t hits;
+    uint64_t misses;
+
+    cache_init(1024 * 1024, 0, IB_KVSTORE_CACHE_WRITE_THROUGH);
+
+    set(&cache, "t1", "A key");
+    ASSERT_EQ("A key", get(&kvstore, "t1"));
+    ASSERT_EQ("A key", get(&cache, "t1"));
+
+    ASSERT_EQ(IB_OK, ib_kvstore_remove(&cache, key("t1")));
+    ASSERT_EQ("<none>", get(&kvstore, "t1"));
+    ASSERT_EQ("<none>", get(&cache, "t1"));
+
+    /* A miss is loaded from the backend, then served from memory. */
+    set(&kvstore, "t2", "Another key");
+    ASSERT_EQ("Another key", get(&cache, "t2"));
+    ASSERT_EQ("Another key", get(&cache, "t2"));
+
+    ib_kvstore_cache_stats(&cache, &hits, &misses);
+    ASSERT_EQ(2U, hits);
+    ASSERT_EQ(2U, misses);
+}
+
+TEST_F(TestKVStoreCache, test_write_behind) {
+    cache_init(1024 * 1024, 0, IB_KVSTORE_CACHE_WRITE_BEHIND);
+
+    ASSERT_EQ(IB_OK, ib_kvstore_remove(&kvstore, key("b1")));
+    set(&cache, "b1", "A key");
+    ASSERT_EQ("A key", get(&cache, "b1"));
+    ASSERT_EQ("<none>", get(&kvstore, "b1"));
+
+    ASSERT_EQ(IB_OK, ib_kvstore_cache_flush(&cache));
+    ASSERT_EQ("A key", get(&kvstore, "b1"));
+}
+
+TEST_F(TestKVStoreCache, test_evict) {
+    char name[16];
+
+    /* Small enough that most entries are evicted, and so written. */
+    cache_init(16 * 256, 0, IB_KVSTORE_CACHE_WRITE_BEHIND);
+
+    for (int i = 0; i < 200; ++i) {
+        snprintf(name, sizeof(name), "e%d", i);
+        set(&cache, name, name);
+    }
+    for (int i = 0; i < 200; ++i) {
+        snprintf(name, sizeof(name), "e%d", i);
+        ASSERT_EQ(name, get(&cache, name));
+    }
+}
+
+static ib_status_t failing_set(
+    ib_kvstore_t                 *kvstore,
+    ib_kvstore_merge_policy_fn_t  merge_policy,
+    const ib_kvstore_key_t       *key,
+    ib_kvstore_value_t           *value,
+    ib_kvstore_cbdata_t          *cbdata)
+{
+    return IB_EOTHER;
+}
+
+TEST_F(TestKVStoreCache, test_evict_failure) {
+    char                name[16];
+    ib_kvstore_set_fn_t set_fn;
+
+    cache_init(16 * 256, 0, IB_KVSTORE_CACHE_WRITE_BEHIND);
+    ib_kvstore_cache_flush_interval_set(&cache, 0);
+
+    /* Entries that can not be written on eviction are kept. */
+    set_fn = backend->set;
+    backend->set = failing_set;
+    for (int i = 0; i < 200; ++i) {
+        snprintf(name, sizeof(name), "f%d", i);
+        set(&cache, name, name);
+    }
+    backend->set = set_fn;
+
+    ASSERT_EQ(IB_OK, ib_kvstore_cache_flush(&cache));
+    for (int i = 0; i < 200; ++i) {
+        snprintf(name, sizeof(name), "f%d", i);
+        ASSERT_EQ(name, get(&kvstore, name));
+    }
+}
+
+TEST_F(TestKVStoreCache, test_flush_interval) {
+    cache_init(1024 * 1024, 0, IB_KVSTORE_CACHE_WRITE_BEHIND);
+    ib_kvstore_cache_flush_interval_set(&cache, 1000);
+
+    ASSERT_EQ(IB_OK, ib_kvstore_remove(&kvstore, key("i1")));
+    set(&cache, "i1", "A key");
+    ASSERT_EQ("<none>", get(&kvstore, "i1"));
+
+    /* A get of the shard after the interval writes the value. */
+    usleep(2000);
+    ASSERT_EQ("A key", get(&cache, "i1"));
+    ASSERT_EQ("A key", get(&kvstore, "i1"));
+}
+
+TEST_F(TestKVStoreCache, test_max_age) {
+    cache_init(1024 * 1024, 1000, IB_KVSTORE_CACHE_WRITE_THROUGH);
+
+    set(&cache, "a1", "A key");
+    set(&kvstore, "a1", "Another key");
+    ASSERT_EQ("A key", get(&cache, "a1"));
+
+    usleep(2000);
+    ASSERT_EQ("Another key", get(&cache, "a1"));
+}
@@ -0,0 +1,246 @@
+//////////////////////////////////////////////////////////////////////////////
+// Licensed to Qualys, Inc. (QUALYS) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.
+// QUALYS licenses this file to You under the Apache License, Version 2.0
+// (the "License"); you may not use this file except in compliance with
+// the License.  You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * @file
+ * @brief IronBee --- Logger record queue tests.
+ */
+
+extern "C" {
+#include "ironbee_config_auto.h"
+
+#include <ironbee/logger.h>
+#include <ironbee/mm_mpool.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+}
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+extern "C" {
+
+static ib_status_t test_format(
+    ib_logger_t           *logger,
+    const ib_logger_rec_t *rec,
+    const uint8_t         *log_msg,
+    const size_t           log_msg_sz,
+    void                  *writer_record,
+    void                  *data
+)
+{
+    char *s = static_cast<char *>(malloc(log_msg_sz + 1));
+    memcpy(s, log_msg, log_msg_sz);
+    s[log_msg_sz] = '\0';
+    *static_cast<char **>(writer_record) = s;
+    return IB_OK;
+}
+
+static void test_free(ib_logger_t *logger, void *writer_record, void *cbdata)
+{
+    free(writer_record);
+}
+
+static ib_status_t test_record(
+    ib_logger_t        *logger,
+    ib_logger_writer_t *writer,
+    void               *cbdata
+)
+{
+    /* Leave records queued; the test dequeues them. */
+    *static_cast<ib_logger_writer_t **>(cbdata) = writer;
+    return IB_OK;
+}
+
+static void test_element(void *element, void *cbdata)
+{
+    static_cast<std::vector<std::string> *>(cbdata)->push_back(
+        static_cast<const char *>(element));
+}
+
+/* For formats without a free function: the handler frees the record. */
+static void test_element_free(void *element, void *cbdata)
+{
+    test_element(element, cbdata);
+    free(element);
+}
+
+static ib_status_t test_msg_fn(
+    const ib_logger_rec_t  *rec,
+    ib_mm_t                 mm,
+    uint8_t               **msg,
+    size_t                 *msg_sz,
+    void                   *data
+)
+{
+    *msg = NULL;
+    *msg_sz = 0;
+    return IB_OK;
+}
+
+}
+
+class TestLogger : public testing::Test
+{
+public:
+    ib_mpool_t         *mp;
+    ib_logger_t        *logger;
+    ib_logger_writer_t *writer;
+    ib_logger_format_t *format;
+
+    virtual void SetUp()
+    {
+        ASSERT_EQ(IB_OK, ib_mpool_create(&mp, "TestLogger", NULL));
+        ASSERT_EQ(IB_OK, ib_logger_create(&logger, IB_LOG_INFO, ib_mm_mpool(mp)));
+        ASSERT_EQ(IB_OK, ib_logger_format_create(
+            logger, &format, test_format, NULL, test_free, NULL));
+        writer = NULL;
+    }
+
+    virtual void TearDown()
+    {
+        ib_mpool_destroy(mp);
+    }
+
+    void addWriter(size_t capacity, ib_logger_overflow_t overflow)
+    {
+        ASSERT_EQ(IB_OK, ib_logger_queue_set(logger, capacity, overflow, 0));
+        ASSERT_EQ(IB_OK, ib_logger_writer_add(
+            logger,
+            NULL, NULL, NULL, NULL, NULL, NULL,
+            format,
+            test_record, &writer));
+    }
+
+    void log(const std::string& msg)
+    {
+        ib_logger_log_msg(
+            logger, IB_LOGGER_ERRORLOG_TYPE, __FILE__, __func__, __LINE__,
+            NULL, NULL, NULL, NULL, IB_LOG_INFO,
+            reinterpret_cast<const uint8_t *>(msg.data()), msg.length(),
+            test_msg_fn, NULL);
+    }
+
+    std::vector<std::string> drain()
+    {
+        std::vector<std::string> records;
+        EXPECT_EQ(IB_OK, ib_logger_dequeue(logger, writer, test_element, &records));
+        return records;
+    }
+};
+
+TEST_F(TestLogger, DropNewest)
+{
+    ib_logger_queue_stats_t stats;
+
+    addWriter(4, IB_LOGGER_OVERFLOW_DROP_NEWEST);
+    for (int i = 0; i < 10; ++i) {
+        log(std::string(1, 'a' + i));
+    }
+    ASSERT_TRUE(writer);
+
+    ib_logger_queue_stats(logger, &stats);
+    EXPECT_EQ(4UL, stats.depth);
+    EXPECT_EQ(4UL, stats.high_water);
+    EXPECT_EQ(6UL, stats.dropped);
+
+    std::vector<std::string> records = drain();
+    ASSERT_EQ(4UL, records.size());
+    EXPECT_EQ("a", records[0]);
+    EXPECT_EQ("d", records[3]);
+
+    ib_logger_writer_queue_stats(writer, &stats);
+    EXPECT_EQ(0UL, stats.depth);
+}
+
+TEST_F(TestLogger, DropOldest)
+{
+    ib_logger_queue_stats_t stats;
+
+    addWriter(3, IB_LOGGER_OVERFLOW_DROP_OLDEST);
+    for (int i = 0; i < 10; ++i) {
+        log(std::string(1, 'a' + i));
+    }
+
+    /* Capacity is rounded up to 4. */
+    std::vector<std::string> records = drain();
+    ASSERT_EQ(4UL, records.size());
+    EXPECT_EQ("g", records[0]);
+    EXPECT_EQ("j", records[3]);
+
+    ib_logger_queue_stats(logger, &stats);
+    EXPECT_EQ(6UL, stats.dropped);
+}
+
+TEST_F(TestLogger, QueueSetRejectsHugeCapacity)
+{
+    EXPECT_EQ(IB_EINVAL, ib_logger_queue_set(
+        logger, 0, IB_LOGGER_OVERFLOW_DROP_NEWEST, 0));
+    EXPECT_EQ(IB_EINVAL, ib_logger_queue_set(
+        logger, SIZE_MAX, IB_LOGGER_OVERFLOW_DROP_NEWEST, 0));
+    EXPECT_EQ(IB_EINVAL, ib_logger_queue_set(
+        logger, SIZE_MAX / 2 + 2, IB_LOGGER_OVERFLOW_DROP_NEWEST, 0));
+    EXPECT_EQ(IB_EINVAL, ib_logger_queue_set(
+        logger, SIZE_MAX / 2 + 1, IB_LOGGER_OVERFLOW_DROP_NEWEST, 0));
+}
+
+TEST_F(TestLogger, WriterAddHugeCapacity)
+{
+    /* Accepted, but the queue can not be allocated. */
+    ASSERT_EQ(IB_OK, ib_logger_queue_set(
+        logger, SIZE_MAX / 64, IB_LOGGER_OVERFLOW_DROP_NEWEST, 0));
+    EXPECT_EQ(IB_EALLOC, ib_logger_writer_add(
+        logger,
+        NULL, NULL, NULL, NULL, NULL, NULL,
+        format,
+        test_record, &writer));
+    EXPECT_EQ(0UL, ib_logger_writer_count(logger));
+}
+
+TEST_F(TestLogger, NoFreeFunction)
+{
+    ASSERT_EQ(IB_OK, ib_logger_format_create(
+        logger, &format, test_format, NULL, NULL, NULL));
+    addWriter(2, IB_LOGGER_OVERFLOW_DROP_NEWEST);
+    for (int i = 0; i < 2; ++i) {
+        log(std::string(1, 'a' + i));
+    }
+
+    std::vector<std::string> records;
+    ASSERT_EQ(IB_OK, ib_logger_dequeue(
+        logger, writer, test_element_free, &records));
+    EXPECT_EQ(2UL, records.size());
+}
+
+TEST_F(TestLogger, BlockTimesOut)
+{
+    ib_logger_queue_stats_t stats;
+
+    addWriter(2, IB_LOGGER_OVERFLOW_BLOCK);
+    for (int i = 0; i < 3; ++i) {
+        log(std::string(1, 'a' + i));
+    }
+
+    ib_logger_queue_stats(logger, &stats);
+    EXPECT_EQ(2UL, stats.depth);
+    EXPECT_EQ(1UL, stats.dropped);
+    EXPECT_EQ(2UL, drain().size());
+}
@@ -0,0 +1,132 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Rule Engine Equality Fold Tests
+ */
+
+#include "gtest/gtest.h"
+#include "base_fixture.h"
+
+#include "rule_engine_private.h"
+
+#include <ironbee/rule_engine.h>
+
+#include <map>
+#include <stdexcept>
+#include <string>
+
+class RuleFoldTest : public BaseTransactionFixture
+{
+public:
+    const ib_rule_t *rule(const char *id)
+    {
+        ib_rule_t *r = NULL;
+
+        EXPECT_EQ(IB_OK, ib_rule_lookup(ib_engine, ib_tx->ctx, id, &r));
+        return r;
+    }
+
+    ib_num_t num(const char *name)
+    {
+        ib_num_t n = 0;
+        ib_field_t *f = getVar(name);
+
+        EXPECT_EQ(IB_OK, ib_field_value(f, ib_ftype_num_out(&n)));
+        return n;
+    }
+};
+
+extern "C" {
+
+static
+ib_status_t count_executions(
+    const ib_rule_t       *rule,
+    const ib_rule_stats_t *stats,
+    void                  *cbdata
+)
+{
+    *reinterpret_cast<uint64_t *>(cbdata) += stats->executions;
+    return IB_OK;
+}
+
+static
+ib_status_t collect_stats(
+    const ib_rule_t       *rule,
+    const ib_rule_stats_t *stats,
+    void                  *cbdata
+)
+{
+    (*reinterpret_cast<std::map<std::string, ib_rule_stats_t> *>(cbdata))
+        [ib_rule_id(rule)] = *stats;
+    return IB_OK;
+}
+
+} // extern "C"
+
+TEST_F(RuleFoldTest, test_fold)
+{
+    uint64_t executions = 0;
+
+    configureIronBee();
+    performTx();
+
+    /* Rules 1, 2, 3, 5 and chain 6 share a group; rule 4 is
+     * case-insensitive. */
+    ASSERT_TRUE(rule("1")->fold);
+    EXPECT_EQ(rule("1")->fold->group, rule("2")->fold->group);
+    EXPECT_EQ(rule("1")->fold->group, rule("3")->fold->group);
+    EXPECT_EQ(rule("1")->fold->group, rule("5")->fold->group);
+    EXPECT_EQ(rule("1")->fold->group, rule("6")->fold->group);
+    EXPECT_EQ(rule("2")->fold->operand, rule("6")->fold->operand);
+    ASSERT_TRUE(rule("4")->fold);
+    EXPECT_NE(rule("1")->fold->group, rule("4")->fold->group);
+    EXPECT_EQ(5UL, rule("1")->fold->group->members);
+
+    /* Inverted, false action and capture rules are not folded. */
+    EXPECT_FALSE(rule("7")->fold);
+    EXPECT_FALSE(rule("8")->fold);
+    EXPECT_FALSE(rule("9")->fold);
+
+    /* Matching rules fire in order, including the chain. */
+    EXPECT_EQ(6, num("order"));
+    EXPECT_EQ(1, num("not_post"));
+    EXPECT_EQ(1, num("not_post2"));
+    EXPECT_THROW(getVar("post"), std::runtime_error);
+    EXPECT_THROW(getVar("put"), std::runtime_error);
+    EXPECT_THROW(getVar("lower"), std::runtime_error);
+
+    /* Skipped rules are still counted: 9 top level rules and 1 chained. */
+    ASSERT_EQ(IB_OK,
+              ib_rule_stats_foreach(ib_engine, count_executions, &executions));
+    EXPECT_EQ(10UL, executions);
+
+    /* The non-matching members were skipped: their operator never ran, so
+     * no time was spent in it. */
+    std::map<std::string, ib_rule_stats_t> stats;
+    ASSERT_EQ(IB_OK,
+              ib_rule_stats_foreach(ib_engine, collect_stats, &stats));
+    const char *skipped[] = { "1", "3", "5" };
+    for (size_t i = 0; i < sizeof(skipped) / sizeof(*skipped); ++i) {
+        ASSERT_EQ(1UL, stats.count(skipped[i])) << skipped[i];
+        EXPECT_EQ(1UL, stats[skipped[i]].executions) << skipped[i];
+        EXPECT_EQ(0UL, stats[skipped[i]].matches) << skipped[i];
+        EXPECT_EQ(0UL, stats[skipped[i]].operator_time) << skipped[i];
+    }
+    EXPECT_EQ(1UL, stats["2"].matches);
+}
@@ -0,0 +1,87 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Rule Engine Statistics Tests
+ */
+
+#include "gtest/gtest.h"
+#include "base_fixture.h"
+
+#include <ironbee/rule_engine.h>
+
+#include <map>
+#include <string>
+
+class RuleStatsTest : public BaseTransactionFixture
+{
+};
+
+typedef std::map<std::string, ib_rule_stats_t> stats_map_t;
+
+extern "C" {
+
+static
+ib_status_t collect_stats(
+    const ib_rule_t       *rule,
+    const ib_rule_stats_t *stats,
+    void                  *cbdata
+)
+{
+    (*reinterpret_cast<stats_map_t *>(cbdata))[rule->meta.id] = *stats;
+    return IB_OK;
+}
+
+} // extern "C"
+
+static
+stats_map_t collect(const ib_engine_t *ib)
+{
+    stats_map_t stats;
+
+    EXPECT_EQ(IB_OK, ib_rule_stats_foreach(ib, collect_stats, &stats));
+    return stats;
+}
+
+TEST_F(RuleStatsTest, test_counts)
+{
+    stats_map_t stats;
+
+    configureIronBee();
+    EXPECT_TRUE(collect(ib_engine).empty());
+
+    performTx();
+    performTx();
+
+    stats = collect(ib_engine);
+    ASSERT_EQ(3UL, stats.size());
+
+    EXPECT_EQ(2UL, stats["1"].executions);
+    EXPECT_EQ(2UL, stats["1"].matches);
+    EXPECT_EQ(0UL, stats["1"].tfn_time);
+
+    EXPECT_EQ(2UL, stats["2"].executions);
+    EXPECT_EQ(0UL, stats["2"].matches);
+
+    EXPECT_EQ(2UL, stats["3"].executions);
+    EXPECT_EQ(2UL, stats["3"].matches);
+    EXPECT_LT(0UL, stats["3"].tfn_time);
+
+    ib_rule_stats_reset(ib_engine);
+    EXPECT_TRUE(collect(ib_engine).empty());
+}
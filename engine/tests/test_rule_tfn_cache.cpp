@@ -0,0 +1,68 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Rule Engine Transformation Cache Tests
+ */
+
+#include "gtest/gtest.h"
+#include "base_fixture.h"
+
+#include <ironbee/rule_engine.h>
+#include <ironbee/transformation.h>
+
+class RuleTfnCacheTest : public BaseTransactionFixture
+{
+};
+
+extern "C" {
+
+static
+ib_status_t count_tfn(
+    ib_mm_t            mm,
+    const ib_field_t  *fin,
+    const ib_field_t **fout,
+    void              *instance_data,
+    void              *cbdata
+)
+{
+    ++*reinterpret_cast<int *>(cbdata);
+    *fout = fin;
+    return IB_OK;
+}
+
+} // extern "C"
+
+TEST_F(RuleTfnCacheTest, test_shared_chain)
+{
+    int count = 0;
+
+    ASSERT_EQ(IB_OK, ib_transformation_create_and_register(
+        NULL, ib_engine, "countTfn", false,
+        NULL, NULL,
+        NULL, NULL,
+        count_tfn, &count
+    ));
+
+    configureIronBee();
+    performTx();
+
+    /* Rules 1-3 share a single-transformation chain which runs once.
+     * Rule 4 has a different (two transformation) chain. */
+    EXPECT_EQ(3, count);
+}
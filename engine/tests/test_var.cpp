@@ -558,6 +558,117 @@ TEST(TestVar, Target)
     EXPECT_EQ("fooA", result_list.front().name_as_s());
 }
 
+TEST(TestVar, TargetFilterIndex)
+{
+    using namespace IronBee;
+
+    ScopedMemoryPool smp;
+    ib_status_t rc;
+    ib_mm_t mm = ib_mm_mpool(MemoryPool(smp).ib());
+    typedef ConstList<IronBee::Field> field_clist_t;
+
+    ib_var_config_t *config = make_config(mm);
+    ASSERT_TRUE(config);
+    ib_var_source_t *source = make_source(config, "data");
+    ASSERT_TRUE(source);
+    ib_var_store_t *store = make_store(config);
+    ASSERT_TRUE(store);
+
+    rc = ib_var_source_append(source, store,
+        Field::create_number(smp, "fooA", 4, 5).ib()
+    );
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_source_append(source, store,
+        Field::create_number(smp, "barA", 4, 6).ib()
+    );
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_source_append(source, store,
+        Field::create_number(smp, "FOOa", 4, 7).ib()
+    );
+    ASSERT_EQ(IB_OK, rc);
+
+    ib_var_target_t *target;
+    const ib_list_t *result = NULL;
+    const ib_list_t *result2 = NULL;
+    field_clist_t result_list;
+
+    rc = ib_var_target_acquire_from_string(&target, mm, config, "data:fooa", 9);
+    ASSERT_EQ(IB_OK, rc);
+
+    rc = ib_var_target_get(target, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    result_list = field_clist_t(result);
+    ASSERT_EQ(2UL, result_list.size());
+    EXPECT_EQ(5, result_list.front().value_as_number());
+    EXPECT_EQ(7, result_list.back().value_as_number());
+
+    /* Repeated lookups share the indexed result. */
+    rc = ib_var_target_get(target, &result2, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(result, result2);
+
+    /* Appending invalidates the index. */
+    rc = ib_var_source_append(source, store,
+        Field::create_number(smp, "Fooa", 4, 8).ib()
+    );
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_target_get(target, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    result_list = field_clist_t(result);
+    ASSERT_EQ(3UL, result_list.size());
+    EXPECT_EQ(8, result_list.back().value_as_number());
+
+    /* Removing invalidates the index. */
+    rc = ib_var_target_remove(target, NULL, IB_MM_NULL, store);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_target_get(target, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(0UL, ib_list_elements(result));
+
+    rc = ib_var_target_acquire_from_string(&target, mm, config, "data:bara", 9);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_target_get(target, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    result_list = field_clist_t(result);
+    ASSERT_EQ(1UL, result_list.size());
+    EXPECT_EQ("barA", result_list.front().name_as_s());
+
+    /* Changing the list directly is also seen, even if its length and last
+     * node stay the same. */
+    rc = ib_var_source_append(source, store,
+        Field::create_number(smp, "other", 5, 1).ib()
+    );
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_target_get(target, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_EQ(1UL, ib_list_elements(result));
+
+    ib_field_t *data_field;
+    ib_list_t  *data_list;
+    rc = ib_var_source_get(source, &data_field, store);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_field_value(data_field, ib_ftype_list_mutable_out(&data_list));
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_EQ(2UL, ib_list_elements(data_list));
+    ib_list_node_remove(data_list, ib_list_first(data_list));
+    rc = ib_list_unshift(data_list,
+        Field::create_number(smp, "BARA", 4, 9).ib()
+    );
+    ASSERT_EQ(IB_OK, rc);
+
+    rc = ib_var_target_get(target, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    result_list = field_clist_t(result);
+    ASSERT_EQ(1UL, result_list.size());
+    EXPECT_EQ(9, result_list.front().value_as_number());
+
+    rc = ib_var_target_acquire_from_string(&target, mm, config, "data:none", 9);
+    ASSERT_EQ(IB_OK, rc);
+    rc = ib_var_target_get(target, &result, mm, store);
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(0UL, ib_list_elements(result));
+}
+
 TEST(TestVar, TargetRemoveTrivial)
 {
     using namespace IronBee;
@@ -59,6 +59,14 @@ struct ib_var_store_t
     ib_hash_t *hash;
     /** Array of source index to value.  Value: `ib_field_t *` */
     ib_array_t *array;
+    /**
+     * Name indices of list fields, keyed by field pointer.
+     *
+     * Value: `var_name_index_t *`.  Created on first filtered lookup.
+     **/
+    ib_hash_t *name_indices;
+    /** Shared empty result for filters that match nothing. */
+    ib_list_t *empty_list;
 };
 
 struct ib_var_source_t
@@ -141,6 +149,26 @@ struct ib_var_target_t
     const ib_var_filter_t *filter;
 };
 
+/**
+ * Case-insensitive name index of a non-dynamic list field.
+ *
+ * Maps each member name to a list of the members with that name, in list
+ * order.  Result lists are shared by all lookups and never modified; a
+ * changed field gets a new index with new lists.
+ **/
+typedef struct var_name_index_t var_name_index_t;
+struct var_name_index_t
+{
+    /** Indexed field; also the storage of the key in name_indices. */
+    const ib_field_t *field;
+    /** Name to list of members.  Value: `ib_list_t *`. */
+    ib_hash_t *by_name;
+    /** List of members when built. */
+    const ib_list_t *members;
+    /** Generation of @ref members when built. */
+    size_t generation;
+};
+
 struct ib_var_expand_t
 {
     /** Text before expansion.  May be NULL. */
@@ -224,6 +252,45 @@ ib_status_t target_filter_get(
 )
 NONNULL_ATTRIBUTE(1, 2, 4);
 
+/**
+ * Apply a filter to a non-dynamic list field through its name index.
+ *
+ * The index of @a field is built or rebuilt as needed.  The result is
+ * shared and has the lifetime of @a store.
+ *
+ * @param[in]  filter Filter to apply.
+ * @param[out] result Members of @a field matching @a filter.
+ * @param[in]  store  Store holding @a field.
+ * @param[in]  field  Non-dynamic list field to filter.
+ *
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ **/
+static
+ib_status_t filter_apply_indexed(
+    const ib_var_filter_t  *filter,
+    const ib_list_t       **result,
+    ib_var_store_t         *store,
+    const ib_field_t       *field
+)
+NONNULL_ATTRIBUTE(1, 2, 3, 4);
+
+/**
+ * Discard the name index of @a field, if any.
+ *
+ * Called whenever members are added to or removed from @a field.
+ *
+ * @param[in] store Store holding @a field.
+ * @param[in] field Field whose index to discard.
+ **/
+static
+void name_index_invalidate(
+    ib_var_store_t   *store,
+    const ib_field_t *field
+)
+NONNULL_ATTRIBUTE(1, 2);
+
 /* var_config */
 
 ib_status_t ib_var_config_acquire(
@@ -282,8 +349,10 @@ ib_status_t ib_var_store_acquire(
         return IB_EALLOC;
     }
 
-    local_store->config = config;
-    local_store->mm     = mm;
+    local_store->config       = config;
+    local_store->mm           = mm;
+    local_store->name_indices = NULL;
+    local_store->empty_list   = NULL;
 
     rc = ib_hash_create_nocase(&local_store->hash, mm);
     if (rc != IB_OK) {
@@ -732,6 +801,8 @@ ib_status_t ib_var_source_append(
         return rc == IB_EALLOC ? rc : IB_EOTHER;
     }
 
+    name_index_invalidate(store, source_field);
+
     return IB_OK;
 }
 
@@ -901,6 +972,153 @@ ib_status_t ib_var_filter_remove(
     return IB_OK;
 }
 
+ib_status_t filter_apply_indexed(
+    const ib_var_filter_t  *filter,
+    const ib_list_t       **result,
+    ib_var_store_t         *store,
+    const ib_field_t       *field
+)
+{
+    assert(filter != NULL);
+    assert(result != NULL);
+    assert(store  != NULL);
+    assert(field  != NULL);
+    assert(field->type == IB_FTYPE_LIST);
+    assert(! ib_field_is_dynamic(field));
+
+    ib_status_t           rc;
+    const ib_list_t      *members;
+    const ib_list_node_t *node;
+    var_name_index_t     *index = NULL;
+    ib_list_t            *matches;
+
+    rc = ib_field_value(field, ib_ftype_list_out(&members));
+    /* Can only fail on dynamic field. */
+    assert(rc == IB_OK);
+
+    if (store->name_indices == NULL) {
+        rc = ib_hash_create(&store->name_indices, store->mm);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+    else {
+        rc = ib_hash_get_ex(
+            store->name_indices,
+            &index,
+            (const char *)&field, sizeof(field)
+        );
+        if (rc != IB_OK && rc != IB_ENOENT) {
+            return rc;
+        }
+    }
+
+    /* Lists can be changed without going through the store, so also check
+     * that the index still describes the list. */
+    if (
+        index != NULL && (
+            index->members    != members ||
+            index->generation != ib_list_generation(members)
+        )
+    ) {
+        index = NULL;
+    }
+
+    if (index == NULL) {
+        index = ib_mm_alloc(store->mm, sizeof(*index));
+        if (index == NULL) {
+            return IB_EALLOC;
+        }
+        index->field = field;
+        index->members    = members;
+        index->generation = ib_list_generation(members);
+        rc = ib_hash_create_nocase(&index->by_name, store->mm);
+        if (rc != IB_OK) {
+            return rc;
+        }
+
+        IB_LIST_LOOP_CONST(members, node) {
+            const ib_field_t *f =
+                (const ib_field_t *)ib_list_node_data_const(node);
+
+            /* Unnamed members can never match a filter. */
+            if (f->name == NULL) {
+                continue;
+            }
+
+            rc = ib_hash_get_ex(index->by_name, &matches, f->name, f->nlen);
+            if (rc == IB_ENOENT) {
+                rc = ib_list_create(&matches, store->mm);
+                if (rc != IB_OK) {
+                    return rc;
+                }
+                rc = ib_hash_set_ex(
+                    index->by_name,
+                    f->name, f->nlen,
+                    matches
+                );
+            }
+            if (rc != IB_OK) {
+                return rc;
+            }
+            /* Discard const because lists are const-generic. */
+            rc = ib_list_push(matches, (void *)f);
+            if (rc != IB_OK) {
+                return rc;
+            }
+        }
+
+        rc = ib_hash_set_ex(
+            store->name_indices,
+            (const char *)&index->field, sizeof(index->field),
+            index
+        );
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    rc = ib_hash_get_ex(
+        index->by_name,
+        &matches,
+        filter->filter_string, filter->filter_string_length
+    );
+    if (rc == IB_ENOENT) {
+        if (store->empty_list == NULL) {
+            rc = ib_list_create(&store->empty_list, store->mm);
+            if (rc != IB_OK) {
+                return rc;
+            }
+        }
+        matches = store->empty_list;
+    }
+    else if (rc != IB_OK) {
+        return rc;
+    }
+
+    *result = matches;
+
+    return IB_OK;
+}
+
+void name_index_invalidate(
+    ib_var_store_t   *store,
+    const ib_field_t *field
+)
+{
+    assert(store != NULL);
+    assert(field != NULL);
+
+    if (store->name_indices != NULL) {
+        /* Ignore return code.  Can only be IB_ENOENT. */
+        ib_hash_remove_ex(
+            store->name_indices,
+            NULL,
+            (const char *)&field, sizeof(field)
+        );
+    }
+}
+
 /* var_target */
 
 ib_status_t ib_var_target_acquire(
@@ -1134,8 +1352,19 @@ ib_status_t ib_var_target_get(
         return rc;
     }
 
-    if (filter != NULL) {
-        /* Filter list field. */
+    if (
+        filter != NULL &&
+        field->type == IB_FTYPE_LIST &&
+        ! ib_field_is_dynamic(field)
+    ) {
+        /* Filter list field through its name index. */
+        rc = filter_apply_indexed(filter, &local_result, store, field);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+    else if (filter != NULL) {
+        /* Filter dynamic field or fail on non-list field. */
         rc = ib_var_filter_apply(
             filter,
             &local_result,
@@ -1267,11 +1496,13 @@ ib_status_t ib_var_target_remove(
     else if (! ib_mm_is_null(local_mm)) {
         /* Simple */
         rc = ib_var_filter_remove(filter, &local_result, local_mm, field);
+        name_index_invalidate(store, field);
         goto finish;
     }
     else {
         /* No memory pool. */
         rc = ib_var_filter_remove(filter, NULL, IB_MM_NULL, field);
+        name_index_invalidate(store, field);
         goto finish;
     }
 
@@ -1408,6 +1639,8 @@ ib_status_t ib_var_target_set(
         return rc == IB_EALLOC ? rc : IB_EOTHER;
     }
 
+    name_index_invalidate(store, source_field);
+
     return IB_OK;
 }
 
@@ -1656,6 +1889,25 @@ ib_status_t ib_var_expand_acquire(
     return IB_OK;
 }
 
+ib_status_t ib_var_expand_constant(
+    const ib_var_expand_t  *expand,
+    const char            **dst,
+    size_t                 *dst_length
+)
+{
+    assert(expand     != NULL);
+    assert(dst        != NULL);
+    assert(dst_length != NULL);
+
+    if (expand->next != NULL || expand->target != NULL) {
+        return IB_EINVAL;
+    }
+
+    *dst = expand->prefix;
+    *dst_length = expand->prefix_length;
+    return IB_OK;
+}
+
 ib_status_t ib_var_expand_execute(
     const ib_var_expand_t  *expand,
     const char            **dst,
@@ -79,14 +79,19 @@ step(
 )
 
 eudoxus = rules + '.e'
+# Engines map the automata, so it must be replaced by rename, never rewritten
+# in place.
+eudoxus_tmp = eudoxus + '.tmp'
 compile_cmd = [
   '../automata/bin/ec',
   '-i',
   automata,
   '-o',
-  eudoxus,
+  eudoxus_tmp,
   '-h',
-  '0.5'
+  '0.5',
+  '-d',
+  '2'
 ]
 
 v "Compiling optimized from #{optimized} to #{eudoxus}"
@@ -97,5 +102,6 @@ if ! status.success?
   v "Failed: #{status}"
   exit 1
 end
+File.rename(eudoxus_tmp, eudoxus)
 
 
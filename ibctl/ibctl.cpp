@@ -125,6 +125,14 @@ void parse_options(
             "    If name is omitted the default is used instead.\n"
             "  engine_status\n"
             "    Return the current status of all engines in JSON.\n"
+            "  rule_stats [<count>]\n"
+            "    Return per-rule execution counts and times in JSON,\n"
+            "    most expensive rules first, at most <count> rules.\n"
+            "  rule_stats_reset\n"
+            "    Zero the per-rule execution counts and times.\n"
+            "  log_queue_stats\n"
+            "    Return the log record queue depth, high water mark and\n"
+            "    number of dropped records in JSON.\n"
             "Options"
         );
 
@@ -198,6 +206,16 @@ void validate_cmd(const parsed_options_t& opts)
             );
         }
     }
+
+    if (opts.cmd[0] == "rule_stats") {
+        if (opts.cmd.size() > 2) {
+            BOOST_THROW_EXCEPTION(
+                exit_exception(
+                    "rule_stats takes at most one argument, a rule count."
+                )
+            );
+        }
+    }
 }
 
 /**
@@ -0,0 +1,136 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Atomic Operations
+ *
+ * Thin wrappers around the compiler's atomic builtins.
+ *
+ * All operations take a pointer to a naturally aligned integer or pointer
+ * object.  Loads have acquire semantics, stores have release semantics and
+ * read-modify-write operations are sequentially consistent unless noted.
+ */
+
+#ifndef _IB_ATOMIC_H_
+#define _IB_ATOMIC_H_
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @defgroup IronBeeUtilAtomic Atomic Operations
+ * @ingroup IronBeeUtil
+ * Lock-free primitives for shared counters and pointers.
+ * @{
+ */
+
+/**
+ * Load the value at @a ptr (acquire).
+ */
+#define ib_atomic_load(ptr) \
+    __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+
+/**
+ * Load the value at @a ptr with no ordering constraints.
+ */
+#define ib_atomic_load_relaxed(ptr) \
+    __atomic_load_n((ptr), __ATOMIC_RELAXED)
+
+/**
+ * Store @a val at @a ptr (release).
+ */
+#define ib_atomic_store(ptr, val) \
+    __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+
+/**
+ * Store @a val at @a ptr with no ordering constraints.
+ */
+#define ib_atomic_store_relaxed(ptr, val) \
+    __atomic_store_n((ptr), (val), __ATOMIC_RELAXED)
+
+/**
+ * Add @a val to the value at @a ptr and return the new value.
+ */
+#define ib_atomic_add(ptr, val) \
+    __atomic_add_fetch((ptr), (val), __ATOMIC_SEQ_CST)
+
+/**
+ * Subtract @a val from the value at @a ptr and return the new value.
+ */
+#define ib_atomic_sub(ptr, val) \
+    __atomic_sub_fetch((ptr), (val), __ATOMIC_SEQ_CST)
+
+/**
+ * Add @a val to the value at @a ptr with no ordering constraints.
+ *
+ * Suitable for statistics counters.
+ */
+#define ib_atomic_add_relaxed(ptr, val) \
+    ((void)__atomic_add_fetch((ptr), (val), __ATOMIC_RELAXED))
+
+/**
+ * Store @a val at @a ptr and return the previous value.
+ */
+#define ib_atomic_exchange(ptr, val) \
+    __atomic_exchange_n((ptr), (val), __ATOMIC_SEQ_CST)
+
+/**
+ * Compare and swap.
+ *
+ * If the value at @a ptr equals the value at @a expected, store @a desired
+ * at @a ptr and return true.  Otherwise, write the current value at @a ptr
+ * to @a expected and return false.
+ */
+#define ib_atomic_cas(ptr, expected, desired) \
+    __atomic_compare_exchange_n(              \
+        (ptr), (expected), (desired), false,  \
+        __ATOMIC_SEQ_CST, __ATOMIC_ACQUIRE)
+
+/**
+ * Raise the value at @a ptr to @a val if @a val is larger.
+ *
+ * Suitable for high-water marks.
+ */
+#define ib_atomic_max(ptr, val)                                 \
+    do {                                                        \
+        __typeof__(*(ptr)) ib_atomic_max_cur_ =                 \
+            __atomic_load_n((ptr), __ATOMIC_RELAXED);           \
+        while (ib_atomic_max_cur_ < (val) &&                    \
+               ! __atomic_compare_exchange_n(                   \
+                   (ptr), &ib_atomic_max_cur_, (val), true,     \
+                   __ATOMIC_RELAXED, __ATOMIC_RELAXED))         \
+        {                                                       \
+        }                                                       \
+    } while (0)
+
+/**
+ * Full (sequentially consistent) memory fence.
+ */
+#define ib_atomic_fence() \
+    __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+/** @} IronBeeUtilAtomic */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _IB_ATOMIC_H_ */
@@ -188,6 +188,84 @@ ib_status_t DLL_PUBLIC ib_engine_config_started(ib_engine_t *ib,
  */
 ib_status_t DLL_PUBLIC ib_engine_config_finished(ib_engine_t *ib);
 
+/**
+ * Configuration job function.
+ *
+ * Jobs run on configuration worker threads, concurrently with each other,
+ * while the thread that queued them waits.  A job must not queue further
+ * jobs and must only allocate from memory that it alone uses.
+ *
+ * @param[in] ib Engine handle
+ * @param[in] cbdata Callback data passed to ib_engine_config_job_add().
+ *
+ * @returns Status code; any failure fails ib_engine_config_jobs_run().
+ */
+typedef ib_status_t (*ib_engine_config_job_fn_t)(
+    ib_engine_t *ib,
+    void        *cbdata
+);
+
+/**
+ * Queue an independent configuration job.
+ *
+ * Queued jobs are run by ib_engine_config_jobs_run(), which is called
+ * whenever a configuration context is closed, so the job's results are
+ * available to all context close callbacks.  Outside of configuration, or
+ * when only one configuration worker is configured, @a fn is called
+ * immediately.
+ *
+ * @param[in] ib Engine handle
+ * @param[in] fn Job function.
+ * @param[in] cbdata Callback data for @a fn.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ * - Status of @a fn if it was called immediately.
+ */
+ib_status_t DLL_PUBLIC ib_engine_config_job_add(
+    ib_engine_t               *ib,
+    ib_engine_config_job_fn_t  fn,
+    void                      *cbdata
+);
+
+/**
+ * Run all queued configuration jobs and wait for them to complete.
+ *
+ * Jobs are spread across up to ib_engine_config_workers() threads,
+ * including the calling thread.  If fewer worker threads can be started,
+ * the remaining workers run the jobs.  All jobs are run even if some fail.
+ *
+ * @param[in] ib Engine handle
+ *
+ * @returns
+ * - IB_OK if all jobs succeeded.
+ * - IB_EALLOC on allocation failure; no job is run.
+ * - Otherwise, the status of the first failed job.
+ */
+ib_status_t DLL_PUBLIC ib_engine_config_jobs_run(ib_engine_t *ib);
+
+/**
+ * Set the number of configuration worker threads.
+ *
+ * @param[in] ib Engine handle
+ * @param[in] workers Number of workers; 0 uses one per online CPU and 1
+ *                    runs configuration jobs serially.
+ */
+void DLL_PUBLIC ib_engine_config_workers_set(
+    ib_engine_t *ib,
+    size_t       workers
+);
+
+/**
+ * Get the number of configuration worker threads.
+ *
+ * @param[in] ib Engine handle
+ *
+ * @returns Number of configuration workers; always at least 1.
+ */
+size_t DLL_PUBLIC ib_engine_config_workers(const ib_engine_t *ib);
+
 /**
  * Get the configuration parser
  *
@@ -82,6 +82,11 @@ extern "C" {
  * its reference count becomes zero), the manager will destroy all inactive
  * engines.
  *
+ * Acquiring and releasing engines never takes the manager lock and never
+ * allocates; they only read an atomically published snapshot of the
+ * engines.  Inactive engines are destroyed only once no acquire or release
+ * in progress can still see them.
+ *
  */
 typedef struct ib_manager_t ib_manager_t;
 
@@ -331,6 +336,7 @@ NONNULL_ATTRIBUTE(1);
  *
  * @returns
  * - IB_OK On success.
+ * - IB_EALLOC On allocation errors. The manager is unchanged.
  * - Other on locking error.
  */
 ib_status_t DLL_PUBLIC ib_manager_disable(
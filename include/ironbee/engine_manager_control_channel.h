@@ -260,6 +260,14 @@ NONNULL_ATTRIBUTE(1);
  *
  * The commands registered are:
  * - valgrind - run valgrind if the server container is being managed so.
+ * - valgrind_added - report leaks added since the last valgrind command.
+ * - version - return the IronBee version.
+ * - rule_stats [\<count\>] - per-rule execution counts and times of the
+ *   current engine as JSON, most expensive first. See
+ *   ib_rule_stats_foreach().
+ * - rule_stats_reset - zero the per-rule statistics of the current engine.
+ * - log_queue_stats - log record queue depth, high water mark and dropped
+ *   records of the current engine as JSON. See ib_logger_queue_stats().
  *
  * @param[in] channel The channel to register this command with.
  *
@@ -0,0 +1,134 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef __IRONBEE__KVSTORE_CACHE_H
+#define __IRONBEE__KVSTORE_CACHE_H
+
+#include <ironbee/clock.h>
+#include <ironbee/kvstore.h>
+#include <ironbee/types.h>
+
+#include <stdint.h>
+
+/**
+ * @file
+ * @brief IronBee --- Key-Value Store In-Memory Cache
+ */
+
+/**
+ * @addtogroup IronBeeKeyValueStore
+ * @ingroup IronBeeUtil
+ * @{
+ */
+
+/** Default interval, in usec, of the periodic write-behind flush. */
+#define IB_KVSTORE_CACHE_FLUSH_INTERVAL 1000000
+
+/**
+ * How a cache writes values to its backend.
+ */
+typedef enum {
+    /** Sets are written to the backend before they are cached. */
+    IB_KVSTORE_CACHE_WRITE_THROUGH,
+    /**
+     * Sets are only cached.  They are written to the backend when evicted,
+     * periodically (see ib_kvstore_cache_flush_interval_set()), by
+     * ib_kvstore_cache_flush() and when the cache is disconnected or
+     * destroyed.
+     */
+    IB_KVSTORE_CACHE_WRITE_BEHIND
+} ib_kvstore_cache_mode_t;
+
+/**
+ * Initializes a kvstore that caches the values of @a backend in memory.
+ *
+ * The cache is a set of shards, each a hash table with its own lock and
+ * least recently used list, keyed by the key bytes.  Expired values are
+ * never returned.  Values loaded from @a backend are reloaded after
+ * @a max_age, so that writes by other processes are seen eventually.
+ *
+ * The cache takes ownership of @a backend: connecting, disconnecting and
+ * destroying the cache does the same to @a backend.  @a backend must
+ * report absolute expiration times from its get function, as the
+ * filesystem and log stores do.
+ *
+ * @param[out] kvstore Initialized as the cache.
+ * @param[in] backend Initialized key-value store to cache.
+ * @param[in] max_bytes Maximum size of cached keys and values.
+ * @param[in] max_age Maximum age, in usec, of values loaded from
+ *            @a backend.  0 means values are kept until they expire or
+ *            are evicted.
+ * @param[in] mode Write mode.
+ * @returns
+ *   - IB_OK on success
+ *   - IB_EALLOC on memory allocation failure using malloc.
+ *   - IB_EOTHER if a lock can not be created.
+ */
+ib_status_t ib_kvstore_cache_init(
+    ib_kvstore_t            *kvstore,
+    ib_kvstore_t            *backend,
+    size_t                   max_bytes,
+    ib_time_t                max_age,
+    ib_kvstore_cache_mode_t  mode);
+
+/**
+ * Write all values that were set but not written to the backend.
+ *
+ * This does nothing for @ref IB_KVSTORE_CACHE_WRITE_THROUGH caches.
+ *
+ * @param[in] kvstore Cache created by ib_kvstore_cache_init().
+ * @returns
+ *   - IB_OK on success.
+ *   - The first error of the backend otherwise.  Values that failed to be
+ *     written remain pending.
+ */
+ib_status_t ib_kvstore_cache_flush(ib_kvstore_t *kvstore);
+
+/**
+ * Set how often values set in a @ref IB_KVSTORE_CACHE_WRITE_BEHIND cache
+ * are written to the backend.
+ *
+ * The flush is done by gets and sets: each shard of the cache writes its
+ * pending values when it is used and its last flush is older than
+ * @a interval.  Values that fail to be written remain pending.  The
+ * default is @ref IB_KVSTORE_CACHE_FLUSH_INTERVAL.  The interval is
+ * counted from this call.  Call this before the cache is shared between
+ * threads.
+ *
+ * @param[in] kvstore Cache created by ib_kvstore_cache_init().
+ * @param[in] interval Interval in usec.  0 disables the periodic flush.
+ */
+void ib_kvstore_cache_flush_interval_set(
+    ib_kvstore_t *kvstore,
+    ib_time_t     interval);
+
+/**
+ * Report how many gets were answered by the cache.
+ *
+ * @param[in] kvstore Cache created by ib_kvstore_cache_init().
+ * @param[out] hits Gets answered from memory.  May be NULL.
+ * @param[out] misses Gets passed to the backend.  May be NULL.
+ */
+void ib_kvstore_cache_stats(
+    ib_kvstore_t *kvstore,
+    uint64_t     *hits,
+    uint64_t     *misses);
+
+/**
+ * @}
+ */
+#endif /* __IRONBEE__KVSTORE_CACHE_H */
@@ -0,0 +1,89 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+#ifndef __IRONBEE__KVSTORE_LOG_H
+#define __IRONBEE__KVSTORE_LOG_H
+
+#include <ironbee/kvstore.h>
+#include <ironbee/types.h>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+/**
+ * @file
+ * @brief IronBee --- Key-Value Log-Structured Store Interface
+ */
+
+/**
+ * @addtogroup IronBeeKeyValueStore
+ * @ingroup IronBeeUtil
+ * @{
+ */
+
+/**
+ * Initializes kvstore that appends to a log in a directory.
+ *
+ * Every set or remove appends a record to `kvstore.log` in @a directory.
+ * The latest record of each key is found through a hash table in
+ * `kvstore.idx`, which is memory mapped and shared by all processes using
+ * @a directory.  Writers, in any process, are serialized with a file lock
+ * on the index; readers do not take the file lock.
+ *
+ * The log is compacted, dropping replaced, removed and expired records,
+ * when at least half of it is dead, and at most once a minute when it
+ * holds expired records.  See also ib_kvstore_log_compact().
+ *
+ * The files are opened by ib_kvstore_connect().
+ *
+ * @param[out] kvstore Initialized with kvserver and some defaults.
+ * @param[in] directory The directory we will store this data in.
+ * @returns
+ *   - IB_OK on success
+ *   - IB_EALLOC on memory allocation failure using malloc.
+ *   - IB_EOTHER if a lock can not be created.
+ */
+ib_status_t ib_kvstore_log_init(
+    ib_kvstore_t *kvstore,
+    const char *directory);
+
+/**
+ * Set the file mode which log and index files are created with.
+ * @param[in] kvstore Key-Value store.
+ * @param[in] mode The mode.
+ */
+void ib_kvstore_log_set_file_mode(ib_kvstore_t *kvstore, mode_t mode);
+
+/**
+ * Compact the log now.
+ *
+ * Live, unexpired records are copied to a new log, which replaces the old
+ * one.  Other processes notice the replacement on their next access.
+ *
+ * @param[in] kvstore Connected key-value store.
+ * @returns
+ *   - IB_OK on success.
+ *   - IB_EINVAL if @a kvstore is not connected.
+ *   - IB_EALLOC on allocation failure.
+ *   - IB_EOTHER on system call failure.
+ */
+ib_status_t ib_kvstore_log_compact(ib_kvstore_t *kvstore);
+
+/**
+ * @}
+ */
+#endif /* __IRONBEE__KVSTORE_LOG_H */
@@ -65,6 +65,7 @@ struct ib_list_node_t {
 struct ib_list_t {
     ib_mm_t mm;
     IB_LIST_GEN_REQ_FIELDS(ib_list_node_t);       /* Required fields */
+    size_t generation;                            /**< See ib_list_generation() */
 };
 /** @endcond */
 
@@ -167,6 +168,20 @@ void DLL_PUBLIC ib_list_clear(ib_list_t *list);
  */
 size_t DLL_PUBLIC ib_list_elements(const ib_list_t *list);
 
+/**
+ * Return the generation of the list.
+ *
+ * The generation changes whenever a node is added to or removed from the
+ * list, so a caller that remembers it can tell if a list it has
+ * already looked at has changed.  Replacing the data of a node with
+ * ib_list_node_data_set() does not change the generation.
+ *
+ * @param list List
+ *
+ * @returns Generation of the list.
+ */
+size_t DLL_PUBLIC ib_list_generation(const ib_list_t *list);
+
 /**
  * Return first node in the list or NULL if there are no elements.
  *
@@ -268,6 +283,8 @@ const void DLL_PUBLIC *ib_list_node_data_const(const ib_list_node_t *node);
 /**
  * Set @a node 's data value.
  *
+ * This does not change the generation of the node's list.
+ *
  * @param[in] node The node whose data element to set.
  * @param[in] data The data pointer to set.
  */
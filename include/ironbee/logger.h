@@ -455,6 +455,8 @@ NONNULL_ATTRIBUTE(1);
  *
  * @returns
  * - IB_OK success.
+ * - IB_EALLOC On memory allocation error, including a record queue too
+ *   large to allocate (see ib_logger_queue_set()).
  */
 ib_status_t ib_logger_writer_add(
     ib_logger_t           *logger,
@@ -564,6 +566,89 @@ ib_status_t DLL_PUBLIC ib_logger_dequeue(
     void                  *cbdata
 );
 
+/**
+ * What a writer does with a new record when its queue is full.
+ */
+typedef enum {
+    IB_LOGGER_OVERFLOW_DROP_NEWEST, /**< Discard the new record. */
+    IB_LOGGER_OVERFLOW_DROP_OLDEST, /**< Discard the oldest queued record. */
+    IB_LOGGER_OVERFLOW_BLOCK        /**< Wait (bounded), then drop newest. */
+} ib_logger_overflow_t;
+
+/**
+ * Default capacity of a writer's record queue.
+ */
+#define IB_LOGGER_QUEUE_CAPACITY_DEFAULT 1024
+
+/**
+ * Default maximum wait, in microseconds, for @ref IB_LOGGER_OVERFLOW_BLOCK.
+ */
+#define IB_LOGGER_QUEUE_WAIT_DEFAULT 100000
+
+/**
+ * Record queue statistics.
+ */
+struct ib_logger_queue_stats_t {
+    size_t depth;      /**< Records currently queued. */
+    size_t high_water; /**< Most records ever queued at once. */
+    size_t dropped;    /**< Records discarded because a queue was full. */
+};
+typedef struct ib_logger_queue_stats_t ib_logger_queue_stats_t;
+
+/**
+ * Configure the record queues of @a logger's writers.
+ *
+ * Each writer has a bounded, lock-free record queue. Formatting threads
+ * never take a lock to enqueue a record. If a queue is full, @a overflow
+ * determines what happens to the record.
+ *
+ * @param[in] logger The logger.
+ * @param[in] capacity Queue capacity. Rounded up to a power of two.
+ *            This only applies to writers added after this call.
+ * @param[in] overflow Overflow policy. Applies to all writers.
+ * @param[in] max_wait Maximum time, in microseconds, a formatting thread
+ *            waits for queue space with @ref IB_LOGGER_OVERFLOW_BLOCK.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EINVAL If @a capacity is 0 or rounds up to a queue whose size in
+ *   bytes does not fit in a size_t.
+ */
+ib_status_t DLL_PUBLIC ib_logger_queue_set(
+    ib_logger_t          *logger,
+    size_t                capacity,
+    ib_logger_overflow_t  overflow,
+    ib_time_t             max_wait
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Get the record queue statistics of a single writer.
+ *
+ * @param[in] writer The logger writer.
+ * @param[out] stats Statistics.
+ */
+void DLL_PUBLIC ib_logger_writer_queue_stats(
+    const ib_logger_writer_t *writer,
+    ib_logger_queue_stats_t  *stats
+)
+NONNULL_ATTRIBUTE(1, 2);
+
+/**
+ * Get the record queue statistics of all writers of @a logger.
+ *
+ * Depth and dropped counts are summed. The high-water mark is the
+ * maximum of all writers.
+ *
+ * @param[in] logger The logger.
+ * @param[out] stats Statistics.
+ */
+void DLL_PUBLIC ib_logger_queue_stats(
+    const ib_logger_t       *logger,
+    ib_logger_queue_stats_t *stats
+)
+NONNULL_ATTRIBUTE(1, 2);
+
 /**
  * A standard logger log message format.
  *
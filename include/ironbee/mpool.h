@@ -176,6 +176,32 @@ ib_status_t DLL_PUBLIC ib_mpool_create_ex(
 )
 NONNULL_ATTRIBUTE(1);
 
+/**
+ * Create a new arena memory pool.
+ *
+ * Arena pools are meant for short lived, frequently created pools such as
+ * those of transactions.  An arena pool has no parent, so creating and
+ * destroying it never locks another pool.  Destroying or releasing it
+ * clears it and returns it and its pages to a cache of the calling thread,
+ * from which later arena pools and their pages are taken.  The caches are
+ * bounded and are freed when their thread exits.
+ *
+ * Arena pools use the default page size, malloc() and free().  Child pools
+ * of an arena pool are ordinary pools.
+ *
+ * @param[out] pmp  Address which new pool is written
+ * @param[in]  name Logical name of the pool (used in reports), can be NULL.
+ *
+ * @returns
+ * - IB_OK     -- Success.
+ * - IB_EALLOC -- Allocation error.
+ */
+ib_status_t DLL_PUBLIC ib_mpool_create_arena(
+    ib_mpool_t **pmp,
+    const char  *name
+)
+NONNULL_ATTRIBUTE(1);
+
 /**
  * Set the name of a memory pool.
  *
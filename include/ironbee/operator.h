@@ -132,6 +132,8 @@ NONNULL_ATTRIBUTE(1, 2, 4);
 #define IB_OP_CAPABILITY_ALLOW_NULL  (1 << 0)
 /*! Supports capture */
 #define IB_OP_CAPABILITY_CAPTURE     (1 << 3)
+/*! Create function may run on a configuration worker thread */
+#define IB_OP_CAPABILITY_THREAD_SAFE_CREATE (1 << 4)
 
 /**
  * Create an operator.
@@ -367,6 +369,40 @@ ib_status_t DLL_PUBLIC ib_operator_inst_create(
 )
 NONNULL_ATTRIBUTE(1, 3, 4);
 
+/**
+ * Create an operator instance, possibly deferring its create function.
+ *
+ * If @a op has @ref IB_OP_CAPABILITY_THREAD_SAFE_CREATE, the create
+ * function is queued with ib_engine_config_job_add() and runs on a
+ * configuration worker before the next context closes.  Until then, the
+ * instance has no instance data and must not be executed.  The create
+ * function receives its own memory manager, which is released with @a mm.
+ *
+ * Other operators are created immediately, as by ib_operator_inst_create().
+ *
+ * @param[out] op_inst               The operator instance.
+ * @param[in]  mm                    Memory manager.
+ * @param[in]  ctx                   Current IronBee context
+ * @param[in]  op                    Operator to create instance of.
+ * @param[in]  required_capabilities Required operator capabilities.
+ * @param[in]  parameters            Parameters used to create the instance.
+ *
+ * @return
+ * - IB_OK on success,
+ * - IB_EALLOC on allocation failure.
+ * - IB_EINVAL if the required capabilities do not match.
+ * - Other if create callback fails when run immediately.
+ */
+ib_status_t DLL_PUBLIC ib_operator_inst_create_deferred(
+    ib_operator_inst_t  **op_inst,
+    ib_mm_t               mm,
+    ib_context_t         *ctx,
+    const ib_operator_t  *op,
+    ib_flags_t            required_capabilities,
+    const char           *parameters
+)
+NONNULL_ATTRIBUTE(1, 3, 4);
+
 /**
  * Get the operator of an operator instance.
  *
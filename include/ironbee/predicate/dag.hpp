@@ -365,6 +365,21 @@ public:
         EvalContext     context
     ) const = 0;
 
+    /**
+     * First phase in which eval_calculate() may change the value.
+     *
+     * This only describes changes the node makes on its own, i.e., not
+     * because a child changed.  It is used by calculate_initial_phases() so
+     * that GraphEvalState can skip nodes that can not have changed.
+     *
+     * The default, IB_PHASE_NONE, means any phase and is always safe.  Nodes
+     * whose value depends only on the values of their children should
+     * return IB_RULE_PHASE_COUNT.
+     *
+     * @return First phase the value of this node may change in.
+     **/
+    virtual ib_rule_phase_num_t eval_initial_phase() const;
+
     ///@}
 
 private:
@@ -496,6 +511,9 @@ public:
         EvalContext     context
     ) const;
 
+    //! Literals never change: IB_RULE_PHASE_COUNT.
+    virtual ib_rule_phase_num_t eval_initial_phase() const;
+
     //! S-Expression.
     // Intentionally inline.
     virtual const std::string& to_s() const
@@ -29,15 +29,197 @@
 
 #include <ironbee/predicate/dag.hpp>
 
+#include <boost/aligned_storage.hpp>
 #include <boost/function_output_iterator.hpp>
-#include <boost/dynamic_bitset.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/static_assert.hpp>
+#include <boost/type_traits/alignment_of.hpp>
 
+#include <new>
 #include <stack>
+#include <typeinfo>
 #include <vector>
 
 namespace IronBee {
 namespace Predicate {
 
+/**
+ * Node specific state.
+ *
+ * Holds a single value of any copyable type of at most @ref c_capacity
+ * bytes.  Unlike boost::any, the value is stored in place, so storing it
+ * never allocates memory.  Larger state should be allocated from the
+ * transaction memory manager and stored by pointer.
+ **/
+class NodeStateSlot
+{
+public:
+    //! Largest size of a stored type.
+    static const size_t c_capacity = 4 * sizeof(void*);
+
+private:
+    /**
+     * Most strictly aligned of the types state is usually made of.
+     *
+     * Memory managers only guarantee this alignment, so the storage must
+     * not ask for more.
+     **/
+    union align_t
+    {
+        void*   p;
+        void    (*f)();
+        int64_t i;
+        double  d;
+    };
+
+    //! Storage type.
+    typedef boost::aligned_storage<
+        c_capacity,
+        boost::alignment_of<align_t>::value
+    > storage_t;
+
+public:
+
+    //! Constructor.  Slot is empty.
+    NodeStateSlot();
+
+    //! Copy constructor.
+    NodeStateSlot(const NodeStateSlot& other);
+
+    //! Destructor.  Destroys stored value.
+    ~NodeStateSlot();
+
+    //! Copy assignment.
+    NodeStateSlot& operator=(const NodeStateSlot& other);
+
+    /**
+     * Store a value.
+     *
+     * Replaces any stored value.
+     *
+     * @tparam T Type of value.  Must be copyable and fit in @ref c_capacity.
+     * @param[in] value Value to store.
+     * @return *this
+     **/
+    template <typename T>
+    NodeStateSlot& operator=(const T& value);
+
+    /**
+     * Access the stored value.
+     *
+     * @tparam T Type the value was stored as.
+     * @return Stored value.
+     * @throw einval if the slot is empty or holds a different type.
+     **/
+    template <typename T>
+    T& as();
+
+    //! True iff no value is stored.
+    bool empty() const
+    {
+        return m_ops == NULL;
+    }
+
+    //! Destroy stored value, if any.
+    void clear();
+
+private:
+    //! Type specific operations.
+    struct ops_t
+    {
+        //! Type of value.
+        const std::type_info& (*type)();
+        //! Copy construct value at @a to from @a from.
+        void (*copy)(void* to, const void* from);
+        //! Destroy value at @a at.
+        void (*destroy)(void* at);
+    };
+
+    //! Operations for @a T.
+    template <typename T>
+    struct ops_for
+    {
+        static const std::type_info& type()
+        {
+            return typeid(T);
+        }
+        static void copy(void* to, const void* from)
+        {
+            new (to) T(*static_cast<const T*>(from));
+        }
+        static void destroy(void* at)
+        {
+            static_cast<T*>(at)->~T();
+        }
+
+        static const ops_t c_ops;
+    };
+
+    //! Throw einval for an access as the wrong type.
+    static void throw_bad_type(const std::type_info& requested);
+
+    //! Address of storage.
+    void* address()
+    {
+        return m_storage.address();
+    }
+    //! Address of storage.
+    const void* address() const
+    {
+        return m_storage.address();
+    }
+
+    //! Operations of stored value or NULL if empty.
+    const ops_t* m_ops;
+    //! Storage.
+    storage_t m_storage;
+};
+
+/// @cond Internal
+template <typename T>
+const NodeStateSlot::ops_t NodeStateSlot::ops_for<T>::c_ops = {
+    &NodeStateSlot::ops_for<T>::type,
+    &NodeStateSlot::ops_for<T>::copy,
+    &NodeStateSlot::ops_for<T>::destroy
+};
+/// @endcond
+
+template <typename T>
+NodeStateSlot& NodeStateSlot::operator=(const T& value)
+{
+    BOOST_STATIC_ASSERT(sizeof(T) <= c_capacity);
+    BOOST_STATIC_ASSERT(
+        boost::alignment_of<T>::value <= boost::alignment_of<align_t>::value
+    );
+
+    if (m_ops == &ops_for<T>::c_ops) {
+        *static_cast<T*>(address()) = value;
+    }
+    else {
+        clear();
+        new (address()) T(value);
+        m_ops = &ops_for<T>::c_ops;
+    }
+
+    return *this;
+}
+
+template <typename T>
+T& NodeStateSlot::as()
+{
+    // Types from different shared objects may have different operations,
+    // so fall back to comparing the type info.
+    if (
+        m_ops != &ops_for<T>::c_ops &&
+        (m_ops == NULL || m_ops->type() != typeid(T))
+    ) {
+        throw_bad_type(typeid(T));
+    }
+
+    return *static_cast<T*>(address());
+}
+
 /**
  * Evaluation state for a single node.
  *
@@ -256,13 +438,13 @@ public:
      * @name Node State
      * Methods to access node state.  The subclass of a Call may need to
      * maintain state during an evaluation.  That state is stored in this
-     * class and may be accessed via a boost::any.  It is good practice to
+     * class and may be accessed via a NodeStateSlot.  It is good practice to
      * setup state in Node::eval_initialize().
      **/
     ///@{
 
     //! Access state.
-    boost::any& state()
+    NodeStateSlot& state()
     {
         return m_state;
     }
@@ -279,7 +461,7 @@ private:
     //! Mutable local list value.
     List<Value> m_local_values;
     //! Node specific state.
-    boost::any m_state;
+    NodeStateSlot m_state;
     //! Last phase evaluated at.
     ib_rule_phase_num_t m_phase;
 };
@@ -346,9 +528,12 @@ struct GraphEvalProfileData {
 /**
  * Evaluation state of an entire graph.
  *
- * This class maintains the state of an entire graph via a vector of
- * NodeEvalState indexed by node index (see Node::index()).  It provides a
- * evaluation oriented API to access and manipulate this state.
+ * This class maintains the state of an entire graph via flat arrays of
+ * NodeEvalState and initialization flags indexed by node index (see
+ * Node::index()).  The arrays are allocated from a memory manager,
+ * usually that of the transaction, so that setting up the state of a
+ * transaction allocates nothing from the heap.  It provides a evaluation
+ * oriented API to access and manipulate this state.
  *
  * The evaluation life cycle is:
  * 1. Constrict a GraphEvalState.
@@ -359,18 +544,37 @@ struct GraphEvalProfileData {
  * 3. Use values() and is_finished() as necessary.  Both of these are only
  *    updated by eval(), so it is generally advisable to call eval() at each
  *    phase before any calls to values() or is_finished().
+ *
+ * If given the initial phases of the graph via set_initial_phases(), eval()
+ * will not recalculate nodes that can not have changed since they were last
+ * calculated.
  **/
-class GraphEvalState
+class GraphEvalState :
+    boost::noncopyable
 {
 public:
     /**
      * Constructor.
      *
-     * @param[in] A reference to all nodes by index.
+     * Allocates the state from a memory pool owned by this object.
+     *
      * @param[in] index_limit All indices of nodes must be below this.
      **/
+    explicit
     GraphEvalState(size_t index_limit);
 
+    /**
+     * Constructor.
+     *
+     * @param[in] index_limit All indices of nodes must be below this.
+     * @param[in] mm          Memory manager to allocate state from.  Must
+     *                        outlive this object.
+     **/
+    GraphEvalState(size_t index_limit, MemoryManager mm);
+
+    //! Destructor.  Destroys the state of every node.
+    ~GraphEvalState();
+
     /**
      * @name Direct accessors.
      * Routines to directly access eval state.
@@ -398,7 +602,7 @@ public:
             initialize(node, context);
         }
 
-        return m_vector[node->index()];
+        return m_nodes[node->index()];
     }
 
     /**
@@ -408,7 +612,7 @@ public:
      */
     NodeEvalState& node_eval_state(size_t idx)
     {
-        return m_vector[idx];
+        return m_nodes[idx];
     }
 
     ///@}
@@ -508,11 +712,39 @@ public:
      *       handed back to the user or return void and insist the user
      *       find the NodeEvalState.
      *
+     * If initial phases are set, see set_initial_phases(), a node that has
+     * been calculated before is not calculated again until a phase at or
+     * after its initial phase is evaluated.  Until then, nothing below it
+     * can have changed.
+     *
      * @param[in] node    Node to evaluate.
      * @param[in] context Evaluation context.
      **/
     void eval(const Node* node, EvalContext context);
 
+    /**
+     * Set initial phases of nodes.
+     *
+     * @sa calculate_initial_phases()
+     *
+     * @param[in] initial_phases Initial phase of each node, indexed by node
+     *                           index, or NULL to calculate nodes at every
+     *                           phase.  Must outlive this object.
+     **/
+    void set_initial_phases(const ib_rule_phase_num_t* initial_phases);
+
+    /**
+     * Number of node calculations skipped.
+     *
+     * Incremented each time eval() does not calculate a node because it can
+     * not have changed since its last calculation.
+     **/
+    size_t num_skipped() const
+    {
+        // Intentionally inline.
+        return m_num_skipped;
+    }
+
     /**
      * @name Profiling
      * Methods to access and control graph profiling information.
@@ -553,12 +785,29 @@ public:
     ///@}
 
 private:
-    typedef std::vector<NodeEvalState> vector_t;
+    //! Allocate and construct state for @a m_size nodes from @a mm.
+    void allocate(MemoryManager mm);
 
-    vector_t m_vector;
+    //! Pool for state if no memory manager was given.
+    boost::scoped_ptr<ScopedMemoryPoolLite> m_pool;
 
-    //! Has a node in m_vector and m_graph been initialized.
-    boost::dynamic_bitset<> m_initialized;
+    //! Number of nodes.
+    size_t m_size;
+
+    //! Evaluation state of each node.
+    NodeEvalState* m_nodes;
+
+    //! Has each node been initialized.
+    bool* m_initialized;
+
+    //! Initial phase of each node or NULL.
+    const ib_rule_phase_num_t* m_initial_phases;
+
+    //! Latest phase eval() has been called in.
+    ib_rule_phase_num_t m_latest_phase;
+
+    //! Number of node calculations eval() skipped.
+    size_t m_num_skipped;
 
     //! If true, eval() profiles node evaluation.
     bool m_profile;
@@ -721,6 +970,37 @@ make_indexer(size_t& index_limit, LIST& traversal)
 boost::function_output_iterator<Impl::make_initializer_helper_t>
 make_initializer(GraphEvalState& graph_eval_state, EvalContext context);
 
+/**
+ * Calculate the initial phase of every node of a graph.
+ *
+ * The initial phase of a node is the earliest Node::eval_initial_phase() of
+ * it and all its descendants, i.e., the first phase in which its value may
+ * change.  Nodes with an initial phase of IB_RULE_PHASE_COUNT never change
+ * once calculated.
+ *
+ * Example:
+ * @code
+ * vector<const Node*> traversal;
+ * vector<ib_rule_phase_num_t> initial_phases;
+ * bfs_down(
+ *    graph.roots().first, graph.roots().second,
+ *    make_indexer(index_limit, traversal)
+ * );
+ * calculate_initial_phases(traversal, initial_phases);
+ * graph_eval_state.set_initial_phases(&initial_phases[0]);
+ * @endcode
+ *
+ * Must be called after pre-evaluation.
+ *
+ * @param[in]  traversal      Every node of the graph, indexed.
+ * @param[out] initial_phases Initial phase of each node, indexed by node
+ *                            index.
+ **/
+void calculate_initial_phases(
+    const std::vector<const Node*>&   traversal,
+    std::vector<ib_rule_phase_num_t>& initial_phases
+);
+
 } // Predicate
 } // IronBee
 
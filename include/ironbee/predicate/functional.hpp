@@ -216,6 +216,16 @@ public:
         EvalContext     context
     ) const;
 
+    /**
+     * First phase value may change in.
+     *
+     * See Node::eval_initial_phase().
+     *
+     * Calls Base::eval_initial_phase().
+     **/
+    virtual
+    ib_rule_phase_num_t eval_initial_phase() const;
+
 private:
     //! Pointer to Base delegate.
     base_p m_base;
@@ -313,6 +323,15 @@ public:
         EvalContext     context
     ) const = 0;
 
+    /**
+     * First phase in which eval() may change the value on its own.
+     *
+     * See Node::eval_initial_phase().  By default, returns IB_PHASE_NONE,
+     * i.e., any phase.
+     **/
+    virtual
+    ib_rule_phase_num_t eval_initial_phase() const;
+
     /**
      * Transform.
      *
@@ -405,6 +424,10 @@ public:
         EvalContext     context
     ) const;
 
+    //! Depends only on arguments: IB_RULE_PHASE_COUNT.
+    virtual
+    ib_rule_phase_num_t eval_initial_phase() const;
+
 protected:
     //! Constructor.  See Base::Base().
     Simple(
@@ -479,6 +502,10 @@ public:
         EvalContext     context
     ) const;
 
+    //! Depends only on arguments: IB_RULE_PHASE_COUNT.
+    virtual
+    ib_rule_phase_num_t eval_initial_phase() const;
+
 protected:
     /**
      * Constructor.
@@ -26,6 +26,7 @@
  */
 
 #include <ironbee/build.h>
+#include <ironbee/clock.h>
 #include <ironbee/queue.h>
 #include <ironbee/types.h>
 
@@ -38,6 +39,14 @@ extern "C" {
 /**
  * @defgroup IronBeeUtilResourcePool Resource Pool
  * @ingroup IronBeeUtil
+ *
+ * A pool of reusable resources.
+ *
+ * A resource pool may be used from multiple threads.  Acquiring an idle
+ * resource and releasing a resource do not take a lock.  Calls to the
+ * create and destroy callbacks are serialized by the pool, but the preuse
+ * and postuse callbacks may run concurrently for different resources.
+ *
  * @{
  */
 
@@ -171,6 +180,29 @@ ib_status_t DLL_PUBLIC ib_resource_acquire(
     ib_resource_t **resource
 );
 
+/**
+ * Acquire a resource, waiting up to @a timeout for one if the pool is full.
+ *
+ * This is ib_resource_acquire() but, if there is no idle resource and the
+ * pool is at its maximum size, the caller blocks until another thread
+ * releases or destroys a resource.
+ *
+ * @param[in] resource_pool The resource pool.
+ * @param[out] resource The resource to get.
+ * @param[in] timeout The longest time to wait, in microseconds. If 0, do
+ *            not wait.
+ *
+ * @returns
+ * - IB_OK If a resource is acquired.
+ * - IB_DECLINED If no resource became available within @a timeout.
+ * - Other on unexpected errors.
+ */
+ib_status_t DLL_PUBLIC ib_resource_acquire_timed(
+    ib_resource_pool_t  *resource_pool,
+    ib_resource_t      **resource,
+    ib_time_t            timeout
+);
+
 /**
  * Return the given resource to its resource pool.
  *
@@ -188,6 +220,8 @@ ib_status_t DLL_PUBLIC ib_resource_release(
 /**
  * Destroy all elements in the pool and re-fill it to the minimum value.
  *
+ * Resources currently acquired are not affected.
+ *
  * @param[in] resource_pool The resource pool
  *
  * @returns
@@ -252,6 +286,52 @@ ib_status_t DLL_PUBLIC ib_resource_pool_set_max(
 )
 NONNULL_ATTRIBUTE(1);
 
+/**
+ * Destroy resources that sit idle for longer than @a timeout.
+ *
+ * Idle resources are checked at most once per @a timeout, as resources are
+ * released or when ib_resource_pool_reap() is called.  The pool is never
+ * reaped below its minimum size.  As many resources are destroyed as have
+ * been idle too long; the ones destroyed are those most recently released.
+ *
+ * @param[in] pool The pool.
+ * @param[in] timeout Idle time in microseconds. If 0, idle resources are
+ *            never destroyed. This is the default.
+ */
+void DLL_PUBLIC ib_resource_pool_set_idle_timeout(
+    ib_resource_pool_t *pool,
+    ib_time_t           timeout
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Destroy resources idle for longer than the pool's idle timeout now.
+ *
+ * @sa ib_resource_pool_set_idle_timeout()
+ *
+ * @param[in] pool The pool.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - Other on locking failures.
+ */
+ib_status_t DLL_PUBLIC ib_resource_pool_reap(
+    ib_resource_pool_t *pool
+)
+NONNULL_ATTRIBUTE(1);
+
+/**
+ * Get the number of resources currently created, idle or in use.
+ *
+ * @param[in] pool The pool.
+ *
+ * @returns The number of resources.
+ */
+size_t DLL_PUBLIC ib_resource_pool_count(
+    const ib_resource_pool_t *pool
+)
+NONNULL_ATTRIBUTE(1);
+
 /** @} IronBeeUtilResourcePool */
 
 #ifdef __cplusplus
@@ -76,6 +76,11 @@ typedef struct ib_rule_phase_meta_t ib_rule_phase_meta_t;
  */
 typedef struct ib_rule_operator_inst_t ib_rule_operator_inst_t;
 
+/**
+ * Membership of a rule in an equality fold group (rule engine internal).
+ */
+typedef struct ib_rule_fold_t ib_rule_fold_t;
+
 /**
  * Basic rule object.
  */
@@ -93,6 +98,7 @@ struct ib_rule_t {
     ib_rule_t             *chained_from;    /**< Ptr to rule chained from */
     const char            *capture_collection; /**< Capture collection name */
     ib_flags_t             flags;           /**< External, etc. */
+    const ib_rule_fold_t  *fold;            /**< Equality fold; or NULL */
 };
 
 /**
@@ -164,6 +170,17 @@ struct ib_rule_exec_t {
      */
     ib_list_t              *value_stack;
 
+    /**
+     * Cache of transformation results, keyed on the untransformed value
+     * and the target's transformation chain fingerprint.
+     */
+    ib_hash_t              *tfn_cache;
+
+    /**
+     * Per equality fold group: the last value looked up and its result.
+     */
+    struct ib_rule_fold_cache_t *fold_cache;
+
 #ifdef IB_RULE_TRACE
     ib_rule_trace_t        *traces; /**< Rule trace information. */
 #endif
@@ -1337,6 +1354,70 @@ bool DLL_PUBLIC ib_rule_is_chained(const ib_rule_t *rule) NONNULL_ATTRIBUTE(1);
  */
 bool DLL_PUBLIC ib_rule_is_marked(const ib_rule_t *rule) NONNULL_ATTRIBUTE(1);
 
+/**
+ * Execution statistics of a single rule.
+ *
+ * Statistics are always collected.  Each thread accumulates into its own
+ * counters, so collection takes no locks; readers sum over all threads.
+ * Times are monotonic clock nanoseconds.
+ */
+typedef struct ib_rule_stats_t {
+    uint64_t executions;    /**< Times the rule was executed. */
+    uint64_t matches;       /**< Executions with a true rule result. */
+    uint64_t operator_time; /**< Time spent in the operator. */
+    uint64_t tfn_time;      /**< Time spent in target transformations. */
+    uint64_t action_time;   /**< Time spent in actions. */
+} ib_rule_stats_t;
+
+/**
+ * Rule statistics callback.
+ *
+ * @param[in] rule The rule.
+ * @param[in] stats Statistics of @a rule summed over all threads.
+ * @param[in] cbdata Callback data.
+ *
+ * @returns
+ * - IB_OK to continue iteration.
+ * - Any other value aborts iteration and is returned by
+ *   ib_rule_stats_foreach().
+ */
+typedef ib_status_t (*ib_rule_stats_fn_t)(
+    const ib_rule_t       *rule,
+    const ib_rule_stats_t *stats,
+    void                  *cbdata
+);
+
+/**
+ * Call @a fn for every rule of @a ib that has been executed.
+ *
+ * Counters are read without synchronizing with executing threads, so the
+ * statistics are not a consistent snapshot of any single instant.
+ *
+ * @param[in] ib IronBee engine.
+ * @param[in] fn Function to call.
+ * @param[in] cbdata Callback data for @a fn.
+ *
+ * @returns
+ * - IB_OK on success.
+ * - Any non-IB_OK value returned by @a fn.
+ */
+ib_status_t DLL_PUBLIC ib_rule_stats_foreach(
+    const ib_engine_t  *ib,
+    ib_rule_stats_fn_t  fn,
+    void               *cbdata
+) NONNULL_ATTRIBUTE(1, 2);
+
+/**
+ * Zero the statistics of all rules of @a ib.
+ *
+ * Executions in progress on other threads may survive the reset.
+ *
+ * @param[in] ib IronBee engine.
+ */
+void DLL_PUBLIC ib_rule_stats_reset(
+    const ib_engine_t *ib
+) NONNULL_ATTRIBUTE(1);
+
 /**
  * Log a fatal rule execution error
  *
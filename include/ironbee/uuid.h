@@ -63,6 +63,10 @@ ib_status_t DLL_PUBLIC ib_uuid_shutdown(void);
 /**
  * Creates a new, random, v4 uuid (static buffer version).
  *
+ * Each thread has its own generator, seeded from the kernel random source
+ * on first use and again after a fork, so this takes no locks.  If a
+ * generator can not be seeded, OSSP UUID is used under a global lock.
+ *
  * @param[in] uuid Where to write UUID.  Must be IB_UUID_LENGTH long.
  *
  * @returns
@@ -719,9 +719,18 @@ NONNULL_ATTRIBUTE(1, 2, 3);
  *
  * The lifetime of @a result will depend on the value.  For non-filtered
  * list fields, the underlying value will be reported directly and @a result
- * will have lifetime equal to that field.  For all other results, the
+ * will have lifetime equal to that field.  Filtered non-dynamic list fields
+ * are looked up in a case-insensitive name index of the field that is kept
+ * in @a store; @a result is shared with other lookups, must not be
+ * modified, and has lifetime equal to @a store.  For all other results, the
  * lifetime will equal that of @a mp.
  *
+ * @warning @a result may be the field's own list or a list shared by every
+ * lookup of the same filter.  Callers must never modify it; copy it with
+ * ib_list_copy() first if it needs to change.  An indexed result describes
+ * the field as it was at lookup time; only later lookups see later changes
+ * to the field.
+ *
  * @param[in]  target Target to get values of.
  * @param[out] result Fetched values.  Lifetime will vary.  See above.
  *                    Value is `ib_field_t *`.
@@ -953,6 +962,24 @@ ib_status_t DLL_PUBLIC ib_var_expand_execute(
 )
 NONNULL_ATTRIBUTE(1, 2, 3, 5);
 
+/**
+ * Get the string of an expansion that refers to no targets.
+ *
+ * @param[in]  expand     String expansion.
+ * @param[out] dst        Constant string.  Lifetime equals @a expand.  May
+ *                        be NULL if @a dst_length is 0.
+ * @param[out] dst_length Length of @a dst.
+ * @return
+ * - IB_OK on success.
+ * - IB_EINVAL if @a expand refers to targets.
+ **/
+ib_status_t DLL_PUBLIC ib_var_expand_constant(
+    const ib_var_expand_t  *expand,
+    const char            **dst,
+    size_t                 *dst_length
+)
+NONNULL_ATTRIBUTE(1, 2, 3);
+
 /**
  * Check if @a str has expansions.
  *
@@ -31,6 +31,7 @@
 
 #include <ironbeepp/abi_compatibility.hpp>
 #include <ironbeepp/memory_manager.hpp>
+#include <ironbeepp/throw.hpp>
 
 #ifdef __clang__
 #pragma clang diagnostic push
@@ -95,6 +96,15 @@ private:
     static void destruct(T* px) {
         px->~T();
     }
+
+    /**
+     * C cleanup function calling destruct().
+     *
+     * @param[in] cbdata The pointer to destruct but not free.
+     */
+    static void destruct_cleanup(void* cbdata) {
+        destruct(static_cast<T*>(cbdata));
+    }
 public:
 
     /**
@@ -110,7 +120,15 @@ public:
     explicit MMPtr(MemoryManager mm)
     {
         m_px = new (mm.alloc(sizeof(T))) T();
-        mm.register_cleanup(boost::bind(&MMPtr::destruct, m_px));
+
+        // Register with the C memory manager directly, as
+        // MemoryManager::register_cleanup() allocates from the heap.
+        ib_status_t rc =
+            ib_mm_register_cleanup(mm.ib(), &MMPtr::destruct_cleanup, m_px);
+        if (rc != IB_OK) {
+            destruct(m_px);
+            throw_if_error(rc);
+        }
     }
 
     /**
@@ -330,7 +330,11 @@ ib_status_t load_eudoxus_pattern_param2(ib_cfgparser_t *cp,
         return IB_EINVAL;
     }
 
-    ia_rc = ia_eudoxus_create_from_path(&eudoxus, automata_file);
+    ia_rc = ia_eudoxus_create_from_path_mapped(
+        &eudoxus,
+        automata_file,
+        IA_EUDOXUS_MAP_POPULATE
+    );
     if (ia_rc != IA_EUDOXUS_OK) {
         ib_log_error(cp->ib,
                      MODULE_NAME_STR ": Error loading eudoxus automata file[%d]: %s.",
@@ -71,6 +71,8 @@ typedef struct fast_search_t                  fast_search_t;
 typedef struct fast_collection_spec_t         fast_collection_spec_t;
 typedef struct fast_collection_runtime_spec_t fast_collection_runtime_spec_t;
 typedef struct fast_specs_t                   fast_specs_t;
+typedef struct fast_record_t                  fast_record_t;
+typedef struct fast_records_t                 fast_records_t;
 
 /**
  * Module runtime data.
@@ -110,7 +112,7 @@ struct fast_config_t
  *
  * This structure holds the data used during a search of the automata.  In
  * particular it is the callback data of the function passed to
- * ia_eudoxus_execute().
+ * ia_eudoxus_execute_batch().
  */
 struct fast_search_t
 {
@@ -128,6 +130,9 @@ struct fast_search_t
 
     /** Rules already added by pointer.  No data. */
     ib_hash_t *rule_set;
+
+    /** Records being searched; input tags index their records. */
+    const fast_records_t *records;
 };
 
 /* Configuration */
@@ -226,6 +231,44 @@ static const fast_collection_spec_t c_response_body_collections[] = {
     { NULL, NULL }
 };
 
+/**
+ * Where a record fed to the automata came from.
+ *
+ * The tag of the record's @ref ia_eudoxus_input_t is its index in
+ * fast_records_t::records.
+ */
+struct fast_record_t
+{
+    /** Source of collection or NULL for the phase bytestrings. */
+    const ib_var_source_t *source;
+    /** Member of collection or NULL for the phase bytestrings. */
+    const ib_field_t *subfield;
+};
+
+/**
+ * Records to feed to the automata.
+ *
+ * A record is fed as a segment per piece of data it is made of, so that
+ * the data is not copied.
+ */
+struct fast_records_t
+{
+    /** Memory manager to allocate records from. */
+    ib_mm_t mm;
+    /** Inputs; one per segment; tags are indices into @ref records. */
+    ia_eudoxus_input_t *inputs;
+    /** Number of inputs. */
+    size_t num_inputs;
+    /** Size of @ref inputs. */
+    size_t capacity;
+    /** Records. */
+    fast_record_t *records;
+    /** Number of records. */
+    size_t num_records;
+    /** Size of @ref records. */
+    size_t records_capacity;
+};
+
 /** String to separate bytestrings. */
 static const char *c_bytestring_separator = " ";
 /** String to separate different keys, bytestring or collection entries. */
@@ -319,79 +362,179 @@ const fast_config_t *fast_get_config_module(
 }
 
 /**
- * Feed data to the automata.
+ * Make room for one more element in an array allocated from @a mm.
  *
- * @param[in] ib          IronBee engine; used for logging.
- * @param[in] eudoxus     Eudoxus engine; used for ia_eudoxus_error().
- * @param[in] state       Current Eudoxus execution state; updated.
- * @param[in] data        Data to send to automata.
- * @param[in] data_length Length of @a data.
+ * @param[in]     mm       Memory manager.
+ * @param[in]     array    Array; may be NULL if @a capacity is 0.
+ * @param[in]     count    Number of elements in @a array.
+ * @param[in,out] capacity Number of elements @a array has room for.
+ * @param[in]     size     Size of an element.
+ * @return
+ * - @a array or a larger copy of it on success.
+ * - NULL on allocation failure.
+ */
+static
+void *fast_array_reserve(
+    ib_mm_t  mm,
+    void    *array,
+    size_t   count,
+    size_t  *capacity,
+    size_t   size
+)
+{
+    assert(capacity != NULL);
+    assert(count <= *capacity);
+
+    size_t  new_capacity;
+    void   *new_array;
+
+    if (count < *capacity) {
+        return array;
+    }
+
+    new_capacity = *capacity == 0 ? 16 : 2 * *capacity;
+    new_array    = ib_mm_alloc(mm, new_capacity * size);
+    if (new_array == NULL) {
+        return NULL;
+    }
+    if (count > 0) {
+        memcpy(new_array, array, count * size);
+    }
+    *capacity = new_capacity;
+
+    return new_array;
+}
+
+/**
+ * Start a new record in @a records.
+ *
+ * Add its data with fast_records_append().
+ *
+ * @param[in] records  Records; updated.
+ * @param[in] source   Source of collection or NULL for phase bytestrings.
+ * @param[in] subfield Member of collection or NULL for phase bytestrings.
  * @return
  * - IB_OK on success.
- * - IB_EINVAL on IronAutomata failure; will emit log message.
+ * - IB_EALLOC on allocation failure.
  */
 static
-ib_status_t fast_feed(
-    const ib_engine_t  *ib,
-    const ia_eudoxus_t *eudoxus,
-    ia_eudoxus_state_t *state,
-    const uint8_t      *data,
-    size_t              data_length
+ib_status_t fast_records_begin(
+    fast_records_t        *records,
+    const ib_var_source_t *source,
+    const ib_field_t      *subfield
 )
 {
-    assert(ib      != NULL);
-    assert(eudoxus != NULL);
-    assert(state   != NULL);
-    assert(data    != NULL);
+    assert(records != NULL);
 
-    ia_eudoxus_result_t irc;
+    fast_record_t *array;
 
-    irc = ia_eudoxus_execute(state, data, data_length);
-    if (irc != IA_EUDOXUS_OK) {
-        ib_log_error(
-            ib,
-            "fast: Error executing eudoxus: %s",
-            fast_eudoxus_error(eudoxus)
-        );
-        return IB_EINVAL;
+    array = fast_array_reserve(
+        records->mm,
+        records->records,
+        records->num_records,
+        &records->records_capacity,
+        sizeof(*array)
+    );
+    if (array == NULL) {
+        return IB_EALLOC;
     }
+    records->records = array;
+
+    array[records->num_records].source   = source;
+    array[records->num_records].subfield = subfield;
+    ++records->num_records;
 
     return IB_OK;
 }
 
 /**
- * Feed a byte string from an @ref ib_var_store_t to the automata.
+ * Append data to the last record of @a records.
+ *
+ * The data is not copied; it must outlive the search.
  *
- * @param[in] ib                IronBee engine; used for logging.
- * @param[in] eudoxus           Eudoxus engine; used for
- *                              ia_eudoxus_error().
- * @param[in] state             Current Eudoxus execution state; updated.
- * @param[in] var_store         Var store.
- * @param[in] bytestring_source Source of bytestring.
+ * @param[in] records Records; updated.  Must have a record.
+ * @param[in] data    Data; may be NULL if @a length is 0.
+ * @param[in] length  Length of @a data; nothing is done if 0.
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure.
+ */
+static
+ib_status_t fast_records_append(
+    fast_records_t *records,
+    const void     *data,
+    size_t          length
+)
+{
+    assert(records              != NULL);
+    assert(records->num_records >  0);
+
+    void               *tag = (void *)(uintptr_t)(records->num_records - 1);
+    ia_eudoxus_input_t *inputs;
+    ia_eudoxus_input_t *input;
+
+    if (length == 0) {
+        return IB_OK;
+    }
+
+    inputs = fast_array_reserve(
+        records->mm,
+        records->inputs,
+        records->num_inputs,
+        &records->capacity,
+        sizeof(*inputs)
+    );
+    if (inputs == NULL) {
+        return IB_EALLOC;
+    }
+    records->inputs = inputs;
+
+    /* Continue the record if it already has a segment. */
+    if (
+        records->num_inputs > 0 &&
+        inputs[records->num_inputs - 1].tag == tag
+    ) {
+        inputs[records->num_inputs - 1].continued = true;
+    }
+
+    input = &inputs[records->num_inputs];
+    input->data      = (const uint8_t *)data;
+    input->length    = length;
+    input->tag       = tag;
+    input->continued = false;
+    ++records->num_inputs;
+
+    return IB_OK;
+}
+
+/**
+ * Fetch a byte string from an @ref ib_var_store_t.
+ *
+ * @param[in]  ib                IronBee engine; used for logging.
+ * @param[in]  var_store         Var store.
+ * @param[in]  bytestring_source Source of bytestring.
+ * @param[out] bs                Byte string.
  * @return
  * - IB_OK on success.
- * - IB_EINVAL on IronAutomata failure; will emit log message.
  * - IB_EOTHER on IronBee failure; will emit log message.
  */
-static ib_status_t fast_feed_var_bytestring(
-    const ib_engine_t     *ib,
-    const ia_eudoxus_t    *eudoxus,
-    ia_eudoxus_state_t    *state,
-    const ib_var_store_t  *var_store,
-    const ib_var_source_t *bytestring_source
+static
+ib_status_t fast_var_bytestring(
+    const ib_engine_t      *ib,
+    const ib_var_store_t   *var_store,
+    const ib_var_source_t  *bytestring_source,
+    const ib_bytestr_t    **bs
 )
 {
     assert(ib                != NULL);
-    assert(eudoxus           != NULL);
-    assert(state             != NULL);
     assert(var_store         != NULL);
     assert(bytestring_source != NULL);
+    assert(bs                != NULL);
 
-    const ib_field_t   *field;
-    const ib_bytestr_t *bs;
-    ib_status_t         rc;
-    const char         *name;
-    size_t              name_length;
+    const ib_field_t *field;
+    ib_status_t       rc;
+    const char       *name;
+    size_t            name_length;
 
     ib_var_source_name(bytestring_source, &name, &name_length);
 
@@ -416,7 +559,7 @@ static ib_status_t fast_feed_var_bytestring(
 
     rc = ib_field_value_type(
         field,
-        ib_ftype_bytestr_out(&bs),
+        ib_ftype_bytestr_out(bs),
         IB_FTYPE_BYTESTR
     );
     if (rc != IB_OK) {
@@ -429,45 +572,107 @@ static ib_status_t fast_feed_var_bytestring(
         return IB_EOTHER;
     }
 
-    if (ib_bytestr_const_ptr(bs) == NULL || ib_bytestr_size(bs) == 0) {
-        return IB_OK;
-    }
-    return fast_feed(
-        ib,
-        eudoxus,
-        state,
-        ib_bytestr_const_ptr(bs), ib_bytestr_size(bs)
-    );
+    return IB_OK;
 }
 
 /**
- * Feed a collection of byte strings from an @ref ib_var_store_t to automata.
+ * Add a record of byte strings from an @ref ib_var_store_t to @a records.
+ *
+ * The record is each byte string followed by @ref c_bytestring_separator,
+ * followed by @ref c_data_separator.
  *
  * @param[in] ib          IronBee engine; used for logging.
- * @param[in] eudoxus     Eudoxus engine; used for ia_eudoxus_error().
- * @param[in] state       Current Eudoxus execution state; updated.
+ * @param[in] records     Records; updated.
  * @param[in] var_store   Var store.
- * @param[in] collection  Collection to feed.
+ * @param[in] bytestrings Sources of bytestrings; NULL terminated.
  * @return
  * - IB_OK on success.
- * - IB_EINVAL on IronAutomata failure; will emit log message.
+ * - IB_EALLOC on allocation failure; will emit log message.
+ * - IB_EOTHER on IronBee failure; will emit log message.
+ */
+static
+ib_status_t fast_records_add_bytestrings(
+    const ib_engine_t      *ib,
+    fast_records_t         *records,
+    const ib_var_store_t   *var_store,
+    const ib_var_source_t **bytestrings
+)
+{
+    assert(ib          != NULL);
+    assert(records     != NULL);
+    assert(var_store   != NULL);
+    assert(bytestrings != NULL);
+
+    const size_t        bs_sep_length   = strlen(c_bytestring_separator);
+    const size_t        data_sep_length = strlen(c_data_separator);
+    const ib_bytestr_t *value;
+    ib_status_t         rc;
+
+    if (bytestrings[0] == NULL) {
+        return IB_OK;
+    }
+
+    rc = fast_records_begin(records, NULL, NULL);
+    for (size_t i = 0; rc == IB_OK && bytestrings[i] != NULL; ++i) {
+        rc = fast_var_bytestring(ib, var_store, bytestrings[i], &value);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        rc = fast_records_append(
+            records,
+            ib_bytestr_const_ptr(value),
+            ib_bytestr_const_ptr(value) == NULL ? 0 : ib_bytestr_size(value)
+        );
+        if (rc == IB_OK) {
+            rc = fast_records_append(
+                records,
+                c_bytestring_separator,
+                bs_sep_length
+            );
+        }
+    }
+    if (rc == IB_OK) {
+        rc = fast_records_append(records, c_data_separator, data_sep_length);
+    }
+    if (rc != IB_OK) {
+        ib_log_error(ib, "fast: Error allocating bytestring record.");
+        return IB_EALLOC;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Add a record per member of a collection from an @ref ib_var_store_t.
+ *
+ * Each record is the member name and value separated by the separator of
+ * @a collection, and both preceded and followed by @ref c_data_separator
+ * so that patterns anchored on either side continue to match.
+ *
+ * @param[in] ib         IronBee engine; used for logging.
+ * @param[in] records    Records; updated.
+ * @param[in] var_store  Var store.
+ * @param[in] collection Collection to add.
+ * @return
+ * - IB_OK on success.
+ * - IB_EALLOC on allocation failure; will emit log message.
  * - IB_EOTHER on IronBee failure; will emit log message.
  */
 static
-ib_status_t fast_feed_var_collection(
+ib_status_t fast_records_add_collection(
     const ib_engine_t                    *ib,
-    const ia_eudoxus_t                   *eudoxus,
-    ia_eudoxus_state_t                   *state,
+    fast_records_t                       *records,
     const ib_var_store_t                 *var_store,
     const fast_collection_runtime_spec_t *collection
 )
 {
     assert(ib         != NULL);
-    assert(eudoxus    != NULL);
-    assert(state      != NULL);
+    assert(records    != NULL);
     assert(var_store  != NULL);
     assert(collection != NULL);
 
+    const size_t          sep_length      = strlen(collection->separator);
+    const size_t          data_sep_length = strlen(c_data_separator);
     const ib_field_t     *field;
     const ib_list_t      *subfields;
     const ib_list_node_t *node;
@@ -510,6 +715,8 @@ ib_status_t fast_feed_var_collection(
     }
 
     IB_LIST_LOOP_CONST(subfields, node) {
+        size_t value_length;
+
         subfield = (const ib_field_t *)ib_list_node_data_const(node);
         assert(subfield != NULL);
 
@@ -521,58 +728,57 @@ ib_status_t fast_feed_var_collection(
         if (rc != IB_OK) {
             ib_log_error(
                 ib,
-                "fast: Error loading data subfield %s of %.*s: %s",
-                subfield->name,
+                "fast: Error loading data subfield %.*s of %.*s: %s",
+                (int)subfield->nlen, subfield->name,
                 (int)name_length, name,
                 ib_status_to_string(rc)
             );
             return IB_EOTHER;
         }
 
-        rc = fast_feed(
-            ib,
-            eudoxus,
-            state,
-            (const uint8_t *)subfield->name,
-            subfield->nlen
-        );
-        if (rc != IB_OK) {
-            return rc;
-        }
+        value_length =
+            ib_bytestr_const_ptr(bs) == NULL ? 0 : ib_bytestr_size(bs);
 
-        rc = fast_feed(
-            ib,
-            eudoxus,
-            state,
-            (const uint8_t *)collection->separator,
-            strlen(collection->separator)
-        );
-        if (rc != IB_OK) {
-            return rc;
+        rc = fast_records_begin(records, collection->source, subfield);
+        if (rc == IB_OK) {
+            rc = fast_records_append(
+                records,
+                c_data_separator,
+                data_sep_length
+            );
         }
-
-        if (ib_bytestr_const_ptr(bs) != NULL && ib_bytestr_size(bs) > 0) {
-            rc = fast_feed(
-                ib,
-                eudoxus,
-                state,
+        if (rc == IB_OK) {
+            rc = fast_records_append(records, subfield->name, subfield->nlen);
+        }
+        if (rc == IB_OK) {
+            rc = fast_records_append(
+                records,
+                collection->separator,
+                sep_length
+            );
+        }
+        if (rc == IB_OK) {
+            rc = fast_records_append(
+                records,
                 ib_bytestr_const_ptr(bs),
-                ib_bytestr_size(bs)
+                value_length
+            );
+        }
+        if (rc == IB_OK) {
+            rc = fast_records_append(
+                records,
+                c_data_separator,
+                data_sep_length
             );
-            if (rc != IB_OK) {
-                return rc;
-            }
         }
-
-        rc = fast_feed(
-            ib,
-            eudoxus,
-            state,
-            (const uint8_t *)c_data_separator,
-            strlen(c_data_separator)
-        );
         if (rc != IB_OK) {
-            return rc;
+            ib_log_error(
+                ib,
+                "fast: Error allocating record for subfield %.*s of %.*s.",
+                (int)subfield->nlen, subfield->name,
+                (int)name_length, name
+            );
+            return IB_EALLOC;
         }
     }
 
@@ -580,79 +786,43 @@ ib_status_t fast_feed_var_collection(
 }
 
 /**
- * Feed data for a specific phase.
+ * Collect records for a specific phase.
  *
- * Pull and feed the specified bytestrings and collections to an automata.
- * This function is similar to fast_rule_injection() but requires an already
- * functioning automata execution.  It can be combined with other feed
- * functions.
+ * Pull the specified bytestrings and collections into records to feed to
+ * the automata in a single ia_eudoxus_execute_batch() call.  The
+ * bytestrings form a single record and each collection member forms its own
+ * record, so patterns can not match across collection members.
  *
  * @param[in] ib          IronBee engine.
- * @param[in] eudoxus     Eudoxus engine.
- * @param[in] state       Eudoxus execution state; updated.
+ * @param[in] records     Records; updated.
  * @param[in] var_store   Var store.
  * @param[in] bytestrings Bytestrings to feed.
  * @param[in] collections Collections to feed.
  * @return
  * - IB_OK on success.
- * - IB_EINVAL on IronAutomata failure; will emit log message.
+ * - IB_EALLOC on allocation failure; will emit log message.
  * - IB_EOTHER on IronBee failure; will emit log message.
  */
 static
-ib_status_t fast_feed_phase(
+ib_status_t fast_collect_phase(
     const ib_engine_t                     *ib,
-    const ia_eudoxus_t                    *eudoxus,
-    ia_eudoxus_state_t                    *state,
+    fast_records_t                        *records,
     const ib_var_store_t                  *var_store,
     const ib_var_source_t                **bytestrings,
     const fast_collection_runtime_spec_t  *collections
 )
 {
     assert(ib          != NULL);
-    assert(eudoxus     != NULL);
-    assert(state       != NULL);
+    assert(records     != NULL);
     assert(var_store   != NULL);
     assert(bytestrings != NULL);
     assert(collections != NULL);
 
     ib_status_t rc;
 
-    /* Lower level feed_* routines log errors, so we simply abort on
-     * non-OK returns. */
-    for (
-        const ib_var_source_t **bytestring_source = bytestrings;
-        *bytestring_source != NULL;
-        ++bytestring_source
-    ) {
-        rc = fast_feed_var_bytestring(
-            ib,
-            eudoxus,
-            state,
-            var_store,
-            *bytestring_source
-        );
-        if (rc != IB_OK) {
-            return rc;
-        }
-        rc = fast_feed(
-            ib,
-            eudoxus,
-            state,
-            (const uint8_t *)c_bytestring_separator,
-            strlen(c_bytestring_separator)
-        );
-        if (rc != IB_OK) {
-            return rc;
-        }
-    }
-
-    rc = fast_feed(
-        ib,
-        eudoxus,
-        state,
-        (uint8_t *)c_data_separator,
-        strlen(c_data_separator)
-    );
+    /* Lower level routines log errors, so we simply abort on non-OK
+     * returns. */
+    rc = fast_records_add_bytestrings(ib, records, var_store, bytestrings);
     if (rc != IB_OK) {
         return rc;
     }
@@ -662,13 +832,7 @@ ib_status_t fast_feed_phase(
         collection->source != NULL;
         ++collection
     ) {
-        rc = fast_feed_var_collection(
-            ib,
-            eudoxus,
-            state,
-            var_store,
-            collection
-        );
+        rc = fast_records_add_collection(ib, records, var_store, collection);
         if (rc != IB_OK) {
             return rc;
         }
@@ -890,6 +1054,8 @@ ib_status_t fast_convert_specs(
  * @param[in] output         Eudoxus output; @c uint32_t of index location.
  * @param[in] output_length  Length of @a output; must be @c sizeof(uint32_t).
  * @param[in] input_location Location in input; ignored.
+ * @param[in] tag            Index of the @ref fast_record_t of the input;
+ *                           used for logging.
  * @param[in] callback_data  The @ref fast_search_t.
  * @return
  * - IA_EUDOXUS_CMD_CONTINUE on success.
@@ -901,6 +1067,7 @@ ia_eudoxus_command_t fast_eudoxus_callback(
     const char    *output,
     size_t         output_length,
     const uint8_t *input_location,
+    void          *tag,
     void          *callback_data
 )
 {
@@ -908,12 +1075,15 @@ ia_eudoxus_command_t fast_eudoxus_callback(
     assert(output        != NULL);
     assert(callback_data != NULL);
 
-    fast_search_t *search = (fast_search_t *)callback_data;
+    fast_search_t       *search = (fast_search_t *)callback_data;
+    const fast_record_t *record;
 
     assert(search->runtime   != NULL);
     assert(search->rule_exec != NULL);
     assert(search->rule_list != NULL);
     assert(search->rule_set  != NULL);
+    assert(search->records   != NULL);
+    assert((uintptr_t)tag    <  search->records->num_records);
 
     uint32_t         index;
     const ib_rule_t *rule;
@@ -1008,6 +1178,28 @@ ia_eudoxus_command_t fast_eudoxus_callback(
         return IA_EUDOXUS_CMD_ERROR;
     }
 
+    record = &search->records->records[(uintptr_t)tag];
+    if (record->source == NULL) {
+        ib_rule_log_debug(
+            search->rule_exec,
+            "fast: Injecting rule %s matched in bytestrings.",
+            ib_rule_id(rule)
+        );
+    }
+    else {
+        const char *name;
+        size_t      name_length;
+
+        ib_var_source_name(record->source, &name, &name_length);
+        ib_rule_log_debug(
+            search->rule_exec,
+            "fast: Injecting rule %s matched in %.*s:%.*s.",
+            ib_rule_id(rule),
+            (int)name_length, name,
+            (int)record->subfield->nlen, record->subfield->name
+        );
+    }
+
     return IA_EUDOXUS_CMD_CONTINUE;
 }
 
@@ -1149,7 +1341,7 @@ done:
  * phase specific functions that simply forward their parameters along with
  * the bytestrings and collections specific to the phase.
  *
- * @sa fast_feed_phase()
+ * @sa fast_collect_phase()
  *
  * @param[in] ib          IronBee engine.
  * @param[in] rule_exec   Current rule execution context.
@@ -1160,6 +1352,7 @@ done:
  * @return
  * - IB_OK on success.
  * - IB_EINVAL on IronAutomata failure; will emit log message.
+ * - IB_EALLOC on allocation failure; will emit log message.
  * - IB_EOTHER on IronBee failure; will emit log message.
  */
 static
@@ -1187,12 +1380,12 @@ ib_status_t fast_rule_injection(
     assert(runtime->index   != NULL);
 
     ia_eudoxus_result_t   irc;
-    ia_eudoxus_state_t   *state = NULL;
     ib_status_t           rc;
     const ib_var_store_t *var_store;
     ib_mpool_lite_t      *tmp_mp = NULL;
     ib_mm_t               tmp_mm;
     ib_hash_t            *rule_set;
+    fast_records_t        records;
 
     rc = ib_mpool_lite_create(&tmp_mp);
     if (rc != IB_OK) {
@@ -1223,41 +1416,54 @@ ib_status_t fast_rule_injection(
         .rule_exec = rule_exec,
         .rules     = cfg->rules,
         .rule_list = rule_list,
-        .rule_set  = rule_set
+        .rule_set  = rule_set,
+        .records   = &records
     };
 
     var_store = rule_exec->tx->var_store;
 
-    irc = ia_eudoxus_create_state(
-        &state,
+    records.mm               = tmp_mm;
+    records.inputs           = NULL;
+    records.num_inputs       = 0;
+    records.capacity         = 0;
+    records.records          = NULL;
+    records.num_records      = 0;
+    records.records_capacity = 0;
+
+    /* fast_collect_phase() will handle logging errors. */
+    rc = fast_collect_phase(
+        ib,
+        &records,
+        var_store,
+        bytestrings,
+        collections
+    );
+    if (rc != IB_OK) {
+        goto done;
+    }
+
+    if (records.num_inputs == 0) {
+        goto done;
+    }
+
+    irc = ia_eudoxus_execute_batch(
         runtime->eudoxus,
+        records.inputs,
+        records.num_inputs,
         fast_eudoxus_callback,
         &search
     );
     if (irc != IA_EUDOXUS_OK) {
         ib_log_error(
             ib,
-            "fast: Error creating state: %s",
+            "fast: Error executing eudoxus: %s",
             fast_eudoxus_error(runtime->eudoxus)
         );
         rc = IB_EINVAL;
         goto done;
     }
 
-    /* fast_feed_phase() will handle logging errors. */
-    rc = fast_feed_phase(
-        ib,
-        runtime->eudoxus,
-        state,
-        var_store,
-        bytestrings,
-        collections
-    );
-
 done:
-    if (state != NULL) {
-        ia_eudoxus_destroy_state(state);
-    }
     if (tmp_mp != NULL) {
         ib_mpool_lite_destroy(tmp_mp);
     }
@@ -1594,8 +1800,13 @@ ib_status_t fast_dir_fast_automata(
         return IB_EALLOC;
     }
 
-    /* Load Automata */
-    irc = ia_eudoxus_create_from_path(&runtime->eudoxus, p1);
+    /* Load Automata.  Mapped images are shared across engines, so
+     * reloading an unchanged automata does no I/O. */
+    irc = ia_eudoxus_create_from_path_mapped(
+        &runtime->eudoxus,
+        p1,
+        IA_EUDOXUS_MAP_POPULATE
+    );
     if (irc != IA_EUDOXUS_OK) {
         /* Note: ia_eudoxus_error() will not work as runtime->eudoxus
          * did not finish construction. */
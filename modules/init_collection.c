@@ -93,6 +93,7 @@ typedef struct json_t json_t;
  *
  * @param[in] impl The implementation created by json_create_fn().
  * @param[in] tx The transaction.
+ * @param[in] mm Memory manager to load @a fields into.
  * @param[in] key Unused.
  * @param[in] key_len Unused.
  * @param[in] fields The output fields.
@@ -105,6 +106,7 @@ typedef struct json_t json_t;
 static ib_status_t json_load_fn(
     void       *impl,
     ib_tx_t    *tx,
+    ib_mm_t     mm,
     const char *key,
     size_t      key_len,
     ib_list_t  *fields,
@@ -122,7 +124,7 @@ static ib_status_t json_load_fn(
     size_t         sz;
 
     /* Load the file into a buffer. */
-    rc = ib_file_readall(tx->mm, json_cfg->file, &buf, &sz);
+    rc = ib_file_readall(mm, json_cfg->file, &buf, &sz);
     if (rc != IB_OK) {
         if (rc == IB_EOTHER || rc == IB_EINVAL) {
             ib_log_error_tx(
@@ -138,7 +140,7 @@ static ib_status_t json_load_fn(
     }
 
     /* Parse the buffer into the fields list. */
-    rc = ib_json_decode_ex(tx->mm, buf, sz, fields, &err_msg);
+    rc = ib_json_decode_ex(mm, buf, sz, fields, &err_msg);
     if (rc != IB_OK) {
         ib_log_error_tx(
             tx,
@@ -464,6 +466,7 @@ static ib_status_t var_create_fn(
  *
  * @param[in] impl The @ref var_t created by var_create_fn().
  * @param[in] tx The current transaction.
+ * @param[in] mm Unused.
  * @param[in] key Unused.
  * @param[in] key_len Unused.
  * @param[in] fields The output fields.
@@ -477,6 +480,7 @@ static
 ib_status_t var_load_fn(
     void       *impl,
     ib_tx_t    *tx,
+    ib_mm_t     mm,
     const char *key,
     size_t      key_len,
     ib_list_t  *fields,
@@ -327,7 +327,7 @@ ib_status_t modlua_context_close(
         cfg->lua_resource = NULL;
         cfg->L = NULL;
 
-        rc = ib_resource_pool_flush(cfg->lua_pool);
+        rc = modlua_runtime_flush(cfg);
         if (rc != IB_OK) {
             return rc;
         }
@@ -340,6 +340,7 @@ ib_status_t modlua_context_close(
  * Context destroy callback.
  *
  * Destroys Lua stack and pointer when the main context is destroyed.
+ * Logs the Lua stack cache statistics at debug level.
  *
  * param[in] ib IronBee engine.
  * param[in] ctx The configuration context.
@@ -365,15 +366,26 @@ ib_status_t modlua_context_destroy(
 
     /* Close of the main context signifies configuration finished. */
     if (ib_context_type(ctx) == IB_CTYPE_MAIN) {
-        ib_status_t   rc;
-        modlua_cfg_t *cfg = NULL;
-        ib_module_t  *module = (ib_module_t *)cbdata;
+        ib_status_t             rc;
+        modlua_cfg_t           *cfg = NULL;
+        ib_module_t            *module = (ib_module_t *)cbdata;
+        modlua_runtime_stats_t  stats;
 
         rc = ib_context_module_config(ctx, module, &cfg);
         if (rc != IB_OK) {
             ib_log_error(ib, "Failed to retrieve modlua configuration.");
             return rc;
         }
+
+        if (cfg->lua_pool_cfg != NULL) {
+            modlua_runtime_stats_get(cfg->lua_pool_cfg, &stats);
+            ib_log_debug(
+                ib,
+                "Lua stack cache: %zu hits, %zu misses, %zu stacks created.",
+                stats.hits,
+                stats.misses,
+                stats.creations);
+        }
     }
 
     return IB_OK;
@@ -601,6 +613,7 @@ static ib_status_t modlua_init(
         ib,
         module,
         mm,
+        cfg->lua_pool_lock,
         &(cfg->lua_pool_cfg));
     if (rc != IB_OK) {
         ib_log_error(ib, "Failed to create Lua resource pool.");
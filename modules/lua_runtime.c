@@ -31,6 +31,7 @@
 #include "lua_modules_private.h"
 #include "lua_private.h"
 
+#include <ironbee/atomic.h>
 #include <ironbee/context.h>
 #include <ironbee/mm_mpool_lite.h>
 
@@ -40,6 +41,7 @@
 #include <lualib.h>
 
 #include <assert.h>
+#include <pthread.h>
 #include <stdlib.h>
 
 /* If LUA_BASE_PATH was not set as part of autoconf, define a default. */
@@ -52,6 +54,12 @@
 //! Maximum number of times a resource pool Lua stack should be used.
 static size_t MAX_LUA_STACK_USES = 1000;
 
+//! Number of Lua stacks each thread keeps out of the resource pool.
+#define MODLUA_RUNTIME_CACHE_SIZE 4
+
+typedef struct modlua_runtime_cbdata_t modlua_runtime_cbdata_t;
+typedef struct modlua_runtime_cache_t modlua_runtime_cache_t;
+
 /**
  * Opaque runtime structure passed back to the user.
  *
@@ -64,17 +72,89 @@ struct modlua_runtime_cfg_t {
      * The limit on the number of times a Lua stack may be used.
      */
     ssize_t max_lua_stack_uses;
+
+    /**
+     * The resource pool callback data this configuration belongs to.
+     */
+    modlua_runtime_cbdata_t *cbdata;
 };
 
 /**
  * Data provided to the resource pool to use in creating Lua stacks.
+ *
+ * This also holds the per-thread caches of Lua stacks for the pool.
  */
 struct modlua_runtime_cbdata_t {
     ib_engine_t          *ib;     /**< The engine. */
     ib_module_t          *module; /**< `ibmod_lua` structure. */
     modlua_runtime_cfg_t  cfg;    /**< Configuration information. */
+
+    /**
+     * Lock protecting the resource pool.
+     */
+    ib_lock_t *lock;
+
+    /**
+     * Key of the calling thread's @ref modlua_runtime_cache_t.
+     */
+    pthread_key_t cache_key;
+
+    /**
+     * Pool generation; bumped by modlua_runtime_flush().
+     *
+     * Stacks created in an older generation are destroyed, not reused.
+     */
+    size_t generation;
+
+    modlua_runtime_stats_t stats; /**< Statistics; updated atomically. */
 };
-typedef struct modlua_runtime_cbdata_t modlua_runtime_cbdata_t;
+
+/**
+ * Per-thread cache of Lua stacks.
+ *
+ * Stacks in the cache remain acquired from the resource pool, so a thread
+ * can reuse them without taking modlua_runtime_cbdata_t::lock.  Because
+ * they count against the pool's maximum, a thread the pool turns away
+ * returns the stacks idle in other threads' caches to the pool.
+ *
+ * A cache is owned by @ref g_lua_caches: whichever of the thread exit
+ * callback and the pool cleanup unlinks it from that list frees it.
+ */
+struct modlua_runtime_cache_t {
+    modlua_runtime_cbdata_t *cbdata; /**< The pool this cache belongs to. */
+    pthread_t                owner;  /**< The thread using this cache. */
+    modlua_runtime_cache_t  *next;   /**< Next cache in @ref g_lua_caches. */
+    modlua_runtime_cache_t  *prev;   /**< Previous cache. */
+    size_t                   count;  /**< Number of cached stacks. */
+
+    /**
+     * Non-zero while the owning thread or lua_cache_reclaim() uses the cache.
+     *
+     * Updated atomically; see lua_cache_enter().
+     */
+    int busy;
+
+    /**
+     * The cached stacks.
+     */
+    modlua_runtime_t *runtimes[MODLUA_RUNTIME_CACHE_SIZE];
+};
+
+/**
+ * All thread caches of all pools in the process.
+ *
+ * Protected by @ref g_lua_caches_lock.
+ */
+static modlua_runtime_cache_t *g_lua_caches = NULL;
+
+/**
+ * Lock protecting @ref g_lua_caches.
+ *
+ * This is process wide, rather than per pool, because a thread exit
+ * callback cannot know whether its pool is still alive until it holds it.
+ * Take it before modlua_runtime_cbdata_t::lock.
+ */
+static pthread_mutex_t g_lua_caches_lock = PTHREAD_MUTEX_INITIALIZER;
 
 /**
  * Given a search prefix this will build a search path and add it to Lua.
@@ -552,8 +632,10 @@ static ib_status_t lua_pool_create_fn(void *resource, void *cbdata)
         goto exit_failure;
     }
 
-    modlua_runtime->use_count = 0;
-    modlua_runtime->mp        = mp;
+    modlua_runtime->use_count  = 0;
+    modlua_runtime->mp         = mp;
+    modlua_runtime->generation =
+        ib_atomic_load(&(modlua_runtime_cbdata->generation));
 
     /* Create a new Lua State. */
     rc = modlua_newstate(ib, cfg, &(modlua_runtime->L));
@@ -571,6 +653,8 @@ static ib_status_t lua_pool_create_fn(void *resource, void *cbdata)
 
     *(void **)resource = modlua_runtime;
 
+    ib_atomic_add_relaxed(&(modlua_runtime_cbdata->stats.creations), 1);
+
     return IB_OK;
 
 exit_failure:
@@ -625,8 +709,8 @@ static void lua_pool_preuse_fn(void *resource, void *cbdata)
 /**
  * Returns @ref IB_EINVAL when modlua_runtime_t should be destroyed.
  *
- * Currently the only condition that triggers destruction is
- * if the max_lua_stack_uses limit is exceeded.
+ * This is the case if the max_lua_stack_uses limit is exceeded or if
+ * the stack predates the last modlua_runtime_flush().
  *
  * @param[in] resource The @ref modlua_runtime_t to check.
  * @param[in] cbdata Callback data. @ref modlua_runtime_cbdata_t.
@@ -649,7 +733,231 @@ static ib_status_t lua_pool_postuse_fn(void *resource, void *cbdata)
     const ssize_t limit = modlua_runtime_cbdata->cfg.max_lua_stack_uses;
 
     /* Signal stack destruction if it was used some number of times. */
-    return (modlua_runtime->use_count > limit)? IB_EINVAL : IB_OK;
+    if (modlua_runtime->use_count > limit) {
+        return IB_EINVAL;
+    }
+
+    /* Signal stack destruction if it is from a flushed generation. */
+    if (modlua_runtime->generation !=
+        ib_atomic_load(&(modlua_runtime_cbdata->generation)))
+    {
+        return IB_EINVAL;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Return all stacks in @a cache to the resource pool.
+ *
+ * This requires the caller to hold modlua_runtime_cbdata_t::lock.
+ *
+ * @param[in] cache The cache to drain.
+ */
+static void lua_cache_drain(modlua_runtime_cache_t *cache)
+{
+    assert(cache != NULL);
+
+    while (cache->count > 0) {
+        modlua_runtime_t *modlua_runtime = cache->runtimes[--(cache->count)];
+
+        ib_resource_release(modlua_runtime->resource);
+    }
+}
+
+/**
+ * Take exclusive use of @a cache.
+ *
+ * This is uncontended except while another thread reclaims the cache.
+ *
+ * @param[in] cache The cache.
+ *
+ * @returns True if @a cache may be used; release it with lua_cache_leave().
+ */
+static bool lua_cache_enter(modlua_runtime_cache_t *cache)
+{
+    assert(cache != NULL);
+
+    int idle = 0;
+
+    return ib_atomic_cas(&(cache->busy), &idle, 1);
+}
+
+/**
+ * Release the use of @a cache taken by lua_cache_enter().
+ *
+ * @param[in] cache The cache.
+ */
+static void lua_cache_leave(modlua_runtime_cache_t *cache)
+{
+    assert(cache != NULL);
+
+    ib_atomic_store(&(cache->busy), 0);
+}
+
+/**
+ * Return the stacks idle in all thread caches to the resource pool.
+ *
+ * Caches in use by their thread at the time are skipped.
+ *
+ * @param[in] cbdata The pool.
+ *
+ * @returns The number of stacks returned.
+ */
+static size_t lua_cache_reclaim(modlua_runtime_cbdata_t *cbdata)
+{
+    assert(cbdata != NULL);
+
+    modlua_runtime_cache_t *cache;
+    size_t                  count = 0;
+
+    pthread_mutex_lock(&g_lua_caches_lock);
+    ib_lock_lock(cbdata->lock);
+    for (cache = g_lua_caches; cache != NULL; cache = cache->next) {
+        if ( (cache->cbdata == cbdata) && lua_cache_enter(cache) ) {
+            count += cache->count;
+            lua_cache_drain(cache);
+            lua_cache_leave(cache);
+        }
+    }
+    ib_lock_unlock(cbdata->lock);
+    pthread_mutex_unlock(&g_lua_caches_lock);
+
+    return count;
+}
+
+/**
+ * Remove @a cache from @ref g_lua_caches.
+ *
+ * This requires the caller to hold @ref g_lua_caches_lock.
+ *
+ * @param[in] cache The cache.
+ */
+static void lua_cache_unlink(modlua_runtime_cache_t *cache)
+{
+    assert(cache != NULL);
+
+    if (cache->prev != NULL) {
+        cache->prev->next = cache->next;
+    }
+    else {
+        g_lua_caches = cache->next;
+    }
+    if (cache->next != NULL) {
+        cache->next->prev = cache->prev;
+    }
+}
+
+/**
+ * Thread exit callback: return a thread's cached stacks and free the cache.
+ *
+ * If the pool cleanup already took @a data, it has been freed and this
+ * does nothing.  The owner check keeps a new cache that happens to reuse
+ * the address of a freed one from being taken for it.
+ *
+ * @param[in] data The @ref modlua_runtime_cache_t.
+ */
+static void lua_cache_destroy_fn(void *data)
+{
+    assert(data != NULL);
+
+    modlua_runtime_cache_t *cache;
+
+    pthread_mutex_lock(&g_lua_caches_lock);
+    for (cache = g_lua_caches; cache != NULL; cache = cache->next) {
+        if ( (cache == data) && pthread_equal(cache->owner, pthread_self()) ) {
+            break;
+        }
+    }
+    if (cache != NULL) {
+        lua_cache_unlink(cache);
+
+        /* The pool outlives its caches in the list. */
+        ib_lock_lock(cache->cbdata->lock);
+        lua_cache_drain(cache);
+        ib_lock_unlock(cache->cbdata->lock);
+    }
+    pthread_mutex_unlock(&g_lua_caches_lock);
+
+    free(cache);
+}
+
+/**
+ * Memory manager cleanup: return all cached stacks to the resource pool.
+ *
+ * This is registered after the resource pool is created, so it runs before
+ * the resource pool destroys its free stacks.
+ *
+ * @param[in] data The @ref modlua_runtime_cbdata_t.
+ */
+static void lua_cache_cleanup_fn(void *data)
+{
+    assert(data != NULL);
+
+    modlua_runtime_cbdata_t *cbdata = (modlua_runtime_cbdata_t *)data;
+    modlua_runtime_cache_t  *cache;
+    modlua_runtime_cache_t  *next;
+
+    /* No more thread exit callbacks for this pool. */
+    pthread_key_delete(cbdata->cache_key);
+
+    pthread_mutex_lock(&g_lua_caches_lock);
+    ib_lock_lock(cbdata->lock);
+    for (cache = g_lua_caches; cache != NULL; cache = next) {
+        next = cache->next;
+        if (cache->cbdata == cbdata) {
+            lua_cache_unlink(cache);
+            lua_cache_drain(cache);
+            free(cache);
+        }
+    }
+    ib_lock_unlock(cbdata->lock);
+    pthread_mutex_unlock(&g_lua_caches_lock);
+}
+
+/**
+ * Get the calling thread's cache of stacks, creating it if need be.
+ *
+ * @param[in] cbdata The pool.
+ *
+ * @returns The cache or NULL if it cannot be created.
+ */
+static modlua_runtime_cache_t *lua_cache_get(modlua_runtime_cbdata_t *cbdata)
+{
+    assert(cbdata != NULL);
+
+    modlua_runtime_cache_t *cache;
+
+    cache = (modlua_runtime_cache_t *)pthread_getspecific(cbdata->cache_key);
+    if (cache != NULL) {
+        return cache;
+    }
+
+    cache = calloc(1, sizeof(*cache));
+    if (cache == NULL) {
+        return NULL;
+    }
+    cache->cbdata = cbdata;
+    cache->owner  = pthread_self();
+
+    /* Register the cache so it can be drained when the pool goes away. */
+    pthread_mutex_lock(&g_lua_caches_lock);
+    cache->next = g_lua_caches;
+    if (cache->next != NULL) {
+        cache->next->prev = cache;
+    }
+    g_lua_caches = cache;
+    pthread_mutex_unlock(&g_lua_caches_lock);
+
+    if (pthread_setspecific(cbdata->cache_key, cache) != 0) {
+        pthread_mutex_lock(&g_lua_caches_lock);
+        lua_cache_unlink(cache);
+        pthread_mutex_unlock(&g_lua_caches_lock);
+        free(cache);
+        return NULL;
+    }
+
+    return cache;
 }
 
 ib_status_t modlua_runtime_cfg_set_stack_use_limit(
@@ -673,6 +981,7 @@ ib_status_t modlua_runtime_resource_pool_create(
     ib_engine_t           *ib,
     ib_module_t           *module,
     ib_mm_t                mm,
+    ib_lock_t             *lock,
     modlua_runtime_cfg_t **cfg
 )
 {
@@ -680,6 +989,7 @@ ib_status_t modlua_runtime_resource_pool_create(
     assert(resource_pool != NULL);
     assert(ib != NULL);
     assert(module != NULL);
+    assert(lock != NULL);
 
     ib_status_t rc;
     modlua_runtime_cbdata_t *modlua_runtime_cbdata;
@@ -693,9 +1003,18 @@ ib_status_t modlua_runtime_resource_pool_create(
 
     modlua_runtime_cbdata->ib = ib;
     modlua_runtime_cbdata->module = module;
+    modlua_runtime_cbdata->lock = lock;
 
     /* Initialize the configuration. */
     modlua_runtime_cbdata->cfg.max_lua_stack_uses = MAX_LUA_STACK_USES;
+    modlua_runtime_cbdata->cfg.cbdata = modlua_runtime_cbdata;
+
+    if (pthread_key_create(
+            &(modlua_runtime_cbdata->cache_key),
+            lua_cache_destroy_fn) != 0)
+    {
+        return IB_EOTHER;
+    }
 
     rc = ib_resource_pool_create(
         resource_pool,         /* Out variable. */
@@ -713,6 +1032,17 @@ ib_status_t modlua_runtime_resource_pool_create(
     );
 
     if (rc != IB_OK) {
+        pthread_key_delete(modlua_runtime_cbdata->cache_key);
+        return rc;
+    }
+
+    /* Registered after the pool so cached stacks are returned first. */
+    rc = ib_mm_register_cleanup(
+        mm,
+        lua_cache_cleanup_fn,
+        modlua_runtime_cbdata);
+    if (rc != IB_OK) {
+        pthread_key_delete(modlua_runtime_cbdata->cache_key);
         return rc;
     }
 
@@ -721,6 +1051,38 @@ ib_status_t modlua_runtime_resource_pool_create(
     return IB_OK;
 }
 
+ib_status_t modlua_runtime_flush(
+    modlua_cfg_t *cfg
+)
+{
+    assert(cfg != NULL);
+    assert(cfg->lua_pool_cfg != NULL);
+
+    ib_status_t rc;
+
+    /* Retire every stack created so far, cached or in use. */
+    ib_atomic_add(&(cfg->lua_pool_cfg->cbdata->generation), 1);
+
+    rc = ib_resource_pool_flush(cfg->lua_pool);
+
+    return rc;
+}
+
+void modlua_runtime_stats_get(
+    const modlua_runtime_cfg_t *cfg,
+    modlua_runtime_stats_t     *stats
+)
+{
+    assert(cfg != NULL);
+    assert(stats != NULL);
+
+    const modlua_runtime_stats_t *src = &(cfg->cbdata->stats);
+
+    stats->hits      = ib_atomic_load_relaxed(&(src->hits));
+    stats->misses    = ib_atomic_load_relaxed(&(src->misses));
+    stats->creations = ib_atomic_load_relaxed(&(src->creations));
+}
+
 ib_status_t modlua_releasestate(
     ib_engine_t      *ib,
     modlua_cfg_t     *cfg,
@@ -729,21 +1091,27 @@ ib_status_t modlua_releasestate(
 {
     assert(ib != NULL);
     assert(cfg != NULL);
+    assert(cfg->lua_pool_cfg != NULL);
 
-    ib_status_t rc;
+    ib_status_t              rc;
+    modlua_runtime_cbdata_t *cbdata = cfg->lua_pool_cfg->cbdata;
+    modlua_runtime_cache_t  *cache;
 
-    rc = ib_lock_lock(cfg->lua_pool_lock);
-    if (rc != IB_OK) {
-        return rc;
+    /* Keep the stack in this thread's cache if the pool would keep it. */
+    cache = (modlua_runtime_cache_t *)pthread_getspecific(cbdata->cache_key);
+    if ( (cache != NULL) &&
+         (lua_pool_postuse_fn(modlua_runtime, cbdata) == IB_OK) &&
+         lua_cache_enter(cache) )
+    {
+        if (cache->count < MODLUA_RUNTIME_CACHE_SIZE) {
+            cache->runtimes[(cache->count)++] = modlua_runtime;
+            lua_cache_leave(cache);
+            return IB_OK;
+        }
+        lua_cache_leave(cache);
     }
 
     rc = ib_resource_release(modlua_runtime->resource);
-    if (rc != IB_OK) {
-        ib_lock_unlock(cfg->lua_pool_lock);
-        return rc;
-    }
-
-    rc = ib_lock_unlock(cfg->lua_pool_lock);
     if (rc != IB_OK) {
         return rc;
     }
@@ -759,22 +1127,40 @@ ib_status_t modlua_acquirestate(
 {
     assert(ib != NULL);
     assert(cfg != NULL);
-
-    ib_status_t    rc;
-    ib_resource_t *resource;
-
-    rc = ib_lock_lock(cfg->lua_pool_lock);
-    if (rc != IB_OK) {
-        return rc;
+    assert(cfg->lua_pool_cfg != NULL);
+
+    ib_status_t              rc;
+    ib_resource_t           *resource;
+    modlua_runtime_cbdata_t *cbdata = cfg->lua_pool_cfg->cbdata;
+    modlua_runtime_cache_t  *cache  = lua_cache_get(cbdata);
+
+    /* Try this thread's cache first. */
+    if ( (cache != NULL) && lua_cache_enter(cache) ) {
+        while (cache->count > 0) {
+            modlua_runtime_t *cached = cache->runtimes[--(cache->count)];
+
+            /* Flushed since it was cached: the pool will destroy it. */
+            if (lua_pool_postuse_fn(cached, cbdata) != IB_OK) {
+                ib_resource_release(cached->resource);
+                continue;
+            }
+
+            lua_cache_leave(cache);
+            lua_pool_preuse_fn(cached, cbdata);
+            ib_atomic_add_relaxed(&(cbdata->stats.hits), 1);
+            *modlua_runtime = cached;
+            return IB_OK;
+        }
+        lua_cache_leave(cache);
     }
 
+    ib_atomic_add_relaxed(&(cbdata->stats.misses), 1);
+
     rc = ib_resource_acquire(cfg->lua_pool, &resource);
-    if (rc != IB_OK) {
-        ib_lock_unlock(cfg->lua_pool_lock);
-        return rc;
+    if ( (rc == IB_DECLINED) && (lua_cache_reclaim(cbdata) > 0) ) {
+        /* The pool was full of stacks idle in other threads' caches. */
+        rc = ib_resource_acquire(cfg->lua_pool, &resource);
     }
-
-    rc = ib_lock_unlock(cfg->lua_pool_lock);
     if (rc != IB_OK) {
         return rc;
     }
@@ -41,13 +41,26 @@
  * Created for each connection and stored as the module's connection data.
  */
 struct modlua_runtime_t {
-    lua_State       *L;         /**< Lua stack */
-    ssize_t          use_count; /**< Number of times this stack is used. */
-    ib_mpool_lite_t *mp;        /**< Memory pool for this runtime. */
-    ib_resource_t   *resource;  /**< Bookkeeping for modlua_releasestate(). */
+    lua_State       *L;          /**< Lua stack */
+    ssize_t          use_count;  /**< Number of times this stack is used. */
+    ib_mpool_lite_t *mp;         /**< Memory pool for this runtime. */
+    ib_resource_t   *resource;   /**< Bookkeeping for modlua_releasestate(). */
+    size_t           generation; /**< Pool generation at creation. */
 };
 typedef struct modlua_runtime_t modlua_runtime_t;
 
+/**
+ * Lua stack acquisition statistics.
+ *
+ * @sa modlua_runtime_stats_get()
+ */
+struct modlua_runtime_stats_t {
+    size_t hits;      /**< Acquisitions served by a thread cache. */
+    size_t misses;    /**< Acquisitions served by the resource pool. */
+    size_t creations; /**< Lua stacks created. */
+};
+typedef struct modlua_runtime_stats_t modlua_runtime_stats_t;
+
 /**
  * The type of reloading that must be done to initialize a new Lua stack.
  *
@@ -103,16 +116,27 @@ NONNULL_ATTRIBUTE(1);
 /**
  * Create a resource pool that manages @ref modlua_runtime_t instances.
  *
+ * Each thread keeps a few Lua stacks out of the pool, so that
+ * modlua_acquirestate() and modlua_releasestate() only take @a lock
+ * when the thread's cache is empty or full.  Cached stacks count against
+ * the pool's maximum; when the pool is at its maximum, a thread returns
+ * the stacks idle in other threads' caches to it before giving up.
+ *
+ * A thread's cache is freed either when the thread exits or when @a mm
+ * is cleaned up, whichever comes first; the two may run concurrently.
+ *
  * @param[out] resource_pool Resource pool to create.
  * @param[in] ib The IronBee engine made available to the Lua runtime.
  * @param[in] module The IronBee module structure.
  * @param[in] mm The memory manager the resource pool will use.
+ * @param[in] lock The lock protecting @a resource_pool.
  * @param[in] cfg Runtime configuration parameters that the user may set
  *            during configuration time.
  *
  *  @returns
  *  - IB_OK On success
  *  - IB_EALLOC If callback data structure cannot be allocated out of @a mp.
+ *  - IB_EOTHER If the thread cache key cannot be created.
  *  - Failures codes ib_resource_pool_create().
  */
 ib_status_t modlua_runtime_resource_pool_create(
@@ -120,9 +144,40 @@ ib_status_t modlua_runtime_resource_pool_create(
     ib_engine_t           *ib,
     ib_module_t           *module,
     ib_mm_t                mm,
+    ib_lock_t             *lock,
     modlua_runtime_cfg_t **cfg
 );
 
+/**
+ * Destroy all idle Lua stacks and retire those in use.
+ *
+ * This is used when the configuration changes such that existing stacks
+ * are no longer valid.  Stacks cached by threads or in use are destroyed
+ * when next returned, rather than reused.
+ *
+ * @param[in] cfg The module configuration.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - Other on locking or ib_resource_pool_flush() failure.
+ */
+ib_status_t modlua_runtime_flush(
+    modlua_cfg_t *cfg
+);
+
+/**
+ * Get Lua stack acquisition statistics.
+ *
+ * @param[in] cfg The configuration object returned to the user by
+ *            modlua_runtime_resource_pool_create().
+ * @param[out] stats The statistics.
+ */
+void modlua_runtime_stats_get(
+    const modlua_runtime_cfg_t *cfg,
+    modlua_runtime_stats_t     *stats
+)
+NONNULL_ATTRIBUTE(1, 2);
+
 /**
  * Reload @a ctx and all parent contexts except the main context.
  *
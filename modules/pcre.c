@@ -22,6 +22,7 @@
  * @author Brian Rectanus <brectanus@qualys.com>
  */
 
+#include <ironbee/atomic.h>
 #include <ironbee/bytestr.h>
 #include <ironbee/capture.h>
 #include <ironbee/cfgmap.h>
@@ -29,7 +30,9 @@
 #include <ironbee/engine.h>
 #include <ironbee/escape.h>
 #include <ironbee/field.h>
+#include <ironbee/hash.h>
 #include <ironbee/mm.h>
+#include <ironbee/mm_mpool_lite.h>
 #include <ironbee/module.h>
 #include <ironbee/operator.h>
 #include <ironbee/rule_engine.h>
@@ -42,6 +45,10 @@
 #include <ironbee_config_auto_gen.h>
 
 #include <pcre.h>
+#ifdef HAVE_PCRE2
+#define PCRE2_CODE_UNIT_WIDTH 8
+#include <pcre2.h>
+#endif
 
 #include <assert.h>
 #include <ctype.h>
@@ -52,6 +59,7 @@
 #include <strings.h>
 #include <time.h>
 #include <limits.h>
+#include <pthread.h>
 
 /* Define the module name as well as a string version of it. */
 #define MODULE_NAME        pcre
@@ -78,6 +86,14 @@
 /* Define the public module symbol. */
 IB_MODULE_DECLARE();
 
+/**
+ * Regular expression engines; values of modpcre_cfg_t::engine.
+ */
+enum modpcre_engine_t {
+    MODPCRE_ENGINE_PCRE  = 0,     /**< PCRE (the default) */
+    MODPCRE_ENGINE_PCRE2 = 1      /**< PCRE2; needs HAVE_PCRE2 */
+};
+
 /**
  * Module Configuration Structure.
  */
@@ -89,6 +105,7 @@ struct modpcre_cfg_t {
     ib_num_t       jit_stack_start;       /**< Starting JIT stack size */
     ib_num_t       jit_stack_max;         /**< Max JIT stack size */
     ib_num_t       dfa_workspace_size;    /**< Size of DFA workspace */
+    ib_num_t       engine;                /**< A modpcre_engine_t */
 };
 typedef struct modpcre_cfg_t modpcre_cfg_t;
 
@@ -96,13 +113,17 @@ typedef struct modpcre_cfg_t modpcre_cfg_t;
  * Internal representation of PCRE compiled patterns.
  */
 struct modpcre_cpat_data_t {
-    ib_module_t         *module;          /**< Pointer to this module. */
     const pcre          *cpatt;           /**< Compiled pattern */
     const pcre_extra    *edata;           /**< PCRE Study data */
     const char          *patt;            /**< Regex pattern text */
     bool                 is_dfa;          /**< Is this a DFA? */
     bool                 is_jit;          /**< Is this JIT compiled? */
     int                  dfa_ws_size;     /**< Size of DFA workspace */
+#ifdef HAVE_PCRE2
+    const pcre2_code    *code2;           /**< PCRE2 pattern; NULL for PCRE */
+    uint32_t             match_limit;     /**< PCRE2 match limit */
+    uint32_t             depth_limit;     /**< PCRE2 depth limit */
+#endif
 };
 typedef struct modpcre_cpat_data_t modpcre_cpat_data_t;
 
@@ -110,11 +131,21 @@ typedef struct modpcre_cpat_data_t modpcre_cpat_data_t;
  * PCRE and DFA rule data types are an alias for the compiled pattern structure.
  */
 struct modpcre_operator_data_t {
-    modpcre_cpat_data_t *cpdata;          /**< Compiled pattern data */
-    const char          *id;              /**< ID for DFA rules */
+    const modpcre_cpat_data_t *cpdata;    /**< Compiled pattern data */
+    size_t                     slot;      /**< Index of DFA rule tx data */
 };
 typedef struct modpcre_operator_data_t modpcre_operator_data_t;
 
+/**
+ * Module runtime data.
+ *
+ * Callback data of dfa_operator_create().
+ */
+struct modpcre_runtime_t {
+    size_t num_dfa_slots;                 /**< DFA operator slots (atomic) */
+};
+typedef struct modpcre_runtime_t modpcre_runtime_t;
+
 /* Instantiate a module global configuration. */
 static modpcre_cfg_t modpcre_global_cfg = {
     1,                     /* study. */
@@ -123,24 +154,359 @@ static modpcre_cfg_t modpcre_global_cfg = {
     5000,                  /* match_limit_recursion. */
     32 * 1024,             /* jit_stack_start. */
     1000 * 1024,           /* jit_stack_max. */
-    WORKSPACE_SIZE_DEFAULT /* dfa_workspace_size. */
+    WORKSPACE_SIZE_DEFAULT,/* dfa_workspace_size. */
+    MODPCRE_ENGINE_PCRE    /* engine. */
 };
 
+/* Forward declaration; see below. */
+typedef struct dfa_workspace_t dfa_workspace_t;
+
+/**
+ * A DFA workspace buffer.
+ *
+ * Buffers are malloc'd and kept in per-thread caches between uses.
+ */
+struct pcre_dfa_buffer_t {
+    struct pcre_dfa_buffer_t *next;        /**< Next buffer in list. */
+    int                       wscount;     /**< Size of workspace. */
+    int                       workspace[]; /**< The workspace. */
+};
+typedef struct pcre_dfa_buffer_t pcre_dfa_buffer_t;
+
+/**
+ * Most free DFA buffers a thread cache keeps.
+ */
+#define DFA_BUFFER_CACHE_MAX 64
+
+/**
+ * Per-thread cache of pcre runtime resources.
+ *
+ * Only the owning thread accesses a cache, so it needs no locking.  JIT
+ * stacks and phase DFA workspaces are only used for the length of a single
+ * match, so they are used directly from the cache.  Streaming DFA
+ * workspaces live for a transaction and are taken from and returned to the
+ * cache of the thread at hand.
+ *
+ * PCRE2 match data and the match context are reused the same way; the
+ * context carries the JIT stack, and the limits of the pattern at hand are
+ * set on it before each match.
+ */
+struct pcre_thread_cache_t {
+    pcre_jit_stack    *stack;       /**< JIT stack; may be NULL. */
+    ib_num_t           stack_start; /**< Start size @ref stack is for. */
+    ib_num_t           stack_max;   /**< Max size @ref stack is for. */
+    pcre_dfa_buffer_t *scratch;     /**< Workspace for phase DFA rules. */
+    pcre_dfa_buffer_t *buffers;     /**< Free buffers for streaming DFA. */
+    size_t             num_buffers; /**< Number of buffers in @ref buffers. */
+#ifdef HAVE_PCRE2
+    pcre2_match_data    *match_data;   /**< PCRE2 match data; MATCH_MAX. */
+    pcre2_match_context *mcontext;     /**< PCRE2 match context. */
+    pcre2_jit_stack     *stack2;       /**< PCRE2 JIT stack; may be NULL. */
+    ib_num_t             stack2_start; /**< Start size @ref stack2 is for. */
+    ib_num_t             stack2_max;   /**< Max size @ref stack2 is for. */
+#endif
+};
+typedef struct pcre_thread_cache_t pcre_thread_cache_t;
+
+/** Cache of the calling thread. */
+static __thread pcre_thread_cache_t *s_thread_cache = NULL;
+/** Key to release caches when their threads exit. */
+static pthread_key_t s_thread_cache_key;
+/** Guard for creating @ref s_thread_cache_key. */
+static pthread_once_t s_thread_cache_once = PTHREAD_ONCE_INIT;
+/** Was @ref s_thread_cache_key created successfully? */
+static bool s_thread_cache_key_ok = false;
+
 /* State information for a PCRE work common to all pcre operators in a tx. */
 struct pcre_tx_data_t {
-    pcre_jit_stack *stack;
-    ib_hash_t      *dfa_workspace_hash;
-    int            *ovector;    /** Array of N matches that is 3 * N long. */
-    int             ovector_sz; /* The size of ovector. 3 * N. */
+    dfa_workspace_t   **dfa_workspaces;     /**< Indexed by operator slot. */
+    size_t              num_dfa_workspaces; /**< Size of dfa_workspaces. */
+    pcre_dfa_buffer_t  *buffers;            /**< Buffers to return. */
 };
 typedef struct pcre_tx_data_t pcre_tx_data_t;
 
+/**
+ * Destroy a thread cache.  Called at thread exit.
+ *
+ * @param[in] data The @ref pcre_thread_cache_t.
+ */
+static void pcre_thread_cache_destroy(void *data)
+{
+    pcre_thread_cache_t *cache = (pcre_thread_cache_t *)data;
+
+    if (cache == NULL) {
+        return;
+    }
+
 #ifdef PCRE_HAVE_JIT
-static void pcre_jit_stack_cleanup(void *stack) {
-    assert(stack != NULL);
-    pcre_jit_stack_free((pcre_jit_stack *)stack);
+    if (cache->stack != NULL) {
+        pcre_jit_stack_free(cache->stack);
+    }
+#endif
+#ifdef HAVE_PCRE2
+    if (cache->match_data != NULL) {
+        pcre2_match_data_free(cache->match_data);
+    }
+    if (cache->mcontext != NULL) {
+        pcre2_match_context_free(cache->mcontext);
+    }
+    if (cache->stack2 != NULL) {
+        pcre2_jit_stack_free(cache->stack2);
+    }
+#endif
+    free(cache->scratch);
+    while (cache->buffers != NULL) {
+        pcre_dfa_buffer_t *next = cache->buffers->next;
+        free(cache->buffers);
+        cache->buffers = next;
+    }
+
+    free(cache);
+    s_thread_cache = NULL;
+}
+
+/**
+ * Create @ref s_thread_cache_key.  Called once.
+ */
+static void pcre_thread_cache_key_create(void)
+{
+    s_thread_cache_key_ok = (
+        pthread_key_create(&s_thread_cache_key, pcre_thread_cache_destroy)
+        == 0
+    );
 }
+
+/**
+ * Get the cache of the calling thread, creating it if needed.
+ *
+ * @returns Cache or NULL if one could not be created.
+ */
+static pcre_thread_cache_t *pcre_thread_cache_get(void)
+{
+    pcre_thread_cache_t *cache = s_thread_cache;
+
+    if (cache != NULL) {
+        return cache;
+    }
+
+    pthread_once(&s_thread_cache_once, pcre_thread_cache_key_create);
+    if (! s_thread_cache_key_ok) {
+        return NULL;
+    }
+
+    /* Zeroed, a cache holds no stack, as if allocated for size 0. */
+    cache = calloc(1, sizeof(*cache));
+    if (cache == NULL) {
+        return NULL;
+    }
+    if (pthread_setspecific(s_thread_cache_key, cache) != 0) {
+        free(cache);
+        return NULL;
+    }
+
+    s_thread_cache = cache;
+    return cache;
+}
+
+/**
+ * Get the JIT stack of the calling thread for the given sizes.
+ *
+ * The stack is reallocated if it was made for different sizes.
+ *
+ * @param[in] start Starting JIT stack size.
+ * @param[in] max   Max JIT stack size.
+ *
+ * @returns JIT stack or NULL if none could be allocated.
+ */
+static pcre_jit_stack *pcre_thread_jit_stack(ib_num_t start, ib_num_t max)
+{
+#ifdef PCRE_HAVE_JIT
+    pcre_thread_cache_t *cache = pcre_thread_cache_get();
+
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    if (cache->stack_start != start || cache->stack_max != max) {
+        if (cache->stack != NULL) {
+            pcre_jit_stack_free(cache->stack);
+        }
+        /* A NULL stack is not fatal; JIT falls back to the call stack.
+         * Remember the sizes anyway so we do not retry on every match. */
+        cache->stack       = pcre_jit_stack_alloc(start, max);
+        cache->stack_start = start;
+        cache->stack_max   = max;
+    }
+
+    return cache->stack;
+#else
+    return NULL;
 #endif
+}
+
+#ifdef HAVE_PCRE2
+/**
+ * Get the cache of the calling thread with its PCRE2 match data and
+ * match context created.
+ *
+ * @returns Cache or NULL if one could not be created.
+ */
+static pcre_thread_cache_t *pcre2_thread_cache_get(void)
+{
+    pcre_thread_cache_t *cache = pcre_thread_cache_get();
+
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    if (cache->match_data == NULL) {
+        cache->match_data = pcre2_match_data_create(MATCH_MAX, NULL);
+        if (cache->match_data == NULL) {
+            return NULL;
+        }
+    }
+    if (cache->mcontext == NULL) {
+        cache->mcontext = pcre2_match_context_create(NULL);
+        if (cache->mcontext == NULL) {
+            return NULL;
+        }
+    }
+
+    return cache;
+}
+
+/**
+ * Assign a PCRE2 JIT stack of the given sizes to the match context of
+ * @a cache.
+ *
+ * The stack is reallocated if it was made for different sizes.  If none
+ * can be allocated, JIT falls back to the call stack.
+ *
+ * @param[in] cache Cache from pcre2_thread_cache_get().
+ * @param[in] start Starting JIT stack size.
+ * @param[in] max   Max JIT stack size.
+ */
+static void pcre2_thread_jit_stack(
+    pcre_thread_cache_t *cache,
+    ib_num_t             start,
+    ib_num_t             max
+)
+{
+    assert(cache != NULL);
+    assert(cache->mcontext != NULL);
+
+    if (cache->stack2_start == start && cache->stack2_max == max) {
+        return;
+    }
+
+    if (cache->stack2 != NULL) {
+        pcre2_jit_stack_free(cache->stack2);
+    }
+    cache->stack2       = pcre2_jit_stack_create(start, max, NULL);
+    cache->stack2_start = start;
+    cache->stack2_max   = max;
+
+    /* A NULL stack assigns the default, call stack based, one. */
+    pcre2_jit_stack_assign(cache->mcontext, NULL, cache->stack2);
+}
+#endif /* HAVE_PCRE2 */
+
+/**
+ * Get the phase DFA workspace of the calling thread.
+ *
+ * @param[in] wscount Minimum size of workspace.
+ *
+ * @returns Buffer or NULL on allocation failure.
+ */
+static pcre_dfa_buffer_t *pcre_thread_dfa_scratch(int wscount)
+{
+    pcre_thread_cache_t *cache = pcre_thread_cache_get();
+
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    if (cache->scratch == NULL || cache->scratch->wscount < wscount) {
+        free(cache->scratch);
+        cache->scratch = malloc(
+            sizeof(*cache->scratch) + sizeof(int) * wscount
+        );
+        if (cache->scratch == NULL) {
+            return NULL;
+        }
+        cache->scratch->next    = NULL;
+        cache->scratch->wscount = wscount;
+    }
+
+    return cache->scratch;
+}
+
+/**
+ * Take a streaming DFA workspace buffer from the calling thread's cache.
+ *
+ * @param[in] wscount Minimum size of workspace.
+ *
+ * @returns Buffer or NULL on allocation failure.
+ */
+static pcre_dfa_buffer_t *pcre_dfa_buffer_take(int wscount)
+{
+    pcre_thread_cache_t *cache = pcre_thread_cache_get();
+    pcre_dfa_buffer_t   *buffer;
+
+    if (cache != NULL) {
+        for (
+            pcre_dfa_buffer_t **link = &cache->buffers;
+            *link != NULL;
+            link = &(*link)->next
+        ) {
+            if ((*link)->wscount >= wscount) {
+                buffer = *link;
+                *link = buffer->next;
+                --cache->num_buffers;
+                buffer->next = NULL;
+                return buffer;
+            }
+        }
+    }
+
+    buffer = malloc(sizeof(*buffer) + sizeof(int) * wscount);
+    if (buffer == NULL) {
+        return NULL;
+    }
+    buffer->next    = NULL;
+    buffer->wscount = wscount;
+
+    return buffer;
+}
+
+/**
+ * Return the buffers of a transaction to the calling thread's cache.
+ *
+ * Registered as a transaction memory cleanup function.
+ *
+ * @param[in] data The @ref pcre_tx_data_t.
+ */
+static void pcre_tx_data_cleanup(void *data)
+{
+    assert(data != NULL);
+
+    pcre_tx_data_t      *tx_data = (pcre_tx_data_t *)data;
+    pcre_thread_cache_t *cache   = pcre_thread_cache_get();
+
+    while (tx_data->buffers != NULL) {
+        pcre_dfa_buffer_t *buffer = tx_data->buffers;
+        tx_data->buffers = buffer->next;
+
+        if (cache != NULL && cache->num_buffers < DFA_BUFFER_CACHE_MAX) {
+            buffer->next = cache->buffers;
+            cache->buffers = buffer;
+            ++cache->num_buffers;
+        }
+        else {
+            free(buffer);
+        }
+    }
+}
 
 
 /**
@@ -218,15 +584,12 @@ static void pcre_log_tx(
 #define pcre_log_debug(tx, ...) pcre_log_tx(tx, IB_LOG_DEBUG, __FILE__, __func__, __LINE__, __VA_ARGS__)
 
 /**
- * Get or create an ib_hash_t inside of @c tx for storing dfa rule data.
- *
- * The hash is stored at the key @c HASH_NAME_STR.
+ * Get or create the pcre data of @a tx.
  *
  * @param[in] m  PCRE module.
  * @param[in] tx The transaction containing @c tx->data which holds
  *            the @a operator_data object.
- * @param[out] hash The fetched or created rule data hash. This is set
- *             to NULL on failure.
+ * @param[out] data The fetched or created data.
  *
  * @return
  *   - IB_OK on success.
@@ -244,84 +607,21 @@ ib_status_t get_or_create_operator_data(
     ib_status_t     rc;
     pcre_tx_data_t *data_tmp;
 
-    /* Get or create the hash that contains the rule data. */
     rc = ib_tx_get_module_data(tx, m, data);
     if ( (rc == IB_OK) && (*data != NULL) ) {
         return IB_OK;
     }
 
-    data_tmp = ib_mm_alloc(tx->mm, sizeof(*data_tmp));
+    /* Workspaces are allocated on first use of each DFA operator. */
+    data_tmp = ib_mm_calloc(tx->mm, 1, sizeof(*data_tmp));
     if (data_tmp == NULL) {
         return IB_EALLOC;
     }
 
-    /* Create the DFA Hash. */
-    {
-        rc = ib_hash_create(&data_tmp->dfa_workspace_hash, tx->mm);
-        if (rc != IB_OK) {
-            return rc;
-        }
-
-        rc = ib_tx_set_module_data(tx, m, data_tmp);
-        if (rc != IB_OK) {
-            return rc;
-        }
-    }
-
-    /* Create capture buffer that DFA and PCRE may use. */
-    {
-        /* We could statically allocate this but it is "cheap" to leave
-         * dynamic and allows us to tweak match size later.
-         * For now it remains at 10. */
-        data_tmp->ovector_sz = 10 * 3;
-        data_tmp->ovector = (int *)ib_mm_alloc(
-            tx->mm,
-            data_tmp->ovector_sz*sizeof(*data_tmp->ovector)
-        );
-
-        if (data_tmp->ovector == NULL) {
-            return IB_EALLOC;
-        }
-    }
-
-    /* Initialize the PCRE JIT Stack for the TX. */
-#ifdef PCRE_HAVE_JIT
-    {
-        modpcre_cfg_t  *config;
-
-        rc = ib_context_module_config(tx->ctx, m, &config);
-        if (rc != IB_OK) {
-            ib_log_error_tx(tx, "Cannot fetch module config for pcre.");
-            return rc;
-        }
-
-        data_tmp->stack = pcre_jit_stack_alloc(
-            config->jit_stack_start,
-            config->jit_stack_max
-        );
-        /* A null stack is extremely unexpected, but not fatal.
-         * JIT can use a callstack in a threadsafe way. */
-        if (data_tmp->stack == NULL) {
-            ib_log_info_tx(
-                tx,
-                "Could not allocate a pcre JIT stack: min=%d max=%d",
-                (int)config->jit_stack_start,
-                (int)config->jit_stack_max
-            );
-        }
-        else {
-            rc = ib_mm_register_cleanup(
-                tx->mm,
-                pcre_jit_stack_cleanup,
-                data_tmp->stack
-            );
-            if (rc != IB_OK) {
-                pcre_jit_stack_free(data_tmp->stack);
-                return rc;
-            }
-        }
+    rc = ib_tx_set_module_data(tx, m, data_tmp);
+    if (rc != IB_OK) {
+        return rc;
     }
-#endif
 
     *data = data_tmp;
 
@@ -381,6 +681,113 @@ static ib_status_t compile_pattern(
     return IB_OK;
 }
 
+#ifdef HAVE_PCRE2
+/**
+ * Free a PCRE2 compiled pattern; a memory manager cleanup function.
+ */
+static void pcre2_code_free_wrapper(void *code)
+{
+    pcre2_code_free((pcre2_code *)code);
+}
+
+/**
+ * Compile @a patt with PCRE2 into @a cpdata.
+ *
+ * PCRE2 studies every pattern, so @ref modpcre_cfg_t::study is ignored.
+ * The match limits are recorded in @a cpdata and set on the match context
+ * of each match.
+ *
+ * @param[in] ib IronBee engine for logging.
+ * @param[in] mm The memory manager to allocate memory out of.
+ * @param[in] config Module configuration
+ * @param[in] is_dfa Set to true for DFA
+ * @param[in,out] cpdata Compiled pattern data to fill in.
+ * @param[in] patt The uncompiled pattern to match.
+ * @param[out] errptr Pointer to an error message describing the failure.
+ * @param[out] erroffset The location of the error, if there is one.
+ *
+ * @returns IB_OK on success, IB_EALLOC or IB_EINVAL on failure.
+ */
+static ib_status_t pcre2_compile_internal(
+    ib_engine_t          *ib,
+    ib_mm_t               mm,
+    const modpcre_cfg_t  *config,
+    bool                  is_dfa,
+    modpcre_cpat_data_t  *cpdata,
+    const char           *patt,
+    const char          **errptr,
+    int                  *erroffset
+)
+{
+    /* Same flags as compile_pattern(). */
+    const uint32_t compile_flags = PCRE2_DOTALL | PCRE2_DOLLAR_ENDONLY;
+    const size_t   message_size  = 256;
+
+    pcre2_code *code;
+    int         errorcode;
+    PCRE2_SIZE  offset;
+    bool        use_jit = (config->use_jit != 0) && ! is_dfa;
+
+    code = pcre2_compile(
+        (PCRE2_SPTR)patt, PCRE2_ZERO_TERMINATED,
+        compile_flags,
+        &errorcode, &offset,
+        NULL
+    );
+    if (code == NULL) {
+        char *message = ib_mm_alloc(mm, message_size);
+        if (message == NULL) {
+            return IB_EALLOC;
+        }
+        pcre2_get_error_message(errorcode, (PCRE2_UCHAR *)message,
+                                message_size);
+        *errptr    = message;
+        *erroffset = (int)offset;
+        ib_log_error(ib, "Error compiling PCRE2 pattern \"%s\": %s at offset %d",
+                     patt, *errptr, *erroffset);
+        return IB_EINVAL;
+    }
+    ib_mm_register_cleanup(mm, pcre2_code_free_wrapper, code);
+
+    if (use_jit && pcre2_jit_compile(code, PCRE2_JIT_COMPLETE) != 0) {
+        ib_log_info(ib, "PCRE2-JIT compiler does not support: %s", patt);
+        ib_log_info(ib, "Falling back to normal PCRE2");
+        use_jit = false;
+    }
+
+    cpdata->patt = ib_mm_strdup(mm, patt);
+    if (cpdata->patt == NULL) {
+        ib_log_error(ib, "Failed to duplicate pattern string: %s", patt);
+        return IB_EALLOC;
+    }
+
+    cpdata->code2  = code;
+    cpdata->is_dfa = is_dfa;
+    cpdata->is_jit = use_jit;
+    if (is_dfa) {
+        cpdata->dfa_ws_size = (int)config->dfa_workspace_size;
+    }
+    else {
+        cpdata->match_limit = (uint32_t)config->match_limit;
+        cpdata->depth_limit = (uint32_t)config->match_limit_recursion;
+    }
+
+    ib_log_trace(ib,
+                 "Compiled PCRE2 pattern \"%s\": "
+                 "limit=%lu rlimit=%lu "
+                 "dfa=%s dfa-ws-sz=%d "
+                 "jit=%s",
+                 patt,
+                 (unsigned long)cpdata->match_limit,
+                 (unsigned long)cpdata->depth_limit,
+                 cpdata->is_dfa ? "yes" : "no",
+                 cpdata->dfa_ws_size,
+                 cpdata->is_jit ? "yes" : "no");
+
+    return IB_OK;
+}
+#endif /* HAVE_PCRE2 */
+
 /**
  * Internal compilation of the modpcre pattern.
  *
@@ -397,7 +804,6 @@ static ib_status_t compile_pattern(
  *          IB_EALLOC if memory allocation fails or IB_OK.
  */
 static ib_status_t pcre_compile_internal(
-    ib_module_t          *module,
     ib_engine_t          *ib,
     ib_mm_t               mm,
     const modpcre_cfg_t  *config,
@@ -443,7 +849,17 @@ static ib_status_t pcre_compile_internal(
         return IB_EALLOC;
     }
 
-    cpdata->module = module;
+#ifdef HAVE_PCRE2
+    if (config->engine == MODPCRE_ENGINE_PCRE2) {
+        ib_rc = pcre2_compile_internal(ib, mm, config, is_dfa, cpdata,
+                                       patt, errptr, erroffset);
+        if (ib_rc != IB_OK) {
+            return ib_rc;
+        }
+        *pcpdata = cpdata;
+        return IB_OK;
+    }
+#endif
 
     /* Populate cpdata->cpatt and cpdata->patt. */
     ib_rc = compile_pattern(ib, cpdata, mm, patt, errptr, erroffset);
@@ -521,43 +937,353 @@ static ib_status_t pcre_compile_internal(
             ib_log_error(ib, "PCRE-JIT failed to get pcre_fullinfo");
             use_jit = false;
         }
-        /* The answer. JIT != 1, jit was not used. */
-        else if (pcre_jit_ret != 1) {
-            ib_log_info(ib, "PCRE-JIT compiler does not support: %s", patt);
-            use_jit = false;
+        /* The answer. JIT != 1, jit was not used. */
+        else if (pcre_jit_ret != 1) {
+            ib_log_info(ib, "PCRE-JIT compiler does not support: %s", patt);
+            use_jit = false;
+        }
+        else {
+            /* pcre_jit_ret == 1. Do nothing */
+        }
+    }
+
+    if (want_jit && !use_jit) {
+        ib_log_info(ib, "Falling back to normal PCRE");
+    }
+#endif /*PCRE_HAVE_JIT*/
+
+    cpdata->is_dfa = is_dfa;
+    cpdata->is_jit = use_jit;
+
+    /* Assert that in call cases:
+     *   - if this is not jit, we don't care about edata.
+     *   - if this *is* jit, edata must be defined.
+     */
+    assert((!cpdata->is_jit) || (cpdata->is_jit && cpdata->edata != NULL));
+
+    ib_log_trace(ib,
+                 "Compiled PCRE pattern \"%s\": "
+                 "limit=%ld rlimit=%ld "
+                 "dfa=%s dfa-ws-sz=%d "
+                 "jit=%s",
+                 patt,
+                 (cpdata->edata==NULL)? 0L : cpdata->edata->match_limit,
+                 (cpdata->edata==NULL)? 0L : cpdata->edata->match_limit_recursion,
+                 cpdata->is_dfa ? "yes" : "no",
+                 cpdata->dfa_ws_size,
+                 cpdata->is_jit ? "yes" : "no");
+    *pcpdata = cpdata;
+
+    return IB_OK;
+}
+
+/**
+ * Configuration a pattern is compiled with; part of a pattern cache key.
+ *
+ * Values that do not affect the compilation are zero, and the whole
+ * structure is zeroed first, so keys can be compared with memcmp().
+ */
+struct pcre_cache_params_t {
+    ib_num_t engine;                /**< modpcre_cfg_t::engine */
+    ib_num_t study;                 /**< modpcre_cfg_t::study */
+    ib_num_t use_jit;               /**< modpcre_cfg_t::use_jit */
+    ib_num_t match_limit;           /**< modpcre_cfg_t::match_limit */
+    ib_num_t match_limit_recursion; /**< See modpcre_cfg_t. */
+    ib_num_t dfa_workspace_size;    /**< See modpcre_cfg_t. */
+    ib_num_t is_dfa;                /**< Compiled for DFA? */
+};
+typedef struct pcre_cache_params_t pcre_cache_params_t;
+
+/**
+ * A compiled pattern in the pattern cache.
+ *
+ * Entries are shared by all contexts of all engines in the process.  Each
+ * operator or filter instance holds a reference, which a cleanup of its
+ * memory manager releases.  As an engine being reloaded is destroyed after
+ * its replacement is created, unchanged patterns survive reloads.
+ */
+struct pcre_cache_entry_t {
+    struct pcre_cache_entry_t *next;     /**< Next entry in bucket. */
+    uint32_t                   hash;     /**< Hash of params and pattern. */
+    pcre_cache_params_t        params;   /**< Compile configuration. */
+    size_t                     refcount; /**< Number of users. */
+    ib_mpool_lite_t           *mpl;      /**< Owns entry and compilation. */
+    const modpcre_cpat_data_t *cpdata;   /**< The compiled pattern. */
+};
+typedef struct pcre_cache_entry_t pcre_cache_entry_t;
+
+/**
+ * Initial number of buckets of the pattern cache.
+ */
+#define PCRE_CACHE_BUCKETS_MIN 1024
+
+/**
+ * The pattern cache; protected by @ref s_cache_lock.
+ */
+static struct {
+    pcre_cache_entry_t **buckets;     /**< Entry chains; NULL until used. */
+    size_t               num_buckets; /**< A power of 2. */
+    size_t               num_entries; /**< Number of entries. */
+} s_cache;
+
+/** Lock of @ref s_cache. */
+static pthread_mutex_t s_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Fill in the cache parameters of a pattern.
+ *
+ * @param[out] params Parameters.
+ * @param[in] config Module configuration.
+ * @param[in] is_dfa Compiled for DFA?
+ */
+static void pcre_cache_params(
+    pcre_cache_params_t *params,
+    const modpcre_cfg_t *config,
+    bool                 is_dfa
+)
+{
+    memset(params, 0, sizeof(*params));
+
+    params->engine  = config->engine;
+    params->study   = config->study;
+    params->use_jit = config->use_jit;
+    params->is_dfa  = is_dfa;
+    if (is_dfa) {
+        params->dfa_workspace_size = config->dfa_workspace_size;
+    }
+    else {
+        params->match_limit           = config->match_limit;
+        params->match_limit_recursion = config->match_limit_recursion;
+    }
+}
+
+/**
+ * Find a cache entry.  Call with @ref s_cache_lock held.
+ *
+ * @param[in] hash Hash of @a params and @a patt.
+ * @param[in] params Compile configuration.
+ * @param[in] patt Pattern.
+ *
+ * @returns Entry or NULL if there is none.
+ */
+static pcre_cache_entry_t *pcre_cache_find(
+    uint32_t                   hash,
+    const pcre_cache_params_t *params,
+    const char                *patt
+)
+{
+    pcre_cache_entry_t *entry;
+
+    if (s_cache.buckets == NULL) {
+        return NULL;
+    }
+
+    for (
+        entry = s_cache.buckets[hash & (s_cache.num_buckets - 1)];
+        entry != NULL;
+        entry = entry->next
+    ) {
+        if (
+            entry->hash == hash &&
+            memcmp(&entry->params, params, sizeof(*params)) == 0 &&
+            strcmp(entry->cpdata->patt, patt) == 0
+        ) {
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Add an entry to the cache.  Call with @ref s_cache_lock held.
+ *
+ * The bucket array is doubled when there are more entries than buckets.
+ * If it can not be, chains just get longer.
+ *
+ * @param[in] entry Entry to add.
+ *
+ * @returns IB_OK or IB_EALLOC if there is no bucket array at all.
+ */
+static ib_status_t pcre_cache_insert(pcre_cache_entry_t *entry)
+{
+    pcre_cache_entry_t **buckets;
+    size_t num_buckets;
+    size_t bucket;
+
+    if (s_cache.buckets == NULL || s_cache.num_entries >= s_cache.num_buckets) {
+        num_buckets = (s_cache.buckets == NULL) ?
+            PCRE_CACHE_BUCKETS_MIN : s_cache.num_buckets * 2;
+        buckets = calloc(num_buckets, sizeof(*buckets));
+        if (buckets == NULL) {
+            if (s_cache.buckets == NULL) {
+                return IB_EALLOC;
+            }
+        }
+        else {
+            for (size_t i = 0; i < s_cache.num_buckets; ++i) {
+                while (s_cache.buckets[i] != NULL) {
+                    pcre_cache_entry_t *moved = s_cache.buckets[i];
+                    s_cache.buckets[i] = moved->next;
+                    bucket = moved->hash & (num_buckets - 1);
+                    moved->next = buckets[bucket];
+                    buckets[bucket] = moved;
+                }
+            }
+            free(s_cache.buckets);
+            s_cache.buckets     = buckets;
+            s_cache.num_buckets = num_buckets;
+        }
+    }
+
+    bucket = entry->hash & (s_cache.num_buckets - 1);
+    entry->next = s_cache.buckets[bucket];
+    s_cache.buckets[bucket] = entry;
+    ++s_cache.num_entries;
+
+    return IB_OK;
+}
+
+/**
+ * Release a reference to a cache entry; a memory manager cleanup function.
+ *
+ * The last reference removes the entry and frees the compilation.
+ *
+ * @param[in] data The @ref pcre_cache_entry_t.
+ */
+static void pcre_cache_release(void *data)
+{
+    pcre_cache_entry_t  *entry = (pcre_cache_entry_t *)data;
+    pcre_cache_entry_t **link;
+
+    pthread_mutex_lock(&s_cache_lock);
+    assert(entry->refcount > 0);
+    --entry->refcount;
+    if (entry->refcount > 0) {
+        pthread_mutex_unlock(&s_cache_lock);
+        return;
+    }
+
+    link = &s_cache.buckets[entry->hash & (s_cache.num_buckets - 1)];
+    while (*link != entry) {
+        link = &(*link)->next;
+    }
+    *link = entry->next;
+    --s_cache.num_entries;
+    pthread_mutex_unlock(&s_cache_lock);
+
+    /* Frees the entry, too. */
+    ib_mpool_lite_destroy(entry->mpl);
+}
+
+/**
+ * Compile a pattern through the process-wide pattern cache.
+ *
+ * Patterns are looked up by pattern text and the configuration values
+ * that affect compilation (see @ref pcre_cache_params_t).  A miss compiles
+ * the pattern with pcre_compile_internal() into memory owned by the cache,
+ * outside of the cache lock.  The returned compilation is shared and
+ * read-only; it lives until @a mm is destroyed.
+ *
+ * Arguments and return values are the same as pcre_compile_internal().
+ */
+static ib_status_t pcre_compile_cached(
+    ib_engine_t                 *ib,
+    ib_mm_t                      mm,
+    const modpcre_cfg_t         *config,
+    bool                         is_dfa,
+    const modpcre_cpat_data_t  **pcpdata,
+    const char                  *patt,
+    const char                 **errptr,
+    int                         *erroffset
+)
+{
+    assert(ib != NULL);
+    assert(config != NULL);
+    assert(pcpdata != NULL);
+    assert(patt != NULL);
+
+    pcre_cache_params_t  params;
+    pcre_cache_entry_t  *entry;
+    pcre_cache_entry_t  *found;
+    modpcre_cpat_data_t *cpdata;
+    ib_mpool_lite_t     *mpl;
+    uint32_t             hash;
+    ib_status_t          rc;
+
+    *errptr = NULL;
+
+    pcre_cache_params(&params, config, is_dfa);
+    hash = ib_hashfunc_djb2((const char *)&params, sizeof(params), 0, NULL);
+    hash = ib_hashfunc_djb2(patt, strlen(patt), hash, NULL);
+
+    pthread_mutex_lock(&s_cache_lock);
+    entry = pcre_cache_find(hash, &params, patt);
+    if (entry != NULL) {
+        ++entry->refcount;
+    }
+    pthread_mutex_unlock(&s_cache_lock);
+
+    if (entry == NULL) {
+        rc = ib_mpool_lite_create(&mpl);
+        if (rc != IB_OK) {
+            return rc;
+        }
+
+        rc = pcre_compile_internal(ib, ib_mm_mpool_lite(mpl), config, is_dfa,
+                                   &cpdata, patt, errptr, erroffset);
+        if (rc != IB_OK) {
+            /* The error message may live in mpl. */
+            if (*errptr != NULL) {
+                *errptr = ib_mm_strdup(mm, *errptr);
+            }
+            ib_mpool_lite_destroy(mpl);
+            return rc;
+        }
+
+        entry = ib_mpool_lite_alloc(mpl, sizeof(*entry));
+        if (entry == NULL) {
+            ib_mpool_lite_destroy(mpl);
+            return IB_EALLOC;
+        }
+        entry->next     = NULL;
+        entry->hash     = hash;
+        entry->params   = params;
+        entry->refcount = 1;
+        entry->mpl      = mpl;
+        entry->cpdata   = cpdata;
+
+        /* Another thread may have compiled the same pattern meanwhile. */
+        pthread_mutex_lock(&s_cache_lock);
+        found = pcre_cache_find(hash, &params, patt);
+        if (found != NULL) {
+            ++found->refcount;
+            rc = IB_OK;
         }
         else {
-            /* pcre_jit_ret == 1. Do nothing */
+            rc = pcre_cache_insert(entry);
         }
-    }
+        pthread_mutex_unlock(&s_cache_lock);
 
-    if (want_jit && !use_jit) {
-        ib_log_info(ib, "Falling back to normal PCRE");
+        if (found != NULL || rc != IB_OK) {
+            ib_mpool_lite_destroy(mpl);
+            entry = found;
+        }
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+    else {
+        ib_log_trace(ib, "Reusing compiled PCRE pattern \"%s\"", patt);
     }
-#endif /*PCRE_HAVE_JIT*/
-
-    cpdata->is_dfa = is_dfa;
-    cpdata->is_jit = use_jit;
-
-    /* Assert that in call cases:
-     *   - if this is not jit, we don't care about edata.
-     *   - if this *is* jit, edata must be defined.
-     */
-    assert((!cpdata->is_jit) || (cpdata->is_jit && cpdata->edata != NULL));
 
-    ib_log_trace(ib,
-                 "Compiled PCRE pattern \"%s\": "
-                 "limit=%ld rlimit=%ld "
-                 "dfa=%s dfa-ws-sz=%d "
-                 "jit=%s",
-                 patt,
-                 (cpdata->edata==NULL)? 0L : cpdata->edata->match_limit,
-                 (cpdata->edata==NULL)? 0L : cpdata->edata->match_limit_recursion,
-                 cpdata->is_dfa ? "yes" : "no",
-                 cpdata->dfa_ws_size,
-                 cpdata->is_jit ? "yes" : "no");
-    *pcpdata = cpdata;
+    rc = ib_mm_register_cleanup(mm, pcre_cache_release, entry);
+    if (rc != IB_OK) {
+        pcre_cache_release(entry);
+        return rc;
+    }
 
+    *pcpdata = entry->cpdata;
     return IB_OK;
 }
 
@@ -589,7 +1315,7 @@ ib_status_t pcre_operator_create(
     ib_engine_t *ib = ib_context_get_engine(ctx);
     assert(ib != NULL);
 
-    modpcre_cpat_data_t *cpdata = NULL;
+    const modpcre_cpat_data_t *cpdata = NULL;
     modpcre_operator_data_t *operator_data = NULL;
     ib_module_t *module;
     modpcre_cfg_t *config;
@@ -620,15 +1346,14 @@ ib_status_t pcre_operator_create(
 
     /* Compile the pattern.  Note that the rule data is an alias for
      * the compiled pattern type */
-    rc = pcre_compile_internal(module,
-                               ib,
-                               mm,
-                               config,
-                               false,
-                               &cpdata,
-                               parameters,
-                               &errptr,
-                               &erroffset);
+    rc = pcre_compile_cached(ib,
+                             mm,
+                             config,
+                             false,
+                             &cpdata,
+                             parameters,
+                             &errptr,
+                             &erroffset);
     if (rc != IB_OK) {
         return rc;
     }
@@ -639,7 +1364,7 @@ ib_status_t pcre_operator_create(
         return IB_EALLOC;
     }
     operator_data->cpdata = cpdata;
-    operator_data->id = NULL;           /* Not needed for rx rules */
+    operator_data->slot = 0;            /* Not needed for rx rules */
 
     /* Rule data is an alias for the compiled pattern data */
     *(modpcre_operator_data_t **)instance_data = operator_data;
@@ -749,7 +1474,6 @@ struct dfa_workspace_t {
      */
     const char *partial;
 };
-typedef struct dfa_workspace_t dfa_workspace_t;
 
 /**
  * Append the range @a ovector[0] to @a ovector[1] into @a operator_data.
@@ -956,8 +1680,100 @@ ib_status_t pcre_dfa_set_match(
     return IB_OK;
 }
 
+#ifdef HAVE_PCRE2
+/**
+ * Translate the PCRE options this module uses to PCRE2 options.
+ *
+ * @param[in] options PCRE options; only PCRE_PARTIAL_SOFT and
+ *            PCRE_DFA_RESTART are supported.
+ *
+ * @returns PCRE2 options.
+ */
+static uint32_t pcre2_options(int options)
+{
+    uint32_t options2 = 0;
+
+    if (options & PCRE_PARTIAL_SOFT) {
+        options2 |= PCRE2_PARTIAL_SOFT;
+    }
+    if (options & PCRE_DFA_RESTART) {
+        options2 |= PCRE2_DFA_RESTART;
+    }
+
+    return options2;
+}
+
+/**
+ * Convert the result of a PCRE2 match to what PCRE would have returned.
+ *
+ * Offsets are copied from @a match_data into @a ovector, as far as it
+ * holds them, and PCRE2 error codes are mapped to PCRE ones.
+ *
+ * @param[in] match_data Match data of the match.
+ * @param[in] rc Return code of the match.
+ * @param[out] ovector PCRE style offset vector.  May be NULL.
+ * @param[in] ovecsize Size of @a ovector.
+ *
+ * @returns @a rc as PCRE would have returned it.
+ */
+static int pcre2_convert_result(
+    pcre2_match_data *match_data,
+    int               rc,
+    int              *ovector,
+    int               ovecsize
+)
+{
+    if (rc >= 0 || rc == PCRE2_ERROR_PARTIAL) {
+        const PCRE2_SIZE *ovector2 = pcre2_get_ovector_pointer(match_data);
+        int pairs;
+
+        if (rc == PCRE2_ERROR_PARTIAL) {
+            pairs = 1;
+        }
+        else if (rc == 0) {
+            /* Too many matches; all pairs are in use. */
+            pairs = (int)pcre2_get_ovector_count(match_data);
+        }
+        else {
+            pairs = rc;
+        }
+        if (pairs > ovecsize / 2) {
+            pairs = ovecsize / 2;
+        }
+
+        for (int i = 0; i < pairs * 2; ++i) {
+            ovector[i] = (ovector2[i] == PCRE2_UNSET) ? -1 : (int)ovector2[i];
+        }
+
+        return (rc == PCRE2_ERROR_PARTIAL) ? PCRE_ERROR_PARTIAL : rc;
+    }
+
+    switch (rc) {
+    case PCRE2_ERROR_NOMATCH:
+        return PCRE_ERROR_NOMATCH;
+    case PCRE2_ERROR_MATCHLIMIT:
+        return PCRE_ERROR_MATCHLIMIT;
+    case PCRE2_ERROR_DEPTHLIMIT:
+        return PCRE_ERROR_RECURSIONLIMIT;
+    case PCRE2_ERROR_NOMEMORY:
+    case PCRE2_ERROR_HEAPLIMIT:
+        return PCRE_ERROR_NOMEMORY;
+    case PCRE2_ERROR_DFA_WSSIZE:
+        return PCRE_ERROR_DFA_WSSIZE;
+    case PCRE2_ERROR_DFA_RECURSE:
+        return PCRE_ERROR_DFA_RECURSE;
+#ifdef PCRE_ERROR_JIT_STACKLIMIT
+    case PCRE2_ERROR_JIT_STACKLIMIT:
+        return PCRE_ERROR_JIT_STACKLIMIT;
+#endif
+    default:
+        return PCRE_ERROR_INTERNAL;
+    }
+}
+#endif /* HAVE_PCRE2 */
+
 /**
- * Internal method to call pcre_jit_exec() or pcre_exec().
+ * Internal method to run a non-DFA match.
  *
  * The arguments are *almost* the same as pcre_exec() except
  * the first two are replaced with this module's
@@ -969,9 +1785,14 @@ ib_status_t pcre_dfa_set_match(
  * HAVE_PCRE_JIT_EXEC are defined, then pcre_jit_exec() is used
  * to evaluate the pattern.
  *
+ * PCRE2 patterns are matched with the match data and match context of the
+ * calling thread; pcre2_jit_match() is used for JIT compiled ones.  The
+ * result is converted to what pcre_exec() would have returned.
+ *
  * @param[in] cpdata Module struct holding the patter, extra data and
  *            the is_jit boolean.
- * @param[in] stack JIT execution stack. May be NULL to disable jit exec.
+ * @param[in] stack_start Starting JIT stack size. Only used for JIT.
+ * @param[in] stack_max Max JIT stack size. Only used for JIT.
  * @param[in] subject Same as pcre_exec().
  * @param[in] length Same as pcre_exec().
  * @param[in] startoffset Same as pcre_exec().
@@ -987,7 +1808,8 @@ ib_status_t pcre_dfa_set_match(
  */
 static int pcre_exec_internal(
     const modpcre_cpat_data_t *cpdata,
-    pcre_jit_stack            *stack,
+    ib_num_t                   stack_start,
+    ib_num_t                   stack_max,
     const char                *subject,
     int                        length,
     int                        startoffset,
@@ -996,9 +1818,50 @@ static int pcre_exec_internal(
     int                        ovecsize
 )
 {
+#ifdef HAVE_PCRE2
+    if (cpdata->code2 != NULL) {
+        pcre_thread_cache_t *cache = pcre2_thread_cache_get();
+        int rc;
+
+        if (cache == NULL) {
+            return PCRE_ERROR_NOMEMORY;
+        }
+
+        pcre2_set_match_limit(cache->mcontext, cpdata->match_limit);
+        pcre2_set_depth_limit(cache->mcontext, cpdata->depth_limit);
+
+        if (cpdata->is_jit) {
+            pcre2_thread_jit_stack(cache, stack_start, stack_max);
+            rc = pcre2_jit_match(
+                cpdata->code2,
+                (PCRE2_SPTR)subject, length, startoffset,
+                pcre2_options(options),
+                cache->match_data,
+                cache->mcontext
+            );
+        }
+        else {
+            rc = pcre2_match(
+                cpdata->code2,
+                (PCRE2_SPTR)subject, length, startoffset,
+                pcre2_options(options),
+                cache->match_data,
+                cache->mcontext
+            );
+        }
+
+        return pcre2_convert_result(cache->match_data, rc, ovector, ovecsize);
+    }
+#endif /* HAVE_PCRE2 */
+
 #ifdef PCRE_HAVE_JIT
 #ifdef HAVE_PCRE_JIT_EXEC
-    if (cpdata->is_jit && stack != NULL) {
+    pcre_jit_stack *stack = NULL;
+
+    if (cpdata->is_jit) {
+        stack = pcre_thread_jit_stack(stack_start, stack_max);
+    }
+    if (stack != NULL) {
         return pcre_jit_exec(
             cpdata->cpatt,
             cpdata->edata,
@@ -1028,6 +1891,76 @@ static int pcre_exec_internal(
     }
 }
 
+/**
+ * Internal method to run a DFA match.
+ *
+ * The arguments are the same as pcre_dfa_exec() except the first two are
+ * replaced with this module's @ref modpcre_cpat_data_t data.  PCRE2
+ * patterns are matched with pcre2_dfa_match() and the match data of the
+ * calling thread; the result is converted to what pcre_dfa_exec() would
+ * have returned.
+ *
+ * @param[in] cpdata Compiled pattern data.
+ * @param[in] subject Same as pcre_dfa_exec().
+ * @param[in] length Same as pcre_dfa_exec().
+ * @param[in] startoffset Same as pcre_dfa_exec().
+ * @param[in] options Same as pcre_dfa_exec().
+ * @param[out] ovector Same as pcre_dfa_exec().
+ * @param[in] ovecsize Same as pcre_dfa_exec().
+ * @param[in,out] workspace Same as pcre_dfa_exec().
+ * @param[in] wscount Same as pcre_dfa_exec().
+ *
+ * @returns the same value as pcre_dfa_exec().
+ */
+static int pcre_dfa_exec_internal(
+    const modpcre_cpat_data_t *cpdata,
+    const char                *subject,
+    int                        length,
+    int                        startoffset,
+    int                        options,
+    int                       *ovector,
+    int                        ovecsize,
+    int                       *workspace,
+    int                        wscount
+)
+{
+#ifdef HAVE_PCRE2
+    if (cpdata->code2 != NULL) {
+        pcre_thread_cache_t *cache = pcre2_thread_cache_get();
+        int rc;
+
+        if (cache == NULL) {
+            return PCRE_ERROR_NOMEMORY;
+        }
+
+        /* As with PCRE, DFA matches run without match limits. */
+        rc = pcre2_dfa_match(
+            cpdata->code2,
+            (PCRE2_SPTR)subject, length, startoffset,
+            pcre2_options(options),
+            cache->match_data,
+            NULL,
+            workspace, wscount
+        );
+
+        return pcre2_convert_result(cache->match_data, rc, ovector, ovecsize);
+    }
+#endif /* HAVE_PCRE2 */
+
+    return pcre_dfa_exec(
+        cpdata->cpatt,
+        cpdata->edata,
+        subject,
+        length,
+        startoffset,
+        options,
+        ovector,
+        ovecsize,
+        workspace,
+        wscount
+    );
+}
+
 
 /**
  * Return an error string that describes the failure.
@@ -1165,7 +2098,7 @@ const char* pcre_error_str(int rc)
  * @param[in] capture If non-NULL, the collection to capture to.
  * @param[out] result The result of the operator 1=true 0=false.
  * @param[in] instance_data Instance data needed for execution.
- * @param[in] cbdata Callback data.
+ * @param[in] cbdata Callback data. An @ref ib_module_t.
  *
  * @returns IB_OK most times. IB_EALLOC when a memory allocation error handles.
  */
@@ -1188,7 +2121,10 @@ static ib_status_t pcre_operator_execute(
     const ib_bytestr_t *bytestr;
     modpcre_operator_data_t *operator_data =
         (modpcre_operator_data_t *)instance_data;
-    pcre_tx_data_t *tx_data;
+    const modpcre_cfg_t *config;
+    ib_num_t stack_start = 0;
+    ib_num_t stack_max = 0;
+    int ovector[MATCH_MAX * 3];
 
 
     assert(operator_data->cpdata->is_dfa == false);
@@ -1227,29 +2163,35 @@ static ib_status_t pcre_operator_execute(
         subject = "";
     }
 
-    ib_rc = get_or_create_operator_data(
-        operator_data->cpdata->module,
-        tx,
-        &tx_data
-    );
-    if (ib_rc != IB_OK) {
-        return ib_rc;
+    if (operator_data->cpdata->is_jit) {
+        ib_rc = ib_context_module_config(
+            tx->ctx,
+            (const ib_module_t *)cbdata,
+            &config
+        );
+        if (ib_rc != IB_OK) {
+            ib_log_error_tx(tx, "Cannot fetch module config for pcre.");
+            return ib_rc;
+        }
+        stack_start = config->jit_stack_start;
+        stack_max   = config->jit_stack_max;
     }
 
     matches = pcre_exec_internal(
         operator_data->cpdata,
-        tx_data->stack,
+        stack_start,
+        stack_max,
         subject,
         subject_len,
         0, /* Starting offset. */
         0, /* Options. */
-        tx_data->ovector,
-        tx_data->ovector_sz
+        ovector,
+        sizeof(ovector) / sizeof(*ovector)
     );
 
     if (matches > 0) {
         if (capture != NULL) {
-            pcre_set_matches(tx, capture, tx_data->ovector, matches, subject);
+            pcre_set_matches(tx, capture, ovector, matches, subject);
         }
         ib_rc = IB_OK;
         *result = 1;
@@ -1274,50 +2216,14 @@ static ib_status_t pcre_operator_execute(
 }
 
 /**
- * Set the ID of a DFA rule.
- *
- * @param[in] mm Memory manager to use for allocations.
- * @param[in,out] operator_data DFA rule object to store ID into.
- *
- * @returns
- *   - IB_OK on success.
- *   - IB_EALLOC on memory failure.
- */
-static
-ib_status_t dfa_id_set(
-    ib_mm_t                  mm,
-    modpcre_operator_data_t *operator_data
-)
-{
-    assert(operator_data != NULL);
-
-    /* We compute the length of the string buffer as such:
-     * +2 for the 0x prefix.
-     * +1 for the \0 string terminations.
-     * +16 for encoding 8 bytes (64 bits) as hex-pairs (2 chars / byte).
-     */
-    size_t id_sz = 16 + 2 + 1;
-    char *id;
-    id = ib_mm_alloc(mm, id_sz+1);
-    if (id == NULL) {
-        return IB_EALLOC;
-    }
-
-    snprintf(id, id_sz, "%p", operator_data);
-    operator_data->id = id;
-
-    return IB_OK;
-}
-
-/**
- * Create the PCRE operator.
+ * Create the DFA operator.
  *
  * @param[in] ctx Current context.
  * @param[in] mm Memory manager.
  * @param[in] parameters Unparsed string with the parameters to
  *                       initialize the operator instance.
  * @param[out] instance_data Instance data.
- * @param[in] cbdata Callback data.
+ * @param[in] cbdata Callback data.  A @ref modpcre_runtime_t.
  *
  * @returns IB_OK on success or IB_EALLOC on any other type of error.
  */
@@ -1333,17 +2239,19 @@ ib_status_t dfa_operator_create(
     assert(ctx           != NULL);
     assert(parameters    != NULL);
     assert(instance_data != NULL);
+    assert(cbdata        != NULL);
 
     ib_engine_t *ib   = ib_context_get_engine(ctx);
     assert(ib != NULL);
 
-    modpcre_cpat_data_t     *cpdata;
-    modpcre_operator_data_t *operator_data;
-    ib_module_t             *module;
-    modpcre_cfg_t           *config;
-    ib_status_t              rc;
-    const char              *errptr;
-    int                      erroffset;
+    modpcre_runtime_t         *runtime = (modpcre_runtime_t *)cbdata;
+    const modpcre_cpat_data_t *cpdata;
+    modpcre_operator_data_t   *operator_data;
+    ib_module_t               *module;
+    modpcre_cfg_t             *config;
+    ib_status_t                rc;
+    const char                *errptr;
+    int                        erroffset;
 
     /* Get my module object */
     rc = ib_engine_module_get(ib, MODULE_NAME_STR, &module);
@@ -1361,15 +2269,14 @@ ib_status_t dfa_operator_create(
         return rc;
     }
 
-    rc = pcre_compile_internal(module,
-                               ib,
-                               mm,
-                               config,
-                               true,
-                               &cpdata,
-                               parameters,
-                               &errptr,
-                               &erroffset);
+    rc = pcre_compile_cached(ib,
+                             mm,
+                             config,
+                             true,
+                             &cpdata,
+                             parameters,
+                             &errptr,
+                             &erroffset);
 
     if (rc != IB_OK) {
         ib_log_error(ib, "Error parsing DFA operator pattern \"%s\":%s",
@@ -1383,14 +2290,9 @@ ib_status_t dfa_operator_create(
         return IB_EALLOC;
     }
     operator_data->cpdata = cpdata;
-    rc = dfa_id_set(mm, operator_data);
-    if (rc != IB_OK) {
-        ib_log_error(ib, "Error creating ID for DFA: %s",
-                     ib_status_to_string(rc));
-        return rc;
-    }
-    ib_log_debug3(ib, "Compiled DFA id=\"%s\" operator pattern \"%s\"",
-                  operator_data->id, parameters);
+    operator_data->slot = ib_atomic_add(&runtime->num_dfa_slots, 1) - 1;
+    ib_log_debug3(ib, "Compiled DFA slot=%zd operator pattern \"%s\"",
+                  operator_data->slot, parameters);
 
     *(modpcre_operator_data_t **)instance_data = operator_data;
     return IB_OK;
@@ -1401,8 +2303,7 @@ ib_status_t dfa_operator_create(
  *
  * @param[in] data Previously created per-tx data.
  * @param[in,out] tx Transaction to store the value in.
- * @param[in] cpatt_data Compiled pattern data
- * @param[in] id The operator identifier used to get it's workspace.
+ * @param[in] slot The operator slot used to get it's workspace.
  * @param[out] workspace Created.
  *
  * @returns
@@ -1413,81 +2314,110 @@ static
 ib_status_t alloc_dfa_tx_data(
     pcre_tx_data_t             *data,
     ib_tx_t                    *tx,
-    const modpcre_cpat_data_t  *cpatt_data,
-    const char                 *id,
+    size_t                      slot,
     dfa_workspace_t           **workspace
 )
 {
     assert(data != NULL);
     assert(tx != NULL);
-    assert(id != NULL);
     assert(workspace != NULL);
 
-    ib_hash_t       *hash;
-    ib_status_t      rc;
     dfa_workspace_t *ws;
-    size_t           size;
 
     *workspace = NULL;
 
-    hash = data->dfa_workspace_hash;
+    /* Grow the slot array to cover all DFA operators created so far. */
+    if (slot >= data->num_dfa_workspaces) {
+        dfa_workspace_t **workspaces;
+        size_t            num = slot + 1;
+
+        if (num < 2 * data->num_dfa_workspaces) {
+            num = 2 * data->num_dfa_workspaces;
+        }
+        workspaces = ib_mm_calloc(tx->mm, num, sizeof(*workspaces));
+        if (workspaces == NULL) {
+            return IB_EALLOC;
+        }
+        if (data->num_dfa_workspaces > 0) {
+            memcpy(
+                workspaces,
+                data->dfa_workspaces,
+                data->num_dfa_workspaces * sizeof(*workspaces)
+            );
+        }
+        data->dfa_workspaces     = workspaces;
+        data->num_dfa_workspaces = num;
+    }
 
     ws = (dfa_workspace_t *)ib_mm_alloc(tx->mm, sizeof(*ws));
     if (ws == NULL) {
         return IB_EALLOC;
     }
 
+    /* The workspace itself is attached on first use; see
+     * dfa_operator_execute_common(). */
     ws->partial    = NULL;
     ws->partial_sz = 0;
     ws->options    = 0;
-    ws->wscount    = cpatt_data->dfa_ws_size;
-    size           = sizeof(*(ws->workspace)) * (ws->wscount);
-    ws->workspace  = (int *)ib_mm_alloc(tx->mm, size);
-    if (ws->workspace == NULL) {
-        return IB_EALLOC;
-    }
+    ws->wscount    = 0;
+    ws->workspace  = NULL;
 
-    rc = ib_hash_set(hash, id, ws);
-    if (rc != IB_OK) {
-        return rc;
-    }
+    data->dfa_workspaces[slot] = ws;
 
     *workspace = ws;
     return IB_OK;
 }
 
 /**
- * Return the per-transaction data for use with the dfa operator.
+ * Attach a workspace buffer for streaming to @a workspace.
+ *
+ * The buffer is taken from the thread cache and returned to it when
+ * @a tx is destroyed.
  *
- * @param[in] m PCRE module.
- * @param[in] tx Transaction to store the value in.
- * @param[in] id The operator identifier used to get it's workspace.
- * @param[out] workspace Retrieved.
+ * @param[in] data Per-tx data.
+ * @param[in] tx Transaction.
+ * @param[in] cpatt_data Compiled pattern data.
+ * @param[in,out] workspace Workspace to attach buffer to.
  *
  * @returns
  *   - IB_OK on success.
- *   - IB_ENOENT if the structure does not exist. Call alloc_dfa_tx_data then.
  *   - IB_EALLOC on an allocation error.
  */
 static
-ib_status_t get_dfa_tx_data(
-    pcre_tx_data_t     *tx_data,
-    const char         *id,
-    dfa_workspace_t   **workspace
+ib_status_t attach_dfa_stream_buffer(
+    pcre_tx_data_t             *data,
+    ib_tx_t                    *tx,
+    const modpcre_cpat_data_t  *cpatt_data,
+    dfa_workspace_t            *workspace
 )
 {
-    assert(tx_data != NULL);
-    assert(id != NULL);
+    assert(data != NULL);
+    assert(tx != NULL);
+    assert(cpatt_data != NULL);
     assert(workspace != NULL);
 
-    ib_status_t     rc;
+    pcre_dfa_buffer_t *buffer;
+    ib_status_t        rc;
 
-    rc = ib_hash_get(tx_data->dfa_workspace_hash, workspace, id);
-    if (rc != IB_OK) {
-        *workspace = NULL;
+    /* First buffer of the tx; arrange to return buffers at tx end. */
+    if (data->buffers == NULL) {
+        rc = ib_mm_register_cleanup(tx->mm, pcre_tx_data_cleanup, data);
+        if (rc != IB_OK) {
+            return rc;
+        }
     }
 
-    return rc;
+    buffer = pcre_dfa_buffer_take(cpatt_data->dfa_ws_size);
+    if (buffer == NULL) {
+        return IB_EALLOC;
+    }
+    buffer->next = data->buffers;
+    data->buffers = buffer;
+
+    workspace->workspace = buffer->workspace;
+    workspace->wscount   = cpatt_data->dfa_ws_size;
+
+    return IB_OK;
 }
 
 /**
@@ -1532,9 +2462,12 @@ static ib_status_t dfa_operator_execute_common(
     const ib_bytestr_t      *bytestr;
     pcre_tx_data_t          *tx_data;
     dfa_workspace_t         *dfa_workspace;
+    int                     *workspace;
+    int                      wscount;
     modpcre_operator_data_t *operator_data =
         (modpcre_operator_data_t *)instance_data;
-    const char              *id = operator_data->id;
+    const size_t             slot = operator_data->slot;
+    int                      ovector[MATCH_MAX * 3];
 
     assert(module != NULL);
     assert(operator_data->cpdata->is_dfa == true);
@@ -1578,16 +2511,20 @@ static ib_status_t dfa_operator_execute_common(
         return IB_OK;
     }
 
-    /* Get the per-tx-per-operator workspace data for this rule data id. */
-    ib_rc = get_dfa_tx_data(tx_data, id, &dfa_workspace);
-    if (is_phase && ib_rc == IB_OK) {
-        /* Phase rules always clear the restart flag on subsequent runs.
-         * NOTE: Phase rules do not need to have pcre_dfa_clear_partial()
-         *       called.
-         */
-        dfa_workspace->options &= (~PCRE_DFA_RESTART);
+    /* Get the per-tx-per-operator workspace data for this rule.  Slots
+     * index an array, so this is no hash lookup. */
+    dfa_workspace = (slot < tx_data->num_dfa_workspaces) ?
+        tx_data->dfa_workspaces[slot] : NULL;
+    if (dfa_workspace != NULL) {
+        if (is_phase) {
+            /* Phase rules always clear the restart flag on subsequent runs.
+             * NOTE: Phase rules do not need to have pcre_dfa_clear_partial()
+             *       called.
+             */
+            dfa_workspace->options &= (~PCRE_DFA_RESTART);
+        }
     }
-    else if (ib_rc == IB_ENOENT) {
+    else {
         /* First time we are called, clear the captures. */
         if (capture != NULL) {
             ib_rc = ib_capture_clear(capture);
@@ -1602,19 +2539,40 @@ static ib_status_t dfa_operator_execute_common(
         ib_rc = alloc_dfa_tx_data(
             tx_data,
             tx,
-            operator_data->cpdata,
-            id,
+            slot,
             &dfa_workspace);
         if (ib_rc != IB_OK) {
             return ib_rc;
         }
 
         dfa_workspace->options = PCRE_PARTIAL_SOFT;
+    }
 
+    /* Phase rules never restart a match, so they can share a workspace
+     * for the length of this call.  Streaming rules keep theirs for the
+     * rest of the transaction. */
+    if (is_phase) {
+        pcre_dfa_buffer_t *scratch =
+            pcre_thread_dfa_scratch(operator_data->cpdata->dfa_ws_size);
+        if (scratch == NULL) {
+            return IB_EALLOC;
+        }
+        workspace = scratch->workspace;
+        wscount   = operator_data->cpdata->dfa_ws_size;
     }
-    else if (ib_rc != IB_OK) {
-        /* Not ok, not ENOENT, then fail. */
-        return ib_rc;
+    else {
+        if (dfa_workspace->workspace == NULL) {
+            ib_rc = attach_dfa_stream_buffer(
+                tx_data,
+                tx,
+                operator_data->cpdata,
+                dfa_workspace);
+            if (ib_rc != IB_OK) {
+                return ib_rc;
+            }
+        }
+        workspace = dfa_workspace->workspace;
+        wscount   = dfa_workspace->wscount;
     }
 
     /* Used in situations of multiple matches.
@@ -1630,23 +2588,22 @@ static ib_status_t dfa_operator_execute_common(
      * If capturing is requested, and a match was found, this loop will
      * iterate more than once until no more matches are found. */
     do {
-        matches = pcre_dfa_exec(
-            operator_data->cpdata->cpatt,
-            operator_data->cpdata->edata,
+        matches = pcre_dfa_exec_internal(
+            operator_data->cpdata,
             subject,
             subject_len,
             start_offset, /* Starting offset. */
             dfa_workspace->options,
-            tx_data->ovector,
-            tx_data->ovector_sz,
-            dfa_workspace->workspace,
-            dfa_workspace->wscount);
+            ovector,
+            sizeof(ovector) / sizeof(*ovector),
+            workspace,
+            wscount);
 
         /* Check that we have matches. */
         if (matches >= 0) {
 
             /* Log if the match is zero length. */
-            if (tx_data->ovector[0] == tx_data->ovector[1]) {
+            if (ovector[0] == ovector[1]) {
                 pcre_log_debug(
                     tx,
                     "Match of zero length",
@@ -1694,12 +2651,12 @@ static ib_status_t dfa_operator_execute_common(
              * 2. We must record the captured values. */
             if (capture) {
 
-                start_offset = tx_data->ovector[1];
+                start_offset = ovector[1];
 
                 ib_rc = pcre_dfa_set_match(
                     tx,
                     capture,
-                    tx_data->ovector,
+                    ovector,
                     matches,
                     subject,
                     operator_data,
@@ -1723,7 +2680,7 @@ static ib_status_t dfa_operator_execute_common(
             /* Start recording into operator_data the buffer. */
             ib_rc = pcre_dfa_record_partial(
                 tx,
-                tx_data->ovector,
+                ovector,
                 subject,
                 dfa_workspace);
             if (ib_rc != IB_OK) {
@@ -1889,6 +2846,12 @@ static IB_CFGMAP_INIT_STRUCTURE(config_map) = {
         modpcre_cfg_t,
         dfa_workspace_size
     ),
+    IB_CFGMAP_INIT_ENTRY(
+        MODULE_NAME_STR ".engine",
+        IB_FTYPE_NUM,
+        modpcre_cfg_t,
+        engine
+    ),
     IB_CFGMAP_INIT_LAST
 };
 
@@ -2033,6 +2996,59 @@ static ib_status_t handle_directive_param(ib_cfgparser_t *cp,
     return IB_OK;
 }
 
+/**
+ * Handle the PcreEngine directive.
+ *
+ * @param cp Config parser
+ * @param name Directive name
+ * @param p1 Engine name: pcre or pcre2
+ * @param cbdata Callback data (ignored)
+ *
+ * @returns Status code
+ */
+static ib_status_t handle_directive_engine(ib_cfgparser_t *cp,
+                                           const char *name,
+                                           const char *p1,
+                                           void *cbdata)
+{
+    assert(cp != NULL);
+    assert(name != NULL);
+    assert(p1 != NULL);
+    assert(cp->ib != NULL);
+
+    ib_engine_t *ib = cp->ib;
+    ib_status_t rc;
+    ib_context_t *ctx = cp->cur_ctx ? cp->cur_ctx : ib_context_main(ib);
+    const char *pname = MODULE_NAME_STR ".engine";
+    ib_num_t value;
+
+    if (strcasecmp("pcre", p1) == 0) {
+        value = MODPCRE_ENGINE_PCRE;
+    }
+    else if (strcasecmp("pcre2", p1) == 0) {
+#ifdef HAVE_PCRE2
+        value = MODPCRE_ENGINE_PCRE2;
+#else
+        ib_cfg_log_warning(cp,
+                           "%s: PCRE2 support is not available; using pcre.",
+                           name);
+        value = MODPCRE_ENGINE_PCRE;
+#endif
+    }
+    else {
+        ib_cfg_log_error(cp, "Invalid value \"%s\" for \"%s\": "
+                         "must be pcre or pcre2.", p1, name);
+        return IB_EINVAL;
+    }
+
+    rc = ib_context_set_num(ctx, pname, value);
+    if (rc != IB_OK) {
+        ib_cfg_log_error(cp, "Error setting \"%s\" to %s for \"%s\": %s",
+                         pname, p1, name, ib_status_to_string(rc));
+    }
+    return IB_OK;
+}
+
 /**! Constant used as cbdata for value filters. */
 static const char *c_filter_rx_value = "FilterValue";
 /**! Constant used as cbdata for name filters. */
@@ -2047,7 +3063,7 @@ static const char *c_filter_rx_name = "FilterName";
  * @param[in] cbdata Module.
  * @return
  * - IB_OK on success.
- * - Any return of pcre_compile_internal().
+ * - Any return of pcre_compile_cached().
  **/
 static
 ib_status_t filter_rx_create(
@@ -2063,13 +3079,12 @@ ib_status_t filter_rx_create(
 
     ib_module_t *m = (ib_module_t *)cbdata;
     ib_engine_t *ib = m->ib;
-    modpcre_cpat_data_t *cpdata;
+    const modpcre_cpat_data_t *cpdata;
     const char *error;
     int error_offset;
     ib_status_t rc;
 
-    rc = pcre_compile_internal(
-        m,
+    rc = pcre_compile_cached(
         ib,
         mm,
         &modpcre_global_cfg,
@@ -2083,7 +3098,7 @@ ib_status_t filter_rx_create(
         return rc;
     }
 
-    *(modpcre_cpat_data_t **)instance_data = cpdata;
+    *(const modpcre_cpat_data_t **)instance_data = cpdata;
 
     return IB_OK;
 }
@@ -2122,7 +3137,6 @@ ib_status_t filter_rx_execute(
     ib_list_t *result;
     ib_field_t *result_field;
     ib_status_t rc;
-    pcre_jit_stack *stack;
     const ib_list_node_t *node;
     const modpcre_cpat_data_t *cpdata =
         (const modpcre_cpat_data_t *)instance_data;
@@ -2146,27 +3160,6 @@ ib_status_t filter_rx_execute(
         return rc;
     }
 
-#ifdef PCRE_HAVE_JIT
-    if (cpdata->is_jit) {
-
-        assert(cpdata->edata != NULL);
-
-        stack = pcre_jit_stack_alloc(32*1024, 1000*1024);
-
-        if (stack != NULL) {
-            rc = ib_mm_register_cleanup(mm, pcre_jit_stack_cleanup, stack);
-            if (rc != IB_OK) {
-                pcre_jit_stack_free(stack);
-                return rc;
-            }
-        }
-    }
-    else
-#endif
-    {
-        stack = NULL;
-    }
-
     rc = ib_list_create(&result, mm);
     if (rc != IB_OK) {
         return rc;
@@ -2203,7 +3196,8 @@ ib_status_t filter_rx_execute(
 
         pcre_rc = pcre_exec_internal(
             cpdata,
-            stack,
+            32 * 1024,
+            1000 * 1024,
             subject, subject_len,
             0, 0,
             NULL, 0
@@ -2274,6 +3268,11 @@ static IB_DIRMAP_INIT_STRUCTURE(directive_map) = {
         handle_directive_param,
         NULL
     ),
+    IB_DIRMAP_INIT_PARAM1(
+        "PcreEngine",
+        handle_directive_engine,
+        NULL
+    ),
     IB_DIRMAP_INIT_LAST
 };
 
@@ -2285,13 +3284,19 @@ static ib_status_t modpcre_init(ib_engine_t *ib,
     assert(m != NULL);
 
     ib_status_t rc;
+    modpcre_runtime_t *runtime;
+
+    runtime = ib_mm_calloc(ib_engine_mm_main_get(ib), 1, sizeof(*runtime));
+    if (runtime == NULL) {
+        return IB_EALLOC;
+    }
 
     /* Register operators. */
     rc = ib_operator_create_and_register(
         NULL,
         ib,
         "pcre",
-        IB_OP_CAPABILITY_CAPTURE,
+        IB_OP_CAPABILITY_CAPTURE | IB_OP_CAPABILITY_THREAD_SAFE_CREATE,
         pcre_operator_create, NULL,
         NULL, NULL,
         pcre_operator_execute, m
@@ -2305,7 +3310,7 @@ static ib_status_t modpcre_init(ib_engine_t *ib,
         NULL,
         ib,
         "rx",
-        IB_OP_CAPABILITY_CAPTURE,
+        IB_OP_CAPABILITY_CAPTURE | IB_OP_CAPABILITY_THREAD_SAFE_CREATE,
         pcre_operator_create, NULL,
         NULL, NULL,
         pcre_operator_execute, m
@@ -2319,8 +3324,8 @@ static ib_status_t modpcre_init(ib_engine_t *ib,
         NULL,
         ib,
         "dfa",
-        IB_OP_CAPABILITY_CAPTURE,
-        dfa_operator_create, NULL,
+        IB_OP_CAPABILITY_CAPTURE | IB_OP_CAPABILITY_THREAD_SAFE_CREATE,
+        dfa_operator_create, runtime,
         NULL, NULL,
         dfa_phase_operator_execute, m
     );
@@ -2331,8 +3336,8 @@ static ib_status_t modpcre_init(ib_engine_t *ib,
         NULL,
         ib,
         "dfa",
-        IB_OP_CAPABILITY_CAPTURE,
-        dfa_operator_create, NULL,
+        IB_OP_CAPABILITY_CAPTURE | IB_OP_CAPABILITY_THREAD_SAFE_CREATE,
+        dfa_operator_create, runtime,
         NULL, NULL,
         dfa_stream_operator_execute, m
     );
@@ -28,7 +28,9 @@
 #include <ironbee/engine.h>
 #include <ironbee/json.h>
 #include <ironbee/kvstore.h>
+#include <ironbee/kvstore_cache.h>
 #include <ironbee/kvstore_filesystem.h>
+#include <ironbee/kvstore_log.h>
 #include <ironbee/list.h>
 #include <ironbee/mm.h>
 #include <ironbee/module.h>
@@ -48,6 +50,7 @@
 static const ib_num_t DEFAULT_EXPIRATION = 60;
 
 static const char FILE_URI_PREFIX[] = "persist-fs://";
+static const char LOG_URI_PREFIX[] = "persist-log://";
 static const char JSON_TYPE[] = "application_json";
 
 /* Define the module name as well as a string version of it. */
@@ -67,6 +70,9 @@ typedef struct persist_cfg_t persist_cfg_t;
 //! File store type.
 static const char FILE_TYPE[] = "filerw";
 
+//! Log-structured file store type.
+static const char LOG_TYPE[] = "logrw";
+
 /**
  * Implementation instance data of a file read-write.
  */
@@ -103,6 +109,24 @@ static const char * get_val(const char *config, const char *opt)
     return NULL;
 }
 
+/**
+ * Return the store type for @a uri.
+ *
+ * @param[in] uri Store URI.
+ *
+ * @returns @ref LOG_TYPE for `persist-log://` URIs; @ref FILE_TYPE otherwise.
+ */
+static const char *store_type(const char *uri)
+{
+    assert(uri != NULL);
+
+    if (strncmp(uri, LOG_URI_PREFIX, sizeof(LOG_URI_PREFIX)-1) == 0) {
+        return LOG_TYPE;
+    }
+
+    return FILE_TYPE;
+}
+
 /**
  * Create a new store and store it in @a impl.
  *
@@ -128,11 +152,16 @@ ib_status_t file_rw_create_fn(
     assert(params != NULL);
     assert(impl != NULL);
 
-    ib_mm_t               mm = ib_engine_mm_main_get(ib);
-    const ib_list_node_t *node;
-    const char           *uri;
-    file_rw_t            *file_rw;
-    ib_status_t           rc;
+    ib_mm_t                  mm = ib_engine_mm_main_get(ib);
+    const ib_list_node_t    *node;
+    const char              *uri;
+    file_rw_t               *file_rw;
+    ib_kvstore_t            *kvstore;
+    ib_num_t                 cache_size = 0;
+    ib_num_t                 cache_max_age = 0;
+    ib_num_t                 cache_flush_interval = -1;
+    ib_kvstore_cache_mode_t  cache_mode = IB_KVSTORE_CACHE_WRITE_THROUGH;
+    ib_status_t              rc;
 
     file_rw = ib_mm_calloc(mm, 1, sizeof(*file_rw));
     if (file_rw == NULL) {
@@ -171,30 +200,125 @@ ib_status_t file_rw_create_fn(
                 ib_log_warning(ib, "Failed to copy key.");
                 return IB_EALLOC;
             }
+            continue;
+        }
+
+        val = get_val("cache=", opt);
+        if (val != NULL) {
+            rc = ib_type_atoi(val, 10, &cache_size);
+            if (rc != IB_OK || cache_size < 0) {
+                ib_log_error(ib, "Invalid cache size: %s", val);
+                return IB_EINVAL;
+            }
+            continue;
+        }
+
+        val = get_val("cache_max_age=", opt);
+        if (val != NULL) {
+            rc = ib_type_atoi(val, 10, &cache_max_age);
+            if (rc != IB_OK ||
+                cache_max_age < 0 ||
+                cache_max_age > INT64_MAX / 1000000)
+            {
+                ib_log_error(ib, "Invalid cache maximum age: %s", val);
+                return IB_EINVAL;
+            }
+            continue;
+        }
+
+        val = get_val("cache_flush_interval=", opt);
+        if (val != NULL) {
+            rc = ib_type_atoi(val, 10, &cache_flush_interval);
+            if (rc != IB_OK ||
+                cache_flush_interval < 0 ||
+                cache_flush_interval > INT64_MAX / 1000000)
+            {
+                ib_log_error(ib, "Invalid cache flush interval: %s", val);
+                return IB_EINVAL;
+            }
+            continue;
+        }
+
+        val = get_val("cache_mode=", opt);
+        if (val != NULL) {
+            if (strcmp(val, "write-through") == 0) {
+                cache_mode = IB_KVSTORE_CACHE_WRITE_THROUGH;
+            }
+            else if (strcmp(val, "write-behind") == 0) {
+                cache_mode = IB_KVSTORE_CACHE_WRITE_BEHIND;
+            }
+            else {
+                ib_log_error(ib, "Invalid cache mode: %s", val);
+                return IB_EINVAL;
+            }
+            continue;
         }
     }
 
-    file_rw->kvstore = ib_mm_alloc(mm, ib_kvstore_size());
+    kvstore = ib_mm_alloc(mm, ib_kvstore_size());
+    if (kvstore == NULL) {
+        return IB_EALLOC;
+    }
 
     if (strncmp(uri, FILE_URI_PREFIX, sizeof(FILE_URI_PREFIX)-1) == 0) {
         const char *dir = uri + sizeof(FILE_URI_PREFIX)-1;
         ib_log_debug(ib, "Creating key-value store in directory: %s", dir);
 
-        rc = ib_kvstore_filesystem_init(file_rw->kvstore, dir);
-        if (rc != IB_OK) {
-            ib_log_error(ib, "Failed to initialize kvstore.");
-            return rc;
+        rc = ib_kvstore_filesystem_init(kvstore, dir);
+    }
+    else if (strncmp(uri, LOG_URI_PREFIX, sizeof(LOG_URI_PREFIX)-1) == 0) {
+        const char *dir = uri + sizeof(LOG_URI_PREFIX)-1;
+        ib_log_debug(ib, "Creating key-value log in directory: %s", dir);
+
+        rc = ib_kvstore_log_init(kvstore, dir);
+    }
+    else {
+        ib_log_error(ib, "Unsupported URI: %s", uri);
+        return IB_EINVAL;
+    }
+    if (rc != IB_OK) {
+        ib_log_error(ib, "Failed to initialize kvstore.");
+        return rc;
+    }
+
+    /* Put a cache in front of the store. It owns the store from now on. */
+    if (cache_size > 0) {
+        file_rw->kvstore = ib_mm_alloc(mm, ib_kvstore_size());
+        if (file_rw->kvstore == NULL) {
+            ib_kvstore_destroy(kvstore);
+            return IB_EALLOC;
         }
 
-        rc = ib_kvstore_connect(file_rw->kvstore);
+        ib_log_debug(
+            ib,
+            "Caching up to %" PRId64 " bytes of key-value store %s.",
+            cache_size,
+            uri);
+        rc = ib_kvstore_cache_init(
+            file_rw->kvstore,
+            kvstore,
+            cache_size,
+            (ib_time_t)cache_max_age * 1000000,
+            cache_mode);
         if (rc != IB_OK) {
-            ib_log_error(ib, "Failed to connect to kvstore.");
+            ib_log_error(ib, "Failed to initialize kvstore cache.");
+            ib_kvstore_destroy(kvstore);
             return rc;
         }
+        if (cache_flush_interval >= 0) {
+            ib_kvstore_cache_flush_interval_set(
+                file_rw->kvstore,
+                (ib_time_t)cache_flush_interval * 1000000);
+        }
     }
     else {
-        ib_log_error(ib, "Unsupported URI: %s", uri);
-        return IB_EINVAL;
+        file_rw->kvstore = kvstore;
+    }
+
+    rc = ib_kvstore_connect(file_rw->kvstore);
+    if (rc != IB_OK) {
+        ib_log_error(ib, "Failed to connect to kvstore.");
+        return rc;
     }
 
     *(file_rw_t **)impl = file_rw;
@@ -220,6 +344,7 @@ static void file_rw_destroy_fn(
 static ib_status_t file_rw_load_fn(
     void       *impl,
     ib_tx_t    *tx,
+    ib_mm_t     mm,
     const char *key,
     size_t      key_len,
     ib_list_t  *list,
@@ -241,7 +366,7 @@ static ib_status_t file_rw_load_fn(
     assert(file_rw->kvstore != NULL);
     assert(ib != NULL);
 
-    rc = ib_kvstore_key_create(&kv_key, tx->mm, (const uint8_t *)key, key_len);
+    rc = ib_kvstore_key_create(&kv_key, mm, (const uint8_t *)key, key_len);
     if (rc != IB_OK) {
         return rc;
     }
@@ -250,7 +375,7 @@ static ib_status_t file_rw_load_fn(
     rc = ib_kvstore_get(
         file_rw->kvstore,
         NULL,
-        tx->mm,
+        mm,
         kv_key,
         &kv_val);
     if (rc != IB_OK) {
@@ -272,7 +397,6 @@ static ib_status_t file_rw_load_fn(
 
         /* Deserialize JSON. */
         const char *err_msg;
-        ib_mm_t mm = ib_engine_mm_main_get(ib);
 
         rc = ib_json_decode_ex(
             mm,
@@ -300,6 +424,7 @@ static ib_status_t file_rw_load_fn(
 static ib_status_t file_rw_store_fn(
     void            *impl,
     ib_tx_t         *tx,
+    ib_mm_t          mm,
     const char      *key,
     size_t           key_len,
     const ib_time_t  expiration,
@@ -311,7 +436,6 @@ static ib_status_t file_rw_store_fn(
 
     file_rw_t          *file_rw = (file_rw_t *)impl;
     ib_engine_t        *ib = file_rw->ib;
-    ib_mm_t             mm = tx->mm;
     ib_status_t         rc;
     ib_kvstore_key_t   *kv_key;
     ib_kvstore_value_t *kv_val;
@@ -364,6 +488,84 @@ static ib_status_t file_rw_store_fn(
     return IB_OK;
 }
 
+/**
+ * Configure write-behind batching of a store from its parameters.
+ *
+ * The options are @c write_behind=SECONDS, the longest a collection is
+ * queued before it is written, and @c merge=sum|replace.  Stores without
+ * @c write_behind are written by each transaction.
+ *
+ * @param[in] cp Configuration parser.
+ * @param[in] ctx Configuration context.
+ * @param[in] cfg Module configuration.
+ * @param[in] store_name The store name.
+ * @param[in] node The first option.
+ *
+ * @returns
+ *  - IB_OK On success.
+ *  - IB_EINVAL On an invalid option.
+ *  - Other on failure of ib_persist_fw_set_write_behind().
+ */
+static ib_status_t set_write_behind(
+    ib_cfgparser_t       *cp,
+    ib_context_t         *ctx,
+    persist_cfg_t        *cfg,
+    const char           *store_name,
+    const ib_list_node_t *node
+)
+{
+    assert(cp != NULL);
+    assert(ctx != NULL);
+    assert(cfg != NULL);
+    assert(store_name != NULL);
+
+    ib_num_t                  window   = -1;
+    ib_persist_fw_merge_fn_t  merge_fn = NULL;
+    ib_status_t               rc;
+
+    for ( ; node != NULL; node = ib_list_node_next_const(node)) {
+        const char *opt = (const char *)ib_list_node_data_const(node);
+        const char *val;
+
+        val = get_val("write_behind=", opt);
+        if (val != NULL) {
+            rc = ib_type_atoi(val, 10, &window);
+            if (rc != IB_OK || window < 0) {
+                ib_cfg_log_error(cp, "Invalid write-behind window: %s", val);
+                return IB_EINVAL;
+            }
+            continue;
+        }
+
+        val = get_val("merge=", opt);
+        if (val != NULL) {
+            if (strcmp(val, "sum") == 0) {
+                merge_fn = ib_persist_fw_merge_sum;
+            }
+            else if (strcmp(val, "replace") == 0) {
+                merge_fn = NULL;
+            }
+            else {
+                ib_cfg_log_error(cp, "Invalid merge: %s", val);
+                return IB_EINVAL;
+            }
+            continue;
+        }
+    }
+
+    if (window < 0) {
+        return IB_OK;
+    }
+
+    return ib_persist_fw_set_write_behind(
+        cfg->persist_fw,
+        ctx,
+        store_name,
+        window * 1000000,
+        merge_fn,
+        NULL);
+}
+
 /**
  * Create a persistence store that can be used to map a collection.
  */
@@ -421,12 +623,23 @@ static ib_status_t persistence_create_store_fn(
     rc = ib_persist_fw_create_store(
         cfg->persist_fw,
         ctx,
-        FILE_TYPE,
+        store_type(store_uri),
         store_name,
         vars);
     if (rc != IB_OK) {
         return rc;
     }
+
+    rc = set_write_behind(
+        cp,
+        ctx,
+        cfg,
+        store_name,
+        ib_list_node_next_const(node));
+    if (rc != IB_OK) {
+        return rc;
+    }
+
     return IB_OK;
 }
 
@@ -439,6 +652,7 @@ static ib_status_t persistence_create_store_fn(
  * @param[in] ctx Configuration context.
  * @param[in] cfg Module configuration.
  * @param[in] vars Parameter list.
+ * @param[in] uri Store URI.
  * @param[out] name The UUID of the store if it was created successfully.
  *             This value is a null-terminated string.
  *             This value is not set unless IB_OK is returned.
@@ -452,12 +666,14 @@ static ib_status_t create_anonymous_store(
     ib_context_t     *ctx,
     persist_cfg_t    *cfg,
     const ib_list_t  *vars,
+    const char       *uri,
     const char      **name
 )
 {
     assert(cp != NULL);
     assert(ctx != NULL);
     assert(cfg != NULL);
+    assert(uri != NULL);
     assert(name != NULL);
 
     ib_mm_t     mm         = cp->mm;
@@ -478,7 +694,7 @@ static ib_status_t create_anonymous_store(
     rc = ib_persist_fw_create_store(
         cfg->persist_fw,
         ctx,
-        FILE_TYPE,
+        store_type(uri),
         store_name,
         vars);
     if (rc != IB_OK) {
@@ -489,6 +705,18 @@ static ib_status_t create_anonymous_store(
         return rc;
     }
 
+    /* The options follow the collection and store names. */
+    rc = set_write_behind(
+        cp,
+        ctx,
+        cfg,
+        store_name,
+        ib_list_node_next_const(
+            ib_list_node_next_const(ib_list_first_const(vars))));
+    if (rc != IB_OK) {
+        return rc;
+    }
+
     *name = store_name;
     return IB_OK;
 }
@@ -584,6 +812,16 @@ static ib_status_t persistence_map_fn(
             continue;
         }
 
+        /* Store options are used if an anonymous store is created. */
+        if ( get_val("cache=", config_str) != NULL ||
+             get_val("cache_max_age=", config_str) != NULL ||
+             get_val("cache_mode=", config_str) != NULL ||
+             get_val("write_behind=", config_str) != NULL ||
+             get_val("merge=", config_str) != NULL )
+        {
+            continue;
+        }
+
         ib_cfg_log_warning(
             cp,
             "Unsupported configuration option for directive %s: %s",
@@ -613,7 +851,7 @@ static ib_status_t persistence_map_fn(
         store_name);
 
     /* Try to make an anonymous store (use a UUID as the name). */
-    rc = create_anonymous_store(cp, ctx, cfg, vars, &store_name);
+    rc = create_anonymous_store(cp, ctx, cfg, vars, store_name, &store_name);
     if (rc != IB_OK) {
         ib_cfg_log_error(
             cp,
@@ -746,6 +984,24 @@ static ib_status_t mod_persist_init(
         return rc;
     }
 
+    rc = ib_persist_fw_register_type(
+        cfg->persist_fw,
+        ib_context_main(ib),
+        LOG_TYPE,
+        file_rw_create_fn,
+        NULL,
+        file_rw_destroy_fn,
+        NULL,
+        file_rw_load_fn,
+        NULL,
+        file_rw_store_fn,
+        NULL
+    );
+    if (rc != IB_OK) {
+        ib_log_error(ib, "Failed to register log type.");
+        return rc;
+    }
+
     rc = register_directives(ib, cfg);
     if (rc != IB_OK) {
         ib_log_error(ib, "Failed to register directive.");
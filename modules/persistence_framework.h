@@ -65,17 +65,33 @@ typedef void (* ib_persist_fw_destroy_fn_t)(
     void *impl,
     void *cbdata
 );
+
+/**
+ * Load the collection stored at @a key into @a list.
+ *
+ * @a tx is NULL when called by the write-behind thread of a store.
+ * Fields are allocated from @a mm, which is @c tx->mm otherwise.
+ */
 typedef ib_status_t (* ib_persist_fw_load_fn_t)(
     void *impl,
     ib_tx_t *tx,
+    ib_mm_t mm,
     const char *key,
     size_t key_length,
     ib_list_t *list,
     void *cbdata
 );
+
+/**
+ * Store the collection @a list at @a key.
+ *
+ * @a tx is NULL when called by the write-behind thread of a store.
+ * Temporary data is allocated from @a mm, which is @c tx->mm otherwise.
+ */
 typedef ib_status_t (* ib_persist_fw_store_fn_t)(
     void *impl,
     ib_tx_t *tx,
+    ib_mm_t mm,
     const char *key,
     size_t key_length,
     ib_time_t expiration,
@@ -83,6 +99,32 @@ typedef ib_status_t (* ib_persist_fw_store_fn_t)(
     void *cbdata
 );
 
+/**
+ * Merge the changes a writer made to a collection into its current value.
+ *
+ * A writer loaded @a base and wants to store @a updated, but the
+ * collection has since become @a current.
+ *
+ * @param[in] mm Memory manager to allocate the fields of @a merged from.
+ * @param[in] base The collection as the writer loaded it.
+ * @param[in] current The current collection.
+ * @param[in] updated The collection as the writer would store it.
+ * @param[out] merged The fields to store are pushed onto this list.
+ * @param[in] cbdata Callback data.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - Other on error; @a updated is then stored as is.
+ */
+typedef ib_status_t (* ib_persist_fw_merge_fn_t)(
+    ib_mm_t          mm,
+    const ib_list_t *base,
+    const ib_list_t *current,
+    const ib_list_t *updated,
+    ib_list_t       *merged,
+    void            *cbdata
+);
+
 /**
  * Create a new persistence framework.
  * @param[in,out] ib The IronBee engine this persistence engine will be
@@ -193,6 +235,68 @@ ib_status_t DLL_PUBLIC ib_persist_fw_map_collection(
     const char      *store
 );
 
+/**
+ * Queue the collections written to a store and write them in batches.
+ *
+ * When a transaction stores a collection in @a store, the collection is
+ * queued instead.  Collections queued for a key are coalesced, and
+ * written by a background thread at most @a window after the first of
+ * them was queued; the thread is started by the first transaction that
+ * queues a collection.  Loads of a queued key return the queued
+ * collection.  Collections still queued are written when the store is
+ * destroyed.
+ *
+ * By default the last collection queued for a key is written.  If
+ * @a merge_fn is given, it merges each transaction's changes into the
+ * queued collection, and the changes of the queue are merged into the
+ * stored collection, which another process may have changed, when it is
+ * written.
+ *
+ * The load and store functions of the store type must accept a NULL
+ * transaction and be safe to call from another thread.
+ *
+ * @param[in] persist_fw The persistence instance.
+ * @param[in] ctx Configuration context the store is defined in.
+ * @param[in] store The store name.
+ * @param[in] window Maximum time, in useconds, a collection is queued.
+ * @param[in] merge_fn Merge function or NULL.
+ * @param[in] merge_data Callback data for @a merge_fn.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_ENOENT If @a store does not exist.
+ * - IB_EEXIST If @a store already has a write-behind queue.
+ * - Other on error.
+ */
+ib_status_t DLL_PUBLIC ib_persist_fw_set_write_behind(
+    ib_persist_fw_t          *persist_fw,
+    ib_context_t             *ctx,
+    const char               *store,
+    ib_time_t                 window,
+    ib_persist_fw_merge_fn_t  merge_fn,
+    void                     *merge_data
+);
+
+/**
+ * Merge function that adds up numeric fields.
+ *
+ * Each number and float in @a updated is stored as its value in
+ * @a current plus the writer's change, its value in @a updated minus its
+ * value in @a base.  Missing numbers count as zero.  Other fields of
+ * @a updated are stored as they are, and fields of @a current that the
+ * writer never saw are kept.
+ *
+ * This is a @ref ib_persist_fw_merge_fn_t; @a cbdata is unused.
+ */
+ib_status_t DLL_PUBLIC ib_persist_fw_merge_sum(
+    ib_mm_t          mm,
+    const ib_list_t *base,
+    const ib_list_t *current,
+    const ib_list_t *updated,
+    ib_list_t       *merged,
+    void            *cbdata
+);
+
 /**
  * @}
  */
@@ -186,6 +186,117 @@ static ib_status_t add_module_config(
 }
 
 
+/**
+ * Record the collection @a mapping loaded in @a tx.
+ *
+ * Stores with a write-behind queue merge what a transaction changed
+ * relative to what it loaded.  The loaded collections of all mappings are
+ * kept in a hash in the persistence framework module's transaction data,
+ * keyed by the mapping pointer.
+ *
+ * @param[in] persist_fw The persistence framework.
+ * @param[in] tx The transaction.
+ * @param[in] mapping The mapping @a list was loaded for.
+ * @param[in] list The loaded collection.  This is copied.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - Other on error.
+ */
+static
+ib_status_t save_base(
+    ib_persist_fw_t               *persist_fw,
+    ib_tx_t                       *tx,
+    const ib_persist_fw_mapping_t *mapping,
+    const ib_list_t               *list
+)
+{
+    assert(persist_fw != NULL);
+    assert(tx != NULL);
+    assert(mapping != NULL);
+    assert(list != NULL);
+
+    ib_hash_t   *bases = NULL;
+    ib_list_t   *base;
+    ib_status_t  rc;
+
+    rc = ib_tx_get_module_data(tx, persist_fw->persist_fw_module, &bases);
+    if (rc != IB_OK && rc != IB_ENOENT) {
+        return rc;
+    }
+    if (bases == NULL) {
+        rc = ib_hash_create(&bases, tx->mm);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        rc = ib_tx_set_module_data(tx, persist_fw->persist_fw_module, bases);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    rc = ib_list_create(&base, tx->mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_persist_fw_copy_fields(tx->mm, list, base);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    return ib_hash_set_ex(
+        bases,
+        (const char *)&mapping, sizeof(mapping),
+        base);
+}
+
+/**
+ * Find the collection recorded by save_base().
+ *
+ * @param[in] persist_fw The persistence framework.
+ * @param[in] tx The transaction.
+ * @param[in] mapping The mapping.
+ *
+ * @returns The loaded collection or NULL if none was loaded.
+ */
+static
+const ib_list_t *find_base(
+    ib_persist_fw_t               *persist_fw,
+    ib_tx_t                       *tx,
+    const ib_persist_fw_mapping_t *mapping
+)
+{
+    assert(persist_fw != NULL);
+    assert(tx != NULL);
+    assert(mapping != NULL);
+
+    ib_hash_t *bases = NULL;
+    ib_list_t *base  = NULL;
+
+    if (
+        ib_tx_get_module_data(
+            tx,
+            persist_fw->persist_fw_module,
+            &bases) != IB_OK ||
+        bases == NULL
+    )
+    {
+        return NULL;
+    }
+
+    if (
+        ib_hash_get_ex(
+            bases,
+            &base,
+            (const char *)&mapping, sizeof(mapping)) != IB_OK
+    )
+    {
+        return NULL;
+    }
+
+    return base;
+}
+
 /**
  * When a context is selected, populate the transaction from the handlers.
  *
@@ -280,15 +391,43 @@ ib_status_t populate_data_in_context(
                 continue;
             }
 
-            rc = store->handler->load_fn(
-                store->impl,
-                tx,
-                key, key_length,
-                list,
-                store->handler->load_data);
+            /* Collections waiting to be written are newer than the store. */
+            rc = IB_ENOENT;
+            if (store->queue != NULL) {
+                rc = ib_persist_fw_queue_load(
+                    store->queue,
+                    tx->mm,
+                    key, key_length,
+                    list);
+            }
+            if (rc == IB_ENOENT) {
+                rc = store->handler->load_fn(
+                    store->impl,
+                    tx,
+                    tx->mm,
+                    key, key_length,
+                    list,
+                    store->handler->load_data);
+            }
             if (rc != IB_OK) {
                 ib_log_debug(ib, "Failed to load collection %s", name);
             }
+            if ( (rc == IB_OK || rc == IB_ENOENT) && store->queue != NULL ) {
+                /* A missing collection is an empty base, so that values
+                 * written by others before the flush are merged with
+                 * rather than overwritten. */
+                if (rc == IB_ENOENT) {
+                    ib_list_clear(list);
+                }
+                rc = save_base(persist_fw, tx, mapping, list);
+                if (rc != IB_OK) {
+                    ib_log_warning(
+                        ib,
+                        "Failed to record loaded collection %s. "
+                        "It will not be merged when written.",
+                        name);
+                }
+            }
         }
     }
 
@@ -380,9 +519,25 @@ ib_status_t persist_data_in_context(
                 continue;
             }
 
+            if (store->queue != NULL) {
+                rc = ib_persist_fw_queue_store(
+                    store->queue,
+                    key, key_length, mapping->expiration,
+                    find_base(persist_fw, tx, mapping),
+                    list);
+                if (rc == IB_OK) {
+                    continue;
+                }
+                ib_log_warning(
+                    ib,
+                    "Failed to queue collection %s. Writing it now.",
+                    name);
+            }
+
             rc = store->handler->store_fn(
                 store->impl,
                 tx,
+                tx->mm,
                 key, key_length, mapping->expiration,
                 list,
                 store->handler->store_data);
@@ -446,6 +601,15 @@ ib_status_t destroy_stores(
 
         ib_hash_iterator_fetch(&key, &keysz, &store, itr);
 
+        /* Write queued collections while the store still exists. */
+        if ( (store != NULL) &&
+             (store->handler != NULL) &&
+             (store->queue != NULL) )
+        {
+            ib_persist_fw_queue_destroy(store->queue);
+            store->queue = NULL;
+        }
+
         /* When a store is destroyed, the handler is NULLed.
          * Check that this store is not destroyed. */
         if ( (store != NULL) &&
@@ -784,6 +948,7 @@ ib_status_t ib_persist_fw_create_store(
 
     store->handler = handler;
     store->impl = NULL;
+    store->queue = NULL;
     store->name = ib_mm_strdup(mm, name);
     if (store->name == NULL) {
         ib_log_error(ib, "Failed to copy store name %s", name);
@@ -817,3 +982,54 @@ ib_status_t ib_persist_fw_create_store(
 
     return IB_OK;
 }
+
+ib_status_t ib_persist_fw_set_write_behind(
+    ib_persist_fw_t          *persist_fw,
+    ib_context_t             *ctx,
+    const char               *name,
+    ib_time_t                 window,
+    ib_persist_fw_merge_fn_t  merge_fn,
+    void                     *merge_data
+)
+{
+    assert(persist_fw != NULL);
+    assert(persist_fw->ib != NULL);
+    assert(ctx != NULL);
+    assert(name != NULL);
+
+    ib_status_t            rc;
+    ib_engine_t           *ib = persist_fw->ib;
+    ib_persist_fw_cfg_t   *persist_fw_cfg = NULL;
+    ib_persist_fw_store_t *store = NULL;
+
+    rc = get_ctx_persist_fw(persist_fw, ctx, &persist_fw_cfg);
+    if (rc != IB_OK) {
+        ib_log_error(ib, "Failed to retrieve persistence store.");
+        return rc;
+    }
+
+    rc = ib_hash_get(persist_fw_cfg->stores, &store, name);
+    if (rc != IB_OK) {
+        ib_log_error(ib, "Store %s does not exist.", name);
+        return IB_ENOENT;
+    }
+
+    if (store->queue != NULL) {
+        ib_log_error(ib, "Store %s is already written behind.", name);
+        return IB_EEXIST;
+    }
+
+    rc = ib_persist_fw_queue_create(
+        ib,
+        store,
+        window,
+        merge_fn,
+        merge_data,
+        &(store->queue));
+    if (rc != IB_OK) {
+        ib_log_error(ib, "Failed to create write-behind queue for %s.", name);
+        return rc;
+    }
+
+    return IB_OK;
+}
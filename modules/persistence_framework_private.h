@@ -44,6 +44,13 @@
 extern "C" {
 #endif
 
+/**
+ * Write-behind queue of a store.
+ *
+ * @sa ib_persist_fw_set_write_behind()
+ */
+typedef struct ib_persist_fw_queue_t ib_persist_fw_queue_t;
+
 /**
  * This structure contains handlers for a particular type.
  *
@@ -87,6 +94,11 @@ struct ib_persist_fw_store_t {
      * by the load/store functions.
      */
     void                 *impl;
+
+    /**
+     * Write-behind queue, or NULL if stores are written immediately.
+     */
+    ib_persist_fw_queue_t *queue;
 };
 typedef struct ib_persist_fw_store_t ib_persist_fw_store_t;
 
@@ -196,6 +208,104 @@ ib_status_t ib_persist_fw_cfg_create(
     ib_persist_fw_cfg_t **persist_fw
 );
 
+/**
+ * Create a write-behind queue for @a store.
+ *
+ * @param[in] ib IronBee engine.
+ * @param[in] store The store to write to.
+ * @param[in] window Maximum time, in useconds, a collection is queued.
+ * @param[in] merge_fn Merge function or NULL.
+ * @param[in] merge_data Callback data for @a merge_fn.
+ * @param[out] queue The queue.  Destroy with ib_persist_fw_queue_destroy().
+ *
+ * @returns
+ * - IB_OK
+ * - IB_EALLOC
+ * - IB_EOTHER If a lock can not be created.
+ */
+ib_status_t ib_persist_fw_queue_create(
+    ib_engine_t               *ib,
+    ib_persist_fw_store_t     *store,
+    ib_time_t                  window,
+    ib_persist_fw_merge_fn_t   merge_fn,
+    void                      *merge_data,
+    ib_persist_fw_queue_t    **queue
+);
+
+/**
+ * Copy the collection queued at @a key into @a list.
+ *
+ * @param[in] queue The queue.
+ * @param[in] mm Memory manager to copy fields into.
+ * @param[in] key The key.
+ * @param[in] key_length Length of @a key.
+ * @param[in] list List to push the fields onto.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_ENOENT If nothing is queued at @a key.
+ * - Other on error.
+ */
+ib_status_t ib_persist_fw_queue_load(
+    ib_persist_fw_queue_t *queue,
+    ib_mm_t                mm,
+    const char            *key,
+    size_t                 key_length,
+    ib_list_t             *list
+);
+
+/**
+ * Queue @a list to be written at @a key.
+ *
+ * @param[in] queue The queue.
+ * @param[in] key The key.
+ * @param[in] key_length Length of @a key.
+ * @param[in] expiration Expiration, in useconds, to write with.
+ * @param[in] base The collection as the transaction loaded it, or NULL.
+ *            Without it, @a list replaces any queued collection.
+ * @param[in] list The collection to write.
+ *
+ * @returns
+ * - IB_OK On success.
+ * - IB_EOTHER If the write-behind thread can not be started.  Nothing
+ *   is queued; the caller should write @a list itself.
+ * - Other on error.
+ */
+ib_status_t ib_persist_fw_queue_store(
+    ib_persist_fw_queue_t *queue,
+    const char            *key,
+    size_t                 key_length,
+    ib_time_t              expiration,
+    const ib_list_t       *base,
+    const ib_list_t       *list
+);
+
+/**
+ * Stop the write-behind thread, write everything queued, and free @a queue.
+ *
+ * @param[in] queue The queue.
+ */
+void ib_persist_fw_queue_destroy(ib_persist_fw_queue_t *queue);
+
+/**
+ * Deep copy a list of fields.
+ *
+ * Dynamic fields are skipped.
+ *
+ * @param[in] mm Memory manager to copy fields into.
+ * @param[in] src Fields to copy.
+ * @param[in] dst List to push the copies onto.
+ *
+ * @returns
+ * - IB_OK
+ * - IB_EALLOC
+ */
+ib_status_t ib_persist_fw_copy_fields(
+    ib_mm_t          mm,
+    const ib_list_t *src,
+    ib_list_t       *dst
+);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,813 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee Engine --- Persistence Framework Write-Behind Queue
+ *
+ * Each queued key is a @ref pending_t, found through a hash and linked
+ * in the order it was first queued.  Since every key waits the same
+ * window, that is also the order they are due in.  The write-behind
+ * thread sleeps until the oldest key is due, then takes every due key
+ * out of the queue and writes them as one batch without holding the
+ * queue lock.
+ *
+ * The thread is started by the first store in a process, so that a
+ * server that forks after configuration gets a thread in each child.
+ */
+
+#include "persistence_framework_private.h"
+
+#include <ironbee/clock.h>
+#include <ironbee/engine.h>
+#include <ironbee/list.h>
+#include <ironbee/mm_mpool_lite.h>
+#include <ironbee/mpool_lite.h>
+
+#include <assert.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * A collection waiting to be written.
+ */
+typedef struct pending_t pending_t;
+struct pending_t {
+    ib_mpool_lite_t *mp;         /**< Holds this, the key and the base. */
+    ib_mpool_lite_t *value_mp;   /**< Holds the value; replaced by updates. */
+    const char      *key;        /**< Key. */
+    size_t           key_length; /**< Length of pending_t::key. */
+    ib_time_t        expiration; /**< Relative expiration to write with. */
+    ib_time_t        deadline;   /**< Absolute time it is due (usec). */
+    ib_list_t       *base;       /**< Collection first loaded, or NULL. */
+    ib_list_t       *value;      /**< Collection to write. */
+    pending_t       *next;       /**< Next in the order queued. */
+};
+
+struct ib_persist_fw_queue_t {
+    ib_engine_t              *ib;         /**< IronBee engine. */
+    ib_persist_fw_store_t    *store;      /**< Store written to. */
+    ib_time_t                 window;     /**< Maximum wait (usec). */
+    ib_persist_fw_merge_fn_t  merge_fn;   /**< Merge function or NULL. */
+    void                     *merge_data; /**< Callback data. */
+    pthread_mutex_t           lock;       /**< Protects the members below. */
+    pthread_cond_t            cond;       /**< Signals the thread. */
+    ib_mpool_lite_t          *mp;         /**< Holds pending. */
+    ib_hash_t                *pending;    /**< Key to pending_t. */
+    pending_t                *head;       /**< First queued. */
+    pending_t                *tail;       /**< Last queued. */
+    pthread_t                 thread;     /**< Write-behind thread. */
+    pid_t                     thread_pid; /**< Process of thread, or 0. */
+    bool                      stopping;   /**< The thread should exit. */
+    ib_persist_fw_queue_t    *next_queue; /**< Next in @ref g_queues. */
+};
+
+/**
+ * All queues, so that fork handlers can reach their locks.
+ *
+ * Protected by @ref g_queues_lock.
+ */
+static ib_persist_fw_queue_t *g_queues = NULL;
+
+/**
+ * Protects @ref g_queues.
+ */
+static pthread_mutex_t g_queues_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Registers the fork handlers once.
+ */
+static pthread_once_t g_queues_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Current time (usec).
+ */
+static ib_time_t now_time(void)
+{
+    ib_timeval_t tv;
+
+    ib_clock_gettimeofday(&tv);
+    return IB_CLOCK_TIMEVAL_TIME(tv);
+}
+
+/**
+ * Find the field named like @a field in @a list.
+ *
+ * @returns The field or NULL.
+ */
+static const ib_field_t *find_field(
+    const ib_list_t  *list,
+    const ib_field_t *field
+)
+{
+    const ib_list_node_t *node;
+
+    if (list == NULL) {
+        return NULL;
+    }
+
+    IB_LIST_LOOP_CONST(list, node) {
+        const ib_field_t *f = (const ib_field_t *)ib_list_node_data_const(node);
+
+        if ( (f->nlen == field->nlen) &&
+             (memcmp(f->name, field->name, f->nlen) == 0) )
+        {
+            return f;
+        }
+    }
+
+    return NULL;
+}
+
+ib_status_t ib_persist_fw_copy_fields(
+    ib_mm_t          mm,
+    const ib_list_t *src,
+    ib_list_t       *dst
+)
+{
+    assert(src != NULL);
+    assert(dst != NULL);
+
+    const ib_list_node_t *node;
+    ib_status_t           rc;
+
+    IB_LIST_LOOP_CONST(src, node) {
+        const ib_field_t *field =
+            (const ib_field_t *)ib_list_node_data_const(node);
+        ib_field_t       *copy;
+
+        if (ib_field_is_dynamic(field)) {
+            continue;
+        }
+
+        if (field->type == IB_FTYPE_LIST) {
+            const ib_list_t *sub;
+            ib_list_t       *sub_copy;
+
+            rc = ib_field_value(field, ib_ftype_list_out(&sub));
+            if (rc != IB_OK) {
+                return rc;
+            }
+            rc = ib_list_create(&sub_copy, mm);
+            if (rc != IB_OK) {
+                return rc;
+            }
+            rc = ib_persist_fw_copy_fields(mm, sub, sub_copy);
+            if (rc != IB_OK) {
+                return rc;
+            }
+            rc = ib_field_create(
+                &copy, mm,
+                field->name, field->nlen,
+                IB_FTYPE_LIST,
+                ib_ftype_list_in(sub_copy));
+        }
+        else {
+            rc = ib_field_copy(&copy, mm, field->name, field->nlen, field);
+        }
+        if (rc != IB_OK) {
+            return rc;
+        }
+
+        rc = ib_list_push(dst, copy);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    return IB_OK;
+}
+
+ib_status_t ib_persist_fw_merge_sum(
+    ib_mm_t          mm,
+    const ib_list_t *base,
+    const ib_list_t *current,
+    const ib_list_t *updated,
+    ib_list_t       *merged,
+    void            *cbdata
+)
+{
+    assert(base != NULL);
+    assert(current != NULL);
+    assert(updated != NULL);
+    assert(merged != NULL);
+
+    const ib_list_node_t *node;
+    ib_list_t            *others;
+    ib_status_t           rc;
+
+    IB_LIST_LOOP_CONST(updated, node) {
+        const ib_field_t *field =
+            (const ib_field_t *)ib_list_node_data_const(node);
+        const ib_field_t *base_field = find_field(base, field);
+        const ib_field_t *current_field = find_field(current, field);
+        ib_field_t       *sum;
+
+        if ( (field->type != IB_FTYPE_NUM && field->type != IB_FTYPE_FLOAT) ||
+             (base_field != NULL && base_field->type != field->type) ||
+             (current_field != NULL && current_field->type != field->type) )
+        {
+            continue;
+        }
+
+        if (field->type == IB_FTYPE_NUM) {
+            ib_num_t value;
+            ib_num_t base_value = 0;
+            ib_num_t current_value = 0;
+
+            rc = ib_field_value(field, ib_ftype_num_out(&value));
+            if (rc == IB_OK && base_field != NULL) {
+                rc = ib_field_value(base_field, ib_ftype_num_out(&base_value));
+            }
+            if (rc == IB_OK && current_field != NULL) {
+                rc = ib_field_value(
+                    current_field,
+                    ib_ftype_num_out(&current_value));
+            }
+            if (rc != IB_OK) {
+                return rc;
+            }
+            value = current_value + (value - base_value);
+            rc = ib_field_create(
+                &sum, mm,
+                field->name, field->nlen,
+                IB_FTYPE_NUM,
+                ib_ftype_num_in(&value));
+        }
+        else {
+            ib_float_t value;
+            ib_float_t base_value = 0;
+            ib_float_t current_value = 0;
+
+            rc = ib_field_value(field, ib_ftype_float_out(&value));
+            if (rc == IB_OK && base_field != NULL) {
+                rc = ib_field_value(
+                    base_field,
+                    ib_ftype_float_out(&base_value));
+            }
+            if (rc == IB_OK && current_field != NULL) {
+                rc = ib_field_value(
+                    current_field,
+                    ib_ftype_float_out(&current_value));
+            }
+            if (rc != IB_OK) {
+                return rc;
+            }
+            value = current_value + (value - base_value);
+            rc = ib_field_create(
+                &sum, mm,
+                field->name, field->nlen,
+                IB_FTYPE_FLOAT,
+                ib_ftype_float_in(&value));
+        }
+        if (rc != IB_OK) {
+            return rc;
+        }
+
+        rc = ib_list_push(merged, sum);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    /* Copy what was not summed: other fields of updated, and the fields of
+     * current that the writer neither saw nor stored. */
+    rc = ib_list_create(&others, mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    IB_LIST_LOOP_CONST(updated, node) {
+        const ib_field_t *field =
+            (const ib_field_t *)ib_list_node_data_const(node);
+        const ib_field_t *summed = find_field(merged, field);
+
+        if (summed == NULL) {
+            rc = ib_list_push(others, (void *)field);
+            if (rc != IB_OK) {
+                return rc;
+            }
+        }
+    }
+    IB_LIST_LOOP_CONST(current, node) {
+        const ib_field_t *field =
+            (const ib_field_t *)ib_list_node_data_const(node);
+
+        if ( (find_field(updated, field) == NULL) &&
+             (find_field(base, field) == NULL) )
+        {
+            rc = ib_list_push(others, (void *)field);
+            if (rc != IB_OK) {
+                return rc;
+            }
+        }
+    }
+
+    return ib_persist_fw_copy_fields(mm, others, merged);
+}
+
+/**
+ * Write @a pending to the store and free it.
+ *
+ * If the queue has a merge function, the queued changes are merged into
+ * the collection currently stored.
+ */
+static void pending_write(ib_persist_fw_queue_t *queue, pending_t *pending)
+{
+    ib_persist_fw_store_t   *store = queue->store;
+    ib_persist_fw_handler_t *handler = store->handler;
+    ib_mpool_lite_t         *mp;
+    ib_mm_t                  mm;
+    const ib_list_t         *list = pending->value;
+    ib_status_t              rc;
+
+    rc = ib_mpool_lite_create(&mp);
+    if (rc != IB_OK) {
+        ib_log_error(queue->ib, "Failed to write queued collections.");
+        goto finish;
+    }
+    mm = ib_mm_mpool_lite(mp);
+
+    if ( (queue->merge_fn != NULL) &&
+         (pending->base != NULL) &&
+         (handler->load_fn != NULL) )
+    {
+        ib_list_t *current;
+        ib_list_t *merged;
+
+        rc = ib_list_create(&current, mm);
+        if (rc == IB_OK) {
+            rc = ib_list_create(&merged, mm);
+        }
+        if (rc == IB_OK) {
+            rc = handler->load_fn(
+                store->impl,
+                NULL,
+                mm,
+                pending->key, pending->key_length,
+                current,
+                handler->load_data);
+            if (rc == IB_ENOENT) {
+                ib_list_clear(current);
+                rc = IB_OK;
+            }
+        }
+        if (rc == IB_OK) {
+            rc = queue->merge_fn(
+                mm,
+                pending->base, current, pending->value,
+                merged,
+                queue->merge_data);
+        }
+        if (rc == IB_OK) {
+            list = merged;
+        }
+        else {
+            ib_log_warning(
+                queue->ib,
+                "Failed to merge collection \"%.*s\" into store %s: %s",
+                (int)pending->key_length, pending->key,
+                store->name,
+                ib_status_to_string(rc));
+        }
+    }
+
+    rc = handler->store_fn(
+        store->impl,
+        NULL,
+        mm,
+        pending->key, pending->key_length,
+        pending->expiration,
+        list,
+        handler->store_data);
+    if (rc != IB_OK) {
+        ib_log_error(
+            queue->ib,
+            "Failed to write collection \"%.*s\" to store %s.",
+            (int)pending->key_length, pending->key,
+            store->name);
+    }
+
+    ib_mpool_lite_destroy(mp);
+
+finish:
+    ib_mpool_lite_destroy(pending->value_mp);
+    ib_mpool_lite_destroy(pending->mp);
+}
+
+/**
+ * Remove the first @a pending from the queue.
+ *
+ * The queue lock must be held.
+ */
+static void queue_pop(ib_persist_fw_queue_t *queue, pending_t *pending)
+{
+    assert(queue->head == pending);
+
+    ib_hash_remove_ex(
+        queue->pending, NULL,
+        pending->key, pending->key_length);
+    queue->head = pending->next;
+    if (queue->head == NULL) {
+        queue->tail = NULL;
+    }
+    pending->next = NULL;
+}
+
+/**
+ * Before fork(): hold every queue lock so none is held by another thread.
+ */
+static void queues_fork_prepare(void)
+{
+    ib_persist_fw_queue_t *queue;
+
+    pthread_mutex_lock(&g_queues_lock);
+    for (queue = g_queues; queue != NULL; queue = queue->next_queue) {
+        pthread_mutex_lock(&(queue->lock));
+    }
+}
+
+/**
+ * After fork() in the parent: release the locks taken before it.
+ */
+static void queues_fork_parent(void)
+{
+    ib_persist_fw_queue_t *queue;
+
+    for (queue = g_queues; queue != NULL; queue = queue->next_queue) {
+        pthread_mutex_unlock(&(queue->lock));
+    }
+    pthread_mutex_unlock(&g_queues_lock);
+}
+
+/**
+ * After fork() in the child: drop collections queued by the parent.
+ *
+ * The parent writes them.  The child has no write-behind thread; one is
+ * started by the next ib_persist_fw_queue_store().
+ */
+static void queues_fork_child(void)
+{
+    ib_persist_fw_queue_t *queue;
+
+    for (queue = g_queues; queue != NULL; queue = queue->next_queue) {
+        while (queue->head != NULL) {
+            pending_t *pending = queue->head;
+
+            queue_pop(queue, pending);
+            ib_mpool_lite_destroy(pending->value_mp);
+            ib_mpool_lite_destroy(pending->mp);
+        }
+        queue->thread_pid = 0;
+
+        /* The parent's thread may have been waiting on the condition. */
+        pthread_cond_init(&(queue->cond), NULL);
+        pthread_mutex_unlock(&(queue->lock));
+    }
+    pthread_mutex_unlock(&g_queues_lock);
+}
+
+/**
+ * Register the fork handlers.
+ */
+static void queues_register_atfork(void)
+{
+    pthread_atfork(
+        queues_fork_prepare,
+        queues_fork_parent,
+        queues_fork_child);
+}
+
+/**
+ * Write-behind thread: write collections as they become due.
+ *
+ * @param[in] arg The @ref ib_persist_fw_queue_t.
+ *
+ * @returns NULL
+ */
+static void *queue_thread(void *arg)
+{
+    ib_persist_fw_queue_t *queue = (ib_persist_fw_queue_t *)arg;
+
+    pthread_mutex_lock(&(queue->lock));
+    while (! queue->stopping) {
+        ib_time_t  now = now_time();
+        pending_t *batch = NULL;
+        pending_t *last = NULL;
+        size_t     count = 0;
+
+        if (queue->head == NULL) {
+            pthread_cond_wait(&(queue->cond), &(queue->lock));
+            continue;
+        }
+
+        if (queue->head->deadline > now) {
+            struct timespec until;
+
+            until.tv_sec = queue->head->deadline / 1000000;
+            until.tv_nsec = (queue->head->deadline % 1000000) * 1000;
+            pthread_cond_timedwait(&(queue->cond), &(queue->lock), &until);
+            continue;
+        }
+
+        while ( (queue->head != NULL) && (queue->head->deadline <= now) ) {
+            pending_t *pending = queue->head;
+
+            queue_pop(queue, pending);
+            if (last == NULL) {
+                batch = pending;
+            }
+            else {
+                last->next = pending;
+            }
+            last = pending;
+            ++count;
+        }
+
+        pthread_mutex_unlock(&(queue->lock));
+
+        ib_log_debug(
+            queue->ib,
+            "Writing %zu queued collections to store %s.",
+            count, queue->store->name);
+        while (batch != NULL) {
+            pending_t *next = batch->next;
+
+            pending_write(queue, batch);
+            batch = next;
+        }
+
+        pthread_mutex_lock(&(queue->lock));
+    }
+    pthread_mutex_unlock(&(queue->lock));
+
+    return NULL;
+}
+
+ib_status_t ib_persist_fw_queue_create(
+    ib_engine_t               *ib,
+    ib_persist_fw_store_t     *store,
+    ib_time_t                  window,
+    ib_persist_fw_merge_fn_t   merge_fn,
+    void                      *merge_data,
+    ib_persist_fw_queue_t    **queue
+)
+{
+    assert(ib != NULL);
+    assert(store != NULL);
+    assert(queue != NULL);
+
+    ib_persist_fw_queue_t *q;
+    ib_status_t            rc;
+
+    q = ib_mm_calloc(ib_engine_mm_main_get(ib), 1, sizeof(*q));
+    if (q == NULL) {
+        return IB_EALLOC;
+    }
+
+    q->ib = ib;
+    q->store = store;
+    q->window = window;
+    q->merge_fn = merge_fn;
+    q->merge_data = merge_data;
+
+    rc = ib_mpool_lite_create(&(q->mp));
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = ib_hash_create(&(q->pending), ib_mm_mpool_lite(q->mp));
+    if (rc != IB_OK) {
+        ib_mpool_lite_destroy(q->mp);
+        return rc;
+    }
+    if (pthread_mutex_init(&(q->lock), NULL) != 0) {
+        ib_mpool_lite_destroy(q->mp);
+        return IB_EOTHER;
+    }
+    if (pthread_cond_init(&(q->cond), NULL) != 0) {
+        pthread_mutex_destroy(&(q->lock));
+        ib_mpool_lite_destroy(q->mp);
+        return IB_EOTHER;
+    }
+
+    pthread_once(&g_queues_once, queues_register_atfork);
+    pthread_mutex_lock(&g_queues_lock);
+    q->next_queue = g_queues;
+    g_queues = q;
+    pthread_mutex_unlock(&g_queues_lock);
+
+    *queue = q;
+    return IB_OK;
+}
+
+ib_status_t ib_persist_fw_queue_load(
+    ib_persist_fw_queue_t *queue,
+    ib_mm_t                mm,
+    const char            *key,
+    size_t                 key_length,
+    ib_list_t             *list
+)
+{
+    assert(queue != NULL);
+    assert(key != NULL);
+    assert(list != NULL);
+
+    pending_t   *pending;
+    ib_status_t  rc;
+
+    pthread_mutex_lock(&(queue->lock));
+    rc = ib_hash_get_ex(queue->pending, &pending, key, key_length);
+    if (rc == IB_OK) {
+        rc = ib_persist_fw_copy_fields(mm, pending->value, list);
+    }
+    pthread_mutex_unlock(&(queue->lock));
+
+    return rc;
+}
+
+ib_status_t ib_persist_fw_queue_store(
+    ib_persist_fw_queue_t *queue,
+    const char            *key,
+    size_t                 key_length,
+    ib_time_t              expiration,
+    const ib_list_t       *base,
+    const ib_list_t       *list
+)
+{
+    assert(queue != NULL);
+    assert(key != NULL);
+    assert(list != NULL);
+
+    pending_t       *pending = NULL;
+    ib_mpool_lite_t *value_mp;
+    ib_mm_t          value_mm;
+    ib_list_t       *value;
+    bool             merged = false;
+    ib_status_t      rc;
+
+    rc = ib_mpool_lite_create(&value_mp);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    value_mm = ib_mm_mpool_lite(value_mp);
+    rc = ib_list_create(&value, value_mm);
+    if (rc != IB_OK) {
+        ib_mpool_lite_destroy(value_mp);
+        return rc;
+    }
+
+    pthread_mutex_lock(&(queue->lock));
+
+    if (queue->thread_pid == 0) {
+        queue->stopping = false;
+        if (pthread_create(&(queue->thread), NULL, queue_thread, queue) != 0) {
+            rc = IB_EOTHER;
+            goto failed;
+        }
+        queue->thread_pid = getpid();
+    }
+
+    rc = ib_hash_get_ex(queue->pending, &pending, key, key_length);
+    if (rc == IB_OK && queue->merge_fn != NULL && base != NULL) {
+        rc = queue->merge_fn(
+            value_mm,
+            base, pending->value, list,
+            value,
+            queue->merge_data);
+        if (rc == IB_OK) {
+            merged = true;
+        }
+        else {
+            ib_log_warning(
+                queue->ib,
+                "Failed to merge collection \"%.*s\" for store %s: %s",
+                (int)key_length, key,
+                queue->store->name,
+                ib_status_to_string(rc));
+            ib_list_clear(value);
+        }
+    }
+    if (! merged) {
+        rc = ib_persist_fw_copy_fields(value_mm, list, value);
+        if (rc != IB_OK) {
+            goto failed;
+        }
+    }
+
+    if (pending == NULL) {
+        ib_mpool_lite_t *mp;
+        ib_mm_t          mm;
+
+        rc = ib_mpool_lite_create(&mp);
+        if (rc != IB_OK) {
+            goto failed;
+        }
+        mm = ib_mm_mpool_lite(mp);
+
+        pending = ib_mm_calloc(mm, 1, sizeof(*pending));
+        if (pending == NULL) {
+            ib_mpool_lite_destroy(mp);
+            rc = IB_EALLOC;
+            goto failed;
+        }
+        pending->mp = mp;
+        pending->key = ib_mm_memdup(mm, key, key_length);
+        pending->key_length = key_length;
+        pending->deadline = now_time() + queue->window;
+        rc = (pending->key == NULL) ? IB_EALLOC : IB_OK;
+        if (rc == IB_OK && base != NULL) {
+            rc = ib_list_create(&(pending->base), mm);
+            if (rc == IB_OK) {
+                rc = ib_persist_fw_copy_fields(mm, base, pending->base);
+            }
+        }
+        if (rc == IB_OK) {
+            rc = ib_hash_set_ex(
+                queue->pending,
+                pending->key, key_length,
+                pending);
+        }
+        if (rc != IB_OK) {
+            ib_mpool_lite_destroy(mp);
+            goto failed;
+        }
+
+        if (queue->tail == NULL) {
+            queue->head = pending;
+            pthread_cond_signal(&(queue->cond));
+        }
+        else {
+            queue->tail->next = pending;
+        }
+        queue->tail = pending;
+    }
+    else {
+        ib_mpool_lite_destroy(pending->value_mp);
+    }
+
+    pending->value_mp = value_mp;
+    pending->value = value;
+    pending->expiration = expiration;
+
+    pthread_mutex_unlock(&(queue->lock));
+    return IB_OK;
+
+failed:
+    pthread_mutex_unlock(&(queue->lock));
+    ib_mpool_lite_destroy(value_mp);
+    return rc;
+}
+
+void ib_persist_fw_queue_destroy(ib_persist_fw_queue_t *queue)
+{
+    assert(queue != NULL);
+
+    ib_persist_fw_queue_t **prev;
+    bool                    join;
+
+    pthread_mutex_lock(&g_queues_lock);
+    for (prev = &g_queues; *prev != NULL; prev = &((*prev)->next_queue)) {
+        if (*prev == queue) {
+            *prev = queue->next_queue;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&g_queues_lock);
+
+    pthread_mutex_lock(&(queue->lock));
+    join = (queue->thread_pid != 0);
+    queue->stopping = true;
+    pthread_cond_signal(&(queue->cond));
+    pthread_mutex_unlock(&(queue->lock));
+
+    if (join) {
+        pthread_join(queue->thread, NULL);
+        queue->thread_pid = 0;
+    }
+
+    while (queue->head != NULL) {
+        pending_t *pending = queue->head;
+
+        queue_pop(queue, pending);
+        pending_write(queue, pending);
+    }
+
+    pthread_cond_destroy(&(queue->cond));
+    pthread_mutex_destroy(&(queue->lock));
+    ib_mpool_lite_destroy(queue->mp);
+}
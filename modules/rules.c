@@ -159,8 +159,9 @@ static ib_status_t parse_operator(ib_cfgparser_t *cp,
         return rc;
     }
 
-    /* Create the operator instance */
-    rc = ib_operator_inst_create(
+    /* Create the operator instance; operators that allow it are compiled
+     * by the configuration workers before the context closes. */
+    rc = ib_operator_inst_create_deferred(
         &real_opinst,
         main_mm,
         cp->cur_ctx,
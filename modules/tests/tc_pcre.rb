@@ -22,6 +22,32 @@ class TestPcre < CLIPPTest::TestCase
     assert_log_no_match /(?:.*\[MATCH\]: this){6}/m
   end
 
+  def test_dfa_streaming_multiple
+    response = "HTTP/1.1 200 OK\n\nthis_is_a_pattern and another_pattern\n\n"
+    clipp(
+      :consumer => 'ironbee:IRONBEE_CONFIG @view:summary @splitdata:1',
+      :input_hashes => [
+        simple_hash("GET / HTTP/1.1\nHost: foo.bar\n\n", response),
+        simple_hash("GET / HTTP/1.1\nHost: foo.bar\n\n", response)
+      ],
+      :modules => %w(pcre),
+      :config => '''
+        ResponseBuffering On
+        InspectionEngineOptions all
+      ''',
+      :default_site_config => <<-EOS
+        StreamInspect RESPONSE_BODY_STREAM @dfa "is_a_pattern" id:a rev:1 clipp_announce:STREAM_A
+        StreamInspect RESPONSE_BODY_STREAM @dfa "another_pattern" id:b rev:1 clipp_announce:STREAM_B
+      EOS
+    )
+
+    assert_no_issues
+    # Each streaming operator keeps its own partial match across the one
+    # byte chunks of each transaction.
+    assert_log_match /(?:.*CLIPP ANNOUNCE: STREAM_A){2}/m
+    assert_log_match /(?:.*CLIPP ANNOUNCE: STREAM_B){2}/m
+  end
+
   def test_dfa_reset_non_streaming
     clipp(
       modules: ['pcre'],
@@ -210,4 +236,57 @@ class TestPcre < CLIPPTest::TestCase
     assert_no_issues
     assert_log_match /CLIPP ANNOUNCE/
   end
+
+  # Without PCRE2 support, PcreEngine pcre2 warns and falls back to pcre,
+  # so these only assert that there are no errors.
+  def test_pcre2_rx_capture
+    clipp(
+      modules: ['pcre'],
+      modhtp: true,
+      config: '''
+        PcreEngine              pcre2
+        PcreUseJit              On
+        PcreMatchLimit          5000
+        PcreMatchLimitRecursion 5000
+      ''',
+      default_site_config: <<-EOS
+        Rule ARGS @rx "a(b+)c" id:1 phase:REQUEST capture "clipp_announce:MATCH=%{CAPTURE:1}"
+        Rule ARGS @rx "xyz" id:2 phase:REQUEST clipp_announce:NO
+      EOS
+    ) do
+      transaction do |t|
+        t.request(raw:"GET /foo?1=foobar&2=---abbbc--- HTTP/1.0")
+      end
+    end
+
+    assert_clean_exit
+    assert_log_no_match(/ (EMERGENCY|CRITICAL|ALERT|ERROR) /)
+    assert_log_match /CLIPP ANNOUNCE: MATCH=bbb/
+    assert_log_no_match /CLIPP ANNOUNCE: NO/
+  end
+
+  def test_pcre2_dfa_streaming
+    clipp(
+      :consumer => 'ironbee:IRONBEE_CONFIG @view:summary @splitdata:1',
+      :input_hashes => [simple_hash("GET / HTTP/1.1\nHost: foo.bar\n\n", "HTTP/1.1 200 OK\n\nthisthis_is_a_patternthisthisthis\n\n") ],
+      :modules => %w(pcre),
+      :config => '''
+        PcreEngine pcre2
+        ResponseBuffering On
+        InspectionEngineOptions all
+        InitVar MATCH broken
+      ''',
+      :default_site_config => <<-EOS
+        StreamInspect RESPONSE_BODY_STREAM @dfa "this" id:this rev:1 capture
+        StreamInspect RESPONSE_BODY_STREAM @dfa "is_a_pattern" id:a rev:1 clipp_announce:STREAM_A
+        Rule "CAPTURE" @clipp_print "MATCH" id:2 rev:1 phase:POSTPROCESS
+      EOS
+    )
+
+    assert_clean_exit
+    assert_log_no_match(/ (EMERGENCY|CRITICAL|ALERT|ERROR) /)
+    assert_log_match /(?:.*\[MATCH\]: this){5}/m
+    assert_log_no_match /(?:.*\[MATCH\]: this){6}/m
+    assert_log_match /CLIPP ANNOUNCE: STREAM_A/
+  end
 end
@@ -51,4 +51,84 @@ class TestPersistence < CLIPPTest::TestCase
 
     assert_no_issues
   end
+
+  def test_persist_log
+    dir = Dir.mktmpdir
+
+    2.times do
+      clipp(
+        modules: %w[ persistence_framework persist ],
+        config: """
+          PersistenceStore persist persist-log://#{dir}
+        """,
+        default_site_config: <<-EOS
+          PersistenceMap IP persist key=%{REMOTE_ADDR} expire=300
+
+          Action id:1 rev:1 phase:REQUEST_HEADER "setvar:IP:count+=1"
+        EOS
+      ) do
+        transaction do |t|
+          t.request(raw: "GET /foobar/a\n")
+        end
+      end
+    end
+
+    assert_no_issues
+  ensure
+    FileUtils.rm_rf(dir)
+  end
+
+  def test_persist_cache
+    dir = Dir.mktmpdir
+
+    2.times do
+      clipp(
+        modules: %w[ persistence_framework persist ],
+        config: """
+          PersistenceStore persist persist-fs://#{dir} cache=65536 cache_mode=write-behind
+        """,
+        default_site_config: <<-EOS
+          PersistenceMap IP persist key=%{REMOTE_ADDR} expire=300
+
+          Action id:1 rev:1 phase:REQUEST_HEADER "setvar:IP:count+=1"
+        EOS
+      ) do
+        transaction do |t|
+          t.request(raw: "GET /foobar/a\n")
+        end
+      end
+    end
+
+    assert_no_issues
+  ensure
+    FileUtils.rm_rf(dir)
+  end
+
+  def test_persist_write_behind
+    dir = Dir.mktmpdir
+    clipp(
+      modules: %w[ persistence_framework persist ],
+      config: """
+        PersistenceStore persist persist-log://#{dir} write_behind=60 merge=sum
+      """,
+      default_site_config: <<-EOS
+        PersistenceMap IP persist key=%{REMOTE_ADDR} expire=300
+
+        Action id:1 rev:1 phase:REQUEST_HEADER "setvar:IP:count+=1"
+        Rule IP:count @clipp_print "IP:count" id:2 rev:1 phase:REQUEST
+      EOS
+    ) do
+      transaction do |t|
+        t.request(raw: "GET /foobar/a\n")
+      end
+      transaction do |t|
+        t.request(raw: "GET /foobar/a\n")
+      end
+    end
+
+    assert_no_issues
+    assert_log_match /clipp_print \[IP:count\]: 2/
+  ensure
+    FileUtils.rm_rf(dir)
+  end
 end
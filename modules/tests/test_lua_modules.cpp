@@ -25,9 +25,16 @@
 #include "base_fixture.h"
 
 extern "C" {
+#include "lua_private.h"
+#include "lua_runtime_private.h"
+
+#include <dlfcn.h>
 #include <unistd.h>
 }
 
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
 class LuaModule : public BaseTransactionFixture
 {
 };
@@ -78,3 +85,92 @@ TEST_F(LuaModule, load_module) {
     ASSERT_EQ(101, num);
 
 }
+
+class LuaModuleTeardown : public BaseFixture
+{
+};
+
+namespace {
+
+//! Acquire and release a Lua stack, so it is cached, then wait and exit.
+void cache_and_exit(
+    ib_engine_t     *ib,
+    modlua_cfg_t    *cfg,
+    boost::barrier  *cached,
+    boost::barrier  *go,
+    ib_status_t     *result
+)
+{
+    typedef ib_status_t (*acquire_fn_t)(
+        ib_engine_t *, modlua_cfg_t *, modlua_runtime_t **);
+    typedef ib_status_t (*release_fn_t)(
+        ib_engine_t *, modlua_cfg_t *, modlua_runtime_t *);
+
+    /* The module is loaded with RTLD_GLOBAL. */
+    acquire_fn_t acquire = reinterpret_cast<acquire_fn_t>(
+        dlsym(RTLD_DEFAULT, "modlua_acquirestate"));
+    release_fn_t release = reinterpret_cast<release_fn_t>(
+        dlsym(RTLD_DEFAULT, "modlua_releasestate"));
+    modlua_runtime_t *runtime;
+
+    *result = IB_EOTHER;
+    if (acquire != NULL && release != NULL) {
+        *result = acquire(ib, cfg, &runtime);
+        if (*result == IB_OK) {
+            *result = release(ib, cfg, runtime);
+        }
+    }
+
+    cached->wait();
+    go->wait();
+
+    /* Returning runs the thread's cache destructor. */
+}
+
+}
+
+//! Destroy the engine while threads holding cached stacks exit.
+TEST_F(LuaModuleTeardown, destroy_while_threads_exit) {
+    typedef ib_status_t (*cfg_get_fn_t)(
+        ib_engine_t *, ib_context_t *, modlua_cfg_t **);
+
+    static const size_t c_num_threads = 8;
+    boost::thread_group      threads;
+    boost::barrier           cached(c_num_threads + 1);
+    boost::barrier           go(c_num_threads + 1);
+    std::vector<ib_status_t> results(c_num_threads, IB_OK);
+    modlua_cfg_t            *cfg = NULL;
+
+    configureIronBeeByString(
+        "LogLevel       info\n"
+        "LoadModule     ibmod_lua.so\n"
+        "SensorId       B9C1B52B-C24A-4309-B9F9-0EF4CD577A3E\n"
+        "SensorName     UnitTesting\n"
+        "SensorHostname unit-testing.sensor.tld\n"
+    );
+
+    cfg_get_fn_t cfg_get = reinterpret_cast<cfg_get_fn_t>(
+        dlsym(RTLD_DEFAULT, "modlua_cfg_get"));
+    ASSERT_TRUE(cfg_get != NULL);
+    ASSERT_EQ(IB_OK, cfg_get(ib_engine, ib_context_main(ib_engine), &cfg));
+
+    for (size_t i = 0; i < c_num_threads; ++i) {
+        threads.create_thread(
+            boost::bind(
+                &cache_and_exit,
+                ib_engine, cfg, &cached, &go, &(results[i])));
+    }
+
+    cached.wait();
+    go.wait();
+
+    /* Races the thread exit callbacks for the Lua stack caches. */
+    ib_engine_destroy(ib_engine);
+    ib_engine = NULL;
+
+    threads.join_all();
+
+    for (size_t i = 0; i < c_num_threads; ++i) {
+        EXPECT_EQ(IB_OK, results[i]) << "Thread " << i;
+    }
+}
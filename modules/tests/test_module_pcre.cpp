@@ -285,6 +285,82 @@ TEST_F(PcreModuleTest, test_pcre_operator)
     ASSERT_TRUE(outfield);
 }
 
+// The instance data of pcre and dfa operators starts with a pointer to the
+// compiled pattern.
+static const void *compiled_pattern(const ib_operator_inst_t *opinst)
+{
+    return *reinterpret_cast<const void * const *>(
+        ib_operator_inst_data(opinst)
+    );
+}
+
+TEST_F(PcreModuleTest, test_pattern_cache)
+{
+    const ib_operator_t *pcre_op;
+    const ib_operator_t *dfa_op;
+    ib_operator_inst_t *opinst1;
+    ib_operator_inst_t *opinst2;
+    ib_operator_inst_t *opinst3;
+    ib_operator_inst_t *opinst4;
+    ib_num_t result;
+    ib_mm_t mm = ib_engine_mm_main_get(ib_engine);
+
+    ASSERT_EQ(IB_OK, ib_operator_lookup(ib_engine, IB_S2SL("pcre"), &pcre_op));
+    ASSERT_EQ(IB_OK, ib_operator_lookup(ib_engine, IB_S2SL("dfa"), &dfa_op));
+
+    ASSERT_EQ(
+        IB_OK,
+        ib_operator_inst_create(
+            &opinst1, mm, ib_context_main(ib_engine), pcre_op,
+            IB_OP_CAPABILITY_NONE, "string\\s2"
+        )
+    );
+    ASSERT_EQ(
+        IB_OK,
+        ib_operator_inst_create(
+            &opinst2, mm, ib_context_main(ib_engine), pcre_op,
+            IB_OP_CAPABILITY_NONE, "string\\s2"
+        )
+    );
+    ASSERT_EQ(
+        IB_OK,
+        ib_operator_inst_create(
+            &opinst3, mm, ib_context_main(ib_engine), pcre_op,
+            IB_OP_CAPABILITY_NONE, "string\\s1"
+        )
+    );
+    ASSERT_EQ(
+        IB_OK,
+        ib_operator_inst_create(
+            &opinst4, mm, ib_context_main(ib_engine), dfa_op,
+            IB_OP_CAPABILITY_NONE, "string\\s2"
+        )
+    );
+
+    // Equal patterns share one compilation; a different pattern, or the
+    // same one compiled for DFA, does not.
+    EXPECT_EQ(compiled_pattern(opinst1), compiled_pattern(opinst2));
+    EXPECT_NE(compiled_pattern(opinst1), compiled_pattern(opinst3));
+    EXPECT_NE(compiled_pattern(opinst1), compiled_pattern(opinst4));
+
+    // The shared compilation matches for both instances.
+    ASSERT_EQ(
+        IB_OK,
+        ib_operator_inst_execute(opinst1, ib_tx, field2, NULL, &result)
+    );
+    EXPECT_TRUE(result);
+    ASSERT_EQ(
+        IB_OK,
+        ib_operator_inst_execute(opinst2, ib_tx, field2, NULL, &result)
+    );
+    EXPECT_TRUE(result);
+    ASSERT_EQ(
+        IB_OK,
+        ib_operator_inst_execute(opinst2, ib_tx, field1, NULL, &result)
+    );
+    EXPECT_FALSE(result);
+}
+
 TEST_F(PcreModuleTest, test_match_basic)
 {
     ib_field_t *outfield;
@@ -25,11 +25,13 @@
 #include "gtest/gtest.h"
 
 #include "base_fixture.h"
+#include "persistence_framework_private.h"
 #include <ironbee/operator.h>
 #include <ironbee/hash.h>
 #include <ironbee/mm.h>
 #include <ironbee/field.h>
 #include <ironbee/bytestr.h>
+#include <ironbee/string.h>
 
 #include <boost/filesystem.hpp>
 
@@ -125,3 +127,181 @@ TEST_F(PersistencePersistTest, LoadStore) {
     configureIronBeeByString(config.c_str());
     performTx();
 }
+
+TEST_F(PersistencePersistTest, WriteBehind) {
+    std::string config(
+        "LogLevel DEBUG\n"
+        "SensorId B9C1B52B-C24A-4309-B9F9-0EF4CD577A3E\n"
+        "SensorName UnitTesting\n"
+        "SensorHostname unit-testing.sensor.tld\n"
+        "LoadModule \"ibmod_rules.so\"\n"
+        "LoadModule \"ibmod_persistence_framework.so\"\n"
+        "LoadModule \"ibmod_persist.so\"\n"
+    );
+
+    config += "PersistenceStore ASTORE persist-log://"+m_path.string()+
+              " write_behind=60 merge=sum\n";
+    config +=
+        "PersistenceMap A ASTORE\n"
+        "<Site test-site>\n"
+        "   SiteId AAAABBBB-1111-2222-3333-000000000000\n"
+        "   Hostname *\n"
+        "   Action id:a1 rev:1 phase:REQUEST \"setvar:A:count+=1\"\n"
+        "   RuleEnable all\n"
+        "</Site>\n"
+    ;
+    configureIronBeeByString(config.c_str());
+
+    /* Each transaction loads the count queued by the one before. */
+    performTx();
+    performTx();
+    performTx();
+    ASSERT_TRUE(ib_tx);
+
+    ib_var_target_t  *target;
+    const ib_list_t  *list;
+    const ib_field_t *field;
+    ib_num_t          num;
+
+    ASSERT_EQ(
+        IB_OK,
+        ib_var_target_acquire_from_string(
+            &target,
+            ib_tx->mm,
+            ib_var_store_config(ib_tx->var_store),
+            "A:count",
+            strlen("A:count"))
+    );
+    ASSERT_EQ(
+        IB_OK,
+        ib_var_target_get_const(
+            target,
+            &list,
+            ib_tx->mm,
+            ib_tx->var_store)
+    );
+    ASSERT_EQ(1U, ib_list_elements(list));
+    field = (const ib_field_t *)ib_list_node_data_const(ib_list_last_const(list));
+    ASSERT_EQ(IB_FTYPE_NUM, field->type);
+    ASSERT_EQ(IB_OK, ib_field_value(field, ib_ftype_num_out(&num)));
+    ASSERT_EQ(3, num);
+}
+
+/* A store holding a single count, standing in for a real kvstore. */
+namespace {
+
+struct CountStore {
+    ib_num_t count;
+    bool     stored;
+};
+
+ib_status_t count_store_load(
+    void       *impl,
+    ib_tx_t    *tx,
+    ib_mm_t     mm,
+    const char *key,
+    size_t      key_length,
+    ib_list_t  *list,
+    void       *cbdata
+)
+{
+    CountStore *store = static_cast<CountStore *>(impl);
+    ib_field_t *field;
+    ib_status_t rc;
+
+    rc = ib_field_create(
+        &field, mm, IB_S2SL("count"),
+        IB_FTYPE_NUM, ib_ftype_num_in(&store->count));
+    if (rc != IB_OK) {
+        return rc;
+    }
+    return ib_list_push(list, field);
+}
+
+ib_status_t count_store_store(
+    void            *impl,
+    ib_tx_t         *tx,
+    ib_mm_t          mm,
+    const char      *key,
+    size_t           key_length,
+    ib_time_t        expiration,
+    const ib_list_t *list,
+    void            *cbdata
+)
+{
+    CountStore       *store = static_cast<CountStore *>(impl);
+    const ib_field_t *field;
+
+    if (ib_list_elements(list) != 1) {
+        return IB_EINVAL;
+    }
+    field = static_cast<const ib_field_t *>(
+        ib_list_node_data_const(ib_list_first_const(list)));
+    store->stored = true;
+    return ib_field_value(field, ib_ftype_num_out(&store->count));
+}
+
+ib_status_t push_count(ib_mm_t mm, ib_list_t *list, ib_num_t count)
+{
+    ib_field_t  *field;
+    ib_status_t  rc;
+
+    rc = ib_field_create(
+        &field, mm, IB_S2SL("count"),
+        IB_FTYPE_NUM, ib_ftype_num_in(&count));
+    if (rc != IB_OK) {
+        return rc;
+    }
+    return ib_list_push(list, field);
+}
+
+}
+
+class PersistenceQueueTest : public BaseFixture {};
+
+TEST_F(PersistenceQueueTest, MergeSumWithConcurrentWriter) {
+    ib_mm_t                  mm = ib_engine_mm_main_get(ib_engine);
+    ib_persist_fw_handler_t  handler;
+    ib_persist_fw_store_t    store;
+    ib_persist_fw_queue_t   *queue;
+    ib_list_t               *base;
+    ib_list_t               *updated;
+    CountStore               counts = { 1, false };
+
+    memset(&handler, 0, sizeof(handler));
+    handler.type     = "count";
+    handler.load_fn  = count_store_load;
+    handler.store_fn = count_store_store;
+
+    memset(&store, 0, sizeof(store));
+    store.name    = "COUNTS";
+    store.handler = &handler;
+    store.impl    = &counts;
+
+    ASSERT_EQ(
+        IB_OK,
+        ib_persist_fw_queue_create(
+            ib_engine, &store, 60000000,
+            ib_persist_fw_merge_sum, NULL,
+            &queue)
+    );
+
+    /* This writer loaded count=1 and added 2. */
+    ASSERT_EQ(IB_OK, ib_list_create(&base, mm));
+    ASSERT_EQ(IB_OK, push_count(mm, base, 1));
+    ASSERT_EQ(IB_OK, ib_list_create(&updated, mm));
+    ASSERT_EQ(IB_OK, push_count(mm, updated, 3));
+    ASSERT_EQ(
+        IB_OK,
+        ib_persist_fw_queue_store(
+            queue, IB_S2SL("key"), 0, base, updated)
+    );
+
+    /* Another writer added 4 before the queue was flushed. */
+    counts.count = 5;
+
+    ib_persist_fw_queue_destroy(queue);
+
+    ASSERT_TRUE(counts.stored);
+    ASSERT_EQ(7, counts.count);
+}
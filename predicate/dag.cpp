@@ -213,6 +213,11 @@ void Node::eval_initialize(
     // nop
 }
 
+ib_rule_phase_num_t Node::eval_initial_phase() const
+{
+    return IB_PHASE_NONE;
+}
+
 bool Node::is_literal() const
 {
     return dynamic_cast<const Literal*>(this);
@@ -403,5 +408,10 @@ void Literal::eval_initialize(
     node_eval_state.finish();
 }
 
+ib_rule_phase_num_t Literal::eval_initial_phase() const
+{
+    return IB_RULE_PHASE_COUNT;
+}
+
 } // Predicate
 } // IronBee
@@ -46,6 +46,93 @@ static const Value
         )
     );
 
+/**
+ * Calculate the initial phase of @a node and its descendants.
+ *
+ * @param[in]     node           Node to calculate initial phase of.
+ * @param[in,out] initial_phases Initial phases; IB_PHASE_INVALID for nodes
+ *                               not yet calculated.
+ * @return Initial phase of @a node.
+ **/
+ib_rule_phase_num_t calculate_initial_phase(
+    const Node*                  node,
+    vector<ib_rule_phase_num_t>& initial_phases
+)
+{
+    assert(node->index() < initial_phases.size());
+
+    ib_rule_phase_num_t& result = initial_phases[node->index()];
+    if (result != IB_PHASE_INVALID) {
+        return result;
+    }
+
+    ib_rule_phase_num_t phase = node->eval_initial_phase();
+    BOOST_FOREACH(const node_p& child, node->children()) {
+        ib_rule_phase_num_t child_phase =
+            calculate_initial_phase(child.get(), initial_phases);
+        if (child_phase < phase) {
+            phase = child_phase;
+        }
+    }
+
+    result = phase;
+    return result;
+}
+
+}
+
+// NodeStateSlot
+
+NodeStateSlot::NodeStateSlot() :
+    m_ops(NULL)
+{
+    // nop
+}
+
+NodeStateSlot::NodeStateSlot(const NodeStateSlot& other) :
+    m_ops(NULL)
+{
+    if (other.m_ops) {
+        other.m_ops->copy(address(), other.address());
+        m_ops = other.m_ops;
+    }
+}
+
+NodeStateSlot::~NodeStateSlot()
+{
+    clear();
+}
+
+NodeStateSlot& NodeStateSlot::operator=(const NodeStateSlot& other)
+{
+    if (this != &other) {
+        clear();
+        if (other.m_ops) {
+            other.m_ops->copy(address(), other.address());
+            m_ops = other.m_ops;
+        }
+    }
+
+    return *this;
+}
+
+void NodeStateSlot::clear()
+{
+    if (m_ops) {
+        const ops_t* ops = m_ops;
+        m_ops = NULL;
+        ops->destroy(address());
+    }
+}
+
+void NodeStateSlot::throw_bad_type(const std::type_info& requested)
+{
+    BOOST_THROW_EXCEPTION(
+        IronBee::einval() << errinfo_what(
+            string("Node state is not of requested type ") +
+            requested.name() + "."
+        )
+    );
 }
 
 // NodeEvalState
@@ -287,12 +374,51 @@ GraphEvalProfileData* GraphEvalProfileData::parent() const {
 // GraphEvalState
 
 GraphEvalState::GraphEvalState(size_t index_limit):
-    m_vector(index_limit),
-    m_initialized(index_limit),
+    m_pool(new ScopedMemoryPoolLite()),
+    m_size(index_limit),
+    m_nodes(NULL),
+    m_initialized(NULL),
+    m_initial_phases(NULL),
+    m_latest_phase(IB_PHASE_NONE),
+    m_num_skipped(0),
     m_profile(false),
     m_parent_profile_data(NULL)
 {
-    // nop
+    allocate(*m_pool);
+}
+
+GraphEvalState::GraphEvalState(size_t index_limit, MemoryManager mm):
+    m_size(index_limit),
+    m_nodes(NULL),
+    m_initialized(NULL),
+    m_initial_phases(NULL),
+    m_latest_phase(IB_PHASE_NONE),
+    m_num_skipped(0),
+    m_profile(false),
+    m_parent_profile_data(NULL)
+{
+    allocate(mm);
+}
+
+GraphEvalState::~GraphEvalState()
+{
+    for (size_t i = 0; i < m_size; ++i) {
+        m_nodes[i].~NodeEvalState();
+    }
+}
+
+void GraphEvalState::allocate(MemoryManager mm)
+{
+    if (m_size == 0) {
+        return;
+    }
+
+    m_initialized = static_cast<bool*>(mm.calloc(m_size, sizeof(bool)));
+    m_nodes = mm.allocate<NodeEvalState>(m_size);
+    // NodeEvalState construction does not throw.
+    for (size_t i = 0; i < m_size; ++i) {
+        new (&m_nodes[i]) NodeEvalState();
+    }
 }
 
 NodeEvalState& GraphEvalState::final(const Node* node, EvalContext context)
@@ -300,8 +426,8 @@ NodeEvalState& GraphEvalState::final(const Node* node, EvalContext context)
     size_t index = node->index();
 
     // For all forwarding nodes...
-    while (m_vector[index].is_forwarding()) {
-        node = m_vector[index].forwarded_to();
+    while (m_nodes[index].is_forwarding()) {
+        node = m_nodes[index].forwarded_to();
         index = node->index();
     }
 
@@ -309,16 +435,16 @@ NodeEvalState& GraphEvalState::final(const Node* node, EvalContext context)
         initialize(node, context);
     }
 
-    return m_vector[index];
+    return m_nodes[index];
 }
 
 NodeEvalState& GraphEvalState::index_final(size_t index)
 {
-    while (m_vector[index].is_forwarding()) {
-        index = m_vector[index].forwarded_to()->index();
+    while (m_nodes[index].is_forwarding()) {
+        index = m_nodes[index].forwarded_to()->index();
     }
 
-    return m_vector[index];
+    return m_nodes[index];
 }
 
 Value GraphEvalState::value(const Node* node, EvalContext context)
@@ -343,10 +469,10 @@ void GraphEvalState::initialize(const Node* node, EvalContext context)
         return;
     }
 
-    assert(! m_vector[node->index()].is_forwarding());
+    assert(! m_nodes[node->index()].is_forwarding());
 
     // Mark that this node is being initialized.
-    m_initialized.flip(node->index());
+    m_initialized[node->index()] = true;
 
     if (m_profile) {
         GraphEvalProfileData& gpd = profiler_mark(node);
@@ -370,11 +496,14 @@ void GraphEvalState::eval(const Node* node, EvalContext context)
     if (context.ib() && context.ib()->rule_exec) {
         phase = context.ib()->rule_exec->phase;
     }
+    if (phase > m_latest_phase) {
+        m_latest_phase = phase;
+    }
 
     // Handle forwarding.
     const Node* final_node = node;
-    while (m_vector[final_node->index()].is_forwarding()) {
-        final_node = m_vector[final_node->index()].forwarded_to();
+    while (m_nodes[final_node->index()].is_forwarding()) {
+        final_node = m_nodes[final_node->index()].forwarded_to();
     }
 
     // Lazy init nodes.
@@ -382,14 +511,25 @@ void GraphEvalState::eval(const Node* node, EvalContext context)
         initialize(final_node, context);
     }
 
-    NodeEvalState& node_eval_state = m_vector[final_node->index()];
+    NodeEvalState& node_eval_state = m_nodes[final_node->index()];
     assert(! node_eval_state.is_forwarding());
 
     if (
         ! node_eval_state.is_finished() &&
         (node_eval_state.phase() != phase || phase == IB_PHASE_NONE)
     ) {
-        if (m_profile) {
+        if (
+            m_initial_phases &&
+            phase != IB_PHASE_NONE &&
+            node_eval_state.phase() != IB_PHASE_NONE &&
+            m_latest_phase < m_initial_phases[final_node->index()]
+        ) {
+            // No phase in which anything below this node may change has
+            // happened yet, so it is unchanged since its last calculation.
+            node_eval_state.set_phase(phase);
+            ++m_num_skipped;
+        }
+        else if (m_profile) {
             GraphEvalProfileData& gpd = profiler_mark(final_node);
             node_eval_state.set_phase(phase);
             final_node->eval_calculate(*this, context);
@@ -406,6 +546,13 @@ void GraphEvalState::eval(const Node* node, EvalContext context)
 #endif
 }
 
+void GraphEvalState::set_initial_phases(
+    const ib_rule_phase_num_t* initial_phases
+)
+{
+    m_initial_phases = initial_phases;
+}
+
 GraphEvalProfileData& GraphEvalState::profiler_mark(const Node* node)
 {
     // Build a data node whose parent is from the prev. call to eval().
@@ -487,5 +634,16 @@ make_initializer(GraphEvalState& graph_eval_state, EvalContext context)
     );
 }
 
+void calculate_initial_phases(
+    const vector<const Node*>&   traversal,
+    vector<ib_rule_phase_num_t>& initial_phases
+)
+{
+    initial_phases.assign(traversal.size(), IB_PHASE_INVALID);
+    BOOST_FOREACH(const Node* node, traversal) {
+        calculate_initial_phase(node, initial_phases);
+    }
+}
+
 } // Predicate
 } // IronBee
@@ -237,23 +237,40 @@ void Call::pre_eval(Environment environment, NodeReporter reporter)
 namespace {
 
 typedef pair<const Node*, size_t> arg_with_index_t;
-typedef list<arg_with_index_t> arg_list_t;
 
+/**
+ * Evaluation state of a call.
+ *
+ * Allocated from the memory manager of the evaluation context, along with
+ * the unfinished argument array.
+ **/
 struct call_state_t {
-    arg_list_t unfinished;
+    call_state_t() : unfinished(NULL), num_unfinished(0) {}
+
+    //! Unfinished non-literal arguments, in order.
+    arg_with_index_t* unfinished;
+    //! Number of elements of @ref unfinished.
+    size_t num_unfinished;
+    //! State of the functional.
     boost::any substate;
 };
-typedef boost::shared_ptr<call_state_t> call_state_p;
+typedef MMPtr<call_state_t> call_state_p;
 
+/**
+ * Evaluate unfinished arguments.
+ *
+ * Finished arguments are validated and removed from @a call_state.
+ **/
 void eval_args(
-    arg_list_t&     args,
+    call_state_t&   call_state,
     const Base&     base,
     GraphEvalState& graph_eval_state,
     EvalContext     context
 )
 {
-    arg_list_t::iterator iter = args.begin();
-    while (iter != args.end()) {
+    size_t kept = 0;
+    for (size_t i = 0; i < call_state.num_unfinished; ++i) {
+        const arg_with_index_t* iter = &call_state.unfinished[i];
         const Node* n = iter->first;
         graph_eval_state.eval(n, context);
         NodeEvalState& n_nes = graph_eval_state.final(n, context);
@@ -278,15 +295,13 @@ void eval_args(
                     )
                 );
             }
-
-            arg_list_t::iterator to_remove = iter;
-            ++iter;
-            args.erase(to_remove);
         }
         else {
-            ++iter;
+            call_state.unfinished[kept] = *iter;
+            ++kept;
         }
     }
+    call_state.num_unfinished = kept;
 }
 
 } // Anonymous
@@ -297,10 +312,15 @@ void Call::eval_initialize(
 ) const
 {
     node_cp me = shared_from_this();
-    call_state_p call_state(new call_state_t());
+    MemoryManager mm = context.memory_manager();
+    call_state_p call_state(mm);
 
     Predicate::Call::eval_initialize(graph_eval_state, context);
 
+    if (! children().empty()) {
+        call_state->unfinished =
+            mm.allocate<arg_with_index_t>(children().size());
+    }
     node_list_t::const_iterator iter;
     size_t i;
     for (
@@ -309,7 +329,9 @@ void Call::eval_initialize(
         ++i, ++iter
     ) {
         if (! (*iter)->is_literal()) {
-            call_state->unfinished.push_back(make_pair(iter->get(), i));
+            call_state->unfinished[call_state->num_unfinished] =
+                make_pair(iter->get(), i);
+            ++call_state->num_unfinished;
         }
     }
 
@@ -329,9 +351,9 @@ void Call::eval_calculate(
 ) const
 {
     NodeEvalState& my_state = graph_eval_state.node_eval_state(this, context);
-    call_state_p call_state = boost::any_cast<call_state_p>(my_state.state());
+    call_state_p call_state = my_state.state().as<call_state_p>();
 
-    eval_args(call_state->unfinished, *m_base, graph_eval_state, context);
+    eval_args(*call_state, *m_base, graph_eval_state, context);
 
     m_base->eval(
         context.memory_manager(),
@@ -342,6 +364,11 @@ void Call::eval_calculate(
     );
 }
 
+ib_rule_phase_num_t Call::eval_initial_phase() const
+{
+    return m_base->eval_initial_phase();
+}
+
 } // Impl
 
 Base::Base(
@@ -373,6 +400,11 @@ void Base::eval_initialize(
     // nop
 }
 
+ib_rule_phase_num_t Base::eval_initial_phase() const
+{
+    return IB_PHASE_NONE;
+}
+
 bool Base::transform(
     node_p             me,
     MergeGraph&        merge_graph,
@@ -430,6 +462,11 @@ void Simple::eval(
     my_state.finish(eval_simple(mm, args));
 }
 
+ib_rule_phase_num_t Simple::eval_initial_phase() const
+{
+    return IB_RULE_PHASE_COUNT;
+}
+
 Constant::Constant(Value value) :
     Simple(0, 0),
     m_value(value)
@@ -484,6 +521,11 @@ void Primary::eval(
     eval_primary(mm, me, substate, my_state, values, *primary_state);
 }
 
+ib_rule_phase_num_t Primary::eval_initial_phase() const
+{
+    return IB_RULE_PHASE_COUNT;
+}
+
 namespace {
 
 struct each_state_t
@@ -322,6 +322,9 @@ private:
 
     //! A breadth-first traversal of roots.begin() to roots.end().
     traversal_t m_traversal;
+
+    //! Initial phase of each node, indexed by node index.
+    vector<ib_rule_phase_num_t> m_initial_phases;
 };
 
 /**
@@ -329,6 +332,7 @@ private:
  *
  * Each transaction has its own graph evaluation state.  The graph evaluation
  * state is initialized the first time the transaction state is requested.
+ * Both are allocated from the transaction memory manager.
  **/
 class PerTransaction
 {
@@ -338,16 +342,19 @@ public:
      *
      * Initializes graph evaluation state.
      *
-     * @param[in] traversal   The traversal to initialize the nodes by.
-     * @param[in] tx          Transaction this state is for.
-     * @param[in] profile     Turn on or off profiling.
-     * @param[in] profile_t   Where to write profiling information.
+     * @param[in] traversal      The traversal to initialize the nodes by.
+     * @param[in] initial_phases Initial phase of each node.  See
+     *                           P::calculate_initial_phases().
+     * @param[in] tx             Transaction this state is for.
+     * @param[in] profile        Turn on or off profiling.
+     * @param[in] profile_t      Where to write profiling information.
      **/
     PerTransaction(
-        const PerContext::traversal_t& traversal,
-        IB::Transaction                tx,
-        bool                           profile,
-        const string&                  profile_to
+        const PerContext::traversal_t&     traversal,
+        const vector<ib_rule_phase_num_t>& initial_phases,
+        IB::Transaction                    tx,
+        bool                               profile,
+        const string&                      profile_to
     );
 
     /**
@@ -450,6 +457,8 @@ private:
     void context_open(IB::Context context) const;
     //! Handle context close; forward to PerContext::close().
     void context_close(IB::Context context);
+    //! Join all context close tasks and start a new, empty group.
+    void join_close_tasks();
     //! Write profiling information, if any.
     void transaction_finished(IB::Transaction tx) const;
 
@@ -515,8 +524,13 @@ private:
     //! Call factory.
     P::CallFactory m_call_factory;
 
-    //! Vector of context close tasks. The main context must join these.
-    boost::thread_group m_close_tasks;
+    /**
+     * Group of context close tasks. The main context must join these.
+     *
+     * Bounded by ib_engine_config_workers().  Replaced after each join so
+     * that joined threads do not count against the bound.
+     **/
+    boost::scoped_ptr<boost::thread_group> m_close_tasks;
 };
 
 //! Find the Delegate given an engine.
@@ -620,6 +634,9 @@ void PerContext::close(IB::Context context)
         P::make_indexer(index_limit, m_traversal)
     );
 
+    // Calculate the first phase each node may change in.
+    P::calculate_initial_phases(m_traversal, m_initial_phases);
+
     // Build roots
     roots.resize(m_merge_graph->size());
     copy(
@@ -913,19 +930,17 @@ void PerContext::graph_lifecycle()
 }
 
 /**
- * Delete the C++ object pointed to by @a t.
+ * Destroy, but do not free, the C++ object pointed to by @a cbdata.
  *
  * T must not point to an array.
  *
- * This is intended to be used with boost::bind to schedule
- * destructors to run at memory pool cleanup time.
+ * This is intended to be registered with ib_mm_register_cleanup() for
+ * objects constructed in memory allocated from that memory manager.
  */
 template<typename T>
-void delete_px(T* t)
+void destroy_px(void* cbdata)
 {
-    if (t != NULL) {
-        delete t;
-    }
+    static_cast<T*>(cbdata)->~T();
 }
 
 PerTransaction& PerContext::fetch_per_transaction(IB::Transaction tx) const
@@ -942,13 +957,25 @@ PerTransaction& PerContext::fetch_per_transaction(IB::Transaction tx) const
 
     // If failure, initialize px, schedule its destruction and store it.
     if (!px) {
-        // Create px.
-        px = new PerTransaction(m_traversal, tx, m_profile, m_profile_to);
+        IB::MemoryManager mm = tx.memory_manager();
+
+        // Create px in the transaction memory.
+        px = new (mm.allocate<PerTransaction>())
+            PerTransaction(
+                m_traversal, m_initial_phases,
+                tx, m_profile, m_profile_to
+            );
 
         // Schedule px to be destroyed with this tx.
-        tx.memory_manager().register_cleanup(
-            boost::bind(&delete_px<PerTransaction>, px)
+        ib_status_t rc = ib_mm_register_cleanup(
+            mm.ib(),
+            &destroy_px<PerTransaction>,
+            px
         );
+        if (rc != IB_OK) {
+            px->~PerTransaction();
+            IB::throw_if_error(rc);
+        }
 
         // Finally, store a copy of the pointer.
         // Note: A copy of the pointer, not a copy of the object.
@@ -995,17 +1022,21 @@ Delegate& PerContext::delegate()
 // PerTransaction
 
 PerTransaction::PerTransaction(
-    const PerContext::traversal_t&  traversal,
-    IB::Transaction                 tx,
-    bool                            profile,
-    const string&                   profile_to
+    const PerContext::traversal_t&     traversal,
+    const vector<ib_rule_phase_num_t>& initial_phases,
+    IB::Transaction                    tx,
+    bool                               profile,
+    const string&                      profile_to
 ) :
-    m_graph_eval_state(traversal.size()),
+    m_graph_eval_state(traversal.size(), tx.memory_manager()),
     m_tx(tx),
     m_profile(profile),
     m_profile_to(profile_to)
 {
     m_graph_eval_state.profiler_enabled(m_profile);
+    if (! initial_phases.empty()) {
+        m_graph_eval_state.set_initial_phases(&initial_phases[0]);
+    }
 }
 
 void PerTransaction::write_profile_file()
@@ -1089,7 +1120,8 @@ IBModPredicateCore::result_t PerTransaction::query(
 // Delegate
 
 Delegate::Delegate(IB::Module module) :
-    IB::ModuleDelegate(module)
+    IB::ModuleDelegate(module),
+    m_close_tasks(new boost::thread_group())
 {
     assert(module);
 
@@ -1180,24 +1212,46 @@ void Delegate::context_open(IB::Context context) const
 
 void Delegate::context_close(IB::Context context)
 {
+    /* Keep at most as many closes in flight as there are configuration
+     * workers. */
+    if (
+        m_close_tasks->size() >=
+        ib_engine_config_workers(module().engine().ib())
+    ) {
+        join_close_tasks();
+    }
+
     /* This packages the call fetch_per_context(context).close(context);
      * into a thread in the thread group. */
-    m_close_tasks.create_thread(
+    m_close_tasks->create_thread(
         boost::bind(
             &PerContext::close, boost::ref(fetch_per_context(context)), context
         )
     );
 
     if (context.ib() == module().engine().main_context().ib()) {
-        m_close_tasks.join_all();
+        join_close_tasks();
     }
 }
 
+void Delegate::join_close_tasks()
+{
+    m_close_tasks->join_all();
+    m_close_tasks.reset(new boost::thread_group());
+}
+
 void Delegate::transaction_finished(IB::Transaction tx) const
 {
-    fetch_per_context(tx.context())
-        .fetch_per_transaction(tx)
-        .write_profile_file();
+    PerTransaction& per_transaction =
+        fetch_per_context(tx.context()).fetch_per_transaction(tx);
+
+    per_transaction.write_profile_file();
+
+    ib_log_debug_tx(
+        tx.ib(),
+        "Predicate skipped %zu node calculations before their phase.",
+        per_transaction.graph_eval_state().num_skipped()
+    );
 }
 
 void Delegate::dir_debug_report(
@@ -147,9 +147,7 @@ void MapCall::map_calculate(
         ConstList<Value> inputs = input_value.as_list();
 
         input_locations_t& input_locations =
-            *boost::any_cast<boost::shared_ptr<input_locations_t> >(
-                my_state.state()
-            );
+            *my_state.state().as<boost::shared_ptr<input_locations_t> >();
 
         // Check empty check is necessary as an empty list is allowed to change
         // to a different list to support values forwarding.
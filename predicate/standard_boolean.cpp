@@ -110,6 +110,9 @@ public:
         GraphEvalState& graph_eval_state,
         EvalContext     context
     ) const;
+
+    //! See Node::eval_initial_phase().
+    virtual ib_rule_phase_num_t eval_initial_phase() const;
 };
 
 /**
@@ -143,6 +146,9 @@ public:
         GraphEvalState& graph_eval_state,
         EvalContext     context
     ) const;
+
+    //! See Node::eval_initial_phase().
+    virtual ib_rule_phase_num_t eval_initial_phase() const;
 };
 
 /**
@@ -175,6 +181,9 @@ public:
         GraphEvalState& graph_eval_state,
         EvalContext     context
     ) const;
+
+    //! See Node::eval_initial_phase().
+    virtual ib_rule_phase_num_t eval_initial_phase() const;
 };
 
 /**
@@ -207,6 +216,9 @@ public:
         GraphEvalState& graph_eval_state,
         EvalContext     context
     ) const;
+
+    //! See Node::eval_initial_phase().
+    virtual ib_rule_phase_num_t eval_initial_phase() const;
 };
 
 /**
@@ -240,6 +252,9 @@ public:
         GraphEvalState& graph_eval_state,
         EvalContext     context
     ) const;
+
+    //! See Node::eval_initial_phase().
+    virtual ib_rule_phase_num_t eval_initial_phase() const;
 };
 
 /**
@@ -273,6 +288,9 @@ public:
         GraphEvalState& graph_eval_state,
         EvalContext     context
     ) const;
+
+    //! See Node::eval_initial_phase().
+    virtual ib_rule_phase_num_t eval_initial_phase() const;
 };
 
 const string& Or::name() const
@@ -305,6 +323,11 @@ void Or::eval_calculate(
     }
 }
 
+ib_rule_phase_num_t Or::eval_initial_phase() const
+{
+    return IB_RULE_PHASE_COUNT;
+}
+
 bool Or::transform(
     MergeGraph&        merge_graph,
     const CallFactory& call_factory,
@@ -386,6 +409,11 @@ void And::eval_calculate(
     }
 }
 
+ib_rule_phase_num_t And::eval_initial_phase() const
+{
+    return IB_RULE_PHASE_COUNT;
+}
+
 bool And::transform(
     MergeGraph&        merge_graph,
     const CallFactory& call_factory,
@@ -462,6 +490,11 @@ void Not::eval_calculate(
     }
 }
 
+ib_rule_phase_num_t Not::eval_initial_phase() const
+{
+    return IB_RULE_PHASE_COUNT;
+}
+
 bool Not::transform(
     MergeGraph&        merge_graph,
     const CallFactory& call_factory,
@@ -529,6 +562,11 @@ void If::eval_calculate(
     }
 }
 
+ib_rule_phase_num_t If::eval_initial_phase() const
+{
+    return IB_RULE_PHASE_COUNT;
+}
+
 bool If::transform(
     MergeGraph&        merge_graph,
     const CallFactory& call_factory,
@@ -597,6 +635,11 @@ void OrSC::eval_calculate(
     my_state.finish();
 }
 
+ib_rule_phase_num_t OrSC::eval_initial_phase() const
+{
+    return IB_RULE_PHASE_COUNT;
+}
+
 bool OrSC::transform(
     MergeGraph&        merge_graph,
     const CallFactory& call_factory,
@@ -674,6 +717,11 @@ void AndSC::eval_calculate(
     my_state.finish_true(context);
 }
 
+ib_rule_phase_num_t AndSC::eval_initial_phase() const
+{
+    return IB_RULE_PHASE_COUNT;
+}
+
 bool AndSC::transform(
     MergeGraph&        merge_graph,
     const CallFactory& call_factory,
@@ -249,7 +249,7 @@ void Sequence::eval_calculate(
     }
 
     // Output current.
-    ib_num_t current = boost::any_cast<ib_num_t>(my_state.state());
+    ib_num_t current = my_state.state().as<ib_num_t>();
     my_state.append_to_list(
         Value::create_number(context.memory_manager(), current)
     );
@@ -103,6 +103,14 @@ public:
     //! See Node::pre_eval()
     virtual void pre_eval(Environment environment, NodeReporter reporter);
 
+    /**
+     * See Node::eval_initial_phase()
+     *
+     * The later of the initial phase of the var source and the initial
+     * phase given by the user.
+     **/
+    virtual ib_rule_phase_num_t eval_initial_phase() const;
+
 protected:
     //! See Node::eval_calculate()
     virtual void eval_calculate(
@@ -625,6 +633,20 @@ void Var::pre_eval(Environment environment, NodeReporter reporter)
     }
 }
 
+ib_rule_phase_num_t Var::eval_initial_phase() const
+{
+    // Source is only known after pre_eval().
+    if (! m_data->source) {
+        return IB_PHASE_NONE;
+    }
+
+    ib_rule_phase_num_t initial_phase = m_data->source.initial_phase();
+    if (m_data->wait_phase > initial_phase) {
+        return m_data->wait_phase;
+    }
+    return initial_phase;
+}
+
 void Var::eval_calculate(
     GraphEvalState& graph_eval_state,
     EvalContext     context
@@ -1631,7 +1653,7 @@ void SetPredicateVars::eval_calculate(
 {
     const Node* child1 = children().front().get();
     fields_t& field =
-        *boost::any_cast<fields_t *>(graph_eval_state.node_eval_state(this, context).state());
+        *graph_eval_state.node_eval_state(this, context).state().as<fields_t *>();
 
     // Give Child 1 a chance to finish if it is not already.
     graph_eval_state.eval(child1, context);
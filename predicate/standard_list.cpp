@@ -167,6 +167,9 @@ public:
         GraphEvalState& graph_eval_state,
         EvalContext     context
     ) const;
+
+    //! See Node::eval_initial_phase()
+    virtual ib_rule_phase_num_t eval_initial_phase() const;
 };
 
 /**
@@ -202,6 +205,9 @@ public:
         GraphEvalState& graph_eval_state,
         EvalContext     context
     ) const;
+
+    //! See Node::eval_initial_phase()
+    virtual ib_rule_phase_num_t eval_initial_phase() const;
 };
 
 /**
@@ -739,9 +745,14 @@ void Cat::eval_calculate(
     EvalContext     context
 ) const
 {
-    boost::any_cast<boost::shared_ptr<cat_impl_t> >(
-        graph_eval_state.node_eval_state(this, context).state()
-    )->eval_calculate(*this, graph_eval_state, context);
+    graph_eval_state.node_eval_state(this, context).state()
+        .as<boost::shared_ptr<cat_impl_t> >()
+        ->eval_calculate(*this, graph_eval_state, context);
+}
+
+ib_rule_phase_num_t Cat::eval_initial_phase() const
+{
+    return IB_RULE_PHASE_COUNT;
 }
 
 const string& List::name() const
@@ -811,7 +822,7 @@ void List::eval_calculate(
     NodeEvalState& my_state = graph_eval_state.node_eval_state(this, context);
 
     node_list_t::const_iterator last_unfinished =
-        boost::any_cast<node_list_t::const_iterator>(my_state.state());
+        my_state.state().as<node_list_t::const_iterator>();
     while (last_unfinished != children().end()) {
         const Node* n = last_unfinished->get();
         graph_eval_state.eval(n, context);
@@ -832,6 +843,11 @@ void List::eval_calculate(
     my_state.state() = last_unfinished;
 }
 
+ib_rule_phase_num_t List::eval_initial_phase() const
+{
+    return IB_RULE_PHASE_COUNT;
+}
+
 } // Anonymous
 
 void load_list(CallFactory& to)
@@ -370,7 +370,7 @@ void FinishAll::eval_calculate(
 
     for (
         node_list_t::const_iterator i =
-            boost::any_cast<node_list_t::const_iterator>(my_state.state());
+            my_state.state().as<node_list_t::const_iterator>();
         i != children().end();
         ++i
     )
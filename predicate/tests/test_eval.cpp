@@ -26,6 +26,8 @@
 #include <ironbee/predicate/value.hpp>
 #include <ironbeepp/test_fixture.hpp>
 
+#include <ironbee/rule_engine.h>
+
 #include "gtest/gtest.h"
 
 #ifdef __clang__
@@ -165,9 +167,36 @@ TEST_F(TestEval, NodeEvalState_State)
     int i = 5;
 
     EXPECT_TRUE(nes.state().empty());
+    EXPECT_THROW(nes.state().as<int>(), IronBee::einval);
     nes.state() = i;
     EXPECT_FALSE(nes.state().empty());
-    EXPECT_EQ(i, boost::any_cast<int>(nes.state()));
+    EXPECT_EQ(i, nes.state().as<int>());
+    EXPECT_THROW(nes.state().as<long>(), IronBee::einval);
+
+    nes.state().as<int>() = 6;
+    EXPECT_EQ(6, nes.state().as<int>());
+}
+
+TEST_F(TestEval, NodeEvalState_StateLifetime)
+{
+    boost::shared_ptr<int> p(new int(5));
+
+    {
+        NodeEvalState nes;
+
+        nes.state() = p;
+        EXPECT_EQ(2L, p.use_count());
+        EXPECT_EQ(p, nes.state().as<boost::shared_ptr<int> >());
+
+        NodeStateSlot copy(nes.state());
+        EXPECT_EQ(3L, p.use_count());
+
+        // Replacing with another type destroys the stored value.
+        nes.state() = 1;
+        EXPECT_EQ(2L, p.use_count());
+    }
+
+    EXPECT_EQ(1L, p.use_count());
 }
 
 TEST_F(TestEval, GraphEvalState)
@@ -227,3 +256,114 @@ TEST_F(TestEval, GraphEvalState)
     EXPECT_TRUE(ges.index_final(n3->index()).is_finished());
     EXPECT_TRUE(ges.index_final(n4->index()).is_finished());
 }
+
+namespace {
+
+//! Call that counts calculations and changes from a given phase.
+class Counted :
+    public Call
+{
+public:
+    explicit
+    Counted(ib_rule_phase_num_t initial_phase) :
+        m_initial_phase(initial_phase),
+        m_calculations(0)
+    {
+        // nop
+    }
+
+    virtual const string& name() const
+    {
+        static const string s_name("counted");
+        return s_name;
+    }
+
+    virtual ib_rule_phase_num_t eval_initial_phase() const
+    {
+        return m_initial_phase;
+    }
+
+    virtual void eval_calculate(
+        GraphEvalState& graph_eval_state,
+        EvalContext     context
+    ) const
+    {
+        ++m_calculations;
+        BOOST_FOREACH(const node_p& child, children()) {
+            graph_eval_state.eval(child.get(), context);
+        }
+    }
+
+    size_t calculations() const
+    {
+        return m_calculations;
+    }
+
+private:
+    ib_rule_phase_num_t m_initial_phase;
+    mutable size_t m_calculations;
+};
+
+} // Anonymous
+
+TEST_F(TestEval, InitialPhases)
+{
+    boost::shared_ptr<Counted> parent(new Counted(IB_RULE_PHASE_COUNT));
+    boost::shared_ptr<Counted> child(new Counted(IB_PHASE_RESPONSE_HEADER));
+    node_p literal(new Literal("foo"));
+    parent->add_child(child);
+    parent->add_child(literal);
+
+    parent->set_index(0);
+    child->set_index(1);
+    literal->set_index(2);
+
+    vector<const Node*> traversal;
+    traversal.push_back(parent.get());
+    traversal.push_back(child.get());
+    traversal.push_back(literal.get());
+
+    vector<ib_rule_phase_num_t> initial_phases;
+    calculate_initial_phases(traversal, initial_phases);
+    ASSERT_EQ(3UL, initial_phases.size());
+    EXPECT_EQ(IB_PHASE_RESPONSE_HEADER, initial_phases[0]);
+    EXPECT_EQ(IB_PHASE_RESPONSE_HEADER, initial_phases[1]);
+    EXPECT_EQ(IB_RULE_PHASE_COUNT, initial_phases[2]);
+
+    ib_rule_exec_t* old_rule_exec = m_transaction.ib()->rule_exec;
+    ib_rule_exec_t rule_exec;
+    m_transaction.ib()->rule_exec = &rule_exec;
+
+    GraphEvalState ges(traversal.size());
+    ges.set_initial_phases(&initial_phases[0]);
+
+    // Always calculated the first time.
+    rule_exec.phase = IB_PHASE_REQUEST_HEADER;
+    ges.eval(parent.get(), m_transaction);
+    EXPECT_EQ(1UL, parent->calculations());
+    EXPECT_EQ(1UL, child->calculations());
+    EXPECT_EQ(0UL, ges.num_skipped());
+
+    // Nothing can change before response header.
+    rule_exec.phase = IB_PHASE_REQUEST;
+    ges.eval(parent.get(), m_transaction);
+    ges.eval(parent.get(), m_transaction);
+    EXPECT_EQ(1UL, parent->calculations());
+    EXPECT_EQ(1UL, child->calculations());
+    EXPECT_EQ(1UL, ges.num_skipped());
+    EXPECT_EQ(IB_PHASE_REQUEST, ges.phase(parent.get(), m_transaction));
+
+    rule_exec.phase = IB_PHASE_RESPONSE_HEADER;
+    ges.eval(parent.get(), m_transaction);
+    EXPECT_EQ(2UL, parent->calculations());
+    EXPECT_EQ(2UL, child->calculations());
+
+    // Once response header has been seen, always calculate.
+    rule_exec.phase = IB_PHASE_REQUEST_PROCESS;
+    ges.eval(parent.get(), m_transaction);
+    EXPECT_EQ(3UL, parent->calculations());
+    EXPECT_EQ(3UL, child->calculations());
+    EXPECT_EQ(1UL, ges.num_skipped());
+
+    m_transaction.ib()->rule_exec = old_rule_exec;
+}
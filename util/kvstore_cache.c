@@ -0,0 +1,1039 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Cache values of another key-value store in memory.
+ *
+ * Keys are hashed to one of @ref CACHE_SHARDS shards.  Each shard is a
+ * chained hash table of @ref cache_entry_t with its own lock, byte count
+ * and least recently used list; a shard evicts from the tail of its list
+ * when it holds more than its share of the cache size.
+ *
+ * Misses are loaded from the backend without holding the shard lock.
+ * Every set and remove increments the shard version, and a loaded value
+ * is only cached if the version did not change while it was loaded, so a
+ * slow load never replaces a newer value.  Sets and removes call the
+ * backend with the shard lock held, which keeps the backend and the cache
+ * in the same order.
+ */
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/kvstore_cache.h>
+
+#include "kvstore_private.h"
+
+#include <ironbee/hash.h>
+#include <ironbee/mm_mpool_lite.h>
+#include <ironbee/mpool_lite.h>
+#include <ironbee/util.h>
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Number of shards.  Must be a power of 2. */
+#define CACHE_SHARDS 16
+
+/** Initial number of buckets of a shard.  Must be a power of 2. */
+static const size_t MIN_BUCKETS = 64;
+
+/** Randomizer of the key hash. */
+static const uint32_t HASH_SEED = 5381;
+
+typedef struct cache_entry_t cache_entry_t;
+
+/**
+ * A cached value.
+ *
+ * The key, the type and the value are stored in cache_entry_t::data.
+ */
+struct cache_entry_t {
+    cache_entry_t *next;         /**< Next entry of the bucket. */
+    cache_entry_t *lru_prev;     /**< More recently used entry. */
+    cache_entry_t *lru_next;     /**< Less recently used entry. */
+    uint32_t       hash;         /**< Hash of the key. */
+    bool           dirty;        /**< Not written to the backend yet. */
+    size_t         key_length;   /**< Length of the key. */
+    size_t         type_length;  /**< Length of the type. */
+    size_t         value_length; /**< Length of the value. */
+    ib_time_t      creation;     /**< Creation time (usec). */
+    ib_time_t      expiration;   /**< Absolute expiration time (usec). */
+    ib_time_t      loaded;       /**< When the entry was cached (usec). */
+    uint8_t        data[];       /**< Key, type and value. */
+};
+
+/**
+ * A shard of the cache.
+ */
+typedef struct {
+    pthread_mutex_t  lock;         /**< Protects all other members. */
+    cache_entry_t  **buckets;      /**< Hash table. */
+    size_t           bucket_count; /**< Number of buckets; a power of 2. */
+    size_t           count;        /**< Number of entries. */
+    size_t           bytes;        /**< Size of all entries. */
+    cache_entry_t    lru;          /**< Sentinel; lru_next is the newest. */
+    uint64_t         version;      /**< Incremented by sets and removes. */
+    ib_time_t        last_flush;   /**< Last periodic flush (usec). */
+    uint64_t         hits;         /**< Gets answered by the shard. */
+    uint64_t         misses;       /**< Gets passed to the backend. */
+} cache_shard_t;
+
+/**
+ * Cache server.
+ */
+typedef struct {
+    ib_kvstore_t            *backend;         /**< Cached store. */
+    ib_kvstore_cache_mode_t  mode;            /**< Write mode. */
+    size_t                   shard_max_bytes; /**< Size limit of a shard. */
+    ib_time_t                max_age;         /**< Max age of loads. */
+    ib_time_t                flush_interval;  /**< Periodic flush (usec). */
+    cache_shard_t            shards[CACHE_SHARDS]; /**< Shards. */
+} cache_server_t;
+
+/**
+ * Current time (usec).
+ */
+static ib_time_t now_time(void)
+{
+    ib_timeval_t tv;
+
+    ib_clock_gettimeofday(&tv);
+    return IB_CLOCK_TIMEVAL_TIME(tv);
+}
+
+/**
+ * Size of @a entry, including its data.
+ */
+static size_t entry_size(const cache_entry_t *entry)
+{
+    return
+        sizeof(*entry) +
+        entry->key_length + entry->type_length + entry->value_length;
+}
+
+/**
+ * Create an entry.
+ *
+ * @returns The entry or NULL on allocation failure.
+ */
+static cache_entry_t *entry_create(
+    const uint8_t *key,
+    size_t         key_length,
+    const char    *type,
+    size_t         type_length,
+    const uint8_t *value,
+    size_t         value_length,
+    ib_time_t      creation,
+    ib_time_t      expiration,
+    bool           dirty
+)
+{
+    cache_entry_t *entry;
+
+    entry = malloc(sizeof(*entry) + key_length + type_length + value_length);
+    if (entry == NULL) {
+        return NULL;
+    }
+
+    entry->next = NULL;
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
+    entry->hash = ib_hashfunc_djb2((const char *)key, key_length,
+                                   HASH_SEED, NULL);
+    entry->dirty = dirty;
+    entry->key_length = key_length;
+    entry->type_length = type_length;
+    entry->value_length = value_length;
+    entry->creation = creation;
+    entry->expiration = expiration;
+    entry->loaded = now_time();
+    memcpy(entry->data, key, key_length);
+    memcpy(entry->data + key_length, type, type_length);
+    memcpy(entry->data + key_length + type_length, value, value_length);
+
+    return entry;
+}
+
+/**
+ * Create a key-value store value from @a entry.
+ *
+ * @param[in] entry The entry.
+ * @param[in] mm Memory manager to allocate the value from.
+ * @param[out] pvalue The value.
+ *
+ * @returns
+ *   - IB_OK on success.
+ *   - IB_EALLOC on allocation failure.
+ */
+static ib_status_t entry_value(
+    const cache_entry_t  *entry,
+    ib_mm_t               mm,
+    ib_kvstore_value_t  **pvalue
+)
+{
+    ib_kvstore_value_t *value;
+    char               *type;
+    uint8_t            *data;
+    ib_status_t         rc;
+
+    type = ib_mm_alloc(mm, entry->type_length + 1);
+    data = ib_mm_alloc(mm, entry->value_length + 1);
+    if ( (type == NULL) || (data == NULL) ) {
+        return IB_EALLOC;
+    }
+    memcpy(type, entry->data + entry->key_length, entry->type_length);
+    type[entry->type_length] = '\0';
+    memcpy(
+        data,
+        entry->data + entry->key_length + entry->type_length,
+        entry->value_length);
+
+    rc = ib_kvstore_value_create(&value, mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    ib_kvstore_value_value_set(value, data, entry->value_length);
+    ib_kvstore_value_type_set(value, type, entry->type_length);
+    ib_kvstore_value_creation_set(value, entry->creation);
+    ib_kvstore_value_expiration_set(value, entry->expiration);
+
+    *pvalue = value;
+    return IB_OK;
+}
+
+/**
+ * Write @a entry to the backend.
+ *
+ * An expired entry is still written, so that it replaces older values.
+ *
+ * @returns Status of the backend set, or IB_EALLOC.
+ */
+static ib_status_t entry_write(
+    const cache_server_t *server,
+    cache_entry_t        *entry
+)
+{
+    ib_mpool_lite_t    *mp;
+    ib_mm_t             mm;
+    ib_kvstore_key_t   *key;
+    ib_kvstore_value_t *value;
+    ib_time_t           now = now_time();
+    ib_status_t         rc;
+
+    rc = ib_mpool_lite_create(&mp);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    mm = ib_mm_mpool_lite(mp);
+
+    rc = ib_kvstore_key_create(&key, mm, entry->data, entry->key_length);
+    if (rc != IB_OK) {
+        goto finish;
+    }
+    rc = ib_kvstore_value_create(&value, mm);
+    if (rc != IB_OK) {
+        goto finish;
+    }
+    ib_kvstore_value_type_set(
+        value,
+        (const char *)(entry->data + entry->key_length),
+        entry->type_length);
+    ib_kvstore_value_value_set(
+        value,
+        entry->data + entry->key_length + entry->type_length,
+        entry->value_length);
+    ib_kvstore_value_expiration_set(
+        value,
+        (entry->expiration > now) ? entry->expiration - now : 0);
+
+    rc = ib_kvstore_set(server->backend, NULL, key, value);
+    if (rc == IB_OK) {
+        entry->dirty = false;
+    }
+
+finish:
+    ib_mpool_lite_destroy(mp);
+    return rc;
+}
+
+/**
+ * Hash of @a key.
+ */
+static uint32_t key_hash(const ib_kvstore_key_t *key)
+{
+    const uint8_t *data;
+    size_t         length;
+
+    ib_kvstore_key_get(key, &data, &length);
+
+    return ib_hashfunc_djb2((const char *)data, length, HASH_SEED, NULL);
+}
+
+/**
+ * Shard of @a hash.
+ */
+static cache_shard_t *shard_of(cache_server_t *server, uint32_t hash)
+{
+    return &(server->shards[hash & (CACHE_SHARDS - 1)]);
+}
+
+/**
+ * Bucket of @a hash in @a shard.
+ *
+ * The low bits of the hash choose the shard, so they are skipped.
+ */
+static cache_entry_t **shard_bucket(
+    const cache_shard_t *shard,
+    uint32_t             hash
+)
+{
+    return &(shard->buckets[(hash / CACHE_SHARDS) &
+                            (shard->bucket_count - 1)]);
+}
+
+/**
+ * Find the link to the entry of @a key in @a shard.
+ *
+ * @returns The link to the entry; *link is NULL if there is none.
+ */
+static cache_entry_t **shard_find(
+    cache_shard_t          *shard,
+    uint32_t                hash,
+    const ib_kvstore_key_t *key
+)
+{
+    const uint8_t  *data;
+    size_t          length;
+    cache_entry_t **link;
+
+    ib_kvstore_key_get(key, &data, &length);
+
+    for (
+        link = shard_bucket(shard, hash);
+        *link != NULL;
+        link = &((*link)->next)
+    )
+    {
+        const cache_entry_t *entry = *link;
+
+        if ( (entry->hash == hash) &&
+             (entry->key_length == length) &&
+             (memcmp(entry->data, data, length) == 0) )
+        {
+            break;
+        }
+    }
+
+    return link;
+}
+
+/**
+ * Unlink @a entry from the least recently used list.
+ */
+static void lru_unlink(cache_entry_t *entry)
+{
+    entry->lru_prev->lru_next = entry->lru_next;
+    entry->lru_next->lru_prev = entry->lru_prev;
+}
+
+/**
+ * Make @a entry the most recently used of @a shard.
+ */
+static void lru_push(cache_shard_t *shard, cache_entry_t *entry)
+{
+    entry->lru_prev = &(shard->lru);
+    entry->lru_next = shard->lru.lru_next;
+    shard->lru.lru_next->lru_prev = entry;
+    shard->lru.lru_next = entry;
+}
+
+/**
+ * Remove the entry at @a link from @a shard.
+ *
+ * @returns The entry, to be freed by the caller.
+ */
+static cache_entry_t *shard_unlink(
+    cache_shard_t  *shard,
+    cache_entry_t **link
+)
+{
+    cache_entry_t *entry = *link;
+
+    *link = entry->next;
+    lru_unlink(entry);
+    shard->count -= 1;
+    shard->bytes -= entry_size(entry);
+
+    return entry;
+}
+
+/**
+ * Double the buckets of @a shard.
+ *
+ * On allocation failure the shard keeps its buckets; chains get longer.
+ */
+static void shard_grow(cache_shard_t *shard)
+{
+    cache_entry_t **old_buckets = shard->buckets;
+    size_t          old_count = shard->bucket_count;
+    cache_entry_t **buckets;
+
+    buckets = calloc(old_count * 2, sizeof(*buckets));
+    if (buckets == NULL) {
+        return;
+    }
+
+    shard->buckets = buckets;
+    shard->bucket_count = old_count * 2;
+    for (size_t i = 0; i < old_count; ++i) {
+        cache_entry_t *entry = old_buckets[i];
+
+        while (entry != NULL) {
+            cache_entry_t  *next = entry->next;
+            cache_entry_t **bucket = shard_bucket(shard, entry->hash);
+
+            entry->next = *bucket;
+            *bucket = entry;
+            entry = next;
+        }
+    }
+    free(old_buckets);
+}
+
+/**
+ * Evict least recently used entries until @a shard fits its limit.
+ *
+ * Dirty entries are written to the backend first.  An entry that can
+ * not be written stays cached and dirty, so that it is retried by a later
+ * eviction or flush, and an error is logged.  The shard may then hold
+ * more than its limit until the backend recovers.
+ */
+static void shard_evict(const cache_server_t *server, cache_shard_t *shard)
+{
+    cache_entry_t *entry = shard->lru.lru_prev;
+
+    while ( (shard->bytes > server->shard_max_bytes) &&
+            (entry != &(shard->lru)) )
+    {
+        cache_entry_t  *prev = entry->lru_prev;
+        cache_entry_t **link;
+
+        if (entry->dirty && entry_write(server, entry) != IB_OK) {
+            ib_util_log_error(
+                "kvstore: Failed to write cache entry for key %.*s; "
+                "keeping it.",
+                (int)entry->key_length, (const char *)entry->data);
+            entry = prev;
+            continue;
+        }
+
+        for (
+            link = shard_bucket(shard, entry->hash);
+            *link != entry;
+            link = &((*link)->next)
+        )
+        {
+            /* Nop. */
+        }
+        free(shard_unlink(shard, link));
+        entry = prev;
+    }
+}
+
+/**
+ * Cache @a entry in @a shard, replacing any entry of the same key.
+ *
+ * @a entry may be evicted, and freed, before this returns.
+ */
+static void shard_put(
+    const cache_server_t *server,
+    cache_shard_t        *shard,
+    cache_entry_t        *entry
+)
+{
+    cache_entry_t **link;
+
+    for (
+        link = shard_bucket(shard, entry->hash);
+        *link != NULL;
+        link = &((*link)->next)
+    )
+    {
+        const cache_entry_t *old = *link;
+
+        if ( (old->hash == entry->hash) &&
+             (old->key_length == entry->key_length) &&
+             (memcmp(old->data, entry->data, entry->key_length) == 0) )
+        {
+            free(shard_unlink(shard, link));
+            break;
+        }
+    }
+
+    if (shard->count >= shard->bucket_count) {
+        shard_grow(shard);
+    }
+
+    link = shard_bucket(shard, entry->hash);
+    entry->next = *link;
+    *link = entry;
+    lru_push(shard, entry);
+    shard->count += 1;
+    shard->bytes += entry_size(entry);
+
+    shard_evict(server, shard);
+}
+
+/**
+ * Write the dirty entries of @a shard.
+ *
+ * @returns IB_OK or the first error of the backend.
+ */
+static ib_status_t shard_flush(
+    const cache_server_t *server,
+    cache_shard_t        *shard
+)
+{
+    ib_status_t rc = IB_OK;
+
+    for (
+        cache_entry_t *entry = shard->lru.lru_next;
+        entry != &(shard->lru);
+        entry = entry->lru_next
+    )
+    {
+        if (entry->dirty) {
+            ib_status_t write_rc = entry_write(server, entry);
+
+            if (rc == IB_OK) {
+                rc = write_rc;
+            }
+        }
+    }
+
+    return rc;
+}
+
+/**
+ * Write the dirty entries of @a shard if its last flush is older than
+ * the flush interval of @a server.
+ *
+ * Failures are logged; the entries stay dirty and are retried.
+ */
+static void shard_flush_due(
+    const cache_server_t *server,
+    cache_shard_t        *shard,
+    ib_time_t             now
+)
+{
+    if ( (server->flush_interval == 0) ||
+         (now < shard->last_flush + server->flush_interval) )
+    {
+        return;
+    }
+
+    shard->last_flush = now;
+    if (shard_flush(server, shard) != IB_OK) {
+        ib_util_log_error("kvstore: Failed to flush cache entries.");
+    }
+}
+
+/**
+ * Connect to the backend.
+ *
+ * @param[in] kvstore The key-value store.
+ * @param[in] cbdata Callback data. Unused.
+ */
+static ib_status_t kvconnect(
+    ib_kvstore_t *kvstore,
+    ib_kvstore_cbdata_t *cbdata)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    cache_server_t *server = (cache_server_t *)kvstore->server;
+
+    return ib_kvstore_connect(server->backend);
+}
+
+/**
+ * Flush the cache and disconnect from the backend.
+ *
+ * @param[in] kvstore The key-value store.
+ * @param[in] cbdata Callback data. Unused.
+ */
+static ib_status_t kvdisconnect(
+    ib_kvstore_t *kvstore,
+    ib_kvstore_cbdata_t *cbdata)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    cache_server_t *server = (cache_server_t *)kvstore->server;
+    ib_status_t     rc;
+
+    rc = ib_kvstore_cache_flush(kvstore);
+    if (rc != IB_OK) {
+        ib_util_log_error("kvstore: Failed to flush cache before disconnect.");
+    }
+
+    return ib_kvstore_disconnect(server->backend);
+}
+
+/**
+ * Get implementation.
+ *
+ * @param[in] kvstore The key-value store.
+ * @param[in] mm Memory manager to allocate @a values out of.
+ * @param[in] key The key to fetch.
+ * @param[out] values A pointer to an array of pointers.
+ * @param[out] values_length The length of *values.
+ * @param[in,out] cbdata Callback data. Unused.
+ */
+static ib_status_t kvget(
+    ib_kvstore_t             *kvstore,
+    ib_mm_t                   mm,
+    const ib_kvstore_key_t   *key,
+    ib_kvstore_value_t     ***values,
+    size_t                   *values_length,
+    ib_kvstore_cbdata_t      *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(key != NULL);
+
+    cache_server_t     *server = (cache_server_t *)kvstore->server;
+    uint32_t            hash = key_hash(key);
+    cache_shard_t      *shard = shard_of(server, hash);
+    cache_entry_t     **link;
+    cache_entry_t      *entry;
+    ib_kvstore_value_t *value = NULL;
+    ib_time_t           now = now_time();
+    uint64_t            version;
+    ib_status_t         rc;
+
+    *values = ib_mm_alloc(mm, sizeof(**values));
+    if (*values == NULL) {
+        return IB_EALLOC;
+    }
+
+    pthread_mutex_lock(&(shard->lock));
+
+    link = shard_find(shard, hash, key);
+    entry = *link;
+    if (entry != NULL) {
+        bool stale =
+            (entry->expiration < now) ||
+            ( ! entry->dirty &&
+              (server->max_age > 0) &&
+              (now - entry->loaded > server->max_age) );
+
+        if (! stale) {
+            shard->hits += 1;
+            if (server->mode == IB_KVSTORE_CACHE_WRITE_BEHIND) {
+                shard_flush_due(server, shard, now);
+            }
+            lru_unlink(entry);
+            lru_push(shard, entry);
+            rc = entry_value(entry, mm, &value);
+            pthread_mutex_unlock(&(shard->lock));
+            if (rc != IB_OK) {
+                return rc;
+            }
+            (*values)[0] = value;
+            *values_length = 1;
+            return IB_OK;
+        }
+
+        /* Make sure an expired value replaces older ones in the backend.
+         * If it can not, keep it, rather than loading an older value. */
+        if (entry->dirty) {
+            rc = entry_write(server, entry);
+            if (rc != IB_OK) {
+                pthread_mutex_unlock(&(shard->lock));
+                return rc;
+            }
+        }
+        free(shard_unlink(shard, link));
+    }
+
+    shard->misses += 1;
+    version = shard->version;
+    pthread_mutex_unlock(&(shard->lock));
+
+    rc = ib_kvstore_get(server->backend, NULL, mm, key, &value);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    {
+        const uint8_t *key_data;
+        size_t         key_length;
+        const char    *type;
+        size_t         type_length;
+        const uint8_t *data;
+        size_t         data_length;
+
+        ib_kvstore_key_get(key, &key_data, &key_length);
+        ib_kvstore_value_type_get(value, &type, &type_length);
+        ib_kvstore_value_value_get(value, &data, &data_length);
+        entry = entry_create(
+            key_data, key_length,
+            type, type_length,
+            data, data_length,
+            ib_kvstore_value_creation_get(value),
+            ib_kvstore_value_expiration_get(value),
+            false);
+    }
+
+    /* Not caching the value is not an error. */
+    if (entry != NULL) {
+        pthread_mutex_lock(&(shard->lock));
+        if (version == shard->version) {
+            shard_put(server, shard, entry);
+            entry = NULL;
+        }
+        pthread_mutex_unlock(&(shard->lock));
+        free(entry);
+    }
+
+    (*values)[0] = value;
+    *values_length = 1;
+    return IB_OK;
+}
+
+/**
+ * Set implementation.
+ *
+ * @param[in] kvstore Key-value store.
+ * @param[in] merge_policy Passed to the backend.
+ * @param[in] key The key to set.
+ * @param[in] value The value.  Its expiration is relative to now.
+ * @param[in,out] cbdata Callback data. Unused.
+ */
+static ib_status_t kvset(
+    ib_kvstore_t                 *kvstore,
+    ib_kvstore_merge_policy_fn_t  merge_policy,
+    const ib_kvstore_key_t       *key,
+    ib_kvstore_value_t           *value,
+    ib_kvstore_cbdata_t          *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(key != NULL);
+    assert(value != NULL);
+
+    cache_server_t *server = (cache_server_t *)kvstore->server;
+    bool            write_behind =
+        (server->mode == IB_KVSTORE_CACHE_WRITE_BEHIND);
+    cache_entry_t  *entry;
+    cache_shard_t  *shard;
+    const uint8_t  *key_data;
+    size_t          key_length;
+    const char     *type;
+    size_t          type_length;
+    const uint8_t  *data;
+    size_t          data_length;
+    ib_time_t       now = now_time();
+    ib_status_t     rc = IB_OK;
+
+    ib_kvstore_key_get(key, &key_data, &key_length);
+    ib_kvstore_value_type_get(value, &type, &type_length);
+    ib_kvstore_value_value_get(value, &data, &data_length);
+
+    entry = entry_create(
+        key_data, key_length,
+        type, type_length,
+        data, data_length,
+        now,
+        now + ib_kvstore_value_expiration_get(value),
+        write_behind);
+    if (entry == NULL) {
+        return IB_EALLOC;
+    }
+
+    shard = shard_of(server, entry->hash);
+    pthread_mutex_lock(&(shard->lock));
+
+    shard->version += 1;
+    if (! write_behind) {
+        rc = ib_kvstore_set(server->backend, merge_policy, key, value);
+    }
+    if (rc == IB_OK) {
+        shard_put(server, shard, entry);
+        if (write_behind) {
+            shard_flush_due(server, shard, now);
+        }
+    }
+    else {
+        cache_entry_t **link = shard_find(shard, entry->hash, key);
+
+        if (*link != NULL) {
+            free(shard_unlink(shard, link));
+        }
+        free(entry);
+    }
+
+    pthread_mutex_unlock(&(shard->lock));
+
+    return rc;
+}
+
+/**
+ * Remove implementation.
+ *
+ * @param[in] kvstore Key-value store.
+ * @param[in] key The key to remove.
+ * @param[in,out] cbdata Callback data. Unused.
+ */
+static ib_status_t kvremove(
+    ib_kvstore_t           *kvstore,
+    const ib_kvstore_key_t *key,
+    ib_kvstore_cbdata_t    *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(key != NULL);
+
+    cache_server_t  *server = (cache_server_t *)kvstore->server;
+    uint32_t         hash = key_hash(key);
+    cache_shard_t   *shard = shard_of(server, hash);
+    cache_entry_t  **link;
+    bool             dirty = false;
+    ib_status_t      rc;
+
+    pthread_mutex_lock(&(shard->lock));
+
+    shard->version += 1;
+    link = shard_find(shard, hash, key);
+    if (*link != NULL) {
+        cache_entry_t *entry = shard_unlink(shard, link);
+
+        dirty = entry->dirty;
+        free(entry);
+    }
+    rc = ib_kvstore_remove(server->backend, key);
+
+    pthread_mutex_unlock(&(shard->lock));
+
+    /* The value only existed in the cache. */
+    if (dirty && rc == IB_ENOENT) {
+        rc = IB_OK;
+    }
+
+    return rc;
+}
+
+/**
+ * Flush and free the cache, and destroy the backend.
+ *
+ * @param[out] kvstore to be destroyed.
+ * @param[in] cbdata Unused.
+ */
+static void kvdestroy(ib_kvstore_t* kvstore, ib_kvstore_cbdata_t *cbdata)
+{
+    assert(kvstore != NULL);
+
+    cache_server_t *server = (cache_server_t *)kvstore->server;
+
+    if (server == NULL) {
+        return;
+    }
+
+    if (ib_kvstore_cache_flush(kvstore) != IB_OK) {
+        ib_util_log_error("kvstore: Failed to flush cache before destroy.");
+    }
+
+    for (size_t i = 0; i < CACHE_SHARDS; ++i) {
+        cache_shard_t *shard = &(server->shards[i]);
+        cache_entry_t *entry = shard->lru.lru_next;
+
+        while (entry != &(shard->lru)) {
+            cache_entry_t *next = entry->lru_next;
+
+            free(entry);
+            entry = next;
+        }
+        free(shard->buckets);
+        pthread_mutex_destroy(&(shard->lock));
+    }
+
+    ib_kvstore_destroy(server->backend);
+    free(server);
+    kvstore->server = NULL;
+}
+
+ib_status_t ib_kvstore_cache_init(
+    ib_kvstore_t            *kvstore,
+    ib_kvstore_t            *backend,
+    size_t                   max_bytes,
+    ib_time_t                max_age,
+    ib_kvstore_cache_mode_t  mode)
+{
+    assert(kvstore != NULL);
+    assert(backend != NULL);
+    assert(kvstore != backend);
+
+    cache_server_t *server;
+    size_t          i;
+
+    ib_kvstore_init(kvstore);
+
+    server = calloc(1, sizeof(*server));
+    if (server == NULL) {
+        return IB_EALLOC;
+    }
+
+    server->backend = backend;
+    server->mode = mode;
+    server->shard_max_bytes = max_bytes / CACHE_SHARDS;
+    server->max_age = max_age;
+    server->flush_interval = IB_KVSTORE_CACHE_FLUSH_INTERVAL;
+
+    for (i = 0; i < CACHE_SHARDS; ++i) {
+        cache_shard_t *shard = &(server->shards[i]);
+
+        shard->last_flush = now_time();
+        shard->lru.lru_next = &(shard->lru);
+        shard->lru.lru_prev = &(shard->lru);
+        shard->bucket_count = MIN_BUCKETS;
+        shard->buckets = calloc(MIN_BUCKETS, sizeof(*(shard->buckets)));
+        if (shard->buckets == NULL) {
+            break;
+        }
+        if (pthread_mutex_init(&(shard->lock), NULL) != 0) {
+            free(shard->buckets);
+            break;
+        }
+    }
+    if (i < CACHE_SHARDS) {
+        ib_status_t rc =
+            (server->shards[i].buckets == NULL) ? IB_EALLOC : IB_EOTHER;
+
+        while (i-- > 0) {
+            free(server->shards[i].buckets);
+            pthread_mutex_destroy(&(server->shards[i].lock));
+        }
+        free(server);
+        return rc;
+    }
+
+    kvstore->server = (ib_kvstore_server_t *)server;
+    kvstore->get = kvget;
+    kvstore->set = kvset;
+    kvstore->remove = kvremove;
+    kvstore->connect = kvconnect;
+    kvstore->disconnect = kvdisconnect;
+    kvstore->destroy = kvdestroy;
+
+    kvstore->malloc_cbdata = NULL;
+    kvstore->free_cbdata = NULL;
+    kvstore->connect_cbdata = NULL;
+    kvstore->disconnect_cbdata = NULL;
+    kvstore->get_cbdata = NULL;
+    kvstore->set_cbdata = NULL;
+    kvstore->remove_cbdata = NULL;
+    kvstore->merge_policy_cbdata = NULL;
+    kvstore->destroy_cbdata = NULL;
+
+    return IB_OK;
+}
+
+ib_status_t ib_kvstore_cache_flush(ib_kvstore_t *kvstore)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    cache_server_t *server = (cache_server_t *)kvstore->server;
+    ib_status_t     rc = IB_OK;
+
+    if (server->mode != IB_KVSTORE_CACHE_WRITE_BEHIND) {
+        return IB_OK;
+    }
+
+    for (size_t i = 0; i < CACHE_SHARDS; ++i) {
+        cache_shard_t *shard = &(server->shards[i]);
+        ib_status_t    shard_rc;
+
+        pthread_mutex_lock(&(shard->lock));
+        shard_rc = shard_flush(server, shard);
+        pthread_mutex_unlock(&(shard->lock));
+
+        if (rc == IB_OK) {
+            rc = shard_rc;
+        }
+    }
+
+    return rc;
+}
+
+void ib_kvstore_cache_flush_interval_set(
+    ib_kvstore_t *kvstore,
+    ib_time_t     interval)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    cache_server_t *server = (cache_server_t *)kvstore->server;
+    ib_time_t       now = now_time();
+
+    /* The first periodic flush is one interval from now. */
+    for (size_t i = 0; i < CACHE_SHARDS; ++i) {
+        cache_shard_t *shard = &(server->shards[i]);
+
+        pthread_mutex_lock(&(shard->lock));
+        shard->last_flush = now;
+        pthread_mutex_unlock(&(shard->lock));
+    }
+    server->flush_interval = interval;
+}
+
+void ib_kvstore_cache_stats(
+    ib_kvstore_t *kvstore,
+    uint64_t     *hits,
+    uint64_t     *misses)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    cache_server_t *server = (cache_server_t *)kvstore->server;
+    uint64_t        total_hits = 0;
+    uint64_t        total_misses = 0;
+
+    for (size_t i = 0; i < CACHE_SHARDS; ++i) {
+        cache_shard_t *shard = &(server->shards[i]);
+
+        pthread_mutex_lock(&(shard->lock));
+        total_hits += shard->hits;
+        total_misses += shard->misses;
+        pthread_mutex_unlock(&(shard->lock));
+    }
+
+    if (hits != NULL) {
+        *hits = total_hits;
+    }
+    if (misses != NULL) {
+        *misses = total_misses;
+    }
+}
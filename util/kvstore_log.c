@@ -0,0 +1,1758 @@
+/*****************************************************************************
+ * Licensed to Qualys, Inc. (QUALYS) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * QUALYS licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ****************************************************************************/
+
+/**
+ * @file
+ * @brief IronBee --- Persist to an append-only log.
+ *
+ * The store is two files in a directory:
+ *
+ * - `kvstore.log` is a sequence of records, each a @ref record_t followed
+ *   by the key, the type and the value, padded to 8 bytes.  Records are
+ *   only appended; a remove appends a tombstone.
+ * - `kvstore.idx` is a @ref index_header_t followed by an open addressing
+ *   hash table of @ref bucket_t, mapping key hashes to the offset of the
+ *   latest record of the key.  It is mapped shared by every process.
+ *
+ * Writers hold the process lock for writing and an exclusive file lock
+ * on the index.  They append the record, then publish its offset in the
+ * index, so readers never see an offset of an incomplete record.
+ * Operations that move buckets or replace the log (growing the index and
+ * compaction) make the index generation odd while they run; readers do
+ * not take the file lock, but retry if the generation changes under them.
+ *
+ * The log is the authority: an index that is missing, invalid, or left
+ * with an odd generation by a crashed writer is rebuilt from the log, and
+ * records appended to the log but not indexed are replayed.  An invalid
+ * index is rebuilt into a new file that is renamed over it, as truncating
+ * a file mapped by other processes would fault their accesses.
+ */
+
+#include "ironbee_config_auto.h"
+
+#include <ironbee/kvstore_log.h>
+
+#include "kvstore_private.h"
+
+#include <ironbee/atomic.h>
+#include <ironbee/clock.h>
+#include <ironbee/kvstore.h>
+#include <ironbee/path.h>
+#include <ironbee/util.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/** Log file name. */
+static const char LOG_FILE[] = "kvstore.log";
+
+/** Index file name. */
+static const char INDEX_FILE[] = "kvstore.idx";
+
+/** Suffix of a log or index being written to replace the current one. */
+static const char TMP_SUFFIX[] = ".tmp";
+
+/** Magic of the log header ("IBKL"). */
+static const uint32_t LOG_MAGIC = 0x4c4b4249;
+
+/** Magic of each record ("IBKR"). */
+static const uint32_t RECORD_MAGIC = 0x524b4249;
+
+/** Magic of the index header ("IBKI"). */
+static const uint32_t INDEX_MAGIC = 0x494b4249;
+
+/** Version of the log and index formats. */
+static const uint32_t FORMAT_VERSION = 1;
+
+/** The default fmode for created files. */
+static const mode_t DEFAULT_FILE_MODE = 0644;
+
+/** The default dmode for created directories. */
+static const mode_t DEFAULT_DIRECTORY_MODE = 0755;
+
+/** Initial number of index buckets.  Must be a power of 2. */
+static const uint64_t MIN_BUCKETS = 1024;
+
+/** Logs smaller than this are never compacted automatically. */
+static const uint64_t COMPACT_MIN_SIZE = 1024 * 1024;
+
+/** Minimum time between compactions for expired records (usec). */
+static const ib_time_t GC_INTERVAL = 60 * 1000000LU;
+
+/** Offset of an empty bucket. */
+#define BUCKET_EMPTY   UINT64_C(0)
+
+/** Offset of a bucket whose key was removed. */
+#define BUCKET_DELETED UINT64_C(1)
+
+/** Record flag: the key was removed. */
+#define RECORD_FLAG_TOMBSTONE (1 << 0)
+
+/**
+ * Log file header.
+ */
+typedef struct {
+    uint32_t magic;   /**< LOG_MAGIC */
+    uint32_t version; /**< FORMAT_VERSION */
+} log_header_t;
+
+/**
+ * Log record header.  The key, type and value follow.
+ */
+typedef struct {
+    uint32_t magic;        /**< RECORD_MAGIC */
+    uint32_t flags;        /**< RECORD_FLAG_* */
+    uint32_t key_length;   /**< Key length. */
+    uint32_t type_length;  /**< Type length. */
+    uint64_t value_length; /**< Value length. */
+    uint64_t creation;     /**< Creation time (usec). */
+    uint64_t expiration;   /**< Absolute expiration time (usec). */
+} record_t;
+
+/**
+ * Index bucket.
+ */
+typedef struct {
+    uint64_t hash;   /**< Hash of the key. */
+    uint64_t offset; /**< Record offset; or BUCKET_EMPTY/BUCKET_DELETED. */
+} bucket_t;
+
+/**
+ * Index file header.  The buckets follow.
+ *
+ * Fields read by readers without the file lock are accessed atomically.
+ */
+typedef struct {
+    uint32_t magic;             /**< INDEX_MAGIC */
+    uint32_t version;           /**< FORMAT_VERSION */
+    uint64_t generation;        /**< Odd while buckets or log are replaced. */
+    uint64_t bucket_count;      /**< Number of buckets; a power of 2. */
+    uint64_t used;              /**< Buckets that are not empty. */
+    uint64_t live;              /**< Buckets that hold a record. */
+    uint64_t log_size;          /**< Indexed bytes of the log. */
+    uint64_t dead_bytes;        /**< Bytes of replaced or removed records. */
+    uint64_t oldest_expiration; /**< Earliest expiration of any record. */
+    uint64_t last_gc;           /**< Time of last compaction (usec). */
+    uint64_t reserved[7];       /**< Pad to 128 bytes. */
+} index_header_t;
+
+/**
+ * The log server object.
+ */
+typedef struct {
+    char             *directory;    /**< Store directory. */
+    char             *log_path;     /**< Log file path. */
+    char             *index_path;   /**< Index file path. */
+    mode_t            fmode;        /**< The mode of created files. */
+    int               log_fd;       /**< Log file; or -1. */
+    int               index_fd;     /**< Index file; or -1. */
+    index_header_t   *header;       /**< Index mapping; or NULL. */
+    size_t            map_size;     /**< Size of @ref header mapping. */
+    uint64_t          bucket_count; /**< Buckets in @ref header mapping. */
+    uint64_t          generation;   /**< Generation @ref log_fd is of. */
+    pthread_rwlock_t  lock;         /**< Process lock. */
+} log_server_t;
+
+/**
+ * Hash a key (64 bit FNV-1a).
+ *
+ * The hash is stored in the index, so must not vary between processes.
+ */
+static uint64_t key_hash(const uint8_t *key, size_t key_length)
+{
+    uint64_t hash = UINT64_C(14695981039346656037);
+
+    for (size_t i = 0; i < key_length; ++i) {
+        hash ^= key[i];
+        hash *= UINT64_C(1099511628211);
+    }
+
+    return hash;
+}
+
+/**
+ * Size of a record, including padding.
+ */
+static uint64_t record_size(const record_t *record)
+{
+    uint64_t size =
+        sizeof(*record) +
+        record->key_length +
+        record->type_length +
+        record->value_length;
+
+    return (size + 7) & ~UINT64_C(7);
+}
+
+/**
+ * Current wall clock time (usec).
+ */
+static ib_time_t now_time(void)
+{
+    ib_timeval_t tv;
+
+    ib_clock_gettimeofday(&tv);
+    return IB_CLOCK_TIMEVAL_TIME(tv);
+}
+
+/**
+ * Read exactly @a length bytes at @a offset.
+ *
+ * @returns true on success.
+ */
+static bool pread_full(int fd, void *buf, size_t length, uint64_t offset)
+{
+    uint8_t *p = (uint8_t *)buf;
+
+    while (length > 0) {
+        ssize_t n = pread(fd, p, length, (off_t)offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        length -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+
+    return true;
+}
+
+/**
+ * Write exactly @a length bytes at @a offset.
+ *
+ * @returns true on success.
+ */
+static bool pwrite_full(int fd, const void *buf, size_t length, uint64_t offset)
+{
+    const uint8_t *p = (const uint8_t *)buf;
+
+    while (length > 0) {
+        ssize_t n = pwrite(fd, p, length, (off_t)offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        length -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+
+    return true;
+}
+
+/**
+ * Lock or unlock the index file, retrying on signals.
+ */
+static ib_status_t file_lock(int fd, int operation)
+{
+    while (flock(fd, operation) != 0) {
+        if (errno != EINTR) {
+            return IB_EOTHER;
+        }
+    }
+
+    return IB_OK;
+}
+
+/**
+ * The buckets of the index mapping.
+ */
+static bucket_t *index_buckets(const log_server_t *server)
+{
+    return (bucket_t *)(server->header + 1);
+}
+
+/**
+ * Size of an index file with @a bucket_count buckets.
+ */
+static size_t index_size(uint64_t bucket_count)
+{
+    return sizeof(index_header_t) + bucket_count * sizeof(bucket_t);
+}
+
+/**
+ * Read and validate the record header at @a offset.
+ *
+ * @returns true if @a offset holds a complete, indexed record.
+ */
+static bool record_read(
+    const log_server_t *server,
+    uint64_t            offset,
+    record_t           *record
+)
+{
+    uint64_t log_size = ib_atomic_load(&(server->header->log_size));
+
+    if ( (offset < sizeof(log_header_t)) ||
+         (offset + sizeof(*record) > log_size) )
+    {
+        return false;
+    }
+    if (! pread_full(server->log_fd, record, sizeof(*record), offset)) {
+        return false;
+    }
+
+    return
+        (record->magic == RECORD_MAGIC) &&
+        (offset + record_size(record) <= log_size);
+}
+
+/**
+ * Compare the key of the record at @a offset to @a key.
+ */
+static bool record_key_equal(
+    const log_server_t *server,
+    uint64_t            offset,
+    const record_t     *record,
+    const uint8_t      *key,
+    size_t              key_length
+)
+{
+    uint8_t buf[256];
+
+    if (record->key_length != key_length) {
+        return false;
+    }
+
+    offset += sizeof(*record);
+    for (size_t done = 0; done < key_length; ) {
+        size_t n = key_length - done;
+
+        if (n > sizeof(buf)) {
+            n = sizeof(buf);
+        }
+        if (! pread_full(server->log_fd, buf, n, offset + done)) {
+            return false;
+        }
+        if (memcmp(buf, key + done, n) != 0) {
+            return false;
+        }
+        done += n;
+    }
+
+    return true;
+}
+
+/**
+ * Find the bucket of @a key.
+ *
+ * @param[in] server Server.
+ * @param[in] hash Hash of @a key.
+ * @param[in] key Key.
+ * @param[in] key_length Length of @a key.
+ * @param[out] found Bucket holding @a key; or the bucket count.
+ * @param[out] slot First bucket @a key can be inserted in; or the bucket
+ *             count if there is none.
+ * @param[out] record Record of @a key, if found.
+ * @param[out] offset Offset of @a record, if found.
+ */
+static void index_find(
+    const log_server_t *server,
+    uint64_t            hash,
+    const uint8_t      *key,
+    size_t              key_length,
+    uint64_t           *found,
+    uint64_t           *slot,
+    record_t           *record,
+    uint64_t           *offset
+)
+{
+    bucket_t *buckets = index_buckets(server);
+    uint64_t  count   = server->bucket_count;
+    uint64_t  mask    = count - 1;
+
+    *found = count;
+    *slot = count;
+
+    for (uint64_t i = 0; i < count; ++i) {
+        bucket_t *bucket = &(buckets[(hash + i) & mask]);
+
+        /* Read once: a writer may replace the offset concurrently. */
+        *offset = ib_atomic_load(&(bucket->offset));
+        if (*offset == BUCKET_EMPTY) {
+            if (*slot == count) {
+                *slot = (hash + i) & mask;
+            }
+            return;
+        }
+        if (*offset == BUCKET_DELETED) {
+            if (*slot == count) {
+                *slot = (hash + i) & mask;
+            }
+            continue;
+        }
+        if (ib_atomic_load_relaxed(&(bucket->hash)) != hash) {
+            continue;
+        }
+        if ( record_read(server, *offset, record) &&
+             record_key_equal(server, *offset, record, key, key_length) )
+        {
+            *found = (hash + i) & mask;
+            return;
+        }
+    }
+}
+
+/**
+ * Insert into a private bucket array.
+ */
+static void buckets_insert(
+    bucket_t *buckets,
+    uint64_t  count,
+    uint64_t  hash,
+    uint64_t  offset
+)
+{
+    uint64_t mask = count - 1;
+
+    for (uint64_t i = 0; i < count; ++i) {
+        bucket_t *bucket = &(buckets[(hash + i) & mask]);
+
+        if (bucket->offset == BUCKET_EMPTY) {
+            bucket->hash = hash;
+            bucket->offset = offset;
+            return;
+        }
+    }
+
+    /* Callers size the array for all entries. */
+    assert(false);
+}
+
+/**
+ * Begin replacing buckets or the log.
+ *
+ * @returns true if the generation was made odd; pass to seq_end().
+ */
+static bool seq_begin(log_server_t *server)
+{
+    uint64_t generation = server->header->generation;
+
+    if ((generation & 1) != 0) {
+        return false;
+    }
+    ib_atomic_store(&(server->header->generation), generation + 1);
+    ib_atomic_fence();
+
+    return true;
+}
+
+/**
+ * End replacing buckets or the log, if @a began.
+ */
+static void seq_end(log_server_t *server, bool began)
+{
+    if (began) {
+        ib_atomic_fence();
+        ib_atomic_store(
+            &(server->header->generation),
+            server->header->generation + 1);
+    }
+    server->generation = server->header->generation;
+}
+
+/**
+ * (Re)map the index file.
+ *
+ * @returns
+ *   - IB_OK on success.
+ *   - IB_EINVAL if the index is too small for its bucket count.
+ *   - IB_EOTHER on system call failure.
+ */
+static ib_status_t index_map(log_server_t *server)
+{
+    struct stat  sb;
+    void        *map;
+    uint64_t     bucket_count;
+
+    if (server->header != NULL) {
+        munmap(server->header, server->map_size);
+        server->header = NULL;
+        server->map_size = 0;
+        server->bucket_count = 0;
+    }
+
+    if (fstat(server->index_fd, &sb) != 0) {
+        return IB_EOTHER;
+    }
+    if ((size_t)sb.st_size < sizeof(index_header_t)) {
+        return IB_EINVAL;
+    }
+
+    map = mmap(
+        NULL,
+        (size_t)sb.st_size,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED,
+        server->index_fd,
+        0);
+    if (map == MAP_FAILED) {
+        return IB_EOTHER;
+    }
+
+    server->header = (index_header_t *)map;
+    server->map_size = (size_t)sb.st_size;
+
+    bucket_count = ib_atomic_load(&(server->header->bucket_count));
+    if ( (bucket_count == 0) ||
+         ((bucket_count & (bucket_count - 1)) != 0) ||
+         (index_size(bucket_count) > server->map_size) )
+    {
+        return IB_EINVAL;
+    }
+    server->bucket_count = bucket_count;
+
+    return IB_OK;
+}
+
+/**
+ * Replace the buckets with @a buckets.
+ *
+ * The caller must have called seq_begin().  The index never shrinks, so
+ * that a mapping of another process never extends past the file.
+ */
+static ib_status_t index_replace(
+    log_server_t   *server,
+    const bucket_t *buckets,
+    uint64_t        bucket_count
+)
+{
+    ib_status_t rc;
+
+    if (index_size(bucket_count) > server->map_size) {
+        if (ftruncate(server->index_fd, (off_t)index_size(bucket_count)) != 0) {
+            return IB_EOTHER;
+        }
+        rc = index_map(server);
+        if ( (rc != IB_OK) && (rc != IB_EINVAL) ) {
+            return rc;
+        }
+        if (server->header == NULL) {
+            return IB_EOTHER;
+        }
+    }
+
+    memcpy(server->header + 1, buckets, bucket_count * sizeof(*buckets));
+    ib_atomic_store(&(server->header->bucket_count), bucket_count);
+    server->bucket_count = bucket_count;
+
+    return IB_OK;
+}
+
+/**
+ * Double the number of buckets.
+ */
+static ib_status_t index_grow(log_server_t *server)
+{
+    const bucket_t *old = index_buckets(server);
+    uint64_t        count = server->bucket_count * 2;
+    bucket_t       *buckets;
+    bool            began;
+    ib_status_t     rc;
+
+    buckets = calloc(count, sizeof(*buckets));
+    if (buckets == NULL) {
+        return IB_EALLOC;
+    }
+    for (uint64_t i = 0; i < server->bucket_count; ++i) {
+        if (old[i].offset > BUCKET_DELETED) {
+            buckets_insert(buckets, count, old[i].hash, old[i].offset);
+        }
+    }
+
+    began = seq_begin(server);
+    rc = index_replace(server, buckets, count);
+    free(buckets);
+    if (rc != IB_OK) {
+        /* Left odd: the index is rebuilt on the next access. */
+        return rc;
+    }
+    server->header->used = server->header->live;
+    seq_end(server, began);
+
+    return IB_OK;
+}
+
+/**
+ * Index the record at @a offset of the log.
+ *
+ * @param[in] server Server.
+ * @param[in] record Record.
+ * @param[in] key Key of @a record.
+ * @param[in] offset Offset of @a record.
+ */
+static ib_status_t index_apply(
+    log_server_t   *server,
+    const record_t *record,
+    const uint8_t  *key,
+    uint64_t        offset
+)
+{
+    index_header_t *header = server->header;
+    bucket_t       *buckets = index_buckets(server);
+    uint64_t        hash = key_hash(key, record->key_length);
+    uint64_t        size = record_size(record);
+    uint64_t        found;
+    uint64_t        slot;
+    record_t        old;
+    uint64_t        old_offset;
+    ib_status_t     rc;
+
+    index_find(server, hash, key, record->key_length,
+               &found, &slot, &old, &old_offset);
+
+    /* Readers only accept offsets below the log size. */
+    ib_atomic_store(&(header->log_size), offset + size);
+
+    if (found < server->bucket_count) {
+        header->dead_bytes += record_size(&old);
+        if ((record->flags & RECORD_FLAG_TOMBSTONE) != 0) {
+            ib_atomic_store(&(buckets[found].offset), BUCKET_DELETED);
+            --header->live;
+            header->dead_bytes += size;
+        }
+        else {
+            ib_atomic_store(&(buckets[found].offset), offset);
+        }
+    }
+    else if ((record->flags & RECORD_FLAG_TOMBSTONE) != 0) {
+        header->dead_bytes += size;
+    }
+    else {
+        if (slot == server->bucket_count) {
+            return IB_EOTHER;
+        }
+        if (buckets[slot].offset == BUCKET_EMPTY) {
+            ++header->used;
+        }
+        ib_atomic_store_relaxed(&(buckets[slot].hash), hash);
+        ib_atomic_store(&(buckets[slot].offset), offset);
+        ++header->live;
+    }
+
+    if ( ((record->flags & RECORD_FLAG_TOMBSTONE) == 0) &&
+         (record->expiration < header->oldest_expiration) )
+    {
+        header->oldest_expiration = record->expiration;
+    }
+
+    /* Keep the load factor below 3/4. */
+    if (header->used * 4 >= server->bucket_count * 3) {
+        rc = index_grow(server);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Index the records of the log from @a offset.
+ *
+ * A trailing incomplete record, left by a crashed writer, is truncated.
+ */
+static ib_status_t log_replay(log_server_t *server, uint64_t offset)
+{
+    struct stat  sb;
+    uint64_t     end;
+    uint8_t     *key = NULL;
+    size_t       key_size = 0;
+    ib_status_t  rc = IB_OK;
+
+    if (fstat(server->log_fd, &sb) != 0) {
+        return IB_EOTHER;
+    }
+    end = (uint64_t)sb.st_size;
+
+    while (offset + sizeof(record_t) <= end) {
+        record_t record;
+
+        if (! pread_full(server->log_fd, &record, sizeof(record), offset)) {
+            break;
+        }
+        if ( (record.magic != RECORD_MAGIC) ||
+             (offset + record_size(&record) > end) )
+        {
+            break;
+        }
+        if (record.key_length > key_size) {
+            uint8_t *tmp = realloc(key, record.key_length);
+            if (tmp == NULL) {
+                rc = IB_EALLOC;
+                goto finish;
+            }
+            key = tmp;
+            key_size = record.key_length;
+        }
+        if (! pread_full(server->log_fd, key, record.key_length,
+                         offset + sizeof(record)))
+        {
+            break;
+        }
+
+        rc = index_apply(server, &record, key, offset);
+        if (rc != IB_OK) {
+            goto finish;
+        }
+        offset += record_size(&record);
+    }
+
+    if (offset < end) {
+        ib_util_log_error(
+            "kvstore: Truncating %" PRIu64 " bytes of incomplete log %s",
+            end - offset,
+            server->log_path);
+        if (ftruncate(server->log_fd, (off_t)offset) != 0) {
+            rc = IB_EOTHER;
+            goto finish;
+        }
+    }
+    ib_atomic_store(&(server->header->log_size), offset);
+
+finish:
+    free(key);
+    return rc;
+}
+
+/**
+ * Rebuild the index from the log.
+ */
+static ib_status_t index_rebuild(log_server_t *server)
+{
+    index_header_t *header = server->header;
+    ib_status_t     rc;
+
+    /* Usually odd already: after a crash or from index_init(). */
+    seq_begin(server);
+
+    memset(index_buckets(server), 0,
+           server->bucket_count * sizeof(bucket_t));
+    header->used = 0;
+    header->live = 0;
+    header->dead_bytes = 0;
+    header->oldest_expiration = UINT64_MAX;
+    ib_atomic_store(&(header->log_size), sizeof(log_header_t));
+
+    rc = log_replay(server, sizeof(log_header_t));
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    seq_end(server, true);
+
+    return IB_OK;
+}
+
+/**
+ * Build an index from the log in a new file, and rename it over the index.
+ *
+ * The new file is locked before the rename, so the caller keeps exclusive
+ * access.  The generation of the replaced index is left odd, which sends
+ * readers of other processes to server_sync(), where index_reopen() moves
+ * them to the new file.
+ */
+static ib_status_t index_init(log_server_t *server)
+{
+    index_header_t *old_header = server->header;
+    size_t          old_size = server->map_size;
+    int             old_fd = server->index_fd;
+    char           *tmp_path;
+    int             fd = -1;
+    ib_status_t     rc;
+
+    tmp_path = malloc(strlen(server->index_path) + sizeof(TMP_SUFFIX));
+    if (tmp_path == NULL) {
+        return IB_EALLOC;
+    }
+    strcpy(tmp_path, server->index_path);
+    strcat(tmp_path, TMP_SUFFIX);
+
+    fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, server->fmode);
+    if (fd < 0) {
+        ib_util_log_error("kvstore: Failed to open %s: %s",
+                          tmp_path, strerror(errno));
+        free(tmp_path);
+        return IB_EOTHER;
+    }
+    if ( (file_lock(fd, LOCK_EX) != IB_OK) ||
+         (ftruncate(fd, (off_t)index_size(MIN_BUCKETS)) != 0) )
+    {
+        rc = IB_EOTHER;
+        goto fail;
+    }
+
+    /* Build the new index in place of the old one. */
+    server->header = NULL;
+    server->map_size = 0;
+    server->bucket_count = 0;
+    server->index_fd = fd;
+
+    /* A zero bucket count fails validation; set it up after mapping. */
+    rc = index_map(server);
+    if (server->header == NULL) {
+        rc = (rc == IB_OK) ? IB_EOTHER : rc;
+        goto fail;
+    }
+    server->header->magic = INDEX_MAGIC;
+    server->header->version = FORMAT_VERSION;
+    server->header->generation = 1;
+    server->header->bucket_count = MIN_BUCKETS;
+    server->bucket_count = MIN_BUCKETS;
+
+    rc = index_rebuild(server);
+    if (rc != IB_OK) {
+        goto fail;
+    }
+
+    if (rename(tmp_path, server->index_path) != 0) {
+        rc = IB_EOTHER;
+        goto fail;
+    }
+
+    if (old_header != NULL) {
+        if (old_size >= sizeof(*old_header)) {
+            ib_atomic_store(
+                &(old_header->generation),
+                (old_header->generation | 1) + 2);
+        }
+        munmap(old_header, old_size);
+    }
+    close(old_fd);
+    free(tmp_path);
+
+    return IB_OK;
+
+fail:
+    if (server->header != NULL) {
+        munmap(server->header, server->map_size);
+    }
+    server->header = old_header;
+    server->map_size = old_size;
+    server->bucket_count = 0;
+    server->index_fd = old_fd;
+    close(fd);
+    unlink(tmp_path);
+    free(tmp_path);
+
+    return rc;
+}
+
+/**
+ * Switch to the index file at the index path if it replaced the open one.
+ *
+ * The caller holds the process lock for writing and the file lock, which
+ * is moved to the new file.
+ */
+static ib_status_t index_reopen(log_server_t *server)
+{
+    for (;;) {
+        struct stat open_sb;
+        struct stat path_sb;
+        bool        missing = false;
+        int         fd;
+
+        if (fstat(server->index_fd, &open_sb) != 0) {
+            return IB_EOTHER;
+        }
+        if (stat(server->index_path, &path_sb) != 0) {
+            if (errno != ENOENT) {
+                return IB_EOTHER;
+            }
+            missing = true;
+        }
+        if ( ! missing &&
+             (open_sb.st_dev == path_sb.st_dev) &&
+             (open_sb.st_ino == path_sb.st_ino) )
+        {
+            return IB_OK;
+        }
+
+        fd = open(server->index_path, O_RDWR | O_CREAT, server->fmode);
+        if (fd < 0) {
+            ib_util_log_error("kvstore: Failed to open %s: %s",
+                              server->index_path, strerror(errno));
+            return IB_EOTHER;
+        }
+        if (file_lock(fd, LOCK_EX) != IB_OK) {
+            close(fd);
+            return IB_EOTHER;
+        }
+
+        if (server->header != NULL) {
+            munmap(server->header, server->map_size);
+            server->header = NULL;
+            server->map_size = 0;
+            server->bucket_count = 0;
+        }
+        close(server->index_fd);
+        server->index_fd = fd;
+
+        /* Check again: the new file may have been replaced before it was
+         * locked. */
+    }
+}
+
+/**
+ * (Re)open the log file, writing a header if it is empty.
+ */
+static ib_status_t log_open(log_server_t *server)
+{
+    struct stat  sb;
+    log_header_t header;
+
+    if (server->log_fd >= 0) {
+        close(server->log_fd);
+    }
+
+    server->log_fd = open(server->log_path, O_RDWR | O_CREAT, server->fmode);
+    if (server->log_fd < 0) {
+        ib_util_log_error("kvstore: Failed to open %s: %s",
+                          server->log_path, strerror(errno));
+        return IB_EOTHER;
+    }
+    if (fstat(server->log_fd, &sb) != 0) {
+        return IB_EOTHER;
+    }
+
+    if (sb.st_size == 0) {
+        header.magic = LOG_MAGIC;
+        header.version = FORMAT_VERSION;
+        if (! pwrite_full(server->log_fd, &header, sizeof(header), 0)) {
+            return IB_EOTHER;
+        }
+        return IB_OK;
+    }
+
+    if ( ! pread_full(server->log_fd, &header, sizeof(header), 0) ||
+         (header.magic != LOG_MAGIC) ||
+         (header.version != FORMAT_VERSION) )
+    {
+        ib_util_log_error("kvstore: %s is not a kvstore log.",
+                          server->log_path);
+        return IB_EINVAL;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Bring the process state up to date with the shared state.
+ *
+ * The caller holds the process lock for writing and the file lock.
+ */
+static ib_status_t server_sync(log_server_t *server)
+{
+    struct stat sb;
+    uint64_t    generation;
+    ib_status_t rc;
+
+    rc = index_reopen(server);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    if (fstat(server->index_fd, &sb) != 0) {
+        return IB_EOTHER;
+    }
+    if ( (server->header == NULL) ||
+         ((size_t)sb.st_size != server->map_size) ||
+         (ib_atomic_load(&(server->header->bucket_count)) !=
+            server->bucket_count) )
+    {
+        rc = index_map(server);
+        if ( (rc == IB_EINVAL) ||
+             ( (server->header != NULL) &&
+               ( (server->header->magic != INDEX_MAGIC) ||
+                 (server->header->version != FORMAT_VERSION) ) ) )
+        {
+            ib_util_log_error("kvstore: Recreating invalid index %s",
+                              server->index_path);
+            return index_init(server);
+        }
+        else if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    generation = ib_atomic_load(&(server->header->generation));
+    if (generation != server->generation) {
+        rc = log_open(server);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    /* A writer died while replacing buckets or the log. */
+    if ((generation & 1) != 0) {
+        ib_util_log_error("kvstore: Rebuilding interrupted index %s",
+                          server->index_path);
+        return index_rebuild(server);
+    }
+
+    /* A writer died between appending and indexing, or the log was
+     * replaced behind our back. */
+    if (fstat(server->log_fd, &sb) != 0) {
+        return IB_EOTHER;
+    }
+    if ((uint64_t)sb.st_size < server->header->log_size) {
+        ib_util_log_error("kvstore: Rebuilding index of shrunk log %s",
+                          server->log_path);
+        return index_rebuild(server);
+    }
+    if ((uint64_t)sb.st_size > server->header->log_size) {
+        rc = log_replay(server, server->header->log_size);
+        if (rc != IB_OK) {
+            return rc;
+        }
+    }
+
+    server->generation = server->header->generation;
+
+    return IB_OK;
+}
+
+/**
+ * Take the process and file locks for writing and synchronize.
+ */
+static ib_status_t writer_lock(log_server_t *server)
+{
+    ib_status_t rc;
+
+    pthread_rwlock_wrlock(&(server->lock));
+
+    if (server->index_fd < 0) {
+        pthread_rwlock_unlock(&(server->lock));
+        return IB_EINVAL;
+    }
+
+    rc = file_lock(server->index_fd, LOCK_EX);
+    if (rc != IB_OK) {
+        pthread_rwlock_unlock(&(server->lock));
+        return rc;
+    }
+
+    rc = server_sync(server);
+    if (rc != IB_OK) {
+        file_lock(server->index_fd, LOCK_UN);
+        pthread_rwlock_unlock(&(server->lock));
+        return rc;
+    }
+
+    return IB_OK;
+}
+
+/**
+ * Release the locks of writer_lock().
+ */
+static void writer_unlock(log_server_t *server)
+{
+    file_lock(server->index_fd, LOCK_UN);
+    pthread_rwlock_unlock(&(server->lock));
+}
+
+/**
+ * Copy live, unexpired records to a new log which replaces the log.
+ *
+ * The caller holds the writer locks.
+ */
+static ib_status_t log_compact(log_server_t *server)
+{
+    index_header_t *header = server->header;
+    const bucket_t *old = index_buckets(server);
+    uint64_t        count = server->bucket_count;
+    ib_time_t       now = now_time();
+    uint64_t        offset = sizeof(log_header_t);
+    uint64_t        kept = 0;
+    uint64_t        oldest = UINT64_MAX;
+    bucket_t       *buckets = NULL;
+    uint8_t        *buf = NULL;
+    size_t          buf_size = 0;
+    char           *tmp_path;
+    int             fd = -1;
+    log_header_t    log_header;
+    bool            began;
+    ib_status_t     rc = IB_OK;
+
+    tmp_path = malloc(strlen(server->log_path) + sizeof(TMP_SUFFIX));
+    buckets = calloc(count, sizeof(*buckets));
+    if ( (tmp_path == NULL) || (buckets == NULL) ) {
+        rc = IB_EALLOC;
+        goto finish;
+    }
+    strcpy(tmp_path, server->log_path);
+    strcat(tmp_path, TMP_SUFFIX);
+
+    fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, server->fmode);
+    if (fd < 0) {
+        rc = IB_EOTHER;
+        goto finish;
+    }
+    log_header.magic = LOG_MAGIC;
+    log_header.version = FORMAT_VERSION;
+    if (! pwrite_full(fd, &log_header, sizeof(log_header), 0)) {
+        rc = IB_EOTHER;
+        goto finish;
+    }
+
+    for (uint64_t i = 0; i < count; ++i) {
+        record_t record;
+        uint64_t size;
+
+        if (old[i].offset <= BUCKET_DELETED) {
+            continue;
+        }
+        if ( ! record_read(server, old[i].offset, &record) ||
+             (record.expiration < now) )
+        {
+            continue;
+        }
+
+        size = record_size(&record);
+        if (size > buf_size) {
+            uint8_t *tmp = realloc(buf, size);
+            if (tmp == NULL) {
+                rc = IB_EALLOC;
+                goto finish;
+            }
+            buf = tmp;
+            buf_size = size;
+        }
+        if ( ! pread_full(server->log_fd, buf, size, old[i].offset) ||
+             ! pwrite_full(fd, buf, size, offset) )
+        {
+            rc = IB_EOTHER;
+            goto finish;
+        }
+
+        buckets_insert(buckets, count, old[i].hash, offset);
+        if (record.expiration < oldest) {
+            oldest = record.expiration;
+        }
+        offset += size;
+        ++kept;
+    }
+
+    began = seq_begin(server);
+    if (rename(tmp_path, server->log_path) != 0) {
+        seq_end(server, began);
+        rc = IB_EOTHER;
+        goto finish;
+    }
+    close(server->log_fd);
+    server->log_fd = fd;
+    fd = -1;
+
+    rc = index_replace(server, buckets, count);
+    if (rc != IB_OK) {
+        /* Left odd: the index is rebuilt on the next access. */
+        goto finish;
+    }
+    header = server->header;
+    header->used = kept;
+    header->live = kept;
+    header->dead_bytes = 0;
+    header->oldest_expiration = oldest;
+    header->last_gc = now;
+    ib_atomic_store(&(header->log_size), offset);
+    seq_end(server, began);
+
+finish:
+    if (fd >= 0) {
+        close(fd);
+        unlink(tmp_path);
+    }
+    free(tmp_path);
+    free(buckets);
+    free(buf);
+
+    return rc;
+}
+
+/**
+ * Compact the log if at least half of it is dead, or if it holds expired
+ * records and was not compacted for GC_INTERVAL.
+ */
+static void log_collect(log_server_t *server)
+{
+    const index_header_t *header = server->header;
+    ib_time_t             now;
+    ib_status_t           rc;
+
+    if (header->log_size < COMPACT_MIN_SIZE) {
+        return;
+    }
+
+    now = now_time();
+    if ( (header->dead_bytes * 2 < header->log_size) &&
+         ( (now <= header->oldest_expiration) ||
+           (now - header->last_gc < GC_INTERVAL) ) )
+    {
+        return;
+    }
+
+    rc = log_compact(server);
+    if (rc != IB_OK) {
+        ib_util_log_error("kvstore: Failed to compact %s: %s",
+                          server->log_path, ib_status_to_string(rc));
+    }
+}
+
+/**
+ * Append a record to the log and index it.
+ *
+ * The caller holds the writer locks.
+ */
+static ib_status_t log_append(
+    log_server_t   *server,
+    const record_t *record,
+    const uint8_t  *key,
+    const char     *type,
+    const uint8_t  *value
+)
+{
+    uint64_t     offset = server->header->log_size;
+    uint64_t     size = record_size(record);
+    uint8_t     *buf;
+    uint8_t     *p;
+    ib_status_t  rc;
+
+    buf = calloc(1, size);
+    if (buf == NULL) {
+        return IB_EALLOC;
+    }
+    p = buf;
+    memcpy(p, record, sizeof(*record));
+    p += sizeof(*record);
+    memcpy(p, key, record->key_length);
+    p += record->key_length;
+    if (record->type_length > 0) {
+        memcpy(p, type, record->type_length);
+        p += record->type_length;
+    }
+    if (record->value_length > 0) {
+        memcpy(p, value, record->value_length);
+    }
+
+    if (! pwrite_full(server->log_fd, buf, size, offset)) {
+        free(buf);
+        if (ftruncate(server->log_fd, (off_t)offset) != 0) {
+            ib_util_log_error("kvstore: Failed to truncate %s",
+                              server->log_path);
+        }
+        return IB_EOTHER;
+    }
+    free(buf);
+
+    rc = index_apply(server, record, key, offset);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    log_collect(server);
+
+    return IB_OK;
+}
+
+static ib_status_t kvconnect(
+    ib_kvstore_t *kvstore,
+    ib_kvstore_cbdata_t *cbdata)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    log_server_t *server = (log_server_t *)kvstore->server;
+    ib_status_t   rc;
+
+    pthread_rwlock_wrlock(&(server->lock));
+
+    if (server->index_fd >= 0) {
+        pthread_rwlock_unlock(&(server->lock));
+        return IB_OK;
+    }
+
+    rc = ib_util_mkpath(server->directory, DEFAULT_DIRECTORY_MODE);
+    if (rc != IB_OK) {
+        ib_util_log_error("kvstore: Failed to create directory %s",
+                          server->directory);
+        goto finish;
+    }
+
+    server->index_fd =
+        open(server->index_path, O_RDWR | O_CREAT, server->fmode);
+    if (server->index_fd < 0) {
+        ib_util_log_error("kvstore: Failed to open %s: %s",
+                          server->index_path, strerror(errno));
+        rc = IB_EOTHER;
+        goto finish;
+    }
+
+    rc = file_lock(server->index_fd, LOCK_EX);
+    if (rc != IB_OK) {
+        goto finish;
+    }
+
+    rc = log_open(server);
+    if (rc == IB_OK) {
+        /* Force server_sync() to reopen the log and check the index. */
+        server->generation = UINT64_MAX;
+        rc = server_sync(server);
+    }
+
+    file_lock(server->index_fd, LOCK_UN);
+
+finish:
+    pthread_rwlock_unlock(&(server->lock));
+
+    return rc;
+}
+
+/**
+ * Unmap and close the files.  The caller holds the process lock.
+ */
+static void server_close(log_server_t *server)
+{
+    if (server->header != NULL) {
+        munmap(server->header, server->map_size);
+        server->header = NULL;
+        server->map_size = 0;
+        server->bucket_count = 0;
+    }
+    if (server->log_fd >= 0) {
+        close(server->log_fd);
+        server->log_fd = -1;
+    }
+    if (server->index_fd >= 0) {
+        close(server->index_fd);
+        server->index_fd = -1;
+    }
+}
+
+static ib_status_t kvdisconnect(
+    ib_kvstore_t *kvstore,
+    ib_kvstore_cbdata_t *cbdata)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    log_server_t *server = (log_server_t *)kvstore->server;
+
+    pthread_rwlock_wrlock(&(server->lock));
+    server_close(server);
+    pthread_rwlock_unlock(&(server->lock));
+
+    return IB_OK;
+}
+
+/**
+ * Look up @a key.  The caller holds the process lock.
+ *
+ * @returns
+ *   - IB_OK on success.
+ *   - IB_ENOENT if @a key is not found or expired.
+ *   - IB_EALLOC on allocation failure.
+ *   - IB_EAGAIN if the record could not be read.
+ */
+static ib_status_t lookup(
+    const log_server_t  *server,
+    ib_mm_t              mm,
+    const uint8_t       *key,
+    size_t               key_length,
+    ib_kvstore_value_t **pvalue
+)
+{
+    ib_kvstore_value_t *value;
+    record_t            record;
+    uint64_t            found;
+    uint64_t            slot;
+    uint64_t            offset;
+    char               *type;
+    uint8_t            *data;
+    ib_status_t         rc;
+
+    index_find(server, key_hash(key, key_length), key, key_length,
+               &found, &slot, &record, &offset);
+    if (found == server->bucket_count) {
+        return IB_ENOENT;
+    }
+    if (record.expiration < now_time()) {
+        return IB_ENOENT;
+    }
+
+    type = ib_mm_alloc(mm, record.type_length + 1);
+    data = ib_mm_alloc(mm, record.value_length + 1);
+    if ( (type == NULL) || (data == NULL) ) {
+        return IB_EALLOC;
+    }
+
+    offset += sizeof(record) + record.key_length;
+    if ( ! pread_full(server->log_fd, type, record.type_length, offset) ||
+         ! pread_full(server->log_fd, data, record.value_length,
+                      offset + record.type_length) )
+    {
+        return IB_EAGAIN;
+    }
+    type[record.type_length] = '\0';
+
+    rc = ib_kvstore_value_create(&value, mm);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    ib_kvstore_value_value_set(value, data, record.value_length);
+    ib_kvstore_value_type_set(value, type, record.type_length);
+    ib_kvstore_value_creation_set(value, record.creation);
+    ib_kvstore_value_expiration_set(value, record.expiration);
+
+    *pvalue = value;
+    return IB_OK;
+}
+
+/**
+ * Get implementation.
+ *
+ * Readers do not take the file lock.  The lookup is retried if the index
+ * generation changed while it ran.
+ *
+ * @param[in] kvstore The key-value store.
+ * @param[in] mm Memory manager to allocate @a values out of.
+ * @param[in] key The key to fetch.
+ * @param[out] values A pointer to an array of pointers.
+ * @param[out] values_length The length of *values.
+ * @param[in,out] cbdata Callback data. Unused.
+ */
+static ib_status_t kvget(
+    ib_kvstore_t             *kvstore,
+    ib_mm_t                   mm,
+    const ib_kvstore_key_t   *key,
+    ib_kvstore_value_t     ***values,
+    size_t                   *values_length,
+    ib_kvstore_cbdata_t      *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(key != NULL);
+
+    log_server_t       *server = (log_server_t *)kvstore->server;
+    ib_kvstore_value_t *value = NULL;
+    const uint8_t      *key_data;
+    size_t              key_length;
+    ib_status_t         rc = IB_EAGAIN;
+
+    ib_kvstore_key_get(key, &key_data, &key_length);
+
+    for (int attempt = 0; attempt < 16; ++attempt) {
+        uint64_t generation;
+        bool     current;
+
+        pthread_rwlock_rdlock(&(server->lock));
+        if (server->header == NULL) {
+            pthread_rwlock_unlock(&(server->lock));
+            return IB_EINVAL;
+        }
+
+        generation = ib_atomic_load(&(server->header->generation));
+        current =
+            (generation == server->generation) &&
+            (ib_atomic_load(&(server->header->bucket_count)) ==
+                server->bucket_count);
+        if (current) {
+            rc = lookup(server, mm, key_data, key_length, &value);
+            current =
+                (ib_atomic_load(&(server->header->generation)) == generation);
+        }
+        pthread_rwlock_unlock(&(server->lock));
+
+        if (current && rc != IB_EAGAIN) {
+            break;
+        }
+
+        /* Wait for the writer, and catch up with it. */
+        rc = writer_lock(server);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        writer_unlock(server);
+        rc = IB_EAGAIN;
+    }
+
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    *values = ib_mm_alloc(mm, sizeof(**values));
+    if (*values == NULL) {
+        return IB_EALLOC;
+    }
+    (*values)[0] = value;
+    *values_length = 1;
+
+    return IB_OK;
+}
+
+/**
+ * Set implementation.
+ *
+ * @param[in] kvstore Key-value store.
+ * @param[in] merge_policy This implementation does not merge on writes.
+ * @param[in] key The key to set.
+ * @param[in] value The value to append.  Its expiration is relative to now.
+ * @param[in,out] cbdata Callback data. Unused.
+ */
+static ib_status_t kvset(
+    ib_kvstore_t                 *kvstore,
+    ib_kvstore_merge_policy_fn_t  merge_policy,
+    const ib_kvstore_key_t       *key,
+    ib_kvstore_value_t           *value,
+    ib_kvstore_cbdata_t          *cbdata
+)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(key != NULL);
+    assert(value != NULL);
+
+    log_server_t  *server = (log_server_t *)kvstore->server;
+    record_t       record;
+    const uint8_t *key_data;
+    size_t         key_length;
+    const char    *type;
+    size_t         type_length;
+    const uint8_t *data;
+    size_t         data_length;
+    ib_status_t    rc;
+
+    ib_kvstore_key_get(key, &key_data, &key_length);
+    ib_kvstore_value_type_get(value, &type, &type_length);
+    ib_kvstore_value_value_get(value, &data, &data_length);
+    if ( (key_length > UINT32_MAX) || (type_length > UINT32_MAX) ) {
+        return IB_EINVAL;
+    }
+
+    memset(&record, 0, sizeof(record));
+    record.magic = RECORD_MAGIC;
+    record.key_length = (uint32_t)key_length;
+    record.type_length = (uint32_t)type_length;
+    record.value_length = data_length;
+    record.creation = now_time();
+    record.expiration =
+        record.creation + ib_kvstore_value_expiration_get(value);
+
+    rc = writer_lock(server);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = log_append(server, &record, key_data, type, data);
+    writer_unlock(server);
+
+    return rc;
+}
+
+/**
+ * Remove implementation.  Appends a tombstone if @a key exists.
+ *
+ * @param[in] kvstore Store.
+ * @param[in] key Key.
+ * @param[in,out] cbdata Callback data.
+ */
+static ib_status_t kvremove(
+    ib_kvstore_t *kvstore,
+    const ib_kvstore_key_t *key,
+    ib_kvstore_cbdata_t *cbdata)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+    assert(key != NULL);
+
+    log_server_t  *server = (log_server_t *)kvstore->server;
+    record_t       record;
+    const uint8_t *key_data;
+    size_t         key_length;
+    uint64_t       found;
+    uint64_t       slot;
+    uint64_t       offset;
+    ib_status_t    rc;
+
+    ib_kvstore_key_get(key, &key_data, &key_length);
+    if (key_length > UINT32_MAX) {
+        return IB_EINVAL;
+    }
+
+    rc = writer_lock(server);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    index_find(server, key_hash(key_data, key_length), key_data, key_length,
+               &found, &slot, &record, &offset);
+    if (found < server->bucket_count) {
+        memset(&record, 0, sizeof(record));
+        record.magic = RECORD_MAGIC;
+        record.flags = RECORD_FLAG_TOMBSTONE;
+        record.key_length = (uint32_t)key_length;
+        record.creation = now_time();
+        rc = log_append(server, &record, key_data, NULL, NULL);
+    }
+
+    writer_unlock(server);
+
+    return rc;
+}
+
+/**
+ * Destroy any allocated elements of the kvstore structure.
+ *
+ * @param[out] kvstore to be destroyed.  The files are untouched.
+ * @param[in] cbdata Unused.
+ */
+static void kvdestroy(ib_kvstore_t* kvstore, ib_kvstore_cbdata_t *cbdata)
+{
+    assert(kvstore != NULL);
+
+    log_server_t *server = (log_server_t *)kvstore->server;
+
+    if (server == NULL) {
+        return;
+    }
+
+    server_close(server);
+    pthread_rwlock_destroy(&(server->lock));
+    free(server->directory);
+    free(server->log_path);
+    free(server->index_path);
+    free(server);
+    kvstore->server = NULL;
+}
+
+/**
+ * Join @a directory and @a file into a malloc'd path.
+ */
+static char *join_path(const char *directory, const char *file)
+{
+    char *path = malloc(strlen(directory) + strlen(file) + 2);
+
+    if (path != NULL) {
+        sprintf(path, "%s/%s", directory, file);
+    }
+
+    return path;
+}
+
+ib_status_t ib_kvstore_log_init(
+    ib_kvstore_t *kvstore,
+    const char *directory)
+{
+    assert(kvstore != NULL);
+    assert(directory != NULL);
+
+    log_server_t *server;
+
+    ib_kvstore_init(kvstore);
+
+    server = calloc(1, sizeof(*server));
+    if (server == NULL) {
+        return IB_EALLOC;
+    }
+
+    server->directory = strdup(directory);
+    server->log_path = join_path(directory, LOG_FILE);
+    server->index_path = join_path(directory, INDEX_FILE);
+    server->fmode = DEFAULT_FILE_MODE;
+    server->log_fd = -1;
+    server->index_fd = -1;
+    if ( (server->directory == NULL) ||
+         (server->log_path == NULL) ||
+         (server->index_path == NULL) )
+    {
+        free(server->directory);
+        free(server->log_path);
+        free(server->index_path);
+        free(server);
+        return IB_EALLOC;
+    }
+    if (pthread_rwlock_init(&(server->lock), NULL) != 0) {
+        free(server->directory);
+        free(server->log_path);
+        free(server->index_path);
+        free(server);
+        return IB_EOTHER;
+    }
+
+    kvstore->server = (ib_kvstore_server_t *)server;
+    kvstore->get = kvget;
+    kvstore->set = kvset;
+    kvstore->remove = kvremove;
+    kvstore->connect = kvconnect;
+    kvstore->disconnect = kvdisconnect;
+    kvstore->destroy = kvdestroy;
+
+    kvstore->malloc_cbdata = NULL;
+    kvstore->free_cbdata = NULL;
+    kvstore->connect_cbdata = NULL;
+    kvstore->disconnect_cbdata = NULL;
+    kvstore->get_cbdata = NULL;
+    kvstore->set_cbdata = NULL;
+    kvstore->remove_cbdata = NULL;
+    kvstore->merge_policy_cbdata = NULL;
+    kvstore->destroy_cbdata = NULL;
+
+    return IB_OK;
+}
+
+void ib_kvstore_log_set_file_mode(ib_kvstore_t *kvstore, mode_t mode)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    log_server_t *server = (log_server_t *)kvstore->server;
+
+    server->fmode = mode;
+}
+
+ib_status_t ib_kvstore_log_compact(ib_kvstore_t *kvstore)
+{
+    assert(kvstore != NULL);
+    assert(kvstore->server != NULL);
+
+    log_server_t *server = (log_server_t *)kvstore->server;
+    ib_status_t   rc;
+
+    rc = writer_lock(server);
+    if (rc != IB_OK) {
+        return rc;
+    }
+    rc = log_compact(server);
+    writer_unlock(server);
+
+    return rc;
+}
@@ -96,6 +96,7 @@ ib_status_t ib_list_push(ib_list_t *list, void *data)
         return IB_EALLOC;
     }
     node->data = data;
+    ++list->generation;
 
     if (list->nelts == 0) {
         IB_LIST_GEN_NODE_INSERT_INITIAL(list, node);
@@ -116,6 +117,7 @@ ib_status_t ib_list_pop(ib_list_t *list, void *pdata)
         return IB_ENOENT;
     }
 
+    ++list->generation;
     if (pdata != NULL) {
         *(void **)pdata = IB_LIST_GEN_NODE_DATA(list->tail);
     }
@@ -133,6 +135,7 @@ ib_status_t ib_list_unshift(ib_list_t *list, void *data)
         return IB_EALLOC;
     }
     node->data = data;
+    ++list->generation;
 
     if (list->nelts == 0) {
         IB_LIST_GEN_NODE_INSERT_INITIAL(list, node);
@@ -153,6 +156,7 @@ ib_status_t ib_list_shift(ib_list_t *list, void *pdata)
         return IB_ENOENT;
     }
 
+    ++list->generation;
     if (pdata != NULL) {
         *(void **)pdata = IB_LIST_GEN_NODE_DATA(list->head);
     }
@@ -163,6 +167,7 @@ ib_status_t ib_list_shift(ib_list_t *list, void *pdata)
 
 void ib_list_clear(ib_list_t *list)
 {
+    ++list->generation;
     list->nelts = 0;
     list->head = list->tail = NULL;
     return;
@@ -173,6 +178,11 @@ size_t ib_list_elements(const ib_list_t *list)
     return list->nelts;
 }
 
+size_t ib_list_generation(const ib_list_t *list)
+{
+    return list->generation;
+}
+
 ib_list_node_t *ib_list_first(ib_list_t *list)
 {
     return IB_LIST_GEN_FIRST(list);
@@ -215,6 +225,7 @@ const ib_list_node_t *ib_list_node_prev_const(const ib_list_node_t *node)
 
 void ib_list_node_remove(ib_list_t *list, ib_list_node_t *node)
 {
+    ++list->generation;
     IB_LIST_GEN_NODE_REMOVE(list, node);
     return;
 }
@@ -257,6 +268,7 @@ ib_status_t ib_list_insert(ib_list_t *list, void *data, const size_t index)
         return IB_EALLOC;
     }
     insert_node->data = data;
+    ++list->generation;
 
     /* If the input is valid and the list is size 0, initialize it. */
     if (IB_LIST_GEN_ELEMENTS(list) == 0) {
@@ -36,6 +36,7 @@
 #endif
 
 #include <assert.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -142,6 +143,28 @@ static char s_zero_length_buffer[1];
  **/
 #define IB_MPOOL_TRACK_ZERO_SIZE 8
 
+/**
+ * Maximum number of pages in a thread's arena cache.
+ *
+ * Arena pools return their pages to a per-thread cache when released and
+ * take pages from it before allocating new ones.  Pages beyond this limit
+ * are freed.  Arena pages are IB_MPOOL_MINIMUM_PAGESIZE bytes, so with the
+ * default tracks this bounds the cache at 4 MB per thread.
+ *
+ * @sa ib_mpool_create_arena()
+ **/
+#define IB_MPOOL_ARENA_CACHE_PAGES 32
+
+/**
+ * Maximum number of released arena pools in a thread's arena cache.
+ *
+ * Released pools keep their pointer pages and cleanup nodes, so reusing one
+ * avoids all allocation for a transaction with few large allocations.
+ *
+ * @sa ib_mpool_create_arena()
+ **/
+#define IB_MPOOL_ARENA_CACHE_POOLS 8
+
 /**@}*/
 
 /* Basic Sanity Check -- Otherwise track number calculation fails. */
@@ -389,6 +412,16 @@ struct ib_mpool_t
      **/
     ib_lock_t *lock;
 
+    /**
+     * Is this an arena pool?
+     *
+     * Arena pools have no parent and recycle themselves and their pages
+     * through the arena cache of the releasing thread.
+     *
+     * @sa ib_mpool_create_arena()
+     **/
+    bool arena;
+
     /**
      * Tracks of pages.
      *
@@ -445,6 +478,36 @@ struct ib_mpool_t
     ib_mpool_t              *free_children;
 };
 
+/**
+ * Per-thread cache of arena pages and pools.
+ *
+ * Only the owning thread accesses a cache, so it needs no locking.
+ *
+ * @sa ib_mpool_create_arena()
+ **/
+struct ib_mpool_arena_cache_t
+{
+    /** Free pages, all IB_MPOOL_MINIMUM_PAGESIZE bytes. */
+    ib_mpool_page_t *pages;
+    /** Number of pages in @c pages. */
+    size_t num_pages;
+    /** Released arena pools, linked through their @c next member. */
+    ib_mpool_t *pools;
+    /** Number of pools in @c pools. */
+    size_t num_pools;
+};
+/** See struct ib_mpool_arena_cache_t */
+typedef struct ib_mpool_arena_cache_t ib_mpool_arena_cache_t;
+
+/** Arena cache of the calling thread. */
+static __thread ib_mpool_arena_cache_t *s_arena_cache = NULL;
+/** Key to release arena caches when their threads exit. */
+static pthread_key_t s_arena_cache_key;
+/** Guard for creating @ref s_arena_cache_key. */
+static pthread_once_t s_arena_cache_once = PTHREAD_ONCE_INIT;
+/** Was @ref s_arena_cache_key created successfully? */
+static bool s_arena_cache_key_ok = false;
+
 /**
  * @name Helper functions for many things.
  */
@@ -614,6 +677,24 @@ ib_mpool_page_t *ib_mpool_alloc_pages(
     assert(mp != NULL);
     assert(pages > 0);
 
+    /* Arena pages move between pools one at a time, so each page must be
+     * its own slab. */
+    if (mp->arena && pages > 1) {
+        ib_mpool_page_t *mpage_list = NULL;
+        for (int i = 0; i < pages; ++i) {
+            ib_mpool_page_t *mpage = ib_mpool_alloc_pages(mp, 1);
+            if (mpage == NULL) {
+                IB_MPOOL_FOREACH(ib_mpool_page_t, free_page, mpage_list) {
+                    mp->free_fn(free_page);
+                }
+                return NULL;
+            }
+            mpage->next = mpage_list;
+            mpage_list = mpage;
+        }
+        return mpage_list;
+    }
+
     /* Allocate a slab of memory to hold all pages.
      *
      * NOTE: Since the ib_mpool_page_t structure size is not
@@ -646,11 +727,88 @@ ib_mpool_page_t *ib_mpool_alloc_pages(
     return mpage_list;
 }
 
+/**
+ * Release the arena cache of an exiting thread.
+ *
+ * @param[in] cbdata The @ref ib_mpool_arena_cache_t to release.
+ **/
+static
+void ib_mpool_arena_cache_destroy(void *cbdata)
+{
+    ib_mpool_arena_cache_t *cache = (ib_mpool_arena_cache_t *)cbdata;
+
+    if (cache == NULL) {
+        return;
+    }
+
+    IB_MPOOL_FOREACH(ib_mpool_page_t, mpage, cache->pages) {
+        free(mpage);
+    }
+    IB_MPOOL_FOREACH(ib_mpool_t, mp, cache->pools) {
+        /* Destroy for real rather than recycle into this cache. */
+        mp->arena = false;
+        mp->next  = NULL;
+        ib_mpool_destroy(mp);
+    }
+
+    free(cache);
+    s_arena_cache = NULL;
+
+    return;
+}
+
+/**
+ * Create @ref s_arena_cache_key.  Called once.
+ **/
+static
+void ib_mpool_arena_cache_key_create(void)
+{
+    s_arena_cache_key_ok = (
+        pthread_key_create(&s_arena_cache_key, ib_mpool_arena_cache_destroy)
+        == 0
+    );
+
+    return;
+}
+
+/**
+ * Get the arena cache of the calling thread, creating it if needed.
+ *
+ * @return Arena cache or NULL if one could not be created.
+ **/
+static
+ib_mpool_arena_cache_t *ib_mpool_arena_cache_get(void)
+{
+    ib_mpool_arena_cache_t *cache = s_arena_cache;
+
+    if (cache != NULL) {
+        return cache;
+    }
+
+    pthread_once(&s_arena_cache_once, ib_mpool_arena_cache_key_create);
+    if (! s_arena_cache_key_ok) {
+        return NULL;
+    }
+
+    cache = calloc(1, sizeof(*cache));
+    if (cache == NULL) {
+        return NULL;
+    }
+    if (pthread_setspecific(s_arena_cache_key, cache) != 0) {
+        free(cache);
+        return NULL;
+    }
+    s_arena_cache = cache;
+
+    return cache;
+}
+
 /**
  * Acquire a new page.
  *
- * Pops a page from the free list if available or allocates a new page if
- * not.  The page returned should be considered uninitialized.
+ * Pops a page from the free list if available, then from the thread's
+ * arena cache for arena pools, or allocates a new page if neither has one.
+ * The page returned should be considered uninitialized.
  *
  * @param[in] mp Memory pool to acquire page for.
  * @return Uninitialized page or NULL on allocation error.
@@ -667,12 +825,20 @@ ib_mpool_page_t *ib_mpool_acquire_page(
     if (mp->free_pages != NULL) {
         mpage = mp->free_pages;
         mp->free_pages = mp->free_pages->next;
+        return mpage;
     }
-    else {
-        mpage = ib_mpool_alloc_pages(mp, 1);
+
+    if (mp->arena) {
+        ib_mpool_arena_cache_t *cache = ib_mpool_arena_cache_get();
+        if (cache != NULL && cache->pages != NULL) {
+            mpage = cache->pages;
+            cache->pages = mpage->next;
+            --cache->num_pages;
+            return mpage;
+        }
     }
 
-    return mpage;
+    return ib_mpool_alloc_pages(mp, 1);
 }
 
 /**
@@ -783,6 +949,70 @@ void ib_mpool_call_cleanups(const ib_mpool_t *mp)
     return;
 }
 
+/**
+ * Recycle arena pool @a mp into the calling thread's arena cache.
+ *
+ * The pool is cleared and its children destroyed.  Its pages go to the
+ * page cache and the pool itself to the pool cache, as far as their limits
+ * allow.
+ *
+ * @param[in] mp Arena pool to recycle.
+ * @return true if @a mp was cached, false if it must be destroyed.
+ **/
+static
+bool ib_mpool_arena_recycle(ib_mpool_t *mp)
+{
+    assert(mp        != NULL);
+    assert(mp->arena);
+
+    ib_mpool_arena_cache_t *cache = ib_mpool_arena_cache_get();
+
+    if (cache == NULL) {
+        return false;
+    }
+
+    ib_mpool_clear(mp);
+
+    IB_MPOOL_FOREACH(ib_mpool_t, free_child, mp->free_children) {
+        free_child->parent = NULL;
+        ib_mpool_destroy(free_child);
+    }
+    IB_MPOOL_FOREACH(ib_mpool_t, child, mp->children) {
+        child->parent = NULL;
+        ib_mpool_destroy(child);
+    }
+    mp->children      = NULL;
+    mp->children_end  = NULL;
+    mp->free_children = NULL;
+
+    IB_MPOOL_FOREACH(ib_mpool_page_t, mpage, mp->free_pages) {
+        assert(mpage == mpage->slab);
+        if (cache->num_pages < IB_MPOOL_ARENA_CACHE_PAGES) {
+            mpage->next = cache->pages;
+            cache->pages = mpage;
+            ++cache->num_pages;
+        }
+        else {
+            mp->free_fn(mpage);
+        }
+    }
+    mp->free_pages = NULL;
+
+    if (cache->num_pools >= IB_MPOOL_ARENA_CACHE_POOLS) {
+        return false;
+    }
+
+#ifdef IB_MPOOL_VALGRIND
+    VALGRIND_DESTROY_MEMPOOL(mp);
+#endif
+
+    mp->next = cache->pools;
+    cache->pools = mp;
+    ++cache->num_pools;
+
+    return true;
+}
+
 /**@}*/
 
 /**
@@ -1018,6 +1248,7 @@ bool ib_mpool_debug_report_helper(
     IMR_PRINTF("  children               = %p\n",  mp->children);
     IMR_PRINTF("  children_end           = %p\n",  mp->children_end);
     IMR_PRINTF("  lock                   = %p\n",  mp->lock);
+    IMR_PRINTF("  arena                  = %d\n",  mp->arena);
     IMR_PRINTF("  tracks                 = %p\n",  mp->tracks);
     IMR_PRINTF("  large_allocations      = %p\n",  mp->large_allocations);
     IMR_PRINTF("  large_allocations_end  = %p\n",  mp->large_allocations_end);
@@ -1579,6 +1810,52 @@ failure:
     return rc;
 }
 
+ib_status_t ib_mpool_create_arena(
+    ib_mpool_t **pmp,
+    const char  *name
+)
+{
+    assert(pmp != NULL);
+
+    ib_mpool_arena_cache_t *cache = ib_mpool_arena_cache_get();
+    ib_mpool_t             *mp;
+    ib_status_t             rc;
+
+    if (cache != NULL && cache->pools != NULL) {
+        mp = cache->pools;
+        cache->pools = mp->next;
+        --cache->num_pools;
+
+        mp->next = NULL;
+        assert(mp->arena);
+        assert(mp->inuse                  == 0);
+        assert(mp->large_allocation_inuse == 0);
+
+#ifdef IB_MPOOL_VALGRIND
+        VALGRIND_CREATE_MEMPOOL(mp, IB_MPOOL_REDZONE_SIZE, 0);
+#endif
+    }
+    else {
+        rc = ib_mpool_create_ex(&mp, NULL, NULL, 0, NULL, NULL);
+        if (rc != IB_OK) {
+            *pmp = NULL;
+            return rc;
+        }
+        mp->arena = true;
+    }
+
+    rc = ib_mpool_setname(mp, name);
+    if (rc != IB_OK) {
+        ib_mpool_destroy(mp);
+        *pmp = NULL;
+        return rc;
+    }
+
+    *pmp = mp;
+
+    return IB_OK;
+}
+
 ib_status_t ib_mpool_setname(
     ib_mpool_t *mp,
     const char *name
@@ -1680,7 +1957,10 @@ void *ib_mpool_alloc(
     /* Actual size: will add redzone if small allocation. */
     size_t actual_size = size;
 
-    size_t track_number = ib_mpool_track_number(actual_size);
+    /* Most allocations fit track zero; skip the track calculation. */
+    size_t track_number =
+        (size <= IB_MPOOL_TRACK_SIZE(0)) ?
+            0 : ib_mpool_track_number(actual_size);
     if (track_number < IB_MPOOL_NUM_TRACKS) {
         /* Small allocation */
         /* Need to make sure we leave red zone at end. */
@@ -1825,6 +2105,10 @@ void ib_mpool_destroy(
     ib_mpool_t *mp
 )
 {
+    if (mp->arena && ib_mpool_arena_recycle(mp)) {
+        return;
+    }
+
     ib_mpool_call_cleanups(mp);
     ib_mpool_free_large_allocations(mp);
     ib_mpool_page_t *freeable = NULL;
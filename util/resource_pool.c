@@ -19,6 +19,17 @@
  * @file
  * @brief IronBee --- Resource Pool Implementation
  *
+ * Idle resources are kept on a lock-free stack, so acquiring an idle
+ * resource and releasing a resource never block.  Creating and destroying
+ * resources is serialized by the pool lock, which also backs waiting for
+ * a resource when the pool is at its maximum size.
+ *
+ * Resource structures are never freed while the pool exists; they live in
+ * chunks addressed by index.  The idle stack head holds the index of the
+ * top resource and a tag which changes on every update, so that a resource
+ * which is popped and pushed again between a reader's load and its
+ * compare-and-swap cannot corrupt the stack.
+ *
  * @author Sam Baskinger <sbaskinger@qualys.com>
  * @nosubgrouping
  */
@@ -26,11 +37,38 @@
 #include "ironbee_config_auto.h"
 
 #include <ironbee/resource_pool.h>
+
+#include <ironbee/atomic.h>
+#include <ironbee/clock.h>
+#include <ironbee/lock.h>
 #include <ironbee/util.h>
 
 #include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
 #include <unistd.h>
 
+/**
+ * Number of resource structures in the first chunk.
+ *
+ * Chunk @c k holds @c RESOURCE_CHUNK_BASE << @c k structures.
+ */
+#define RESOURCE_CHUNK_BASE 16
+
+/**
+ * Maximum number of chunks; enough for 2^28 resources.
+ */
+#define RESOURCE_CHUNKS 24
+
+/**
+ * Index value meaning "no resource" in a stack link.
+ *
+ * Links store the resource index plus one.
+ */
+#define RESOURCE_NONE 0
+
 /**
  * This represents a resource to be managed by an ib_resource_pool_t.
  */
@@ -38,6 +76,9 @@ struct ib_resource_t {
     ib_resource_pool_t *owner;    /**< What pool did this come from. */
     void               *resource; /**< Pointer to the user resource. */
     size_t              use;      /**< Number of times this has been used. */
+    uint32_t            index;    /**< Index of this structure. */
+    uint32_t            next;     /**< Next link in the idle or empty list. */
+    ib_time_t           released; /**< When it was last made idle. */
 };
 
 /**
@@ -45,14 +86,35 @@ struct ib_resource_t {
  */
 struct ib_resource_pool_t {
     ib_mm_t     mm;        /**< The memory manager for this pool. */
-    ib_queue_t *resources; /**< List of free ib_resource_t objs. */
+
+    /**
+     * Lock serializing resource creation and destruction.
+     *
+     * This also protects ib_resource_pool_t::chunks,
+     * ib_resource_pool_t::empty and ib_resource_pool_t::slots, and
+     * backs ib_resource_pool_t::cond.
+     */
+    ib_lock_t      *lock;
+    pthread_cond_t  cond;      /**< Signaled when waiters may proceed. */
+    size_t          waiters;   /**< Number of waiting acquirers. */
+
+    /**
+     * Head of the idle stack: tag in the high 32 bits, link in the low.
+     */
+    uint64_t    idle;
+
     /**
-     * List of empty @ref ib_resource_t.
+     * Empty resource structures, available for new resources.
      *
-     * Empty @ref ib_resource_t are pulled from here, if available,
-     * instead of allocating new ones.
+     * Empty structures are pulled from here, if available, instead of
+     * using new ones.  This is a link, as in ib_resource_t::next.
      */
-    ib_queue_t *free_queue;
+    uint32_t    empty;
+    uint32_t    slots;     /**< Number of structures handed out. */
+
+    //! Chunks of resource structures.
+    ib_resource_t *chunks[RESOURCE_CHUNKS];
+
     size_t      count;     /**< Number of created resources. */
 
     /* Callbacks. */
@@ -73,34 +135,233 @@ struct ib_resource_pool_t {
     /**
      * The total number of resource should never drop below this value.
      *
-     * If a resource being destroyed reduce count below this value,
-     * a new resource is immediately created and inserted into the
-     * free queue.
+     * Idle reaping does not destroy resources below this value.
      */
     size_t min_count;
+
+    /**
+     * Idle resources older than this are destroyed; 0 to disable.
+     *
+     * @sa ib_resource_pool_set_idle_timeout()
+     */
+    ib_time_t idle_timeout;
+
+    /**
+     * When idle resources were last reaped.
+     */
+    ib_time_t last_reap;
 };
 
 /**
- * This is registered with the memory pool passed to ib_resource_pool_create.
+ * Get the resource structure at @a index.
  *
- * @param[out] data The memory pool created.
+ * @param[in] resource_pool The resource pool.
+ * @param[in] index The index.
+ *
+ * @returns The structure.
  */
-static void ib_resource_pool_destroy(void *data) {
-    assert(data != NULL);
+static ib_resource_t *resource_at(
+    const ib_resource_pool_t *resource_pool,
+    uint32_t                  index
+)
+{
+    /* Chunk k holds the indexes [BASE * (2^k - 1), BASE * (2^(k+1) - 1)). */
+    const unsigned long n = (unsigned long)index / RESOURCE_CHUNK_BASE + 1;
+    const unsigned int  k = (sizeof(n) * 8 - 1) - __builtin_clzl(n);
+    ib_resource_t      *chunk = ib_atomic_load(&(resource_pool->chunks[k]));
 
-    ib_status_t rc;
-    ib_resource_pool_t *rp = (ib_resource_pool_t *)data;
+    assert(k < RESOURCE_CHUNKS);
+    assert(chunk != NULL);
 
-    while (ib_queue_size(rp->resources) > 0) {
-        void *v;
-        rc = ib_queue_pop_front(rp->resources, &v);
-        if (rc != IB_OK) {
-            return;
+    return &(chunk[index - RESOURCE_CHUNK_BASE * ((1UL << k) - 1)]);
+}
+
+/**
+ * Push @a resource onto the idle stack.
+ *
+ * @param[in] resource_pool The resource pool.
+ * @param[in] resource The resource.
+ */
+static void idle_push(
+    ib_resource_pool_t *resource_pool,
+    ib_resource_t      *resource
+)
+{
+    uint64_t head = ib_atomic_load(&(resource_pool->idle));
+    uint64_t new_head;
+
+    do {
+        ib_atomic_store(&(resource->next), (uint32_t)head);
+        new_head = (((head >> 32) + 1) << 32) | (resource->index + 1);
+    } while (! ib_atomic_cas(&(resource_pool->idle), &head, new_head));
+}
+
+/**
+ * Pop a resource from the idle stack.
+ *
+ * @param[in] resource_pool The resource pool.
+ *
+ * @returns A resource or NULL if the stack is empty.
+ */
+static ib_resource_t *idle_pop(
+    ib_resource_pool_t *resource_pool
+)
+{
+    uint64_t       head = ib_atomic_load(&(resource_pool->idle));
+    uint64_t       new_head;
+    ib_resource_t *resource;
+
+    do {
+        if ((uint32_t)head == RESOURCE_NONE) {
+            return NULL;
+        }
+        resource = resource_at(resource_pool, (uint32_t)head - 1);
+
+        /* If resource was popped since head was loaded, the tag differs
+         * and the CAS fails, whatever next was read here. */
+        new_head =
+            (((head >> 32) + 1) << 32) | ib_atomic_load(&(resource->next));
+    } while (! ib_atomic_cas(&(resource_pool->idle), &head, new_head));
+
+    return resource;
+}
+
+/**
+ * Count the resources on the idle stack released before @a before.
+ *
+ * This walks the stack without taking it, so acquirers may pop and push
+ * concurrently; the count is then only an estimate.  Links always name
+ * allocated structures, so the walk is safe, and it is bounded in case
+ * concurrent changes make it revisit structures.
+ *
+ * This requires the caller to hold the pool lock.
+ *
+ * @param[in] resource_pool The resource pool.
+ * @param[in] before Count resources released before this time.
+ *
+ * @returns The number of resources.
+ */
+static size_t idle_count_before(
+    ib_resource_pool_t *resource_pool,
+    ib_time_t           before
+)
+{
+    uint32_t link  = (uint32_t)ib_atomic_load(&(resource_pool->idle));
+    size_t   count = 0;
+
+    for (uint32_t i = 0; i < resource_pool->slots; ++i) {
+        ib_resource_t *resource;
+
+        if (link == RESOURCE_NONE) {
+            break;
+        }
+        resource = resource_at(resource_pool, link - 1);
+        if (ib_atomic_load_relaxed(&(resource->released)) < before) {
+            ++count;
+        }
+        link = ib_atomic_load(&(resource->next));
+    }
+
+    return count;
+}
+
+/**
+ * Wake up acquirers waiting in ib_resource_acquire_timed().
+ *
+ * @param[in] resource_pool The resource pool.
+ * @param[in] locked Does the caller hold the pool lock?
+ */
+static void wake_waiters(
+    ib_resource_pool_t *resource_pool,
+    bool                locked
+)
+{
+    /* Order the caller's update before the check; pairs with the
+     * increment in wait_for_resource(). */
+    ib_atomic_fence();
+    if (ib_atomic_load(&(resource_pool->waiters)) == 0) {
+        return;
+    }
+
+    if (! locked) {
+        ib_lock_lock(resource_pool->lock);
+    }
+    pthread_cond_broadcast(&(resource_pool->cond));
+    if (! locked) {
+        ib_lock_unlock(resource_pool->lock);
+    }
+}
+
+/**
+ * Count a new resource against the maximum.
+ *
+ * @param[in] resource_pool The resource pool.
+ *
+ * @returns True if a resource may be created.
+ */
+static bool reserve_resource(
+    ib_resource_pool_t *resource_pool
+)
+{
+    size_t count = ib_atomic_load(&(resource_pool->count));
+
+    do {
+        const size_t max_count = ib_atomic_load(&(resource_pool->max_count));
+
+        if (max_count != 0 && count >= max_count) {
+            return false;
         }
+    } while (! ib_atomic_cas(&(resource_pool->count), &count, count + 1));
+
+    return true;
+}
 
-        ib_resource_t *r = (ib_resource_t *)v;
-        (rp->destroy_fn)(r->resource, rp->destroy_data);
+/**
+ * Get an empty resource structure.
+ *
+ * This requires the caller to hold the pool lock.
+ *
+ * @param[in] resource_pool The resource pool.
+ *
+ * @returns The structure or NULL on allocation failure.
+ */
+static ib_resource_t *empty_resource(
+    ib_resource_pool_t *resource_pool
+)
+{
+    ib_resource_t *resource;
+    unsigned int   k;
+    unsigned long  n;
+
+    /* Attempt to get an already allocated resource struct. */
+    if (resource_pool->empty != RESOURCE_NONE) {
+        resource = resource_at(resource_pool, resource_pool->empty - 1);
+        resource_pool->empty = resource->next;
+        return resource;
+    }
+
+    /* Otherwise, take the next one, allocating a chunk if need be. */
+    n = (unsigned long)resource_pool->slots / RESOURCE_CHUNK_BASE + 1;
+    k = (sizeof(n) * 8 - 1) - __builtin_clzl(n);
+    if (k >= RESOURCE_CHUNKS) {
+        return NULL;
+    }
+    if (resource_pool->chunks[k] == NULL) {
+        ib_resource_t *chunk = ib_mm_calloc(
+            resource_pool->mm,
+            RESOURCE_CHUNK_BASE << k,
+            sizeof(*chunk));
+        if (chunk == NULL) {
+            return NULL;
+        }
+        ib_atomic_store(&(resource_pool->chunks[k]), chunk);
     }
+
+    resource = resource_at(resource_pool, resource_pool->slots);
+    resource->index = resource_pool->slots;
+    ++(resource_pool->slots);
+
+    return resource;
 }
 
 /**
@@ -110,9 +371,11 @@ static void ib_resource_pool_destroy(void *data) {
  * may create new @ref ib_resource_t. This function isolates that
  * common code.
  *
+ * The caller must have counted the resource with reserve_resource(); it
+ * is uncounted again on failure.
+ *
  * @returns
  * - IB_OK On success.
- * - IB_DECLINED If the max limit is reached.
  * - IB_EALLOC If an allocation error occurs.
  * - Other from the user create function.
  */
@@ -129,41 +392,172 @@ static ib_status_t create_resource(
 
     void *user_resource = NULL;
 
+    rc = ib_lock_lock(resource_pool->lock);
+    if (rc != IB_OK) {
+        goto failure;
+    }
+
     /* It is most likely that resource creation will fail.
     * Do this first to detect most likely errors fast. */
     rc = (resource_pool->create_fn)(
             &user_resource,
             resource_pool->create_data);
     if (rc != IB_OK) {
-        return rc;
+        ib_lock_unlock(resource_pool->lock);
+        goto failure;
     }
 
-    /* Attempt to get an already allocated resource struct. */
-    if (ib_queue_size(resource_pool->free_queue) > 0) {
-        rc = ib_queue_pop_front(
-            resource_pool->free_queue,
-            &tmp_resource);
-        if (rc != IB_OK) {
-            return rc;
-        }
-    }
-    /* Otherwise, allocate a new one. */
-    else {
-        tmp_resource = ib_mm_alloc(resource_pool->mm, sizeof(*tmp_resource));
-        if (tmp_resource == NULL) {
-            return IB_EALLOC;
-        }
+    tmp_resource = empty_resource(resource_pool);
+    if (tmp_resource == NULL) {
+        (resource_pool->destroy_fn)(
+            user_resource,
+            resource_pool->destroy_data);
+        ib_lock_unlock(resource_pool->lock);
+        rc = IB_EALLOC;
+        goto failure;
     }
 
+    ib_lock_unlock(resource_pool->lock);
+
     tmp_resource->use = 0;
     tmp_resource->owner = resource_pool;
     tmp_resource->resource = user_resource;
 
-    ++(resource_pool->count);
-
     *resource = tmp_resource;
 
     return IB_OK;
+
+failure:
+    ib_atomic_sub(&(resource_pool->count), 1);
+    wake_waiters(resource_pool, false);
+    return rc;
+}
+
+/**
+ * Destroy the resource @a resource.
+ *
+ * This requires the caller to hold the pool lock.
+ *
+ * @param[in] resource Destroy this resource.
+ */
+static void destroy_resource(
+    ib_resource_t *resource
+)
+{
+    assert(resource != NULL);
+    assert(resource->owner != NULL);
+
+    ib_resource_pool_t *resource_pool = resource->owner;
+
+    (resource_pool->destroy_fn)(
+        resource->resource,
+        resource_pool->destroy_data);
+    resource->use = 0;
+    resource->resource = NULL;
+
+    /* Store the empty resource struct for reuse.  A stale idle_pop() or
+     * idle_count_before() may still read next. */
+    ib_atomic_store_relaxed(&(resource->next), resource_pool->empty);
+    resource_pool->empty = resource->index + 1;
+
+    ib_atomic_sub(&(resource_pool->count), 1);
+
+    /* A waiter may now create a resource. */
+    wake_waiters(resource_pool, true);
+}
+
+/**
+ * Destroy idle resources.
+ *
+ * Resources are popped from the idle stack one at a time, so acquirers
+ * still find the rest of the stack while this runs.  Idle resources are
+ * interchangeable, so when reaping, as many resources as have been idle
+ * for too long are destroyed, whichever are on top of the stack.
+ *
+ * This requires the caller to hold the pool lock.
+ *
+ * @param[in] resource_pool The resource pool.
+ * @param[in] all Destroy all idle resources? Otherwise, only as many as
+ *            have been idle for longer than
+ *            ib_resource_pool_t::idle_timeout are destroyed, and not below
+ *            ib_resource_pool_t::min_count.
+ */
+static void destroy_idle(
+    ib_resource_pool_t *resource_pool,
+    bool                all
+)
+{
+    size_t remaining = SIZE_MAX;
+
+    if (! all) {
+        const ib_time_t now = ib_clock_get_time();
+        const ib_time_t timeout =
+            ib_atomic_load(&(resource_pool->idle_timeout));
+
+        remaining = idle_count_before(resource_pool, now - timeout + 1);
+    }
+
+    for (; remaining > 0; --remaining) {
+        ib_resource_t *resource;
+
+        if (! all &&
+            ib_atomic_load(&(resource_pool->count)) <=
+                ib_atomic_load(&(resource_pool->min_count)))
+        {
+            break;
+        }
+
+        resource = idle_pop(resource_pool);
+        if (resource == NULL) {
+            break;
+        }
+        destroy_resource(resource);
+    }
+}
+
+/**
+ * Destroy resources idle for too long, if it is time to check.
+ *
+ * At most one thread reaps per ib_resource_pool_t::idle_timeout.
+ *
+ * @param[in] resource_pool The resource pool.
+ * @param[in] now The current time.
+ */
+static void maybe_reap(
+    ib_resource_pool_t *resource_pool,
+    ib_time_t           now
+)
+{
+    const ib_time_t timeout = ib_atomic_load(&(resource_pool->idle_timeout));
+    ib_time_t       last = ib_atomic_load(&(resource_pool->last_reap));
+
+    if (timeout == 0 || now - last < timeout) {
+        return;
+    }
+    if (! ib_atomic_cas(&(resource_pool->last_reap), &last, now)) {
+        /* Someone else is reaping. */
+        return;
+    }
+
+    if (ib_lock_lock(resource_pool->lock) != IB_OK) {
+        return;
+    }
+    destroy_idle(resource_pool, false);
+    ib_lock_unlock(resource_pool->lock);
+}
+
+/**
+ * This is registered with the memory pool passed to ib_resource_pool_create.
+ *
+ * @param[out] data The memory pool created.
+ */
+static void ib_resource_pool_destroy(void *data) {
+    assert(data != NULL);
+
+    ib_resource_pool_t *rp = (ib_resource_pool_t *)data;
+
+    destroy_idle(rp, true);
+    pthread_cond_destroy(&(rp->cond));
 }
 
 /**
@@ -183,17 +577,21 @@ static ib_status_t fill_to_min(
     assert(resource_pool != NULL);
 
     /* Pre-create the minimum number of items. */
-    while (resource_pool->min_count > resource_pool->count) {
+    while (ib_atomic_load(&(resource_pool->min_count)) >
+           ib_atomic_load(&(resource_pool->count)))
+    {
         ib_resource_t *r;
         ib_status_t rc;
-        rc = create_resource(resource_pool, &r);
-        if (rc != IB_OK) {
-            return rc;
+
+        if (! reserve_resource(resource_pool)) {
+            break;
         }
-        rc = ib_queue_push_back(resource_pool->resources, r);
+        rc = create_resource(resource_pool, &r);
         if (rc != IB_OK) {
             return rc;
         }
+        ib_atomic_store_relaxed(&(r->released), ib_clock_get_time());
+        idle_push(resource_pool, r);
     }
 
     return IB_OK;
@@ -230,14 +628,13 @@ ib_status_t ib_resource_pool_create(
         return IB_EALLOC;
     }
 
-    rc = ib_queue_create(&(rp->resources), mm, IB_QUEUE_NONE);
+    rc = ib_lock_create(&(rp->lock), mm);
     if (rc != IB_OK) {
         return rc;
     }
 
-    rc = ib_queue_create(&(rp->free_queue), mm, IB_QUEUE_NONE);
-    if (rc != IB_OK) {
-        return rc;
+    if (pthread_cond_init(&(rp->cond), NULL) != 0) {
+        return IB_EALLOC;
     }
 
     rp->mm = mm;
@@ -253,14 +650,17 @@ ib_status_t ib_resource_pool_create(
     rp->postuse_data = postuse_data;
 
     /* Assign limits, initialize counters. */
-    rp->count     = 0;
-
-    /* Arcane casting to get around the C constness of {max,min}_count. */
-    *(size_t *)&(rp->max_count) = max_count;
-    *(size_t *)&(rp->min_count) = min_count;
+    rp->count        = 0;
+    rp->max_count    = max_count;
+    rp->min_count    = min_count;
+    rp->idle         = RESOURCE_NONE;
+    rp->empty        = RESOURCE_NONE;
+    rp->idle_timeout = 0;
+    rp->last_reap    = ib_clock_get_time();
 
     rc = ib_mm_register_cleanup(mm, ib_resource_pool_destroy, rp);
     if (rc != IB_OK) {
+        pthread_cond_destroy(&(rp->cond));
         return rc;
     }
 
@@ -275,61 +675,113 @@ ib_status_t ib_resource_pool_create(
     return IB_OK;
 }
 
-ib_status_t ib_resource_acquire(
-    ib_resource_pool_t *resource_pool,
-    ib_resource_t **resource
+/**
+ * Wait for a resource to be released or destroyed.
+ *
+ * @param[in] resource_pool The resource pool.
+ * @param[in] deadline The absolute time to wait until.
+ * @param[out] resource An idle resource, if one was found while waiting.
+ *
+ * @returns
+ * - IB_OK If woken or a resource was found; try again.
+ * - IB_DECLINED If @a deadline has passed.
+ * - Other on locking errors.
+ */
+static ib_status_t wait_for_resource(
+    ib_resource_pool_t    *resource_pool,
+    const struct timespec *deadline,
+    ib_resource_t        **resource
+)
+{
+    ib_status_t rc;
+    int         wait_rc = 0;
+
+    rc = ib_lock_lock(resource_pool->lock);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    /* Register before checking for idle resources, so that a release
+     * after the check will see us and signal. */
+    ib_atomic_add(&(resource_pool->waiters), 1);
+
+    *resource = idle_pop(resource_pool);
+    if (*resource == NULL) {
+        const size_t max_count = ib_atomic_load(&(resource_pool->max_count));
+
+        if (max_count == 0 ||
+            ib_atomic_load(&(resource_pool->count)) < max_count)
+        {
+            /* Room to create one. */
+            wait_rc = 0;
+        }
+        else {
+            wait_rc = pthread_cond_timedwait(
+                &(resource_pool->cond),
+                resource_pool->lock,
+                deadline);
+        }
+    }
+
+    ib_atomic_sub(&(resource_pool->waiters), 1);
+    ib_lock_unlock(resource_pool->lock);
+
+    return (wait_rc == ETIMEDOUT) ? IB_DECLINED : IB_OK;
+}
+
+ib_status_t ib_resource_acquire_timed(
+    ib_resource_pool_t  *resource_pool,
+    ib_resource_t      **resource,
+    ib_time_t            timeout
 )
 {
     assert(resource_pool != NULL);
     assert(resource != NULL);
 
-    ib_resource_t *tmp_resource = NULL;
-    ib_status_t rc;
-
-    /* If there is a free resource, acquire it. */
-    if (ib_queue_size(resource_pool->resources) > 0) {
-        rc = ib_queue_pop_front(
-            resource_pool->resources,
-            &tmp_resource);
-        if (rc != IB_OK) {
-            goto failure;
+    ib_resource_t   *tmp_resource = NULL;
+    ib_status_t      rc;
+    struct timespec  deadline;
+
+    if (timeout > 0) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec  += timeout / 1000000;
+        deadline.tv_nsec += (timeout % 1000000) * 1000;
+        if (deadline.tv_nsec >= 1000000000) {
+            deadline.tv_sec  += 1;
+            deadline.tv_nsec -= 1000000000;
         }
+    }
 
-        /* Ensure that we have a resource. */
-        if (tmp_resource == NULL) {
-            ib_util_log_error("Resource queue returned NULL.");
-            rc = IB_DECLINED;
-            goto failure;
+    for (;;) {
+        /* If there is a free resource, acquire it. */
+        tmp_resource = idle_pop(resource_pool);
+        if (tmp_resource != NULL) {
+            break;
         }
 
-        goto success;
-    }
-    /* If we may create a new resource, do so. */
-    else if (   (resource_pool->max_count == 0)
-             || (resource_pool->max_count > resource_pool->count) )
-    {
-        rc = create_resource(resource_pool, &tmp_resource);
-        if (rc != IB_OK) {
-            goto failure;
+        /* If we may create a new resource, do so. */
+        if (reserve_resource(resource_pool)) {
+            rc = create_resource(resource_pool, &tmp_resource);
+            if (rc != IB_OK) {
+                return rc;
+            }
+            break;
         }
 
-        /* Ensure that we have a resource. */
-        if (tmp_resource == NULL) {
-            ib_util_log_error("Creation function created NULL resource.");
-            rc = IB_DECLINED;
-            goto failure;
+        /* If we may not wait for the resource, fail w/ IB_DECLINED. */
+        if (timeout == 0) {
+            return IB_DECLINED;
         }
 
-        goto success;
-    }
-    /* If we may not wait for the resource, fail w/ IB_DECLINED. */
-    else {
-        rc = IB_DECLINED;
-        goto failure;
+        rc = wait_for_resource(resource_pool, &deadline, &tmp_resource);
+        if (rc != IB_OK) {
+            return rc;
+        }
+        if (tmp_resource != NULL) {
+            break;
+        }
     }
 
-success:
-
     if (resource_pool->preuse_fn != NULL) {
         (resource_pool->preuse_fn)(
             tmp_resource->resource,
@@ -339,43 +791,15 @@ success:
     ++(tmp_resource->use);
 
     *resource = tmp_resource;
-    return rc;
-
-failure:
-    return rc;
+    return IB_OK;
 }
 
-/**
- * Destroy the resource @a resource.
- * @param[in] resource Destroy this resource.
- * @returns
- * - IB_OK On success.
- * - IB_EALLOC If the empty ib_resource_t cannot be put in the free queue.
- */
-static ib_status_t destroy_resource(
-    ib_resource_t *resource
+ib_status_t ib_resource_acquire(
+    ib_resource_pool_t *resource_pool,
+    ib_resource_t **resource
 )
 {
-    assert(resource != NULL);
-    assert(resource->owner != NULL);
-
-    ib_status_t rc;
-
-    (resource->owner->destroy_fn)(
-        resource->resource,
-        resource->owner->destroy_data);
-    resource->use = 0;
-    resource->resource = NULL;
-
-    --(resource->owner->count);
-
-    /* Store the empty resource struct on the free queue for reused. */
-    rc = ib_queue_push_back(resource->owner->free_queue, resource);
-    if (rc != IB_OK) {
-        return rc;
-    }
-
-    return IB_OK;
+    return ib_resource_acquire_timed(resource_pool, resource, 0);
 }
 
 ib_status_t ib_resource_release(
@@ -385,23 +809,36 @@ ib_status_t ib_resource_release(
     assert(resource != NULL);
     assert(resource->owner != NULL);
 
-    ib_status_t rc;
+    ib_resource_pool_t *resource_pool = resource->owner;
+    ib_status_t         rc;
+    ib_time_t           now;
 
     /* If a postuse function is defined, handle it. */
-    if (resource->owner->postuse_fn != NULL) {
-        rc = (resource->owner->postuse_fn)(
+    if (resource_pool->postuse_fn != NULL) {
+        rc = (resource_pool->postuse_fn)(
             resource->resource,
-            resource->owner->postuse_data);
+            resource_pool->postuse_data);
 
         /* If the user says that the resource is invalid, destroy it. */
         if (rc == IB_EINVAL) {
-            return destroy_resource(resource);
+            rc = ib_lock_lock(resource_pool->lock);
+            if (rc != IB_OK) {
+                return rc;
+            }
+            destroy_resource(resource);
+            ib_lock_unlock(resource_pool->lock);
+            return IB_OK;
         }
     }
 
-    rc = ib_queue_push_back(resource->owner->resources, resource);
+    now = ib_clock_get_time();
+    ib_atomic_store_relaxed(&(resource->released), now);
 
-    return rc;
+    idle_push(resource_pool, resource);
+    wake_waiters(resource_pool, false);
+    maybe_reap(resource_pool, now);
+
+    return IB_OK;
 }
 
 void *ib_resource_get(const ib_resource_t* resource)
@@ -420,11 +857,13 @@ ib_status_t ib_resource_pool_set_min(ib_resource_pool_t *pool, size_t limit)
 {
     assert(pool != NULL);
 
-    if (pool->max_count != 0 && pool->max_count < limit) {
+    const size_t max_count = ib_atomic_load(&(pool->max_count));
+
+    if (max_count != 0 && max_count < limit) {
         return IB_EINVAL;
     }
 
-    pool->min_count = limit;
+    ib_atomic_store(&(pool->min_count), limit);
 
     return IB_OK;
 }
@@ -434,15 +873,62 @@ ib_status_t ib_resource_pool_set_max(ib_resource_pool_t *pool, size_t limit)
     assert(pool != NULL);
 
     /* MAX cannot be less than MIN. */
-    if (limit != 0 && limit < pool->min_count) {
+    if (limit != 0 && limit < ib_atomic_load(&(pool->min_count))) {
         return IB_EINVAL;
     }
 
-    pool->max_count = limit;
+    ib_atomic_store(&(pool->max_count), limit);
+
+    /* A raised limit may let waiters create resources. */
+    wake_waiters(pool, false);
+
+    return IB_OK;
+}
+
+void ib_resource_pool_set_idle_timeout(
+    ib_resource_pool_t *pool,
+    ib_time_t           timeout
+)
+{
+    assert(pool != NULL);
+
+    ib_atomic_store(&(pool->idle_timeout), timeout);
+}
+
+ib_status_t ib_resource_pool_reap(
+    ib_resource_pool_t *pool
+)
+{
+    assert(pool != NULL);
+
+    ib_status_t rc;
+
+    if (ib_atomic_load(&(pool->idle_timeout)) == 0) {
+        return IB_OK;
+    }
+
+    rc = ib_lock_lock(pool->lock);
+    if (rc != IB_OK) {
+        return rc;
+    }
+
+    ib_atomic_store(&(pool->last_reap), ib_clock_get_time());
+    destroy_idle(pool, false);
+
+    ib_lock_unlock(pool->lock);
 
     return IB_OK;
 }
 
+size_t ib_resource_pool_count(
+    const ib_resource_pool_t *pool
+)
+{
+    assert(pool != NULL);
+
+    return ib_atomic_load(&(pool->count));
+}
+
 ib_status_t ib_resource_pool_flush(
     ib_resource_pool_t *resource_pool
 )
@@ -451,17 +937,13 @@ ib_status_t ib_resource_pool_flush(
 
     ib_status_t rc;
 
-    /* Destroy all the resources. */
-    while (resource_pool->count > 0) {
-        ib_resource_t *r;
-
-        rc = ib_queue_pop_front(resource_pool->resources, &r);
-        if (rc != IB_OK) {
-            return rc;
-        }
-
-        destroy_resource(r);
+    /* Destroy all the idle resources. */
+    rc = ib_lock_lock(resource_pool->lock);
+    if (rc != IB_OK) {
+        return rc;
     }
+    destroy_idle(resource_pool, true);
+    ib_lock_unlock(resource_pool->lock);
 
     /* Fill to the minimum. */
     rc = fill_to_min(resource_pool);
@@ -571,4 +571,45 @@ TEST_F(TestIBUtilList, test_insert) {
     ASSERT_EQ(IB_OK, ib_list_shift(list, &p));
     ASSERT_EQ(&k, p) << "k expected";
 
-}
\ No newline at end of file
+}
+/// @test Test util list library - ib_list_generation()
+TEST_F(TestIBUtilList, test_list_generation) {
+    ib_list_t      *list;
+    void           *p;
+    size_t          generation;
+
+    int i = 1, j = 2;
+
+    ASSERT_EQ(IB_OK, ib_list_create(&list, MM()));
+    generation = ib_list_generation(list);
+
+    ASSERT_EQ(IB_OK, ib_list_push(list, &i));
+    ASSERT_NE(generation, ib_list_generation(list));
+    generation = ib_list_generation(list);
+
+    ASSERT_EQ(IB_OK, ib_list_unshift(list, &j));
+    ASSERT_NE(generation, ib_list_generation(list));
+    generation = ib_list_generation(list);
+
+    /* Same length and last node, but a different first node. */
+    ib_list_node_remove(list, ib_list_first(list));
+    ASSERT_EQ(IB_OK, ib_list_insert(list, &i, 0));
+    ASSERT_EQ(2UL, ib_list_elements(list));
+    ASSERT_NE(generation, ib_list_generation(list));
+    generation = ib_list_generation(list);
+
+    ASSERT_EQ(IB_OK, ib_list_pop(list, &p));
+    ASSERT_NE(generation, ib_list_generation(list));
+    generation = ib_list_generation(list);
+
+    ASSERT_EQ(IB_OK, ib_list_shift(list, &p));
+    ASSERT_NE(generation, ib_list_generation(list));
+    generation = ib_list_generation(list);
+
+    /* Failed removals do not change the list. */
+    ASSERT_EQ(IB_ENOENT, ib_list_pop(list, &p));
+    ASSERT_EQ(generation, ib_list_generation(list));
+
+    ib_list_clear(list);
+    ASSERT_NE(generation, ib_list_generation(list));
+}
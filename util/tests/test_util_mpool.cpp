@@ -852,3 +852,87 @@ TEST(TestMpool, ReleaseComplex)
     ASSERT_EQ(g_malloc_calls, g_free_calls);
     ASSERT_EQ(g_malloc_bytes, g_free_bytes);
 }
+
+extern "C" {
+
+static
+void count_cleanup(void *cbdata)
+{
+    ++*reinterpret_cast<int *>(cbdata);
+}
+
+}
+
+TEST(TestMpool, ArenaRecycle)
+{
+    ib_mpool_t* mp = NULL;
+    ib_mpool_t* child = NULL;
+    int         cleanups = 0;
+
+    ib_status_t rc = ib_mpool_create_arena(&mp, "arena");
+    ASSERT_EQ(IB_OK, rc);
+    ASSERT_TRUE(mp);
+    EXPECT_EQ(string("arena"), ib_mpool_name(mp));
+    EXPECT_FALSE(ib_mpool_parent(mp));
+
+    char* small = (char *)ib_mpool_alloc(mp, 16);
+    ASSERT_TRUE(small);
+    char* medium = (char *)ib_mpool_alloc(mp, 1000);
+    ASSERT_TRUE(medium);
+    void* large = ib_mpool_alloc(mp, 1 << 20);
+    ASSERT_TRUE(large);
+    ASSERT_EQ(IB_OK, ib_mpool_cleanup_register(mp, count_cleanup, &cleanups));
+    ASSERT_EQ(IB_OK, ib_mpool_create(&child, "child", mp));
+    ASSERT_EQ(IB_OK, ib_mpool_cleanup_register(child, count_cleanup, &cleanups));
+    EXPECT_VALID(mp);
+
+    ib_mpool_release(mp);
+    EXPECT_EQ(2, cleanups);
+
+    /* The pool and its pages come back from the thread's cache. */
+    ib_mpool_t* mp2 = NULL;
+    rc = ib_mpool_create_arena(&mp2, "arena2");
+    ASSERT_EQ(IB_OK, rc);
+    EXPECT_EQ(mp, mp2);
+    EXPECT_EQ(string("arena2"), ib_mpool_name(mp2));
+    EXPECT_EQ(0U, ib_mpool_inuse(mp2));
+    EXPECT_VALID(mp2);
+
+    char* small2 = (char *)ib_mpool_alloc(mp2, 16);
+    ASSERT_TRUE(small2);
+    small2[15] = 'x';
+    EXPECT_VALID(mp2);
+
+    ib_mpool_destroy(mp2);
+    EXPECT_EQ(2, cleanups);
+}
+
+namespace {
+
+void muck_with_arenas()
+{
+    static const size_t num_mucks = (size_t)1e4;
+    ib_mpool_t* mp;
+
+    for (size_t i = 0; i < num_mucks; ++i) {
+        ASSERT_EQ(IB_OK, ib_mpool_create_arena(&mp, NULL));
+        for (size_t j = 0; j < 8; ++j) {
+            ASSERT_TRUE(ib_mpool_alloc(mp, 32 << j));
+        }
+        ib_mpool_destroy(mp);
+    }
+}
+
+}
+
+TEST(TestMpool, ArenaMultithreading)
+{
+    static const size_t num_threads = 4;
+
+    boost::thread_group threads;
+    for (size_t i = 0; i < num_threads; ++i) {
+        threads.create_thread(muck_with_arenas);
+    }
+
+    threads.join_all();
+}
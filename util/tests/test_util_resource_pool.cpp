@@ -24,12 +24,16 @@
 
 #include "ironbee_config_auto.h"
 
+#include <ironbee/atomic.h>
 #include <ironbee/mm.h>
 #include <ironbee/mm_mpool.h>
 #include <ironbee/resource_pool.h>
 
 #include "gtest/gtest.h"
 
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
 namespace {
 extern "C" {
     //! The resource we are going to build and test the resource pool with.
@@ -234,3 +238,181 @@ TEST_F(ResourcePoolTest, create_destroy) {
         }
     }
 }
+
+namespace {
+
+//! Release @a resource after a short delay.
+void delayed_release(ib_resource_t *resource)
+{
+    boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    ib_resource_release(resource);
+}
+
+} // anonymous namespace
+
+TEST_F(ResourcePoolTest, acquire_timed) {
+    ib_resource_t *ib_r[10];
+    ib_resource_t *extra;
+    ib_time_t      start;
+
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(IB_OK, ib_resource_acquire(m_rp, &ib_r[i]));
+    }
+
+    /* Time out waiting for the 11th resource. */
+    start = ib_clock_get_time();
+    ASSERT_EQ(IB_DECLINED, ib_resource_acquire_timed(m_rp, &extra, 20000));
+    ASSERT_LE(20000U, ib_clock_get_time() - start);
+
+    /* Get it when another thread releases one. */
+    boost::thread releaser(boost::bind(&delayed_release, ib_r[0]));
+    ASSERT_EQ(IB_OK, ib_resource_acquire_timed(m_rp, &extra, 10000000));
+    releaser.join();
+    ib_r[0] = extra;
+
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(IB_OK, ib_resource_release(ib_r[i]));
+    }
+}
+
+TEST_F(ResourcePoolTest, idle_reap) {
+    ib_resource_t *ib_r[5];
+
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_EQ(IB_OK, ib_resource_acquire(m_rp, &ib_r[i]));
+    }
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_EQ(IB_OK, ib_resource_release(ib_r[i]));
+    }
+    ASSERT_EQ(5U, ib_resource_pool_count(m_rp));
+
+    /* Reaping is disabled by default. */
+    ASSERT_EQ(IB_OK, ib_resource_pool_reap(m_rp));
+    ASSERT_EQ(5U, ib_resource_pool_count(m_rp));
+
+    /* Nothing has been idle long enough. */
+    ib_resource_pool_set_idle_timeout(m_rp, 1000000);
+    ASSERT_EQ(IB_OK, ib_resource_pool_reap(m_rp));
+    ASSERT_EQ(5U, ib_resource_pool_count(m_rp));
+
+    /* Everything is idle, but the pool keeps its minimum. */
+    ib_resource_pool_set_idle_timeout(m_rp, 1000);
+    boost::this_thread::sleep(boost::posix_time::milliseconds(5));
+    ASSERT_EQ(IB_OK, ib_resource_pool_reap(m_rp));
+    ASSERT_EQ(1U, ib_resource_pool_count(m_rp));
+
+    /* The pool still works. */
+    ASSERT_EQ(IB_OK, ib_resource_acquire(m_rp, &ib_r[0]));
+    ASSERT_EQ(IB_OK, ib_resource_release(ib_r[0]));
+}
+
+namespace {
+
+//! Acquire and release resources from many threads.
+void acquire_release(ib_resource_pool_t *rp, int *failures)
+{
+    for (int i = 0; i < 10000; ++i) {
+        ib_resource_t *ib_r;
+        resource_t    *r;
+
+        if (ib_resource_acquire_timed(rp, &ib_r, 10000000) != IB_OK) {
+            ++(*failures);
+            continue;
+        }
+
+        /* No one else may use this resource now. */
+        r = reinterpret_cast<resource_t *>(ib_resource_get(ib_r));
+        ++(r->use);
+        if (r->use != r->preuse || r->destroy != 0) {
+            ++(*failures);
+        }
+
+        if (ib_resource_release(ib_r) != IB_OK) {
+            ++(*failures);
+        }
+    }
+}
+
+} // anonymous namespace
+
+TEST_F(ResourcePoolTest, concurrent) {
+    static const int c_num_threads = 16;
+    boost::thread_group threads;
+    int failures[c_num_threads] = { 0 };
+
+    for (int i = 0; i < c_num_threads; ++i) {
+        threads.create_thread(
+            boost::bind(&acquire_release, m_rp, &failures[i]));
+    }
+    threads.join_all();
+
+    for (int i = 0; i < c_num_threads; ++i) {
+        EXPECT_EQ(0, failures[i]);
+    }
+    EXPECT_GE(10U, ib_resource_pool_count(m_rp));
+}
+
+namespace {
+
+//! Acquire and release resources without waiting.
+void acquire_release_nowait(ib_resource_pool_t *rp, int *failures)
+{
+    for (int i = 0; i < 10000; ++i) {
+        ib_resource_t *ib_r;
+        resource_t    *r;
+
+        /* There are fewer threads than the maximum, and the reaper
+         * only holds the one resource it is destroying, so this must not
+         * be declined. */
+        if (ib_resource_acquire(rp, &ib_r) != IB_OK) {
+            ++(*failures);
+            continue;
+        }
+
+        r = reinterpret_cast<resource_t *>(ib_resource_get(ib_r));
+        if (r->destroy != 0) {
+            ++(*failures);
+        }
+
+        if (ib_resource_release(ib_r) != IB_OK) {
+            ++(*failures);
+        }
+    }
+}
+
+//! Reap idle resources until @a stop is set.
+void reap_until(ib_resource_pool_t *rp, const bool *stop, int *reaps)
+{
+    while (! ib_atomic_load(stop)) {
+        ib_resource_pool_reap(rp);
+        ++(*reaps);
+    }
+}
+
+} // anonymous namespace
+
+TEST_F(ResourcePoolTest, concurrent_reap) {
+    static const int c_num_threads = 9;
+    boost::thread_group threads;
+    int failures[c_num_threads] = { 0 };
+    int reaps = 0;
+    bool stop = false;
+
+    /* Everything idle is reaped. */
+    ib_resource_pool_set_idle_timeout(m_rp, 1);
+
+    boost::thread reaper(boost::bind(&reap_until, m_rp, &stop, &reaps));
+    for (int i = 0; i < c_num_threads; ++i) {
+        threads.create_thread(
+            boost::bind(&acquire_release_nowait, m_rp, &failures[i]));
+    }
+    threads.join_all();
+    ib_atomic_store(&stop, true);
+    reaper.join();
+
+    for (int i = 0; i < c_num_threads; ++i) {
+        EXPECT_EQ(0, failures[i]);
+    }
+    EXPECT_LT(0, reaps);
+    EXPECT_GE(10U, ib_resource_pool_count(m_rp));
+}
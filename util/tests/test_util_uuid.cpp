@@ -28,7 +28,48 @@
 
 #include "gtest/gtest.h"
 
+#include <boost/thread.hpp>
+
+#include <set>
+#include <string>
+#include <vector>
+
 #include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+//! Check that @a uuid is a well formed, lower case, v4 UUID.
+void check_v4(const char *uuid)
+{
+    ASSERT_EQ(IB_UUID_LENGTH - 1, strlen(uuid));
+    for (int i = 0; i < IB_UUID_LENGTH - 1; ++i) {
+        if (i == 8 || i == 13 || i == 18 || i == 23) {
+            EXPECT_EQ('-', uuid[i]) << uuid;
+        }
+        else {
+            EXPECT_TRUE(strchr("0123456789abcdef", uuid[i]) != NULL) << uuid;
+        }
+    }
+    EXPECT_EQ('4', uuid[14]) << uuid;
+    EXPECT_TRUE(strchr("89ab", uuid[19]) != NULL) << uuid;
+}
+
+//! Create @a n UUIDs into @a out.
+void create_many(std::vector<std::string> *out, size_t n)
+{
+    char uuid[IB_UUID_LENGTH];
+
+    for (size_t i = 0; i < n; ++i) {
+        if (ib_uuid_create_v4(uuid) != IB_OK) {
+            return;
+        }
+        out->push_back(uuid);
+    }
+}
+
+}
 
 TEST(TestIBUtilUUID, random)
 {
@@ -49,3 +90,82 @@ TEST(TestIBUtilUUID, random)
 
     ib_uuid_shutdown();
 }
+
+TEST(TestIBUtilUUID, format)
+{
+    char uuid[IB_UUID_LENGTH];
+
+    ib_uuid_initialize();
+
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_EQ(IB_OK, ib_uuid_create_v4(uuid));
+        check_v4(uuid);
+    }
+
+    ib_uuid_shutdown();
+}
+
+TEST(TestIBUtilUUID, threads)
+{
+    static const size_t c_num_threads = 8;
+    static const size_t c_per_thread  = 10000;
+
+    std::vector<std::vector<std::string> > results(c_num_threads);
+    boost::thread_group threads;
+    std::set<std::string> all;
+
+    ib_uuid_initialize();
+
+    for (size_t i = 0; i < c_num_threads; ++i) {
+        threads.create_thread(
+            boost::bind(create_many, &results[i], c_per_thread)
+        );
+    }
+    threads.join_all();
+
+    for (size_t i = 0; i < c_num_threads; ++i) {
+        ASSERT_EQ(c_per_thread, results[i].size());
+        all.insert(results[i].begin(), results[i].end());
+    }
+    EXPECT_EQ(c_num_threads * c_per_thread, all.size());
+
+    ib_uuid_shutdown();
+}
+
+TEST(TestIBUtilUUID, fork)
+{
+    char parent[IB_UUID_LENGTH];
+    char child[IB_UUID_LENGTH];
+    int fds[2];
+    int status;
+
+    ib_uuid_initialize();
+
+    // Seed this thread's generator before forking.
+    ASSERT_EQ(IB_OK, ib_uuid_create_v4(parent));
+
+    ASSERT_EQ(0, pipe(fds));
+    pid_t pid = fork();
+    ASSERT_NE(-1, pid);
+    if (pid == 0) {
+        close(fds[0]);
+        if (
+            ib_uuid_create_v4(child) != IB_OK ||
+            write(fds[1], child, IB_UUID_LENGTH) != IB_UUID_LENGTH
+        ) {
+            _exit(1);
+        }
+        _exit(0);
+    }
+    close(fds[1]);
+
+    ASSERT_EQ(IB_OK, ib_uuid_create_v4(parent));
+    ASSERT_EQ(IB_UUID_LENGTH, read(fds[0], child, IB_UUID_LENGTH));
+    close(fds[0]);
+    ASSERT_EQ(pid, waitpid(pid, &status, 0));
+    EXPECT_EQ(0, status);
+
+    EXPECT_STRNE(parent, child);
+
+    ib_uuid_shutdown();
+}
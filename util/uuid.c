@@ -31,17 +31,179 @@
 #include <ironbee/lock.h>
 
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <string.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_RANDOM_H
+#include <sys/random.h>
+#endif
 
 /*
  * These are initialized by ib_uuid_init();
  * OSSP UUID is ... generous .. in what it creates for a UUID.  E.g., it will
  * do multiple allocations, check its MAC (it may have changed?), etc. for
  * every creation.  So we only keep one at reuse it.
+ *
+ * OSSP UUID is only used if a thread can not seed its generator (below).
  */
 static ib_lock_t *g_uuid_lock;
 static uuid_t    *g_ossp_uuid;
 
+/**
+ * Per-thread v4 UUID generator.
+ *
+ * A xoshiro256** generator seeded from the kernel.  A fork handler clears
+ * the seeded flag of the forking thread, the only thread of the child, so
+ * that the child reseeds instead of repeating the UUIDs of its parent.
+ */
+typedef struct {
+    uint64_t s[4];   /**< Generator state; not all zero once seeded. */
+    bool     seeded; /**< Whether @ref s is seeded. */
+} ib_uuid_generator_t;
+
+static __thread ib_uuid_generator_t s_generator;
+
+/** Registers uuid_fork_child() once. */
+static pthread_once_t g_uuid_atfork_once = PTHREAD_ONCE_INIT;
+
+/**
+ * Make the generator of a forked child reseed.
+ */
+static void uuid_fork_child(void)
+{
+    s_generator.seeded = false;
+}
+
+/**
+ * Register uuid_fork_child().
+ */
+static void uuid_register_atfork(void)
+{
+    pthread_atfork(NULL, NULL, uuid_fork_child);
+}
+
+/**
+ * Fill @a buf with @a len bytes from the kernel random source.
+ *
+ * @param[out] buf Buffer to fill.
+ * @param[in]  len Length of @a buf.
+ * @returns true on success.
+ */
+static bool uuid_random_bytes(void *buf, size_t len)
+{
+    uint8_t *p = (uint8_t *)buf;
+
+#ifdef HAVE_GETRANDOM
+    while (len > 0) {
+        ssize_t n = getrandom(p, len, 0);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            /* E.g., ENOSYS on older kernels; try /dev/urandom. */
+            break;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    if (len == 0) {
+        return true;
+    }
+#endif
+
+    int fd = open("/dev/urandom", O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    close(fd);
+
+    return len == 0;
+}
+
+static inline uint64_t uuid_rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * Next 64 bits of @a g.
+ */
+static inline uint64_t uuid_next(ib_uuid_generator_t *g)
+{
+    uint64_t *s = g->s;
+    const uint64_t result = uuid_rotl(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = uuid_rotl(s[3], 45);
+
+    return result;
+}
+
+/**
+ * Calling thread's generator, (re)seeded if needed.
+ *
+ * @returns Generator or NULL if it could not be seeded.
+ */
+static ib_uuid_generator_t *uuid_generator(void)
+{
+    ib_uuid_generator_t *g = &s_generator;
+
+    if (! g->seeded) {
+        /* Before seeding, so a fork after it is seen. */
+        pthread_once(&g_uuid_atfork_once, uuid_register_atfork);
+
+        if (! uuid_random_bytes(g->s, sizeof(g->s))) {
+            return NULL;
+        }
+        if ((g->s[0] | g->s[1] | g->s[2] | g->s[3]) == 0) {
+            g->s[0] = 1;
+        }
+        g->seeded = true;
+    }
+
+    return g;
+}
+
+/**
+ * Write @a bytes as a UUID string to @a uuid.
+ *
+ * @param[out] uuid  Where to write; must be IB_UUID_LENGTH long.
+ * @param[in]  bytes UUID.
+ */
+static void uuid_format(char *uuid, const uint8_t bytes[16])
+{
+    static const char hex[] = "0123456789abcdef";
+
+    for (int i = 0; i < 16; ++i) {
+        if (i == 4 || i == 6 || i == 8 || i == 10) {
+            *uuid++ = '-';
+        }
+        *uuid++ = hex[bytes[i] >> 4];
+        *uuid++ = hex[bytes[i] & 0x0f];
+    }
+    *uuid = '\0';
+}
+
 ib_status_t ib_uuid_initialize(void)
 {
     ib_status_t rc;
@@ -66,7 +228,12 @@ ib_status_t ib_uuid_shutdown(void)
     return IB_OK;
 }
 
-ib_status_t ib_uuid_create_v4(char *uuid)
+/**
+ * Create a v4 UUID with OSSP UUID.
+ *
+ * Fallback for threads whose generator can not be seeded.
+ */
+static ib_status_t uuid_create_v4_ossp(char *uuid)
 {
     assert(uuid != NULL);
 
@@ -109,3 +276,28 @@ finish:
 
     return rc;
 }
+
+ib_status_t ib_uuid_create_v4(char *uuid)
+{
+    assert(uuid != NULL);
+
+    ib_uuid_generator_t *g = uuid_generator();
+    uint64_t             words[2];
+    uint8_t              bytes[16];
+
+    if (g == NULL) {
+        return uuid_create_v4_ossp(uuid);
+    }
+
+    words[0] = uuid_next(g);
+    words[1] = uuid_next(g);
+    memcpy(bytes, words, sizeof(bytes));
+
+    /* Version 4 (random) and RFC 4122 variant. */
+    bytes[6] = (bytes[6] & 0x0f) | 0x40;
+    bytes[8] = (bytes[8] & 0x3f) | 0x80;
+
+    uuid_format(uuid, bytes);
+
+    return IB_OK;
+}